@@ -23,56 +23,78 @@
 #include <v10/RingItemFactory.h>
 #include <v11/RingItemFactory.h>
 #include <v12/RingItemFactory.h>
+#include <v10/RingViewDecoder.h>
+#include <v11/RingViewDecoder.h>
+#include <v12/RingViewDecoder.h>
 #include <abstract/RingItemFactoryBase.h>
+#include <abstract/CRingItemValidator.h>
+#include <abstract/DataFormat.h>
+#include <v10/DataFormat.h>
+#include <atomic>
 #include <map>
 #include <stdexcept>
 #include <stdint.h>
 /**
  * Since ring item factories have no state but must be instantiable classes
- * in order to support the polymorphism we need, we're going to maintain a map
+ * in order to support the polymorphism we need, we're going to maintain a table
  * indexed by version of the factories we've created.  In that way, we
  * provide a reused factory if there's s duplicate request.
  * Note this means that factories we return references to are owned by us
  * not the caller who obtains those references -- specifically callers _must_
  * not delete factories they receive from us.
+ *
+ * selectFactory is called from worker threads so the table is an array of
+ * atomic pointers rather than a map.  Lookups are a single acquire load.
+ * The first request for a version creates a factory and publishes it with a
+ * compare and exchange; a thread that loses that race deletes its factory
+ * and uses the winner's.  Factories that carry state (e.g. an item pool)
+ * should not be shared between threads; selectThreadFactory gives each
+ * thread its own.
  */
 
 namespace ufmt {
     namespace FormatSelector {
+        static const unsigned NUM_VERSIONS = v12 + 1;
+        
         /**
          * cache of previously created ring item factories.
          */
-        static std::map<SupportedVersions, ::ufmt::RingItemFactoryBase*> instantiatedFactories;
+        static std::atomic<::ufmt::RingItemFactoryBase*> instantiatedFactories[NUM_VERSIONS];
         /**
          * lookup table between version numbers and the version enumerator.
+         * This is never modified so concurrent lookups are safe.
          */
-        static std::map<uint16_t, SupportedVersions> versionLookup = {
+        static const std::map<uint16_t, SupportedVersions> versionLookup = {
             {10, v10}, {11, v11}, {12, v12}
         };
+        /**
+         * Per thread factories; deleted when the thread exits.
+         */
+        struct ThreadFactories {
+            ::ufmt::RingItemFactoryBase* s_factories[NUM_VERSIONS];
+            ThreadFactories() {
+                for (unsigned i = 0; i < NUM_VERSIONS; i++) {
+                    s_factories[i] = nullptr;
+                }
+            }
+            ~ThreadFactories() {
+                for (unsigned i = 0; i < NUM_VERSIONS; i++) {
+                    delete s_factories[i];
+                }
+            }
+        };
         
         /**
-         * createFactory [private]
-         *    This is a private 'method' to actually create a factory and enter it into
-         *    the cache of factories, once we know we need one.
-         *  @param v - version we need a new factory for.
+         * checkVersion [private]
+         *  @param v - a version.
          *  @throw std::invalid_argument if v is not a valid, supported version.
-         *      this can happen because C++ can be fast and loose babou
+         *      this can happen because C++ can be fast and loose about enums.
          */
-        static void createFactory(SupportedVersions v) {
-            switch (v) {
-                case v10:
-                    instantiatedFactories[v10] = new ::ufmt::v10::RingItemFactory;
-                    break;
-                case v11:
-                    instantiatedFactories[v11] = new ::ufmt::v11::RingItemFactory;
-                    break;
-                case v12:
-                    instantiatedFactories[v12] = new ::ufmt::v12::RingItemFactory;
-                    break;
-                default:
-                    throw std::invalid_argument(
-                        "Invalid NSCLDAQ version instantiating a format factory"
-                    );
+        static void checkVersion(SupportedVersions v) {
+            if (unsigned(v) >= NUM_VERSIONS) {
+                throw std::invalid_argument(
+                    "Invalid NSCLDAQ version instantiating a format factory"
+                );
             }
         }
         /**
@@ -90,10 +112,45 @@ namespace ufmt {
         ::ufmt::RingItemFactoryBase&
         selectFactory(SupportedVersions version)
         {
-            if (instantiatedFactories.count(version) == 0) {
-                createFactory(version);
+            checkVersion(version);
+            auto& slot(instantiatedFactories[version]);
+            ::ufmt::RingItemFactoryBase* pFactory =
+                slot.load(std::memory_order_acquire);
+            if (!pFactory) {
+                ::ufmt::RingItemFactoryBase* pNew = makeFactory(version);
+                if (slot.compare_exchange_strong(
+                        pFactory, pNew, std::memory_order_acq_rel,
+                        std::memory_order_acquire
+                    )) {
+                    pFactory = pNew;
+                } else {
+                    delete pNew;           // Another thread got there first.
+                }
+            }
+            return *pFactory;
+        }
+        /**
+         * selectThreadFactory
+         *    Like selectFactory but each thread gets its own factory.  Use
+         *    this for factories that will be given per thread state such
+         *    as an item pool.
+         * @param version - the version we need a factory for.
+         * @return RingItemFactoryBase& - the calling thread's factory for that
+         *        version.  It's deleted when the thread exits and must not
+         *        be deleted by the caller nor used by other threads after
+         *        that.
+         * @throw std::invalid_argument - if the version is not a valid/supported version.
+         */
+        ::ufmt::RingItemFactoryBase&
+        selectThreadFactory(SupportedVersions version)
+        {
+            checkVersion(version);
+            static thread_local ThreadFactories factories;
+            ::ufmt::RingItemFactoryBase*& pFactory(factories.s_factories[version]);
+            if (!pFactory) {
+                pFactory = makeFactory(version);
             }
-            return *instantiatedFactories[version];
+            return *pFactory;
         }
         /**
          * selectFactory
@@ -113,10 +170,35 @@ namespace ufmt {
             // we only care about the major version.
             
             uint16_t major = item.getMajor();
-            if (versionLookup.count(major)  == 0) {
+            auto p = versionLookup.find(major);
+            if (p == versionLookup.end()) {
                 throw std::invalid_argument("Format item has unrecognized version");
             } else {
-                return selectFactory(versionLookup[major]);
+                return selectFactory(p->second);
+            }
+        }
+        /**
+         * selectViewDecoder
+         *    Return the decoder the typed ring item views use for items
+         *    of a version.  Decoders have no state so one of each is shared.
+         * @param version - the version of the items to decode.
+         * @return RingViewDecoderBase& - the decoder.  This module owns it.
+         * @throw std::invalid_argument - if the version is not a valid/supported version.
+         */
+        const ::ufmt::RingViewDecoderBase&
+        selectViewDecoder(SupportedVersions version)
+        {
+            static const v10::RingViewDecoder v10Decoder;
+            static const v11::RingViewDecoder v11Decoder;
+            static const v12::RingViewDecoder v12Decoder;
+            checkVersion(version);
+            switch (version) {
+            case v10:
+                return v10Decoder;
+            case v11:
+                return v11Decoder;
+            default:
+                return v12Decoder;
             }
         }
         /**
@@ -132,16 +214,159 @@ namespace ufmt {
             // can't call it and that's what call us.  Fortunately, there's
             // not so many pointers:
 
-
-            for (auto p : instantiatedFactories) {
-                if (p.second == &fact) {   // contents matched.
-                    auto iter = instantiatedFactories.find(p.first); // has to exist.
-                    instantiatedFactories.erase(iter);
+            for (unsigned i = 0; i < NUM_VERSIONS; i++) {
+                ::ufmt::RingItemFactoryBase* pExpected = &fact;
+                if (instantiatedFactories[i].compare_exchange_strong(
+                        pExpected, nullptr, std::memory_order_acq_rel
+                    )) {
                     break;
                 }
             }
         }
-
+        /**
+         * makeFactory
+         *    Create a new factory for a version.  Unlike selectFactory, the
+         *    factory is not cached; the caller owns it and must delete it
+         *    (or hand it to something, like a DataSource, that will).
+         * @param version - the version we need a factory for.
+         * @return RingItemFactoryBase* - new concrete factory.
+         * @throw std::invalid_argument if version is not a valid, supported version.
+         */
+        ::ufmt::RingItemFactoryBase*
+        makeFactory(SupportedVersions version)
+        {
+            switch (version) {
+                case v10:
+                    return new ::ufmt::v10::RingItemFactory;
+                case v11:
+                    return new ::ufmt::v11::RingItemFactory;
+                case v12:
+                    return new ::ufmt::v12::RingItemFactory;
+                default:
+                    throw std::invalid_argument(
+                        "Invalid NSCLDAQ version instantiating a format factory"
+                    );
+            }
+        }
+        /**
+         * getFormatVersion
+         *    If raw data is a RING_FORMAT item, get the version it declares.
+         *    v10 has no format items so this is only ever v11 or v12 data.
+         * @param pItem - points to a complete ring item.
+         * @param[out] version - the version declared by the item.
+         * @return bool - true if the item is a format item with a supported
+         *                major version, false otherwise (version is unchanged).
+         */
+        bool
+        getFormatVersion(const void* pItem, SupportedVersions& version)
+        {
+            const DataFormat* p = reinterpret_cast<const DataFormat*>(pItem);
+            if ((p->s_header.s_type != RING_FORMAT) ||
+                (p->s_header.s_size < sizeof(DataFormat))) {
+                return false;
+            }
+            auto v = versionLookup.find(p->s_majorVersion);
+            if (v == versionLookup.end()) {
+                return false;
+            }
+            version = v->second;
+            return true;
+        }
+        /**
+         * detectVersion
+         *    Decide the format of data from the items at its start without
+         *    making any ring items.  At most MAX_DETECT_ITEMS complete items
+         *    are looked at:
+         *    - A RING_FORMAT item settles the question.
+         *    - Otherwise v10 is chosen if the items are all plausible v10
+         *      items but not plausible v11/v12 items, or if there's a state
+         *      change item whose size is exactly that of a v10 state change
+         *      item.
+         *    - Otherwise the body header size words decide between v11,
+         *      which writes 0 for items with no body header, and v12 which
+         *      writes sizeof(uint32_t).
+         *    - If every item has a body header, the data is v11 or v12 but
+         *      which one can't be told.  The version passed in is kept if
+         *      it's one of those, otherwise v12 is chosen.
+         * @param pData - the data, starting at an item boundary.
+         * @param nBytes - number of bytes of data.  Items cut off by the
+         *                 end of the data are ignored.
+         * @param[inout] version - on entry the version the caller would
+         *                 choose, on exit the detected version.
+         * @return bool - false if the data does not decide the version
+         *                (version is then unchanged).
+         */
+        bool
+        detectVersion(const void* pData, size_t nBytes, SupportedVersions& version)
+        {
+            CRingItemValidator v10Check(v10);
+            CRingItemValidator v12Check(v12);
+            const uint8_t* p = reinterpret_cast<const uint8_t*>(pData);
+            size_t   pos = 0;
+            unsigned nItems = 0;
+            unsigned v10Bad = 0;
+            unsigned v12Bad = 0;
+            unsigned v10StateChanges = 0;
+            unsigned noBodyHeader0 = 0;       // v11 style.
+            unsigned noBodyHeader4 = 0;       // v12 style.
+            unsigned bodyHeaders   = 0;
+            
+            while ((nItems < MAX_DETECT_ITEMS) &&
+                   (nBytes - pos >= v12Check.headerBytes())) {
+                const RingItem* pItem = reinterpret_cast<const RingItem*>(p + pos);
+                uint32_t size = pItem->s_header.s_size;
+                if ((size < sizeof(RingItemHeader)) || (size > nBytes - pos)) {
+                    break;                   // Can't walk further.
+                }
+                if (getFormatVersion(pItem, version)) {
+                    return true;
+                }
+                bool v10Ok = v10Check.isPlausible(pItem);
+                bool v12Ok = v12Check.isPlausible(pItem);
+                if (!v10Ok) v10Bad++;
+                if (!v12Ok) {
+                    v12Bad++;
+                } else {
+                    uint32_t bhSize = pItem->s_body.u_noBodyHeader.s_empty;
+                    if (bhSize == 0) noBodyHeader0++;
+                    if (bhSize == sizeof(uint32_t)) noBodyHeader4++;
+                    if (bhSize == sizeof(BodyHeader)) bodyHeaders++;
+                }
+                uint32_t type = pItem->s_header.s_type;
+                if (((type == BEGIN_RUN) || (type == END_RUN) ||
+                     (type == PAUSE_RUN) || (type == RESUME_RUN)) &&
+                    (size == sizeof(v10::StateChangeItem))) {
+                    v10StateChanges++;
+                }
+                nItems++;
+                pos += size;
+            }
+            if (nItems == 0) {
+                return false;
+            }
+            if ((v10Bad == 0) && ((v12Bad > 0) || (v10StateChanges > 0))) {
+                version = v10;
+                return true;
+            }
+            if (v12Bad > 0) {
+                return false;                // Not ring items of any format.
+            }
+            if ((noBodyHeader0 > 0) && (noBodyHeader4 == 0)) {
+                version = v11;
+                return true;
+            }
+            if ((noBodyHeader4 > 0) && (noBodyHeader0 == 0)) {
+                version = v12;
+                return true;
+            }
+            if (bodyHeaders == nItems) {
+                if (version == v10) {
+                    version = v12;
+                }
+                return true;
+            }
+            return false;
+        }
         
     }   // FormatSelector
 }       // ufmt
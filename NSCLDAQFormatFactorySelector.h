@@ -22,22 +22,36 @@
 #ifndef NSCLDAQFORMATFACTORYSELECTOR_H
 #define NSCLDAQFORMATFACTORYSELECTOR_H
 #include <fmtconfig.h>
+#include <stddef.h>
 
 namespace ufmt {
     /**
      * Rather than a class, we can just use a namespace to provide these
      * essentially unbound functions.
+     * The functions may be called from any thread.
      */
 
     class RingItemFactoryBase;
     class CDataFormatItem;
     class CRingItem;
+    class RingViewDecoderBase;
     namespace FormatSelector {
         enum SupportedVersions {v10, v11, v12};
         
         RingItemFactoryBase& selectFactory(SupportedVersions version);
         RingItemFactoryBase& selectFactory(CDataFormatItem& item);
+        RingItemFactoryBase& selectThreadFactory(SupportedVersions version);
         void unregisterFactory(RingItemFactoryBase& fact);     // Remove a factory from the cache if it's in.
+        RingItemFactoryBase* makeFactory(SupportedVersions version); // Caller owns.
+        const RingViewDecoderBase& selectViewDecoder(SupportedVersions version);
+
+        // Format detection from raw data:
+
+        static const unsigned MAX_DETECT_ITEMS = 32;
+        bool getFormatVersion(const void* pItem, SupportedVersions& version);
+        bool detectVersion(
+            const void* pData, size_t nBytes, SupportedVersions& version
+        );
 
     }                          // End namespace FormatSelector
 
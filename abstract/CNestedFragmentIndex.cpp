@@ -0,0 +1,245 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CNestedFragmentIndex.cpp
+ *  @brief: Implement the nested built event index.
+ */
+#include "CNestedFragmentIndex.h"
+#include "DataFormat.h"
+#include "fragment.h"
+#include <stdexcept>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param version - format of the payload ring items.
+     *   @param maxDepth - number of levels of fragments to index (1 just
+     *                indexes the top level like FragmentIndex).
+     */
+    CNestedFragmentIndex::CNestedFragmentIndex(
+        FormatSelector::SupportedVersions version, unsigned maxDepth
+    ) :
+        m_version(version), m_maxDepth(maxDepth ? maxDepth : 1)
+    {}
+    /**
+     * index
+     *   Index the fragments of a built body.
+     *   @param pBody - the body; it starts with the uint32_t byte count
+     *             (which includes itself) that precedes the first fragment.
+     *   @throw std::runtime_error - a top level fragment doesn't fit.
+     */
+    void
+    CNestedFragmentIndex::index(const void* pBody)
+    {
+        uint32_t nBytes = *reinterpret_cast<const uint32_t*>(pBody);
+        if (nBytes < sizeof(uint32_t)) {
+            throw std::runtime_error(
+                "CNestedFragmentIndex::index - body byte count is too small"
+            );
+        }
+        indexFragments(
+            reinterpret_cast<const uint8_t*>(pBody) + sizeof(uint32_t),
+            nBytes - sizeof(uint32_t)
+        );
+    }
+    /**
+     * indexFragments
+     *   Index raw fragments.
+     *   @param pFragments - the first fragment.
+     *   @param nBytes - bytes from there to the end of the last fragment.
+     *   @throw std::runtime_error - a top level fragment doesn't fit.
+     */
+    void
+    CNestedFragmentIndex::indexFragments(const void* pFragments, size_t nBytes)
+    {
+        m_entries.clear();
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(pFragments);
+        walk(p, p + nBytes, 0, -1, true);
+    }
+    /**
+     * size
+     *   @return size_t - number of fragments found at all depths.
+     */
+    size_t
+    CNestedFragmentIndex::size() const
+    {
+        return m_entries.size();
+    }
+    /**
+     * operator[]
+     *   @param i - entry number (not checked).
+     *   @return const Entry& - that entry.
+     */
+    const CNestedFragmentIndex::Entry&
+    CNestedFragmentIndex::operator[](size_t i) const
+    {
+        return m_entries[i];
+    }
+    /**
+     * nextSibling
+     *   @param i - entry number.
+     *   @return size_t - the entry after all those nested in entry i.  This
+     *             is the next entry at the same depth unless i is the last
+     *             child of its parent.  size() at the end of the table.
+     */
+    size_t
+    CNestedFragmentIndex::nextSibling(size_t i) const
+    {
+        return i + 1 + m_entries[i].s_nDescendants;
+    }
+    /**
+     * begin
+     *   @return const_iterator - first entry.
+     */
+    CNestedFragmentIndex::const_iterator
+    CNestedFragmentIndex::begin() const
+    {
+        return m_entries.begin();
+    }
+    /**
+     * end
+     *   @return const_iterator - past the last entry.
+     */
+    CNestedFragmentIndex::const_iterator
+    CNestedFragmentIndex::end() const
+    {
+        return m_entries.end();
+    }
+    /**
+     * getMaxDepth
+     *   @return unsigned - levels that are indexed.
+     */
+    unsigned
+    CNestedFragmentIndex::getMaxDepth() const
+    {
+        return m_maxDepth;
+    }
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - format of the payloads.
+     */
+    FormatSelector::SupportedVersions
+    CNestedFragmentIndex::getVersion() const
+    {
+        return m_version;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods.
+
+    /**
+     * walk
+     *    Add the fragments in a range of data, and those nested in them, to
+     *    the table.
+     * @param p    - first fragment.
+     * @param pEnd - end of the fragments.
+     * @param depth - depth of these fragments.
+     * @param parent - entry whose payload holds them.
+     * @param top - true for the top level: malformed data throws.  Below
+     *             that the entries added are removed and false returned.
+     * @return bool - true if the range parsed completely as fragments.
+     */
+    bool
+    CNestedFragmentIndex::walk(
+        const uint8_t* p, const uint8_t* pEnd, uint32_t depth,
+        int32_t parent, bool top
+    )
+    {
+        size_t first = m_entries.size();
+        while (p < pEnd) {
+            const EVB::FlatFragment* pFrag =
+                reinterpret_cast<const EVB::FlatFragment*>(p);
+            size_t remaining = pEnd - p;
+            if ((remaining < sizeof(EVB::FragmentHeader)) ||
+                (pFrag->s_header.s_size > remaining - sizeof(EVB::FragmentHeader))) {
+                if (top) {
+                    throw std::runtime_error(
+                        "CNestedFragmentIndex insufficient data in buffer for next fragment!"
+                    );
+                }
+                m_entries.resize(first);
+                return false;
+            }
+            Entry e;
+            e.s_depth        = depth;
+            e.s_parent       = parent;
+            e.s_nDescendants = 0;
+            e.s_timestamp    = pFrag->s_header.s_timestamp;
+            e.s_sourceId     = pFrag->s_header.s_sourceId;
+            e.s_barrier      = pFrag->s_header.s_barrier;
+            e.s_size         = pFrag->s_header.s_size;
+            e.s_payload      = pFrag->s_body;
+            locateBody(e);
+
+            size_t i = m_entries.size();
+            m_entries.push_back(e);
+            if ((depth + 1 < m_maxDepth) && isBuilt(e)) {
+                const uint8_t* pBody = reinterpret_cast<const uint8_t*>(e.s_body);
+                walk(
+                    pBody + sizeof(uint32_t), pBody + e.s_bodySize, depth + 1,
+                    i, false
+                );
+                m_entries[i].s_nDescendants = m_entries.size() - i - 1;
+            }
+            p += sizeof(EVB::FragmentHeader) + e.s_size;
+        }
+        return true;
+    }
+    /**
+     * locateBody
+     *    Fill in the body pointer and size of an entry from its payload.
+     *    v11 and v12 items have a body header size word after the ring item
+     *    header: sizeof(BodyHeader) if there is a body header, 0 or
+     *    sizeof(uint32_t) if not.  v10 items have no such word.
+     * @param entry - entry whose payload is filled in.
+     */
+    void
+    CNestedFragmentIndex::locateBody(Entry& entry) const
+    {
+        entry.s_body     = nullptr;
+        entry.s_bodySize = 0;
+        const RingItem* pItem = reinterpret_cast<const RingItem*>(entry.s_payload);
+        size_t offset = sizeof(RingItemHeader);
+        if (m_version != FormatSelector::v10) {
+            if (entry.s_size < offset + sizeof(uint32_t)) return;
+            uint32_t bhSize = pItem->s_body.u_noBodyHeader.s_empty;
+            offset += (bhSize > sizeof(uint32_t)) ? bhSize : sizeof(uint32_t);
+        }
+        // The ring item must fill the payload:
+
+        if ((entry.s_size < offset) || (pItem->s_header.s_size != entry.s_size)) {
+            return;
+        }
+        entry.s_body     = reinterpret_cast<const uint8_t*>(pItem) + offset;
+        entry.s_bodySize = entry.s_size - offset;
+    }
+    /**
+     * isBuilt
+     * @param entry - an entry with its body located.
+     * @return bool - true if the payload could be a built event: a
+     *                PHYSICS_EVENT whose body starts with its own byte count.
+     */
+    bool
+    CNestedFragmentIndex::isBuilt(const Entry& entry) const
+    {
+        if (!entry.s_body || (entry.s_bodySize < sizeof(uint32_t))) {
+            return false;
+        }
+        const RingItem* pItem = reinterpret_cast<const RingItem*>(entry.s_payload);
+        return (pItem->s_header.s_type == PHYSICS_EVENT) &&
+            (*reinterpret_cast<const uint32_t*>(entry.s_body) == entry.s_bodySize);
+    }
+}
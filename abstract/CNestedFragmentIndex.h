@@ -0,0 +1,105 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CNestedFragmentIndex.h
+ *  @brief: Index of the fragments of built events that contain built events.
+ */
+#ifndef CNESTEDFRAGMENTINDEX_H
+#define CNESTEDFRAGMENTINDEX_H
+
+#include <NSCLDAQFormatFactorySelector.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ufmt {
+    /**
+     * @class CNestedFragmentIndex
+     *    When events are built in more than one stage, the payload of a
+     *    fragment can be a PHYSICS_EVENT whose body is itself a set of
+     *    fragments.  This class walks such an event in a single pass to a
+     *    maximum depth and records every fragment it finds in one flat
+     *    table.
+     *
+     *    The table is in depth-first order.  Each entry records its depth
+     *    (0 for the fragments of the top level body), the index of the
+     *    entry whose payload contains it and how many entries follow it
+     *    that are nested inside it.  So the descendants of an entry are the
+     *    entries just after it, and its next sibling is at
+     *    nextSibling(i).
+     *
+     *    Each entry also locates the body of its payload ring item.  That
+     *    skips the body header if there is one, which depends on the
+     *    format version.  This differs from FragmentInfo::s_itembody, which
+     *    only skips the ring item header.
+     *
+     *    A payload is only treated as a built event if its body parses,
+     *    completely, as fragments.  Otherwise it's a leaf.  Malformed
+     *    fragments at the top level are an error, as in FragmentIndex.
+     *
+     *    The table is reused by each call to index, so an index object
+     *    kept from event to event stops allocating once it has seen the
+     *    largest event.
+     */
+    class CNestedFragmentIndex {
+    public:
+        static const unsigned DEFAULT_MAX_DEPTH = 4;
+
+        struct Entry {
+            uint32_t    s_depth;
+            int32_t     s_parent;         // Entry index; -1 at the top level.
+            uint32_t    s_nDescendants;   // Entries nested inside this one.
+            uint64_t    s_timestamp;
+            uint32_t    s_sourceId;
+            uint32_t    s_barrier;
+            uint32_t    s_size;           // Bytes of payload.
+            const void* s_payload;        // The payload ring item.
+            const void* s_body;           // Its body (nullptr if too small).
+            uint32_t    s_bodySize;
+        };
+        typedef std::vector<Entry>::const_iterator const_iterator;
+    private:
+        FormatSelector::SupportedVersions m_version;
+        unsigned           m_maxDepth;
+        std::vector<Entry> m_entries;
+    public:
+        CNestedFragmentIndex(
+            FormatSelector::SupportedVersions version = FormatSelector::v12,
+            unsigned maxDepth = DEFAULT_MAX_DEPTH
+        );
+
+        void index(const void* pBody);
+        void indexFragments(const void* pFragments, size_t nBytes);
+
+        size_t size() const;
+        const Entry& operator[](size_t i) const;
+        size_t nextSibling(size_t i) const;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        unsigned getMaxDepth() const;
+        FormatSelector::SupportedVersions getVersion() const;
+    private:
+        bool walk(
+            const uint8_t* p, const uint8_t* pEnd, uint32_t depth,
+            int32_t parent, bool top
+        );
+        void locateBody(Entry& entry) const;
+        bool isBuilt(const Entry& entry) const;
+    };
+}
+#endif
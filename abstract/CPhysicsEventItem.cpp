@@ -153,12 +153,22 @@ namespace ufmt {
   ::std::vector<FragmentInfo>
   CPhysicsEventItem::getFragments() const {
     
-    const uint16_t* body = reinterpret_cast<const uint16_t*>(getBodyPointer());
-    FragmentIndex indexer(body);
-
-    
-    ::std::vector<FragmentInfo> result(indexer.begin(), indexer.end());
+    FragmentRange frags(fragments());
+    ::std::vector<FragmentInfo> result(frags.begin(), frags.end());
 
     return result;   
   }
+  /**
+   * fragments
+   *
+   *    @return FragmentRange - the fragments of an event built item.  Iterating
+   *              over these decodes the fragment headers in place, so unlike
+   *              getFragments nothing is allocated or copied.
+   *   @note the same caveats as getFragments apply.  The range points into the
+   *         item and is only valid as long as the item's contents are.
+   */
+  FragmentRange
+  CPhysicsEventItem::fragments() const {
+    return FragmentRange(reinterpret_cast<const uint16_t*>(getBodyPointer()));
+  }
 }                             // Namespace ufmt
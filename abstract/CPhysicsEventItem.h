@@ -39,7 +39,7 @@ namespace ufmt {
     class CPhysicsEventItem : public CRingItem
     {
     public:
-        CPhysicsEventItem(size_t maxBody=8192);
+        CPhysicsEventItem(size_t maxBody=CRingItemStaticBufferSize - 10);
         
         CPhysicsEventItem(const CRingItem& rhs) ;
         CPhysicsEventItem(const CPhysicsEventItem& rhs);
@@ -63,6 +63,7 @@ namespace ufmt {
                             uint32_t barrierType = 0);
         virtual ::std::vector<FragmentInfo>
             getFragments() const;
+        FragmentRange fragments() const;
         
 
     };
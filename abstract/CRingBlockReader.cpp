@@ -0,0 +1,493 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingBlockReader.cpp
+ *  @brief: Implement the block buffered ring item reader.
+ */
+#include "CRingBlockReader.h"
+#include "DataFormat.h"
+
+#include <string.h>
+#include <errno.h>
+#include <stdexcept>
+#include <algorithm>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param fd  - file descriptor open on the ring item source.
+     *   @param blockSize - Number of bytes we try to read at a time.
+     *                This is also the initial buffer size.
+     */
+    CRingBlockReader::CRingBlockReader(int fd, size_t blockSize) :
+        m_fd(fd), m_pBuffer(nullptr), m_bufferSize(blockSize),
+        m_blockSize(blockSize), m_cursor(0), m_endData(0), m_eof(false),
+        m_pValidator(nullptr), m_pFilter(nullptr),
+        m_seekable(lseek(fd, 0, SEEK_CUR) >= 0), m_filtered(0), m_consumed(0)
+    {
+        if (m_blockSize < sizeof(RingItemHeader)) {
+            throw std::invalid_argument(
+                "CRingBlockReader block size must hold at least a ring item header"
+            );
+        }
+        m_pBuffer = new uint8_t[m_bufferSize];
+    }
+    /**
+     * destructor
+     */
+    CRingBlockReader::~CRingBlockReader()
+    {
+        delete []m_pBuffer;
+    }
+
+    /**
+     * nextItem
+     *    Return a pointer to the next complete ring item.
+     *  @return const RingItem*  - pointer to the item in the block buffer.
+     *                 This is only valid until the next call to nextItem.
+     *  @retval nullptr - end of file (a truncated final item is treated
+     *                 as an end of file just as the unbuffered readers do).
+     *  @throw int - errno if a read fails.
+     *  @throw std::runtime_error - the item size is smaller than a header,
+     *                 which can only happen if we've lost sync with the data.
+     */
+    const RingItem*
+    CRingBlockReader::nextItem()
+    {
+        while (true) {
+            if (m_pValidator && !resync()) {
+                return nullptr;
+            }
+            if (!fill(sizeof(RingItemHeader))) {
+                return nullptr;
+            }
+            const RingItemHeader* pHeader =
+                reinterpret_cast<const RingItemHeader*>(m_pBuffer + m_cursor);
+            uint32_t size = pHeader->s_size;
+            if (size < sizeof(RingItemHeader)) {
+                throw std::runtime_error(
+                    "CRingBlockReader - ring item size is smaller than a ring item header"
+                );
+            }
+            // Rejected items are stepped over with only their headers read:
+            if (m_pFilter) {
+                if (!fill(std::min(size_t(size), m_pFilter->headerBytes()))) {
+                    return nullptr;
+                }
+                if (!m_pFilter->accept(m_pBuffer + m_cursor)) {
+                    m_filtered++;
+                    if (!skipItem(size)) {
+                        return nullptr;
+                    }
+                    continue;
+                }
+            }
+            if (!fill(size)) {
+                return nullptr;
+            }
+            const RingItem* pResult =
+                reinterpret_cast<const RingItem*>(m_pBuffer + m_cursor);
+            m_cursor   += size;
+            m_consumed += size;
+            return pResult;
+        }
+    }
+    /**
+     * getFd
+     *  @return int - the file descriptor we read from.
+     */
+    int
+    CRingBlockReader::getFd() const
+    {
+        return m_fd;
+    }
+    /**
+     * getBlockSize
+     *  @return size_t - the number of bytes we attempt to read at a time.
+     */
+    size_t
+    CRingBlockReader::getBlockSize() const
+    {
+        return m_blockSize;
+    }
+    /**
+     * peek
+     *    Copy bytes from the front of the unconsumed data without consuming
+     *    them.  If fewer than nBytes are buffered, one more read is done;
+     *    like nextItem we don't wait for a full buffer from a live source.
+     * @param pDest - where to copy the data.
+     * @param nBytes - most bytes to copy.
+     * @return size_t - number of bytes copied (0 only at end of file).
+     */
+    size_t
+    CRingBlockReader::peek(void* pDest, size_t nBytes)
+    {
+        if ((bytesBuffered() < nBytes) && !m_eof) {
+            fill(bytesBuffered() + 1);
+        }
+        size_t n = bytesBuffered();
+        if (n > nBytes) n = nBytes;
+        memcpy(pDest, m_pBuffer + m_cursor, n);
+        return n;
+    }
+    /**
+     * bytesBuffered
+     *   @return size_t - number of bytes read from the fd but not yet
+     *                    handed out as items.
+     */
+    size_t
+    CRingBlockReader::bytesBuffered() const
+    {
+        return m_endData - m_cursor;
+    }
+    /**
+     * eof
+     *   @return bool - true if a read has returned end of file.  There may
+     *             still be buffered items.
+     */
+    bool
+    CRingBlockReader::eof() const
+    {
+        return m_eof;
+    }
+    /**
+     * setValidator
+     *   Check items before handing them out and resynchronize on bad ones.
+     *   @param pValidator - the checks to apply; nullptr turns checking off.
+     *              The caller owns this and it must live as long as it's set.
+     */
+    void
+    CRingBlockReader::setValidator(const CRingItemValidator* pValidator)
+    {
+        m_pValidator = pValidator;
+    }
+    /**
+     * getValidator
+     *   @return const CRingItemValidator* - the item checks (nullptr if none).
+     */
+    const CRingItemValidator*
+    CRingBlockReader::getValidator() const
+    {
+        return m_pValidator;
+    }
+    /**
+     * getConsumed
+     *   @return uint64_t - bytes handed out as items or skipped.  This is
+     *             the offset of the next item relative to where reading
+     *             started.
+     */
+    uint64_t
+    CRingBlockReader::getConsumed() const
+    {
+        return m_consumed;
+    }
+    /**
+     * getSkipped
+     *   @return const std::vector<SkippedRange>& - the byte ranges skipped
+     *             to resynchronize, in order.
+     */
+    const std::vector<CRingBlockReader::SkippedRange>&
+    CRingBlockReader::getSkipped() const
+    {
+        return m_skipped;
+    }
+    /**
+     * getSkippedBytes
+     *   @return uint64_t - total bytes skipped.
+     */
+    uint64_t
+    CRingBlockReader::getSkippedBytes() const
+    {
+        uint64_t result = 0;
+        for (auto& r : m_skipped) {
+            result += r.s_nBytes;
+        }
+        return result;
+    }
+    /**
+     * clearSkipped
+     *    Forget the skipped ranges (e.g. once they've been reported).
+     */
+    void
+    CRingBlockReader::clearSkipped()
+    {
+        m_skipped.clear();
+    }
+    /**
+     * setFilter
+     *   Only hand out the items a filter accepts.
+     *   @param pFilter - the filter; nullptr hands out all items.  The
+     *              caller owns this and it must live as long as it's set.
+     */
+    void
+    CRingBlockReader::setFilter(const CRingItemFilter* pFilter)
+    {
+        m_pFilter = pFilter;
+    }
+    /**
+     * getFilter
+     *   @return const CRingItemFilter* - the item filter (nullptr if none).
+     */
+    const CRingItemFilter*
+    CRingBlockReader::getFilter() const
+    {
+        return m_pFilter;
+    }
+    /**
+     * getFilteredCount
+     *   @return uint64_t - number of items the filter has rejected.
+     */
+    uint64_t
+    CRingBlockReader::getFilteredCount() const
+    {
+        return m_filtered;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Protected methods.
+
+    /**
+     * readBlock
+     *    Do a single read from the file descriptor.  Retriable errors are
+     *    retried.
+     * @param pDest - where to put the data.
+     * @param nBytes - most bytes to read.
+     * @return ssize_t - number of bytes read, 0 on end of file.
+     * @throw int - errno on non-retriable errors (as fmtio::readData does).
+     */
+    ssize_t
+    CRingBlockReader::readBlock(void* pDest, size_t nBytes)
+    {
+        ssize_t nRead;
+        do {
+            nRead = read(m_fd, pDest, nBytes);
+        } while ((nRead < 0) &&
+            ((errno == EINTR) || (errno == EAGAIN) || (errno == EWOULDBLOCK)));
+        if (nRead < 0) {
+            throw errno;
+        }
+        return nRead;
+    }
+    /**
+     * skipData
+     *    Skip over data that hasn't been read yet.  A seekable descriptor
+     *    is just moved past it; seeking past the end of file is noticed
+     *    by the next read.  Derived classes whose readBlock doesn't read
+     *    m_fd sequentially must override this.
+     * @param nBytes - number of bytes to skip.
+     * @return uint64_t - number of bytes skipped; fewer than nBytes if
+     *                the data ended.
+     * @throw int - errno on read errors.
+     */
+    uint64_t
+    CRingBlockReader::skipData(uint64_t nBytes)
+    {
+        if (m_seekable && (lseek(m_fd, nBytes, SEEK_CUR) >= 0)) {
+            return nBytes;
+        }
+        return discardData(nBytes);
+    }
+    /**
+     * exchangeBuffer
+     *    Derived readers that read into buffers of their own can hand one
+     *    over in place of m_pBuffer rather than having readBlock copy it.
+     *    The unconsumed bytes from m_cursor to m_endData must end up just
+     *    before the new data, with m_cursor and m_endData set to bound
+     *    them.  This default doesn't, so data are always read with readBlock.
+     * @return bool - true if the buffer was exchanged for one with more data.
+     */
+    bool
+    CRingBlockReader::exchangeBuffer()
+    {
+        return false;
+    }
+    /**
+     * discardData
+     *    Skip data by reading it into the (empty) buffer and throwing it
+     *    away.  This is skipData for sources that can't seek.
+     * @param nBytes - number of bytes to skip.
+     * @return uint64_t - number of bytes skipped; fewer than nBytes if
+     *                the data ended.
+     */
+    uint64_t
+    CRingBlockReader::discardData(uint64_t nBytes)
+    {
+        m_cursor  = 0;
+        m_endData = 0;
+        uint64_t result = 0;
+        while (result < nBytes) {
+            size_t n = std::min(uint64_t(m_bufferSize), nBytes - result);
+            ssize_t nRead = readBlock(m_pBuffer, n);
+            if (nRead == 0) {
+                m_eof = true;
+                break;
+            }
+            result += nRead;
+        }
+        return result;
+    }
+    /**
+     * fill
+     *    Ensure there are at least nBytes of contiguous unconsumed data
+     *    in the buffer starting at m_cursor.
+     * @param nBytes - Number of bytes needed.
+     * @return bool - false if the end of file was hit before that many
+     *                bytes were available.
+     */
+    bool
+    CRingBlockReader::fill(size_t nBytes)
+    {
+        while ((m_endData - m_cursor) < nBytes) {
+            if (m_eof) {
+                return false;
+            }
+            if (exchangeBuffer()) {
+                continue;
+            }
+            makeRoom(nBytes);
+            ssize_t nRead = readBlock(
+                m_pBuffer + m_endData, m_bufferSize - m_endData
+            );
+            if (nRead == 0) {
+                m_eof = true;
+            } else {
+                m_endData += nRead;
+            }
+        }
+        return true;
+    }
+    /**
+     * skipItem
+     *    Step over an item the filter rejected.  The buffered part of it is
+     *    dropped and the rest is skipped without being read if possible.
+     * @param size - size of the item at m_cursor.
+     * @return bool - false if the data ended within the item.
+     */
+    bool
+    CRingBlockReader::skipItem(uint32_t size)
+    {
+        size_t buffered = std::min(size_t(size), bytesBuffered());
+        m_cursor   += buffered;
+        m_consumed += buffered;
+        uint64_t remaining = size - buffered;
+        if (remaining) {
+            if (m_eof) {
+                return false;
+            }
+            uint64_t skipped = skipData(remaining);
+            m_consumed += skipped;
+            if (skipped < remaining) {
+                return false;
+            }
+        }
+        return true;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods
+
+    /**
+     * makeRoom
+     *    Ensures there's space after m_endData to read into and that
+     *    the buffer can hold nBytes starting at m_cursor.  The unconsumed
+     *    data is slid to the front of the buffer if needed and the buffer
+     *    is enlarged if a single item won't fit in it.
+     * @param nBytes - number of bytes needed beginning at m_cursor.
+     */
+    void
+    CRingBlockReader::makeRoom(size_t nBytes)
+    {
+        size_t unconsumed = m_endData - m_cursor;
+        if (unconsumed == 0) {                 // Cheap reset, nothing to slide.
+            m_cursor  = 0;
+            m_endData = 0;
+        }
+        if ((m_cursor + nBytes > m_bufferSize) || (m_endData == m_bufferSize)) {
+            memmove(m_pBuffer, m_pBuffer + m_cursor, unconsumed);
+            m_cursor  = 0;
+            m_endData = unconsumed;
+        }
+        if (nBytes > m_bufferSize) {
+            uint8_t* pNew = new uint8_t[nBytes];
+            memcpy(pNew, m_pBuffer, m_endData);
+            delete []m_pBuffer;
+            m_pBuffer    = pNew;
+            m_bufferSize = nBytes;
+        }
+    }
+    /**
+     * resync
+     *    Ensure the buffer starts with a complete, plausible item, skipping
+     *    over any bytes that aren't.  A skipped range is recorded.
+     * @return bool - false if the data ended before a plausible item.
+     */
+    bool
+    CRingBlockReader::resync()
+    {
+        size_t   need    = m_pValidator->headerBytes();
+        uint64_t start   = m_consumed;
+        uint64_t skipped = 0;
+        CRingItemValidator::Problem why = CRingItemValidator::ok;
+        bool     searching = false;
+        bool     result;
+        while (true) {
+            if (!fill(need)) {                 // Too little left for an item.
+                if (bytesBuffered() && !searching) {
+                    why = CRingItemValidator::truncated;
+                }
+                skipped    += bytesBuffered();
+                m_consumed += bytesBuffered();
+                m_cursor    = m_endData;
+                result = false;
+                break;
+            }
+            if (!searching) {
+                why = m_pValidator->check(m_pBuffer + m_cursor);
+                if (why == CRingItemValidator::ok) {
+                    uint32_t size = reinterpret_cast<RingItemHeader*>(
+                        m_pBuffer + m_cursor)->s_size;
+                    if (fill(size)) {
+                        result = true;
+                        break;
+                    }
+                    why = CRingItemValidator::truncated;
+                }
+                searching = true;
+            }
+            // Items resume where several plausible items follow
+            // each other:
+
+            size_t offset;
+            CRingItemValidator::SyncResult r = m_pValidator->findSync(
+                m_pBuffer + m_cursor, bytesBuffered(), m_eof, offset
+            );
+            m_cursor   += offset;
+            m_consumed += offset;
+            skipped    += offset;
+            if (r == CRingItemValidator::syncFound) {
+                result = true;
+                break;
+            }
+            if (!m_eof) {
+                fill(bytesBuffered() + m_blockSize);
+            }
+        }
+        if (skipped) {
+            SkippedRange range = {start, skipped, why};
+            m_skipped.push_back(range);
+        }
+        return result;
+    }
+}
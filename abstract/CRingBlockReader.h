@@ -0,0 +1,129 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingBlockReader.h
+ *  @brief: Block buffered reader of raw ring items from a file descriptor.
+ */
+#ifndef CRINGBLOCKREADER_H
+#define CRINGBLOCKREADER_H
+
+#include "CRingItemValidator.h"
+#include "CRingItemFilter.h"
+#include <unistd.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ufmt {
+    struct _RingItem;
+    typedef _RingItem RingItem, *pRingItem;
+
+    /**
+     * @class CRingBlockReader
+     *    Reads ring items from a file descriptor in large blocks rather
+     *    than with a header read and a body read per item.  Items are
+     *    handed out as pointers into the block buffer.  An item that
+     *    straddles the end of a block is carried over to the front of
+     *    the buffer before the next block is read.  If a single item is
+     *    larger than the block size, the buffer grows to hold it.
+     *
+     *    Reads are single read(2) calls that take whatever the source
+     *    has available, so pipes and sockets carrying live data do not
+     *    stall waiting for a full block.
+     *
+     *    If given a CRingItemValidator, the reader checks each item
+     *    header before handing the item out.  On an implausible header
+     *    (or an item truncated by the end of the data) it skips forward to
+     *    where plausible items resume (see CRingItemValidator::findSync)
+     *    and records the range of bytes it skipped.  Without a validator,
+     *    garbage sizes are believed and a truncated item looks like the
+     *    end of the data.
+     *
+     *    If given a CRingItemFilter, items the filter rejects are stepped
+     *    over without being handed out.  Only the header and body header
+     *    of a rejected item need be buffered; the rest of it is skipped
+     *    with skipData, which seeks past it when the descriptor is
+     *    seekable and reads and discards it otherwise.
+     *
+     *  @note without a validator the only format dependency is the leading
+     *        size word of each item, which is the same in all NSCLDAQ
+     *        versions.  Factories turn the raw items into the appropriate
+     *        CRingItem objects.
+     *  @note the file descriptor is owned by the caller.
+     */
+    class CRingBlockReader {
+    public:
+        static const size_t DEFAULT_BLOCK_SIZE = 1024*1024;
+
+        /** Bytes skipped to resynchronize. */
+        struct SkippedRange {
+            uint64_t s_offset;         // Relative to where reading started.
+            uint64_t s_nBytes;
+            CRingItemValidator::Problem s_problem;  // Why the first byte was skipped.
+        };
+    protected:
+        int      m_fd;
+        uint8_t* m_pBuffer;
+        size_t   m_bufferSize;         // Bytes allocated to m_pBuffer.
+        size_t   m_blockSize;          // Bytes we try to read at a time.
+        size_t   m_cursor;             // Offset of the first unconsumed byte.
+        size_t   m_endData;            // Offset just past the last valid byte.
+        bool     m_eof;
+        const CRingItemValidator* m_pValidator;
+        const CRingItemFilter*    m_pFilter;
+        bool     m_seekable;           // lseek works on m_fd.
+        uint64_t m_filtered;           // Items rejected by the filter.
+        uint64_t m_consumed;           // Bytes handed out or skipped.
+        std::vector<SkippedRange> m_skipped;
+    public:
+        CRingBlockReader(int fd, size_t blockSize = DEFAULT_BLOCK_SIZE);
+        virtual ~CRingBlockReader();
+    private:
+        CRingBlockReader(const CRingBlockReader& rhs);
+        CRingBlockReader& operator=(const CRingBlockReader& rhs);
+    public:
+        const RingItem* nextItem();
+        size_t peek(void* pDest, size_t nBytes);
+
+        int    getFd() const;
+        size_t getBlockSize() const;
+        size_t bytesBuffered() const;
+        bool   eof() const;
+
+        void     setValidator(const CRingItemValidator* pValidator);
+        const CRingItemValidator* getValidator() const;
+        uint64_t getConsumed() const;
+        const std::vector<SkippedRange>& getSkipped() const;
+        uint64_t getSkippedBytes() const;
+        void     clearSkipped();
+
+        void     setFilter(const CRingItemFilter* pFilter);
+        const CRingItemFilter* getFilter() const;
+        uint64_t getFilteredCount() const;
+    protected:
+        virtual ssize_t readBlock(void* pDest, size_t nBytes);
+        virtual uint64_t skipData(uint64_t nBytes);
+        virtual bool exchangeBuffer();
+        bool fill(size_t nBytes);
+        uint64_t discardData(uint64_t nBytes);
+        bool skipItem(uint32_t size);
+    private:
+        void makeRoom(size_t nBytes);
+        bool resync();
+    };
+}
+#endif
@@ -0,0 +1,226 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  CRingBlockWriter.cpp
+ *  @brief: Implement the buffered ring item writer.
+ */
+#include "CRingBlockWriter.h"
+#include "io.h"
+#include <string.h>
+#include <stdexcept>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param fd - file descriptor open on the ring item sink.
+     *   @param blockSize - size of the buffer; we write when it fills.
+     *   @param flushIntervalMs - if non zero, the longest time in
+     *                milliseconds data can stay in the buffer.
+     *   @throw std::invalid_argument - the block size is zero.
+     */
+    CRingBlockWriter::CRingBlockWriter(
+        int fd, size_t blockSize, unsigned flushIntervalMs
+    ) :
+        m_fd(fd), m_pBuffer(nullptr), m_blockSize(blockSize), m_nBytes(0),
+        m_flushInterval(flushIntervalMs), m_stopping(false)
+    {
+        if (m_blockSize == 0) {
+            throw std::invalid_argument(
+                "CRingBlockWriter block size must be non-zero"
+            );
+        }
+        m_pBuffer = new uint8_t[m_blockSize];
+        if (flushIntervalMs) {
+            m_flusher = std::thread(&CRingBlockWriter::flushThread, this);
+        }
+    }
+    /**
+     * destructor
+     *    Stop the flush thread and write anything that's left.
+     */
+    CRingBlockWriter::~CRingBlockWriter()
+    {
+        if (m_flusher.joinable()) {
+            {
+                std::lock_guard<std::mutex> s(m_lock);
+                m_stopping = true;
+            }
+            m_wakeup.notify_one();
+            m_flusher.join();
+        }
+        try {
+            std::lock_guard<std::mutex> s(m_lock);
+            flushLocked();
+        }
+        catch (...) {}                  // Can't throw from a destructor.
+        delete []m_pBuffer;
+    }
+
+    /**
+     * put
+     *    Add data (normally a ring item) to the buffer.  If it won't fit,
+     *    the buffer is written first.  If it's bigger than the buffer
+     *    it's written directly.
+     *  @param pData - the data.
+     *  @param nBytes - how much there is.
+     *  @throw int errno - errors from fmtio::writeData (from this or an earlier
+     *         background flush).
+     */
+    void
+    CRingBlockWriter::put(const void* pData, size_t nBytes)
+    {
+        std::lock_guard<std::mutex> s(m_lock);
+        throwFlusherError();
+        if (nBytes > m_blockSize - m_nBytes) {
+            flushLocked();
+            if (nBytes >= m_blockSize) {
+                writeBlock(pData, nBytes);
+                return;
+            }
+        }
+        if (m_nBytes == 0) {
+            m_oldest = std::chrono::steady_clock::now();
+        }
+        memcpy(m_pBuffer + m_nBytes, pData, nBytes);
+        m_nBytes += nBytes;
+    }
+    /**
+     * flush
+     *    Write any buffered data.
+     *  @throw int errno - errors from fmtio::writeData.
+     */
+    void
+    CRingBlockWriter::flush()
+    {
+        std::lock_guard<std::mutex> s(m_lock);
+        throwFlusherError();
+        flushLocked();
+    }
+    /**
+     * getFd
+     *  @return int - the file descriptor we write.
+     */
+    int
+    CRingBlockWriter::getFd() const
+    {
+        return m_fd;
+    }
+    /**
+     * getBlockSize
+     *  @return size_t - size of the buffer.
+     */
+    size_t
+    CRingBlockWriter::getBlockSize() const
+    {
+        return m_blockSize;
+    }
+    /**
+     * bytesBuffered
+     *  @return size_t - number of bytes waiting to be written.
+     */
+    size_t
+    CRingBlockWriter::bytesBuffered()
+    {
+        std::lock_guard<std::mutex> s(m_lock);
+        return m_nBytes;
+    }
+    /**
+     * getFlushInterval
+     *  @return unsigned - milliseconds data can be buffered (0 no limit).
+     */
+    unsigned
+    CRingBlockWriter::getFlushInterval() const
+    {
+        return m_flushInterval.count();
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Protected methods:
+
+    /**
+     * writeBlock
+     *    Write data to the file descriptor.  This is virtual so that tests
+     *    can see the writes.
+     *  @param pData - data to write.
+     *  @param nBytes - number of bytes to write.
+     */
+    void
+    CRingBlockWriter::writeBlock(const void* pData, size_t nBytes)
+    {
+        fmtio::writeData(m_fd, pData, nBytes);
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods:
+
+    /**
+     * flushLocked
+     *    Write the buffer.  The caller holds m_lock.
+     */
+    void
+    CRingBlockWriter::flushLocked()
+    {
+        if (m_nBytes) {
+            size_t n = m_nBytes;
+            m_nBytes = 0;                // Don't rewrite on error.
+            writeBlock(m_pBuffer, n);
+        }
+    }
+    /**
+     * throwFlusherError
+     *    Rethrow (once) an error the flush thread had writing.
+     *    The caller holds m_lock.
+     */
+    void
+    CRingBlockWriter::throwFlusherError()
+    {
+        if (m_flusherError) {
+            std::exception_ptr e = m_flusherError;
+            m_flusherError = nullptr;
+            std::rethrow_exception(e);
+        }
+    }
+    /**
+     * flushThread
+     *    Runs while there's a flush interval.  Wakes up periodically
+     *    and writes the buffer if its oldest data is at least the flush
+     *    interval old.
+     */
+    void
+    CRingBlockWriter::flushThread()
+    {
+        std::unique_lock<std::mutex> s(m_lock);
+        while (!m_stopping) {
+            std::chrono::milliseconds wait = m_flushInterval;
+            if (m_nBytes) {
+                auto age = std::chrono::steady_clock::now() - m_oldest;
+                if (age >= m_flushInterval) {
+                    try {
+                        flushLocked();
+                    }
+                    catch (...) {
+                        m_flusherError = std::current_exception();
+                    }
+                } else {
+                    wait = std::chrono::duration_cast<std::chrono::milliseconds>(
+                        m_flushInterval - age
+                    ) + std::chrono::milliseconds(1);
+                }
+            }
+            m_wakeup.wait_for(s, wait);
+        }
+    }
+}
@@ -0,0 +1,93 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  CRingBlockWriter.h
+ *  @brief: Buffered writer that coalesces ring items into large writes.
+ */
+#ifndef CRINGBLOCKWRITER_H
+#define CRINGBLOCKWRITER_H
+
+#include <unistd.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+
+namespace ufmt {
+    /**
+     * @class CRingBlockWriter
+     *    The output counterpart of CRingBlockReader.  Ring items put to
+     *    the writer are copied into a block buffer which is written with a
+     *    single write when it fills or on flush(), rather than doing a
+     *    write per item.  Data larger than the block is written directly.
+     *
+     *    If a flush interval is given, a background thread bounds the time
+     *    data can sit in the buffer: data that's been buffered for the flush
+     *    interval is written even if no more items arrive.  This keeps
+     *    latency bounded for sparse live data.  Errors writing from that
+     *    thread are rethrown by the next put or flush.
+     *
+     *    Anything still buffered is written on destruction (errors are
+     *    then ignored; call flush first if they matter).
+     *
+     *  @note the file descriptor is owned by the caller.
+     */
+    class CRingBlockWriter {
+    public:
+        static const size_t DEFAULT_BLOCK_SIZE = 1024*1024;
+    protected:
+        int      m_fd;
+        uint8_t* m_pBuffer;
+        size_t   m_blockSize;
+        size_t   m_nBytes;                 // Bytes buffered.
+        std::chrono::milliseconds             m_flushInterval;  // 0 - none.
+        std::chrono::steady_clock::time_point m_oldest;  // When m_nBytes went non-zero.
+        std::mutex                  m_lock;
+        std::condition_variable     m_wakeup;
+        std::thread                 m_flusher;
+        bool                        m_stopping;
+        std::exception_ptr          m_flusherError;
+    public:
+        CRingBlockWriter(
+            int fd, size_t blockSize = DEFAULT_BLOCK_SIZE,
+            unsigned flushIntervalMs = 0
+        );
+        virtual ~CRingBlockWriter();
+    private:
+        CRingBlockWriter(const CRingBlockWriter& rhs);
+        CRingBlockWriter& operator=(const CRingBlockWriter& rhs);
+    public:
+        void put(const void* pData, size_t nBytes);
+        void flush();
+
+        int      getFd() const;
+        size_t   getBlockSize() const;
+        size_t   bytesBuffered();
+        unsigned getFlushInterval() const;
+    protected:
+        virtual void writeBlock(const void* pData, size_t nBytes);
+    private:
+        void flushLocked();
+        void throwFlusherError();
+        void flushThread();
+    };
+}
+#endif
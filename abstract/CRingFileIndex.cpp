@@ -0,0 +1,515 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingFileIndex.cpp
+ *  @brief: Implement the sidecar event file index.
+ */
+#include "CRingFileIndex.h"
+#include "CRingBlockReader.h"
+#include "CRingItemView.h"
+#include "DataFormat.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace ufmt {
+    static const char MAGIC[8] = {'U', 'F', 'M', 'T', 'I', 'D', 'X', '1'};
+
+    /**
+     * constructor
+     *    Makes an empty index; use build or read to fill it in.
+     */
+    CRingFileIndex::CRingFileIndex() :
+        m_version(FormatSelector::v12), m_stride(DEFAULT_STRIDE),
+        m_fileSize(0), m_fileMtime(0), m_fileMtimeNs(0), m_itemCount(0)
+    {}
+    /**
+     * build
+     *    Read an event file from the beginning and index it.
+     *  @param fd - file descriptor open on the event file.  On return it's
+     *              positioned at the end of the last complete item.
+     *  @param version - format of the file (needed to find body headers).
+     *  @param stride  - items per block.
+     *  @throw std::invalid_argument - stride is zero.
+     *  @throw std::system_error - the file can't be stat-ed or positioned.
+     *  @throw int - errno on read errors.
+     *  @throw std::runtime_error - an item is too small to be one.
+     */
+    void
+    CRingFileIndex::build(
+        int fd, FormatSelector::SupportedVersions version, unsigned stride
+    )
+    {
+        if (stride == 0) {
+            throw std::invalid_argument("CRingFileIndex stride must be non-zero");
+        }
+        statFile(fd, m_fileSize, m_fileMtime, m_fileMtimeNs);
+        if (lseek(fd, 0, SEEK_SET) < 0) {
+            throw std::system_error(
+                errno, std::generic_category(), "CRingFileIndex rewinding file"
+            );
+        }
+        m_version   = version;
+        m_stride    = stride;
+        m_itemCount = 0;
+        m_blocks.clear();
+
+        CRingBlockReader reader(fd);
+        uint64_t offset  = 0;
+        uint64_t physics = 0;
+        const size_t minWithBodyHeader = sizeof(RingItemHeader) + sizeof(BodyHeader);
+        while (const RingItem* pItem = reader.nextItem()) {
+            if ((m_itemCount % m_stride) == 0) {
+                Block b;
+                b.s_offset        = offset;
+                b.s_firstItem     = m_itemCount;
+                b.s_physicsBefore = physics;
+                b.s_minTimestamp  = NO_TIMESTAMP;
+                b.s_maxTimestamp  = NO_TIMESTAMP;
+                b.s_itemCount     = 0;
+                m_blocks.push_back(b);
+            }
+            Block& b = m_blocks.back();
+            CRingItemView item(pItem, version);
+            uint32_t type = item.type();
+            b.s_itemCount++;
+            b.s_typeCounts[type]++;
+            if (type == PHYSICS_EVENT) physics++;
+
+            if ((item.size() >= minWithBodyHeader) && item.hasBodyHeader()) {
+                uint64_t ts = item.getEventTimestamp();
+                if (ts != NO_TIMESTAMP) {
+                    if ((b.s_minTimestamp == NO_TIMESTAMP) || (ts < b.s_minTimestamp)) {
+                        b.s_minTimestamp = ts;
+                    }
+                    if ((b.s_maxTimestamp == NO_TIMESTAMP) || (ts > b.s_maxTimestamp)) {
+                        b.s_maxTimestamp = ts;
+                    }
+                }
+            }
+            offset += item.size();
+            m_itemCount++;
+        }
+        indexTimestamps();
+        lseek(fd, offset, SEEK_SET);
+    }
+    /**
+     * build
+     *    Index an event file given its name.
+     *  @param eventFile - path to the file.
+     *  @param version, stride - see above.
+     *  @throw std::system_error - the file can't be opened.
+     */
+    void
+    CRingFileIndex::build(
+        const std::string& eventFile, FormatSelector::SupportedVersions version,
+        unsigned stride
+    )
+    {
+        int fd = open(eventFile.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(
+                errno, std::generic_category(), "CRingFileIndex opening event file"
+            );
+        }
+        try {
+            build(fd, version, stride);
+        }
+        catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+    }
+    /**
+     * write
+     *    Write the index to a sidecar file.
+     *  @param indexFile - path of the sidecar (see indexPath).
+     *  @throw std::runtime_error - the file can't be written.
+     */
+    void
+    CRingFileIndex::write(const std::string& indexFile) const
+    {
+        std::ofstream out(indexFile.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error(
+                std::string("CRingFileIndex unable to create ") + indexFile
+            );
+        }
+        FileHeader h;
+        memset(&h, 0, sizeof(h));
+        memcpy(h.s_magic, MAGIC, sizeof(MAGIC));
+        h.s_format      = m_version;
+        h.s_stride      = m_stride;
+        h.s_fileSize    = m_fileSize;
+        h.s_fileMtime   = m_fileMtime;
+        h.s_fileMtimeNs = m_fileMtimeNs;
+        h.s_itemCount   = m_itemCount;
+        h.s_blockCount  = m_blocks.size();
+        out.write(reinterpret_cast<const char*>(&h), sizeof(h));
+
+        for (auto& b : m_blocks) {
+            BlockHeader bh;
+            memset(&bh, 0, sizeof(bh));
+            bh.s_offset        = b.s_offset;
+            bh.s_firstItem     = b.s_firstItem;
+            bh.s_physicsBefore = b.s_physicsBefore;
+            bh.s_minTimestamp  = b.s_minTimestamp;
+            bh.s_maxTimestamp  = b.s_maxTimestamp;
+            bh.s_itemCount     = b.s_itemCount;
+            bh.s_typeCount     = b.s_typeCounts.size();
+            out.write(reinterpret_cast<const char*>(&bh), sizeof(bh));
+            for (auto& t : b.s_typeCounts) {
+                TypeCount tc = {t.first, t.second};
+                out.write(reinterpret_cast<const char*>(&tc), sizeof(tc));
+            }
+        }
+        out.close();
+        if (!out) {
+            throw std::runtime_error(
+                std::string("CRingFileIndex failed writing ") + indexFile
+            );
+        }
+    }
+    /**
+     * read
+     *    Replace the index with one read from a sidecar file.
+     *  @param indexFile - path of the sidecar.
+     *  @throw std::runtime_error - the file can't be read, isn't an index or
+     *         its blocks don't agree with its item count and file size.
+     */
+    void
+    CRingFileIndex::read(const std::string& indexFile)
+    {
+        std::ifstream in(indexFile.c_str(), std::ios::binary);
+        if (!in) {
+            throw std::runtime_error(
+                std::string("CRingFileIndex unable to open ") + indexFile
+            );
+        }
+        FileHeader h;
+        in.read(reinterpret_cast<char*>(&h), sizeof(h));
+        if (!in || memcmp(h.s_magic, MAGIC, sizeof(MAGIC))) {
+            throw std::runtime_error(indexFile + " is not a ring item file index");
+        }
+        // Every item has at least a header and every block but the last
+        // holds stride items:
+
+        if ((h.s_stride == 0) ||
+            (h.s_itemCount > h.s_fileSize / sizeof(RingItemHeader)) ||
+            (h.s_blockCount != (h.s_itemCount + h.s_stride - 1) / h.s_stride)) {
+            throw std::runtime_error(indexFile + " has an inconsistent header");
+        }
+        std::vector<Block> blocks;
+        for (uint64_t i = 0; i < h.s_blockCount; i++) {
+            BlockHeader bh;
+            in.read(reinterpret_cast<char*>(&bh), sizeof(bh));
+            Block b;
+            b.s_offset        = bh.s_offset;
+            b.s_firstItem     = bh.s_firstItem;
+            b.s_physicsBefore = bh.s_physicsBefore;
+            b.s_minTimestamp  = bh.s_minTimestamp;
+            b.s_maxTimestamp  = bh.s_maxTimestamp;
+            b.s_itemCount     = bh.s_itemCount;
+            for (uint32_t t = 0; in && (t < bh.s_typeCount); t++) {
+                TypeCount tc;
+                in.read(reinterpret_cast<char*>(&tc), sizeof(tc));
+                b.s_typeCounts[tc.s_type] = tc.s_count;
+            }
+            if (!in) {
+                throw std::runtime_error(indexFile + " is truncated");
+            }
+            uint64_t first = i * h.s_stride;
+            uint64_t count = std::min<uint64_t>(h.s_stride, h.s_itemCount - first);
+            if ((b.s_firstItem != first) || (b.s_itemCount != count) ||
+                (b.s_offset >= h.s_fileSize) ||
+                (i && (b.s_offset <= blocks.back().s_offset))) {
+                throw std::runtime_error(
+                    indexFile + " has blocks that don't fit the event file"
+                );
+            }
+            blocks.push_back(b);
+        }
+        m_version     = FormatSelector::SupportedVersions(h.s_format);
+        m_stride      = h.s_stride;
+        m_fileSize    = h.s_fileSize;
+        m_fileMtime   = h.s_fileMtime;
+        m_fileMtimeNs = h.s_fileMtimeNs;
+        m_itemCount   = h.s_itemCount;
+        m_blocks.swap(blocks);
+        indexTimestamps();
+    }
+    /**
+     * isCurrent
+     *   @param eventFile - path to the event file the index is for.
+     *   @return bool - true if the file's size and modification time are
+     *                  what they were when the index was built.
+     */
+    bool
+    CRingFileIndex::isCurrent(const std::string& eventFile) const
+    {
+        int fd = open(eventFile.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        uint64_t size;
+        int64_t  mtime, mtimeNs;
+        try {
+            statFile(fd, size, mtime, mtimeNs);
+        }
+        catch (...) {
+            close(fd);
+            return false;
+        }
+        close(fd);
+        return (size == m_fileSize) && (mtime == m_fileMtime) &&
+            (mtimeNs == m_fileMtimeNs);
+    }
+    /**
+     * indexPath
+     *   @param eventFile - path to an event file.
+     *   @return std::string - conventional path of its sidecar index.
+     */
+    std::string
+    CRingFileIndex::indexPath(const std::string& eventFile)
+    {
+        return eventFile + ".idx";
+    }
+    /**
+     * findItem
+     *   @param fd - file descriptor open on the indexed file.
+     *   @param n  - item number (from 0).
+     *   @param[out] offset - file offset of the item.
+     *   @return bool - false if there's no such item.
+     *   @throw std::runtime_error - the file is shorter than the index says.
+     */
+    bool
+    CRingFileIndex::findItem(int fd, uint64_t n, uint64_t& offset) const
+    {
+        if (n >= m_itemCount) return false;
+        const Block& b = m_blocks[n / m_stride];
+        offset = b.s_offset;
+        uint32_t type;
+        for (uint64_t i = b.s_firstItem; i < n; i++) {
+            offset += readHeader(fd, offset, type);
+        }
+        return true;
+    }
+    /**
+     * findPhysicsEvent
+     *   @param fd - file descriptor open on the indexed file.
+     *   @param n  - physics event number (from 0).
+     *   @param[out] offset - file offset of that PHYSICS_EVENT item.
+     *   @return bool - false if there's no such event.
+     */
+    bool
+    CRingFileIndex::findPhysicsEvent(int fd, uint64_t n, uint64_t& offset) const
+    {
+        // First block whose physics events extend past n:
+
+        auto p = std::upper_bound(
+            m_blocks.begin(), m_blocks.end(), n,
+            [](uint64_t n, const Block& b) { return n < b.s_physicsBefore; }
+        );
+        if (p == m_blocks.begin()) return false;
+        const Block& b = *(p - 1);
+        auto c = b.s_typeCounts.find(PHYSICS_EVENT);
+        if ((c == b.s_typeCounts.end()) || (n >= b.s_physicsBefore + c->second)) {
+            return false;
+        }
+        offset = b.s_offset;
+        uint64_t physics = b.s_physicsBefore;
+        for (uint32_t i = 0; i < b.s_itemCount; i++) {
+            uint32_t type;
+            uint32_t size = readHeader(fd, offset, type);
+            if (type == PHYSICS_EVENT) {
+                if (physics == n) return true;
+                physics++;
+            }
+            offset += size;
+        }
+        return false;                 // Index and file disagree.
+    }
+    /**
+     * findTimestamp
+     *   @param fd - file descriptor open on the indexed file.
+     *   @param timestamp - a body header timestamp.
+     *   @param[out] offset - file offset of the first item whose body header
+     *                timestamp is at least timestamp.
+     *   @return bool - false if there's no such item.
+     */
+    bool
+    CRingFileIndex::findTimestamp(int fd, uint64_t timestamp, uint64_t& offset) const
+    {
+        // Blocks before the first whose running maximum reaches timestamp
+        // can't hold the item:
+
+        auto p = std::lower_bound(m_latest.begin(), m_latest.end(), timestamp);
+        for (auto b = m_blocks.begin() + (p - m_latest.begin()); b != m_blocks.end(); b++) {
+            if ((b->s_maxTimestamp == NO_TIMESTAMP) || (b->s_maxTimestamp < timestamp)) {
+                continue;
+            }
+            offset = b->s_offset;
+            for (uint32_t i = 0; i < b->s_itemCount; i++) {
+                uint64_t ts;
+                if (readTimestamp(fd, offset, ts) && (ts >= timestamp)) {
+                    return true;
+                }
+                uint32_t type;
+                offset += readHeader(fd, offset, type);
+            }
+        }
+        return false;
+    }
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - format of the indexed file.
+     */
+    FormatSelector::SupportedVersions
+    CRingFileIndex::getVersion() const
+    {
+        return m_version;
+    }
+    /**
+     * getStride
+     *   @return unsigned - items per block.
+     */
+    unsigned
+    CRingFileIndex::getStride() const
+    {
+        return m_stride;
+    }
+    /**
+     * getItemCount
+     *   @return uint64_t - number of items in the file.
+     */
+    uint64_t
+    CRingFileIndex::getItemCount() const
+    {
+        return m_itemCount;
+    }
+    /**
+     * getTypeCount
+     *   @param type - a ring item type.
+     *   @return uint64_t - number of items of that type in the file.
+     */
+    uint64_t
+    CRingFileIndex::getTypeCount(uint32_t type) const
+    {
+        uint64_t result = 0;
+        for (auto& b : m_blocks) {
+            auto p = b.s_typeCounts.find(type);
+            if (p != b.s_typeCounts.end()) result += p->second;
+        }
+        return result;
+    }
+    /**
+     * getBlocks
+     *   @return const std::vector<Block>& - the blocks of the index.
+     */
+    const std::vector<CRingFileIndex::Block>&
+    CRingFileIndex::getBlocks() const
+    {
+        return m_blocks;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods:
+
+    /**
+     * readHeader
+     *   @param fd - file descriptor.
+     *   @param offset - offset of an item.
+     *   @param[out] type - the item's type.
+     *   @return uint32_t - the item's size.
+     *   @throw std::runtime_error - no complete header or a bad size.
+     */
+    uint32_t
+    CRingFileIndex::readHeader(int fd, uint64_t offset, uint32_t& type) const
+    {
+        RingItemHeader h;
+        if (pread(fd, &h, sizeof(h), offset) != ssize_t(sizeof(h))) {
+            throw std::runtime_error(
+                "CRingFileIndex: event file is shorter than its index"
+            );
+        }
+        if (h.s_size < sizeof(h)) {
+            throw std::runtime_error("CRingFileIndex: bad ring item size");
+        }
+        type = h.s_type;
+        return h.s_size;
+    }
+    /**
+     * readTimestamp
+     *   @param fd - file descriptor.
+     *   @param offset - offset of an item.
+     *   @param[out] timestamp - body header timestamp of the item.
+     *   @return bool - false if the item has no timestamp.
+     */
+    bool
+    CRingFileIndex::readTimestamp(int fd, uint64_t offset, uint64_t& timestamp) const
+    {
+        uint8_t buffer[sizeof(RingItemHeader) + sizeof(BodyHeader)];
+        memset(buffer, 0, sizeof(buffer));
+        ssize_t n = pread(fd, buffer, sizeof(buffer), offset);
+        CRingItemView item(buffer, m_version);
+        if ((n < ssize_t(sizeof(buffer))) || (item.size() < sizeof(buffer)) ||
+            !item.hasBodyHeader()) {
+            return false;
+        }
+        timestamp = item.getEventTimestamp();
+        return timestamp != NO_TIMESTAMP;
+    }
+    /**
+     * indexTimestamps
+     *    Compute the largest timestamp in each block and the ones before
+     *    it.  These never decrease so findTimestamp can binary search them
+     *    even when the blocks' own ranges overlap.
+     */
+    void
+    CRingFileIndex::indexTimestamps()
+    {
+        m_latest.clear();
+        uint64_t latest = 0;
+        for (auto& b : m_blocks) {
+            if ((b.s_maxTimestamp != NO_TIMESTAMP) && (b.s_maxTimestamp > latest)) {
+                latest = b.s_maxTimestamp;
+            }
+            m_latest.push_back(latest);
+        }
+    }
+    /**
+     * statFile
+     *    Get the size and modification time of a file.
+     */
+    void
+    CRingFileIndex::statFile(int fd, uint64_t& size, int64_t& mtime, int64_t& mtimeNs)
+    {
+        struct stat info;
+        if (fstat(fd, &info)) {
+            throw std::system_error(
+                errno, std::generic_category(), "CRingFileIndex stat-ing file"
+            );
+        }
+        size    = info.st_size;
+        mtime   = info.st_mtim.tv_sec;
+        mtimeNs = info.st_mtim.tv_nsec;
+    }
+}
@@ -0,0 +1,147 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingFileIndex.h
+ *  @brief: Sidecar index for random access into event files.
+ */
+#ifndef CRINGFILEINDEX_H
+#define CRINGFILEINDEX_H
+
+#include <NSCLDAQFormatFactorySelector.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace ufmt {
+    /**
+     * @class CRingFileIndex
+     *    An index of an event file built by reading it once.  The file is
+     *    divided into blocks of stride items.  For each block the index
+     *    holds the file offset of its first item, the counts of each item
+     *    type in it and the smallest and largest body header timestamps in
+     *    it.  With that the offset of the Nth item, the Nth physics event
+     *    or the first item with a timestamp at or after some time is
+     *    found by looking up its block and then stepping over at most
+     *    stride-1 item headers (read with pread) - no items are read or
+     *    allocated.
+     *
+     *    Indices are written to a sidecar file (by convention the event
+     *    file name with ".idx" appended, see indexPath).  The sidecar
+     *    records the size and modification time of the event file so
+     *    stale indices can be detected (isCurrent).
+     *
+     *    Sidecar layout (native byte order):
+     *    - FileHeader
+     *    - s_blockCount times: BlockHeader followed by s_typeCount
+     *      TypeCount records.
+     *
+     *  @note timestamps are min/max rather than first/last so that
+     *        findTimestamp is exact even when merged data are not
+     *        perfectly time ordered.
+     */
+    class CRingFileIndex {
+    public:
+        static const unsigned DEFAULT_STRIDE = 1024;
+        static const uint64_t NO_TIMESTAMP   = UINT64_C(0xffffffffffffffff);
+
+        /** What's known about a block of stride items. */
+        struct Block {
+            uint64_t s_offset;           // File offset of the first item.
+            uint64_t s_firstItem;        // Item number of the first item.
+            uint64_t s_physicsBefore;    // Physics events in earlier blocks.
+            uint64_t s_minTimestamp;     // NO_TIMESTAMP if none in the block.
+            uint64_t s_maxTimestamp;
+            uint32_t s_itemCount;
+            std::map<uint32_t, uint32_t> s_typeCounts;  // type -> count.
+        };
+    private:
+        // On disk structures:
+
+        struct FileHeader {
+            char     s_magic[8];
+            uint32_t s_format;           // FormatSelector::SupportedVersions
+            uint32_t s_stride;
+            uint64_t s_fileSize;
+            int64_t  s_fileMtime;        // seconds.
+            int64_t  s_fileMtimeNs;
+            uint64_t s_itemCount;
+            uint64_t s_blockCount;
+        };
+        struct BlockHeader {
+            uint64_t s_offset;
+            uint64_t s_firstItem;
+            uint64_t s_physicsBefore;
+            uint64_t s_minTimestamp;
+            uint64_t s_maxTimestamp;
+            uint32_t s_itemCount;
+            uint32_t s_typeCount;
+        };
+        struct TypeCount {
+            uint32_t s_type;
+            uint32_t s_count;
+        };
+    private:
+        FormatSelector::SupportedVersions m_version;
+        unsigned           m_stride;
+        uint64_t           m_fileSize;
+        int64_t            m_fileMtime;
+        int64_t            m_fileMtimeNs;
+        uint64_t           m_itemCount;
+        std::vector<Block> m_blocks;
+        std::vector<uint64_t> m_latest;  // Largest timestamp up to each block.
+    public:
+        CRingFileIndex();
+
+        void build(
+            int fd, FormatSelector::SupportedVersions version,
+            unsigned stride = DEFAULT_STRIDE
+        );
+        void build(
+            const std::string& eventFile,
+            FormatSelector::SupportedVersions version,
+            unsigned stride = DEFAULT_STRIDE
+        );
+        void write(const std::string& indexFile) const;
+        void read(const std::string& indexFile);
+        bool isCurrent(const std::string& eventFile) const;
+        static std::string indexPath(const std::string& eventFile);
+
+        // Lookups.  fd must be open on the indexed file; only pread is
+        // used so its file position is not changed:
+
+        bool findItem(int fd, uint64_t n, uint64_t& offset) const;
+        bool findPhysicsEvent(int fd, uint64_t n, uint64_t& offset) const;
+        bool findTimestamp(int fd, uint64_t timestamp, uint64_t& offset) const;
+
+        // Selectors:
+
+        FormatSelector::SupportedVersions getVersion() const;
+        unsigned getStride() const;
+        uint64_t getItemCount() const;
+        uint64_t getTypeCount(uint32_t type) const;
+        const std::vector<Block>& getBlocks() const;
+    private:
+        uint32_t readHeader(int fd, uint64_t offset, uint32_t& type) const;
+        bool     readTimestamp(int fd, uint64_t offset, uint64_t& timestamp) const;
+        void     indexTimestamps();
+        static void statFile(int fd, uint64_t& size, int64_t& mtime, int64_t& mtimeNs);
+    };
+}
+#endif
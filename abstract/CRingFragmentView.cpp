@@ -0,0 +1,101 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingFragmentView.cpp
+ *  @brief: Implement the in place fragment item view.
+ */
+#include "CRingFragmentView.h"
+#include <typeinfo>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param item - view of the item to interpret as a fragment.
+     *   @param decoder - decoder for the item's format.
+     *   @throw std::bad_cast - the item is not a fragment or is too small
+     *                 to hold the fragment header.
+     */
+    CRingFragmentView::CRingFragmentView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    ) :
+        CRingItemView(item)
+    {
+        if (item.isNull() || !decoder.decodeFragment(item, m_info)) {
+            throw std::bad_cast();
+        }
+    }
+    /**
+     * canView
+     *   @param item - a ring item view.
+     *   @param decoder - decoder for the item's format.
+     *   @return bool - true if the item is a fragment with a complete
+     *                  fragment header.
+     */
+    bool
+    CRingFragmentView::canView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    )
+    {
+        RingViewDecoderBase::FragmentInfo info;
+        return !item.isNull() && decoder.decodeFragment(item, info);
+    }
+    /**
+     * timestamp
+     *   @return uint64_t - the fragment's event builder timestamp.
+     */
+    uint64_t
+    CRingFragmentView::timestamp() const
+    {
+        return m_info.s_timestamp;
+    }
+    /**
+     * source
+     *   @return uint32_t - the fragment's source id.
+     */
+    uint32_t
+    CRingFragmentView::source() const
+    {
+        return m_info.s_sourceId;
+    }
+    /**
+     * payloadSize
+     *   @return size_t - number of bytes of payload.
+     */
+    size_t
+    CRingFragmentView::payloadSize() const
+    {
+        return m_info.s_payloadSize;
+    }
+    /**
+     * payloadPointer
+     *   @return const void* - pointer to the payload.
+     */
+    const void*
+    CRingFragmentView::payloadPointer() const
+    {
+        return m_info.s_pPayload;
+    }
+    /**
+     * barrierType
+     *   @return uint32_t - the fragment's barrier type (0 if not a barrier).
+     */
+    uint32_t
+    CRingFragmentView::barrierType() const
+    {
+        return m_info.s_barrier;
+    }
+}
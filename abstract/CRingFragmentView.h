@@ -0,0 +1,54 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingFragmentView.h
+ *  @brief: Read-only view of an event builder fragment item in place.
+ */
+#ifndef CRINGFRAGMENTVIEW_H
+#define CRINGFRAGMENTVIEW_H
+
+#include "CRingItemView.h"
+#include "RingViewDecoderBase.h"
+
+namespace ufmt {
+    /**
+     * @class CRingFragmentView
+     *    Provides the selectors of CRingFragmentItem directly on the
+     *    storage of an EVB_FRAGMENT or EVB_UNKNOWN_PAYLOAD item.  In v10
+     *    the fragment header is part of the item body; in v11 and v12 it
+     *    is the body header.
+     */
+    class CRingFragmentView : public CRingItemView {
+    private:
+        RingViewDecoderBase::FragmentInfo m_info;
+    public:
+        CRingFragmentView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        static bool canView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        uint64_t    timestamp() const;
+        uint32_t    source() const;
+        size_t      payloadSize() const;
+        const void* payloadPointer() const;
+        uint32_t    barrierType() const;
+    };
+}
+#endif
@@ -0,0 +1,375 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHeaderColumns.cpp
+ *  @brief: Implement header field extraction into columns.
+ */
+#include "CRingHeaderColumns.h"
+#include "DataFormat.h"
+#include "fragment.h"
+#include <algorithm>
+#include <stdexcept>
+#include <string.h>
+
+namespace ufmt {
+    // Offsets of the fields we extract relative to the start of an item:
+
+    static const size_t BH_SIZE_OFFSET      = sizeof(RingItemHeader);
+    static const size_t BH_TIMESTAMP_OFFSET = BH_SIZE_OFFSET + sizeof(uint32_t);
+    static const size_t BH_SOURCE_OFFSET    = BH_TIMESTAMP_OFFSET + sizeof(uint64_t);
+    static const size_t BH_BARRIER_OFFSET   = BH_SOURCE_OFFSET + sizeof(uint32_t);
+    static const size_t WITH_BODY_HEADER    = sizeof(RingItemHeader) + sizeof(BodyHeader);
+
+    // Unaligned loads:
+
+    static inline uint32_t
+    get32(const uint8_t* p)
+    {
+        uint32_t result;
+        memcpy(&result, p, sizeof(result));
+        return result;
+    }
+    static inline uint64_t
+    get64(const uint8_t* p)
+    {
+        uint64_t result;
+        memcpy(&result, p, sizeof(result));
+        return result;
+    }
+    /**
+     * hasBodyHeader
+     *   @param p - an item.
+     *   @param size - its size.
+     *   @return bool - true if it has a body header.  Body headers may be
+     *                followed by extension data counted in their size.
+     */
+    static inline bool
+    hasBodyHeader(const uint8_t* p, uint32_t size)
+    {
+        return (size >= WITH_BODY_HEADER) &&
+            (get32(p + BH_SIZE_OFFSET) > sizeof(uint32_t));
+    }
+
+    /**
+     * extract
+     *    Add the headers of the complete items in a buffer.
+     * @param pData - first item.
+     * @param nBytes - bytes in the buffer.
+     * @param baseOffset - offset of the buffer (e.g. in its file); item
+     *               offsets are relative to this.
+     * @return size_t - bytes of complete items.  An item cut off by the end
+     *               of the buffer is not extracted; a caller reading blocks
+     *               should start the next block with it.
+     * @throw std::runtime_error - an item size is smaller than a header.
+     */
+    size_t
+    CRingHeaderColumns::extract(const void* pData, size_t nBytes, uint64_t baseOffset)
+    {
+        const uint8_t* pBegin = reinterpret_cast<const uint8_t*>(pData);
+
+        // Locate the items; this is inherently serial:
+
+        m_items.clear();
+        size_t pos = 0;
+        while (nBytes - pos >= sizeof(RingItemHeader)) {
+            uint32_t size = get32(pBegin + pos);
+            if (size < sizeof(RingItemHeader)) {
+                throw std::runtime_error(
+                    "CRingHeaderColumns::extract - item size is smaller than a ring item header"
+                );
+            }
+            if (size > nBytes - pos) break;
+            m_items.push_back(pBegin + pos);
+            pos += size;
+        }
+        size_t first = size();
+        size_t n     = m_items.size();
+        grow(n);
+
+        // Fill the columns:
+
+        const uint8_t* const* pItems = m_items.data();
+        uint64_t* pOffsets   = m_offsets.data() + first;
+        uint32_t* pSizes     = m_sizes.data() + first;
+        uint32_t* pTypes     = m_types.data() + first;
+        uint64_t* pStamps    = m_timestamps.data() + first;
+        uint32_t* pSids      = m_sourceIds.data() + first;
+        uint32_t* pBarriers  = m_barriers.data() + first;
+        uint8_t*  pFlags     = m_bodyHeaders.data() + first;
+
+        for (size_t i = 0; i < n; i++) {
+            pOffsets[i] = baseOffset + (pItems[i] - pBegin);
+        }
+        for (size_t i = 0; i < n; i++) {
+            pSizes[i] = get32(pItems[i]);
+        }
+        for (size_t i = 0; i < n; i++) {
+            pTypes[i] = get32(pItems[i] + sizeof(uint32_t));
+        }
+        for (size_t i = 0; i < n; i++) {
+            bool bh = hasBodyHeader(pItems[i], pSizes[i]);
+            pStamps[i]   = bh ? get64(pItems[i] + BH_TIMESTAMP_OFFSET) : NULL_TIMESTAMP;
+            pSids[i]     = bh ? get32(pItems[i] + BH_SOURCE_OFFSET) : 0;
+            pBarriers[i] = bh ? get32(pItems[i] + BH_BARRIER_OFFSET) : 0;
+            pFlags[i]    = bh;
+        }
+        return pos;
+    }
+    /**
+     * extractFragments
+     *    Add the fragments of an event built body.
+     * @param pBody - the body, which begins with a uint32_t byte count that
+     *               includes itself.
+     * @param baseOffset - offset of the body; fragment payload offsets are
+     *               relative to this.
+     * @return size_t - number of fragments added.
+     * @throw std::runtime_error - a fragment runs past the end of the body.
+     */
+    size_t
+    CRingHeaderColumns::extractFragments(const void* pBody, uint64_t baseOffset)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(pBody);
+        uint32_t nBytes = get32(p);
+        if (nBytes < sizeof(uint32_t)) {
+            throw std::runtime_error(
+                "CRingHeaderColumns::extractFragments - body byte count is too small"
+            );
+        }
+        return extractFragments(
+            p + sizeof(uint32_t), nBytes - sizeof(uint32_t),
+            baseOffset + sizeof(uint32_t)
+        );
+    }
+    /**
+     * extractFragments
+     *    Add raw fragments.
+     * @param pFragments - first fragment.
+     * @param nBytes - bytes from there to the end of the last fragment.
+     * @param baseOffset - offset of the first fragment.
+     * @return size_t - number of fragments added.
+     * @throw std::runtime_error - a fragment runs past the end of the data.
+     */
+    size_t
+    CRingHeaderColumns::extractFragments(
+        const void* pFragments, size_t nBytes, uint64_t baseOffset
+    )
+    {
+        const uint8_t* pBegin = reinterpret_cast<const uint8_t*>(pFragments);
+        m_items.clear();
+        size_t pos = 0;
+        while (pos < nBytes) {
+            if (nBytes - pos < sizeof(EVB::FragmentHeader)) {
+                throw std::runtime_error(
+                    "CRingHeaderColumns::extractFragments - insufficient data for a fragment header"
+                );
+            }
+            uint32_t size = reinterpret_cast<const EVB::FragmentHeader*>(
+                pBegin + pos
+            )->s_size;
+            if (size > nBytes - pos - sizeof(EVB::FragmentHeader)) {
+                throw std::runtime_error(
+                    "CRingHeaderColumns::extractFragments - insufficient data for a fragment"
+                );
+            }
+            m_items.push_back(pBegin + pos);
+            pos += sizeof(EVB::FragmentHeader) + size;
+        }
+        size_t first = size();
+        size_t n     = m_items.size();
+        grow(n);
+
+        const uint8_t* const* pFrags = m_items.data();
+        uint64_t* pOffsets   = m_offsets.data() + first;
+        uint32_t* pSizes     = m_sizes.data() + first;
+        uint32_t* pTypes     = m_types.data() + first;
+        uint64_t* pStamps    = m_timestamps.data() + first;
+        uint32_t* pSids      = m_sourceIds.data() + first;
+        uint32_t* pBarriers  = m_barriers.data() + first;
+        uint8_t*  pFlags     = m_bodyHeaders.data() + first;
+
+        for (size_t i = 0; i < n; i++) {
+            const EVB::FragmentHeader* pH =
+                reinterpret_cast<const EVB::FragmentHeader*>(pFrags[i]);
+            pOffsets[i]  = baseOffset + (pFrags[i] - pBegin) + sizeof(EVB::FragmentHeader);
+            pStamps[i]   = pH->s_timestamp;
+            pSids[i]     = pH->s_sourceId;
+            pBarriers[i] = pH->s_barrier;
+            pSizes[i]    = pH->s_size;
+            pFlags[i]    = 1;
+        }
+        // The payloads are normally ring items:
+
+        for (size_t i = 0; i < n; i++) {
+            pTypes[i] = (pSizes[i] >= sizeof(RingItemHeader)) ?
+                get32(pFrags[i] + sizeof(EVB::FragmentHeader) + sizeof(uint32_t)) : 0;
+        }
+        return n;
+    }
+    /**
+     * append
+     *    Add one item given the start of it.
+     * @param pItem - the item.
+     * @param nBytes - bytes of it there; the header and (if the item is big
+     *               enough to have one) the body header must be.
+     * @param offset - offset of the item.
+     * @throw std::runtime_error - the header isn't all there or the item's
+     *               size is too small.
+     */
+    void
+    CRingHeaderColumns::append(const void* pItem, size_t nBytes, uint64_t offset)
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(pItem);
+        uint32_t size = (nBytes >= sizeof(RingItemHeader)) ? get32(p) : 0;
+        if ((size < sizeof(RingItemHeader)) ||
+            (nBytes < std::min(size_t(size), WITH_BODY_HEADER))) {
+            throw std::runtime_error(
+                "CRingHeaderColumns::append - the item header isn't all there"
+            );
+        }
+        bool bh = hasBodyHeader(p, size);
+        m_offsets.push_back(offset);
+        m_sizes.push_back(size);
+        m_types.push_back(get32(p + sizeof(uint32_t)));
+        m_timestamps.push_back(bh ? get64(p + BH_TIMESTAMP_OFFSET) : NULL_TIMESTAMP);
+        m_sourceIds.push_back(bh ? get32(p + BH_SOURCE_OFFSET) : 0);
+        m_barriers.push_back(bh ? get32(p + BH_BARRIER_OFFSET) : 0);
+        m_bodyHeaders.push_back(bh);
+    }
+    /**
+     * clear
+     *    Empty the columns (their storage is kept).
+     */
+    void
+    CRingHeaderColumns::clear()
+    {
+        m_offsets.clear();
+        m_sizes.clear();
+        m_types.clear();
+        m_timestamps.clear();
+        m_sourceIds.clear();
+        m_barriers.clear();
+        m_bodyHeaders.clear();
+    }
+    /**
+     * reserve
+     *   @param nItems - number of items to make room for.
+     */
+    void
+    CRingHeaderColumns::reserve(size_t nItems)
+    {
+        m_offsets.reserve(nItems);
+        m_sizes.reserve(nItems);
+        m_types.reserve(nItems);
+        m_timestamps.reserve(nItems);
+        m_sourceIds.reserve(nItems);
+        m_barriers.reserve(nItems);
+        m_bodyHeaders.reserve(nItems);
+        m_items.reserve(nItems);
+    }
+    /**
+     * size
+     *   @return size_t - number of items in the columns.
+     */
+    size_t
+    CRingHeaderColumns::size() const
+    {
+        return m_offsets.size();
+    }
+    /**
+     * getOffsets
+     *   @return const uint64_t* - item offsets (payload offsets for fragments).
+     */
+    const uint64_t*
+    CRingHeaderColumns::getOffsets() const
+    {
+        return m_offsets.data();
+    }
+    /**
+     * getSizes
+     *   @return const uint32_t* - item sizes.
+     */
+    const uint32_t*
+    CRingHeaderColumns::getSizes() const
+    {
+        return m_sizes.data();
+    }
+    /**
+     * getTypes
+     *   @return const uint32_t* - item types.
+     */
+    const uint32_t*
+    CRingHeaderColumns::getTypes() const
+    {
+        return m_types.data();
+    }
+    /**
+     * getTimestamps
+     *   @return const uint64_t* - body header timestamps.
+     */
+    const uint64_t*
+    CRingHeaderColumns::getTimestamps() const
+    {
+        return m_timestamps.data();
+    }
+    /**
+     * getSourceIds
+     *   @return const uint32_t* - body header source ids.
+     */
+    const uint32_t*
+    CRingHeaderColumns::getSourceIds() const
+    {
+        return m_sourceIds.data();
+    }
+    /**
+     * getBarriers
+     *   @return const uint32_t* - body header barrier types.
+     */
+    const uint32_t*
+    CRingHeaderColumns::getBarriers() const
+    {
+        return m_barriers.data();
+    }
+    /**
+     * getBodyHeaders
+     *   @return const uint8_t* - 1 for items with body headers (and all
+     *                fragments), 0 for the others.
+     */
+    const uint8_t*
+    CRingHeaderColumns::getBodyHeaders() const
+    {
+        return m_bodyHeaders.data();
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods.
+
+    /**
+     * grow
+     *   @param nItems - items to add to the end of every column.
+     */
+    void
+    CRingHeaderColumns::grow(size_t nItems)
+    {
+        size_t n = size() + nItems;
+        m_offsets.resize(n);
+        m_sizes.resize(n);
+        m_types.resize(n);
+        m_timestamps.resize(n);
+        m_sourceIds.resize(n);
+        m_barriers.resize(n);
+        m_bodyHeaders.resize(n);
+    }
+}
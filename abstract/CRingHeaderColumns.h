@@ -0,0 +1,87 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHeaderColumns.h
+ *  @brief: Extract the header fields of many ring items into columns.
+ */
+#ifndef CRINGHEADERCOLUMNS_H
+#define CRINGHEADERCOLUMNS_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ufmt {
+    /**
+     * @class CRingHeaderColumns
+     *    Holds the header fields of a set of ring items as a struct of
+     *    arrays: one contiguous array per field.  The fields are the
+     *    item's offset and size and type, plus the timestamp, source id
+     *    and barrier type from its body header.  Items with no body
+     *    header get NULL_TIMESTAMP, source id 0 and barrier 0; a flag
+     *    column says which items had one.
+     *
+     *    extract scans a buffer of contiguous v11/v12 ring items without
+     *    making any ring item objects.  One pass locates the items; the
+     *    others then fill one column each with simple loops over the item
+     *    offsets, which the compiler can vectorize.  extractFragments does
+     *    the same for the fragments of an event built body.  There, the
+     *    timestamp, source id and barrier come from the fragment headers,
+     *    and the type and size from the payload ring items.  Offsets are
+     *    those of the fragment payloads.  append adds one item at a time
+     *    for readers (e.g. CRingHeaderScanner) that only have the headers.
+     *
+     *    The columns are added to until clear is called.  Sorting,
+     *    filtering (see CRingItemFilter::accept) and rate code can work
+     *    on just the columns it needs.
+     *
+     * @note v10 items have no body header size word and aren't supported.
+     */
+    class CRingHeaderColumns {
+    private:
+        std::vector<uint64_t> m_offsets;
+        std::vector<uint32_t> m_sizes;
+        std::vector<uint32_t> m_types;
+        std::vector<uint64_t> m_timestamps;
+        std::vector<uint32_t> m_sourceIds;
+        std::vector<uint32_t> m_barriers;
+        std::vector<uint8_t>  m_bodyHeaders;    // 1 if the item has one.
+        std::vector<const uint8_t*> m_items;    // Scratch: item pointers.
+    public:
+        size_t extract(const void* pData, size_t nBytes, uint64_t baseOffset = 0);
+        size_t extractFragments(const void* pBody, uint64_t baseOffset = 0);
+        size_t extractFragments(
+            const void* pFragments, size_t nBytes, uint64_t baseOffset
+        );
+        void   append(const void* pItem, size_t nBytes, uint64_t offset);
+
+        void   clear();
+        void   reserve(size_t nItems);
+        size_t size() const;
+
+        const uint64_t* getOffsets() const;
+        const uint32_t* getSizes() const;
+        const uint32_t* getTypes() const;
+        const uint64_t* getTimestamps() const;
+        const uint32_t* getSourceIds() const;
+        const uint32_t* getBarriers() const;
+        const uint8_t*  getBodyHeaders() const;
+    private:
+        void grow(size_t nItems);
+    };
+}
+#endif
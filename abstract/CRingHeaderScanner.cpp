@@ -0,0 +1,247 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHeaderScanner.cpp
+ *  @brief: Implement the header only ring item scanner.
+ */
+#include "CRingHeaderScanner.h"
+#include "CRingHeaderColumns.h"
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+#include <errno.h>
+#include <string.h>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param fd - file descriptor open on the data (caller owns it).
+     *   @param version - format of the data.
+     *   @param blockSize - size of the read buffer.
+     *   @param smallItemSize - items at least this big are followed by
+     *                short reads.
+     *   @throw std::invalid_argument - blockSize can't hold an item header.
+     *   @throw std::system_error - the descriptor's offset can't be gotten
+     *                for a reason other than it not being seekable.
+     */
+    CRingHeaderScanner::CRingHeaderScanner(
+        int fd, FormatSelector::SupportedVersions version,
+        size_t blockSize, size_t smallItemSize
+    ) :
+        CRingBlockReader(fd, blockSize),
+        m_version(version), m_smallItem(smallItemSize), m_start(0),
+        m_position(0), m_itemOffset(0), m_lastSize(0), m_bytesRead(0),
+        m_itemCount(0)
+    {
+        if (blockSize < HEADER_SIZE) {
+            throw std::invalid_argument(
+                "CRingHeaderScanner block size is too small to hold an item header"
+            );
+        }
+        off_t start = lseek(fd, 0, SEEK_CUR);
+        if ((start < 0) && (errno != ESPIPE)) {
+            throw std::system_error(
+                errno, std::generic_category(),
+                "CRingHeaderScanner can't get the file offset"
+            );
+        }
+        if (m_seekable) {
+            m_start    = start;
+            m_position = start;
+        }
+    }
+    /**
+     * destructor
+     */
+    CRingHeaderScanner::~CRingHeaderScanner()
+    {
+    }
+    /**
+     * next
+     *    Get the header of the next item.
+     *  @param[out] item - set to view the header and body header of the
+     *                item.  This is valid until the next call.
+     *  @return bool - false if there are no more items.
+     *  @throw std::runtime_error - an item's size is too small to be a ring
+     *                item so the rest of the data can't be followed.
+     *  @throw int - errno on read errors.
+     */
+    bool
+    CRingHeaderScanner::next(CRingItemView& item)
+    {
+        while (true) {
+            if (!fill(sizeof(RingItemHeader))) {
+                return false;
+            }
+            const RingItemHeader* pHeader =
+                reinterpret_cast<const RingItemHeader*>(m_pBuffer + m_cursor);
+            uint32_t size = pHeader->s_size;
+            if (size < sizeof(RingItemHeader)) {
+                throw std::runtime_error("CRingHeaderScanner: bad ring item size");
+            }
+            size_t nHeader = std::min(size_t(size), HEADER_SIZE);
+            if (!fill(nHeader)) {
+                return false;
+            }
+            bool wanted = !m_pFilter || m_pFilter->accept(m_pBuffer + m_cursor);
+            if (wanted) {
+                // The copy is zero padded so a tiny item doesn't appear to
+                // have a body header from whatever follows it.
+
+                memset(m_header, 0, sizeof(m_header));
+                memcpy(m_header, m_pBuffer + m_cursor, nHeader);
+                item.setItem(m_header, m_version);
+                m_itemOffset = m_start + m_consumed;
+                m_itemCount++;
+            } else {
+                m_filtered++;
+            }
+            m_lastSize = size;
+            skipItem(size);              // A short body is the end of data.
+            if (wanted) {
+                return true;
+            }
+        }
+    }
+    /**
+     * scan
+     *    Add the headers of the next items to columns.
+     *  @param columns - where the headers go.  Columns don't support v10
+     *                items.
+     *  @param maxItems - most items to add.
+     *  @return size_t - number of items added; fewer than maxItems only at
+     *                the end of the data.
+     *  @throw std::runtime_error, int - see next.
+     */
+    size_t
+    CRingHeaderScanner::scan(CRingHeaderColumns& columns, size_t maxItems)
+    {
+        CRingItemView item;
+        size_t n = 0;
+        while ((n < maxItems) && next(item)) {
+            columns.append(
+                m_header, std::min(size_t(m_lastSize), HEADER_SIZE), m_itemOffset
+            );
+            n++;
+        }
+        return n;
+    }
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - format of the views.
+     */
+    FormatSelector::SupportedVersions
+    CRingHeaderScanner::getVersion() const
+    {
+        return m_version;
+    }
+    /**
+     * isSeekable
+     *   @return bool - true if bodies are skipped without reading them.
+     */
+    bool
+    CRingHeaderScanner::isSeekable() const
+    {
+        return m_seekable;
+    }
+    /**
+     * getItemOffset
+     *   @return uint64_t - offset of the item last returned by next.  For
+     *                unseekable descriptors, offsets are relative to where
+     *                scanning started.
+     */
+    uint64_t
+    CRingHeaderScanner::getItemOffset() const
+    {
+        return m_itemOffset;
+    }
+    /**
+     * getOffset
+     *   @return uint64_t - offset of the next item.
+     */
+    uint64_t
+    CRingHeaderScanner::getOffset() const
+    {
+        return m_start + m_consumed;
+    }
+    /**
+     * getBytesRead
+     *   @return uint64_t - bytes actually read from the descriptor.
+     */
+    uint64_t
+    CRingHeaderScanner::getBytesRead() const
+    {
+        return m_bytesRead;
+    }
+    /**
+     * getItemCount
+     *   @return uint64_t - number of items returned by next.
+     */
+    uint64_t
+    CRingHeaderScanner::getItemCount() const
+    {
+        return m_itemCount;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Protected methods:
+
+    /**
+     * readBlock
+     *    Read from where the last read left off.  After a big item, only a
+     *    short read is done since the next item is probably big too and
+     *    only its header is wanted.
+     *   @param pDest - where to put the data.
+     *   @param nBytes - most bytes to read.
+     *   @return ssize_t - bytes read, 0 at the end of the data.
+     *   @throw int - errno on read errors.
+     */
+    ssize_t
+    CRingHeaderScanner::readBlock(void* pDest, size_t nBytes)
+    {
+        if (m_seekable && (m_lastSize >= m_smallItem)) {
+            nBytes = std::min(nBytes, SKIP_READ_SIZE);
+        }
+        ssize_t nRead;
+        do {
+            nRead = m_seekable ?
+                pread(m_fd, pDest, nBytes, m_position) : read(m_fd, pDest, nBytes);
+        } while ((nRead < 0) && (errno == EINTR));
+        if (nRead < 0) {
+            throw errno;
+        }
+        m_position  += nRead;
+        m_bytesRead += nRead;
+        return nRead;
+    }
+    /**
+     * skipData
+     *    A seekable descriptor is skipped by moving where the next pread
+     *    is done; the descriptor's own offset isn't touched.  Others are
+     *    read and discarded.
+     *   @param nBytes - number of unread bytes to skip.
+     *   @return uint64_t - bytes skipped.
+     */
+    uint64_t
+    CRingHeaderScanner::skipData(uint64_t nBytes)
+    {
+        if (m_seekable) {
+            m_position += nBytes;
+            return nBytes;
+        }
+        return discardData(nBytes);
+    }
+}
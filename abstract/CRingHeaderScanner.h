@@ -0,0 +1,117 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingHeaderScanner.h
+ *  @brief: Reads just the headers of the ring items in a file.
+ */
+#ifndef CRINGHEADERSCANNER_H
+#define CRINGHEADERSCANNER_H
+
+#include "CRingBlockReader.h"
+#include "CRingItemView.h"
+#include "DataFormat.h"
+#include <unistd.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ufmt {
+    class CRingHeaderColumns;
+
+    /**
+     * @class CRingHeaderScanner
+     *    Steps through the items of a file descriptor looking only at
+     *    each item's header and body header.  Tools that count items, make
+     *    per source rate reports or look for run boundaries never need the
+     *    bodies, so the scanner doesn't read them.  It's a CRingBlockReader
+     *    that only ever fills its buffer as far as the next header and
+     *    steps over the rest of each item with skipItem:
+     *    -  Data are read into the block buffer with pread(2).  While items
+     *       are small the next item headers are usually already in the
+     *       buffer.
+     *    -  When an item extends past the buffer, the buffered part is
+     *       dropped and the next read starts at the following item - the
+     *       body is never read.  After an item of at least smallItemSize
+     *       bytes only SKIP_READ_SIZE bytes are read since the next item is
+     *       probably big as well.
+     *
+     *    Each item is handed out as a CRingItemView of a copy of its
+     *    header and body header.  Only the header and body header
+     *    selectors of the view (type, size, hasBodyHeader,
+     *    getEventTimestamp, getSourceId, getBarrierType) may be used;
+     *    the body isn't there.  scan instead adds the headers of many
+     *    items to a CRingHeaderColumns so they can be filtered, sorted or
+     *    counted a column at a time.  A filter set with setFilter steps
+     *    over the items it rejects.
+     *
+     *    pread needs a seekable descriptor.  Pipes and sockets are read
+     *    sequentially with the bodies read into the buffer and discarded,
+     *    which saves the item copies but not the I/O.
+     *
+     *  @note the descriptor is owned by the caller.  Scanning starts at
+     *        its file offset when the scanner is made, which must be the
+     *        start of an item.  A seekable descriptor's offset is not
+     *        changed.
+     *  @note a truncated last header looks like the end of the data.
+     *        Since bodies aren't read, a truncated last body isn't noticed.
+     *  @note next, scan and nextItem all take items from the same buffer
+     *        and can be mixed.  A validator (setValidator) is only applied
+     *        by nextItem.
+     */
+    class CRingHeaderScanner : public CRingBlockReader {
+    public:
+        static const size_t DEFAULT_BLOCK_SIZE = 64*1024;
+        static const size_t DEFAULT_SMALL_ITEM = 8*1024;
+        static const size_t SKIP_READ_SIZE     = 4096;
+        static const size_t HEADER_SIZE =
+            sizeof(RingItemHeader) + sizeof(BodyHeader);
+    private:
+        FormatSelector::SupportedVersions m_version;
+        size_t   m_smallItem;
+        uint64_t m_start;              // File offset where scanning started.
+        uint64_t m_position;           // File offset of the next read.
+        uint64_t m_itemOffset;         // File offset of the last item.
+        uint32_t m_lastSize;           // Size of the last item.
+        uint64_t m_bytesRead;
+        uint64_t m_itemCount;
+        uint8_t  m_header[HEADER_SIZE];
+    public:
+        CRingHeaderScanner(
+            int fd,
+            FormatSelector::SupportedVersions version = FormatSelector::v12,
+            size_t blockSize = DEFAULT_BLOCK_SIZE,
+            size_t smallItemSize = DEFAULT_SMALL_ITEM
+        );
+        virtual ~CRingHeaderScanner();
+    private:
+        CRingHeaderScanner(const CRingHeaderScanner& rhs);
+        CRingHeaderScanner& operator=(const CRingHeaderScanner& rhs);
+    public:
+        bool next(CRingItemView& item);
+        size_t scan(CRingHeaderColumns& columns, size_t maxItems);
+
+        FormatSelector::SupportedVersions getVersion() const;
+        bool     isSeekable() const;
+        uint64_t getItemOffset() const;
+        uint64_t getOffset() const;
+        uint64_t getBytesRead() const;
+        uint64_t getItemCount() const;
+    protected:
+        virtual ssize_t readBlock(void* pDest, size_t nBytes);
+        virtual uint64_t skipData(uint64_t nBytes);
+    };
+}
+#endif
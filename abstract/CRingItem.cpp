@@ -19,6 +19,7 @@
 
 #include "CRingItem.h"
 #include "DataFormat.h"
+#include "CRingItemPool.h"
 
 #include <string.h>
 #include <iostream>
@@ -52,7 +53,8 @@ namespace ufmt {
   */
   CRingItem::CRingItem(uint16_t type, size_t maxBody) :
     m_pItem(reinterpret_cast<RingItem*>(&m_staticBuffer)),
-    m_storageSize(maxBody)
+    m_storageSize(maxBody), m_externalStorage(false),
+    m_pPool(CRingItemPool::current())
   {
 
     // If necessary, dynamically allocate (big max item).
@@ -74,7 +76,8 @@ namespace ufmt {
     \param rhs  - The source of the copy.
   */
   CRingItem::CRingItem(const CRingItem& rhs) :
-    m_pItem(reinterpret_cast<RingItem*>(&m_staticBuffer)) // Needed to prevent uncond new.
+    m_pItem(reinterpret_cast<RingItem*>(&m_staticBuffer)), // Needed to prevent uncond new.
+    m_externalStorage(false), m_pPool(CRingItemPool::current())
   {
     
   
@@ -85,14 +88,36 @@ namespace ufmt {
 
     copyIn(rhs);
   }
+  /**
+   * move constructor
+   *    Takes over the storage of rhs rather than copying it (see moveIn).
+   * @param rhs - the item we take over.  It is left an empty item of the
+   *              same type.
+   */
+  CRingItem::CRingItem(CRingItem&& rhs) :
+    m_pItem(reinterpret_cast<RingItem*>(&m_staticBuffer)),
+    m_storageSize(0),
+    m_externalStorage(false), m_pPool(CRingItemPool::current())
+  {
+    moveIn(rhs);
+  }
   /**
    * constructor from raw ring item.
+   *   Items that fit in the static buffer are put there.  Larger items
+   *   get CRingItemFromRawSlop extra bytes of dynamic storage to allow
+   *   them to grow.  Adding the slop to small items too would push items
+   *   just under the static buffer size to dynamic storage needlessly.
    * @param pItem - pointer to the raw ring item.
    */
   CRingItem::CRingItem(pRingItem pItem) :
-    m_pItem(reinterpret_cast<RingItem*>(&m_staticBuffer))
+    m_pItem(reinterpret_cast<RingItem*>(&m_staticBuffer)),
+    m_storageSize(pItem->s_header.s_size),
+    m_externalStorage(false), m_pPool(CRingItemPool::current())
   {
-    newIfNecessary(pItem->s_header.s_size + CRingItemFromRawSlop);
+    if (m_storageSize > CRingItemStaticBufferSize) {
+      m_storageSize += CRingItemFromRawSlop;
+    }
+    newIfNecessary(m_storageSize);
     
     
     // Doing things this way gets the cursor right.
@@ -110,6 +135,28 @@ namespace ufmt {
     deleteIfNecessary();
   }
 
+  /**
+   * operator new
+   *    Ring item objects come from the thread's current pool.
+   * @param nBytes - size of the object.
+   * @return void* - storage for the object.
+   */
+  void*
+  CRingItem::operator new(size_t nBytes)
+  {
+    return CRingItemPool::allocate(CRingItemPool::current(), nBytes);
+  }
+  /**
+   * operator delete
+   *    Give the object's storage back to the pool it came from.
+   * @param p - the storage.
+   */
+  void
+  CRingItem::operator delete(void* p)
+  {
+    CRingItemPool::release(p);
+  }
+
   /*!
     Assignment.  If necessary destroy the body.  If necessary re-create the body.
     After that it's just a copy in.
@@ -128,6 +175,25 @@ namespace ufmt {
 
     return *this;
   }
+  /**
+   * move assignment
+   *    Release our storage and take over that of rhs.  Note this can be
+   *    used to give an item of one concrete class to another object of
+   *    a different concrete class (that's how the factories do typed
+   *    conversions without a copy).
+   * @param rhs - the item we take over.  It is left an empty item of the
+   *              same type.
+   * @return CRingItem& - *this.
+   */
+  CRingItem&
+  CRingItem::operator=(CRingItem&& rhs)
+  {
+    if (this != &rhs) {
+      deleteIfNecessary();
+      moveIn(rhs);
+    }
+    return *this;
+  }
 
   /*!
     Comparison for equality.. note that true equality may be time consuming
@@ -222,6 +288,7 @@ namespace ufmt {
   void*
   CRingItem::getBodyCursor()
   {
+    makeWritable();
     return m_pCursor;
   }
   /*!
@@ -231,6 +298,7 @@ namespace ufmt {
   pRingItem
   CRingItem::getItemPointer()
   {
+    makeWritable();
     return m_pItem;
   }
 
@@ -319,6 +387,18 @@ namespace ufmt {
       return 0;
   }
 
+  /**
+   * isExternalStorage
+   *
+   * @return bool - true if the item lives in storage we don't own
+   *                (see useExternalStorage).
+   */
+  bool
+  CRingItem::isExternalStorage() const
+  {
+      return m_externalStorage;
+  }
+
   ///////////////////////////////////////////////////////////////////////////////////////
   //
   // Mutators.
@@ -334,6 +414,52 @@ namespace ufmt {
     m_pCursor = reinterpret_cast<uint8_t*>(pNewCursor);
   }
 
+  /**
+   * useExternalStorage
+   *    Point this object at a complete raw ring item that lives in storage
+   *    owned by someone else (e.g. a memory mapped file) rather than copying
+   *    it into our own storage.  The external storage is treated as read
+   *    only: the first use of a writable accessor (getItemPointer,
+   *    getBodyPointer, getBodyCursor and the mutators built on them)
+   *    copies the item into our own storage first (see makeWritable).  The
+   *    caller must ensure the storage outlives this object (or the next
+   *    call to this method).
+   *
+   * @param pItem - pointer to the raw ring item.
+   */
+  void
+  CRingItem::useExternalStorage(pRingItem pItem)
+  {
+    deleteIfNecessary();
+    m_pItem           = pItem;
+    m_externalStorage = true;
+    m_storageSize     = pItem->s_header.s_size;
+    m_pCursor = reinterpret_cast<uint8_t*>(pItem) + pItem->s_header.s_size;
+  }
+  /**
+   * prepareForRefill
+   *    Get the item ready to have a complete new raw item of a known size
+   *    put into it (e.g. by the factory getRingItem overloads that fill in
+   *    an existing item).  The existing storage is reused if it is big
+   *    enough, so refilling the same object over and over only allocates
+   *    when an item larger than any seen before comes along.
+   *
+   * @param itemSize - size of the whole raw item that will be put in.
+   * @return pRingItem - where to put the item.  Once it's been put there,
+   *                set the body cursor to itemSize bytes past this and
+   *                call updateSize.
+   * @note the current contents of the item are not preserved.
+   * @note an item using external storage gets its own storage back.
+   */
+  pRingItem
+  CRingItem::prepareForRefill(uint32_t itemSize)
+  {
+    if (itemSize > itemCapacity()) {
+      newIfNecessary(itemSize);
+    }
+    m_pCursor = m_pItem;
+    return m_pItem;
+  }
   /*!
   ** Given the current item cursor set the size of the item.
   */
@@ -520,14 +646,56 @@ namespace ufmt {
   }
 
 
+  /*
+  * Common code for move construction and assignment.
+  * Dynamic and external storage is handed over as is.  The
+  * static buffer is part of the object so an item that lives there
+  * has to be copied (at most CRingItemStaticBufferSize bytes).
+  * rhs is left holding an empty item of its original type in its static
+  * buffer.  We assume any storage of our own has already been released.
+  */
+  void
+  CRingItem::moveIn(CRingItem& rhs)
+  {
+    uint32_t type = rhs.type();
+    uint32_t size = rhs.size();
+    m_storageSize = rhs.m_storageSize;
+
+    if (rhs.m_pItem == reinterpret_cast<pRingItem>(rhs.m_staticBuffer)) {
+      m_pItem = reinterpret_cast<pRingItem>(m_staticBuffer);
+      m_externalStorage = false;
+      memcpy(m_pItem, rhs.m_pItem, size);
+    } else {
+      m_pItem           = rhs.m_pItem;
+      m_externalStorage = rhs.m_externalStorage;
+      rhs.m_pItem           = reinterpret_cast<pRingItem>(rhs.m_staticBuffer);
+      rhs.m_externalStorage = false;
+      rhs.m_storageSize     = CRingItemStaticBufferSize - 10;
+    }
+    m_pCursor = reinterpret_cast<uint8_t*>(m_pItem) + size;   // As copyIn.
+
+    // Empty rhs - a zero after the header means no body header in
+    // all formats that have them.
+
+    uint32_t* pAfter = static_cast<uint32_t*>(
+      fillRingHeader(rhs.m_pItem, sizeof(RingItemHeader), type)
+    );
+    *pAfter = 0;
+    rhs.m_pCursor = pAfter;
+  }
+
   /*
   *   If necessary, delete dynamically allocated buffer space.
+  *   External storage is just forgotten.
   */
   void 
   CRingItem::deleteIfNecessary()
   {
-    if ((m_pItem != (pRingItem)m_staticBuffer) ) {
-      delete [](reinterpret_cast<uint8_t*>(m_pItem));
+    if (m_externalStorage) {
+      m_pItem = (pRingItem)(m_staticBuffer);
+      m_externalStorage = false;
+    } else if ((m_pItem != (pRingItem)m_staticBuffer) ) {
+      CRingItemPool::release(m_pItem);
       m_pItem = (pRingItem)(m_staticBuffer);   // No ned to delete now.
     }
   }
@@ -540,16 +708,61 @@ namespace ufmt {
   void
   CRingItem::newIfNecessary(uint32_t size)
   {
+    m_storageSize = size;
     if (size > CRingItemStaticBufferSize) {
       deleteIfNecessary();                     // In some cases we get called more than once.
-      m_pItem  = reinterpret_cast<RingItem*>(new uint8_t[size + sizeof(RingItemHeader) + 100]);
+      m_pItem  = reinterpret_cast<RingItem*>(
+        CRingItemPool::allocate(m_pPool, size + sizeof(RingItemHeader) + 100)
+      );
     }
     else {
       m_pItem = reinterpret_cast<RingItem*>(m_staticBuffer);
+      m_externalStorage = false;
     }
     m_pCursor= reinterpret_cast<uint8_t*>(&(m_pItem->s_body));
 
   }
+  /*
+  *  Copy an item that lives in external storage into storage of our own
+  *  so that it can be modified or extended without touching the external
+  *  storage (which may be read only or followed by another item).  As with
+  *  construction from a raw item, big items get CRingItemFromRawSlop bytes
+  *  of room to grow.  The cursor keeps its offset into the item.  Items
+  *  already in our own storage are left alone.
+  */
+  void
+  CRingItem::makeWritable()
+  {
+    if (m_externalStorage) {
+      pRingItem pExternal = m_pItem;
+      uint32_t  size      = pExternal->s_header.s_size;
+      size_t    cursor    =
+        reinterpret_cast<uint8_t*>(m_pCursor) - reinterpret_cast<uint8_t*>(pExternal);
+      uint32_t  storage   = size;
+      if (storage > CRingItemStaticBufferSize) {
+        storage += CRingItemFromRawSlop;
+      }
+      newIfNecessary(storage);             // Forgets the external storage.
+      memcpy(m_pItem, pExternal, size);
+      m_pCursor = reinterpret_cast<uint8_t*>(m_pItem) + cursor;
+    }
+  }
+  /*
+  *  Number of bytes of complete ring item the current storage can hold.
+  *  External storage is treated as having no capacity as we can't
+  *  put anything else there.
+  */
+  uint32_t
+  CRingItem::itemCapacity() const
+  {
+    if (m_externalStorage) {
+      return 0;
+    }
+    if (m_pItem == (pRingItem)m_staticBuffer) {
+      return sizeof(m_staticBuffer);
+    }
+    return m_storageSize + sizeof(RingItemHeader) + 100;   // See newIfNecessary.
+  }
   /**
    * throwIfNoBodyHeader
    *
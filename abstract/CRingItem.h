@@ -24,14 +24,20 @@
 #include <unistd.h>
 #include <stdint.h>
 #include <string>
+#include <fmtconfig.h>         // UFMT_RINGITEM_INLINE_SIZE (cmake cache variable).
 
 namespace ufmt {
       struct _RingItem;
       typedef _RingItem RingItem, *pRingItem;
+      class CRingItemPool;
 
 
-      static const uint32_t CRingItemStaticBufferSize=8192;
+      static const uint32_t CRingItemStaticBufferSize=UFMT_RINGITEM_INLINE_SIZE;
       static const uint32_t CRingItemFromRawSlop = 1024;
+      static_assert(
+            CRingItemStaticBufferSize >= 128,
+            "UFMT_RINGITEM_INLINE_SIZE must be at least 128 bytes"
+      );
 
       /**
        * @class CRingItem
@@ -40,7 +46,14 @@ namespace ufmt {
        *    is supposed to come through factories rather than direct user
        *    code construction... however that is also supported-- for the specific
        *    concrete classes.
-       *  @note this base class will do storage management.
+       *  @note this base class will do storage management.  Items that fit
+       *        in CRingItemStaticBufferSize bytes live in m_staticBuffer,
+       *        larger items are put in exactly sized heap storage.  The
+       *        size of m_staticBuffer is a build time choice.
+       *  @note Item objects and their heap storage come from the
+       *        CRingItemPool that is current when the item is constructed
+       *        (see RingItemFactoryBase::setItemPool).  With no current pool
+       *        memory comes from the system as usual.
        */
       class CRingItem {
       protected:    
@@ -48,15 +61,23 @@ namespace ufmt {
             uint32_t    m_storageSize;
             uint8_t     m_staticBuffer[CRingItemStaticBufferSize + 100];
             void*       m_pCursor;
+            bool        m_externalStorage;   // m_pItem is not ours to delete.
+            CRingItemPool* m_pPool;          // Heap storage comes from here.
 
       public:
             CRingItem(uint16_t type, size_t maxBody = CRingItemStaticBufferSize - 10);
             
             CRingItem(const CRingItem& rhs);
+            CRingItem(CRingItem&& rhs);
             CRingItem(pRingItem pItem);
             
       
             virtual ~CRingItem();
+
+            static void* operator new(size_t nBytes);
+            static void  operator delete(void* p);
+
+            CRingItem& operator=(CRingItem&& rhs);
       private:                                   // Don't allow these vestigial
             CRingItem& operator=(const CRingItem& rhs);
             int operator==(const CRingItem& rhs) const;
@@ -76,6 +97,7 @@ namespace ufmt {
             const RingItem*  getItemPointer() const;
             uint32_t type() const;
             uint32_t size() const;
+            bool isExternalStorage() const;
             virtual bool mustSwap() const;
             virtual bool hasBodyHeader() const;
             virtual void* getBodyHeader() const = 0;
@@ -89,6 +111,8 @@ namespace ufmt {
             virtual void setBodyHeader(uint64_t timestamp, uint32_t sourceId,
                               uint32_t barrierType = 0) = 0;
             virtual void setBodyCursor(void* pNewCursor);
+            void useExternalStorage(pRingItem pItem);
+            pRingItem prepareForRefill(uint32_t itemSize);
       
             // Object actions:
       
@@ -106,8 +130,11 @@ namespace ufmt {
             
       protected:
             void newIfNecessary(uint32_t newSize);
+            uint32_t itemCapacity() const;
+            void makeWritable();
             void deleteIfNecessary();
             void copyIn(const CRingItem& rhs);
+            void moveIn(CRingItem& rhs);
             void throwIfNoBodyHeader(std::string msg) const;
             static void* fillRingHeader(pRingItem p, uint32_t size, uint32_t type);
 
@@ -0,0 +1,313 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemFilter.cpp
+ *  @brief: Implement ring item selection by header.
+ */
+#include "CRingItemFilter.h"
+#include "CRingHeaderColumns.h"
+#include "DataFormat.h"
+#include "fragment.h"
+#include <algorithm>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   Makes a filter that accepts everything.
+     *   @param version - format of the items to filter.  This determines
+     *                whether they can have body headers.
+     */
+    CRingItemFilter::CRingItemFilter(FormatSelector::SupportedVersions version) :
+        m_version(version)
+    {
+        clear();
+    }
+    /**
+     * selectTypes
+     *    Accept only items of the given types.  This replaces any earlier
+     *    type predicate.
+     *  @param types - the types to accept.
+     */
+    void
+    CRingItemFilter::selectTypes(const std::vector<uint32_t>& types)
+    {
+        setTypes(types, true);
+    }
+    /**
+     * excludeTypes
+     *    Accept all items but those of the given types.  This replaces any
+     *    earlier type predicate.
+     *  @param types - the types to reject.
+     */
+    void
+    CRingItemFilter::excludeTypes(const std::vector<uint32_t>& types)
+    {
+        setTypes(types, false);
+    }
+    /**
+     * selectSourceIds
+     *    Accept only items whose body header source id is one of these.
+     *  @param ids - the source ids to accept.
+     */
+    void
+    CRingItemFilter::selectSourceIds(const std::vector<uint32_t>& ids)
+    {
+        m_sourceIds = ids;
+        std::sort(m_sourceIds.begin(), m_sourceIds.end());
+        m_sourceFilter = true;
+    }
+    /**
+     * setTimestampRange
+     *    Accept only items whose body header timestamp is in [low, high].
+     *  @param low - smallest timestamp accepted.
+     *  @param high - largest timestamp accepted.
+     */
+    void
+    CRingItemFilter::setTimestampRange(uint64_t low, uint64_t high)
+    {
+        m_lowTimestamp    = low;
+        m_highTimestamp   = high;
+        m_timestampFilter = true;
+    }
+    /**
+     * selectBarrierTypes
+     *    Accept only items whose body header barrier type is one of these.
+     *    Including 0 keeps the items that aren't barriers.
+     *  @param types - barrier types to accept.
+     */
+    void
+    CRingItemFilter::selectBarrierTypes(const std::vector<uint32_t>& types)
+    {
+        m_barrierTypes = types;
+        std::sort(m_barrierTypes.begin(), m_barrierTypes.end());
+        m_barrierFilter = true;
+    }
+    /**
+     * requireBodyHeader
+     *  @param require - if true, items with no body header are rejected.
+     */
+    void
+    CRingItemFilter::requireBodyHeader(bool require)
+    {
+        m_requireBodyHeader = require;
+    }
+    /**
+     * clear
+     *    Remove all predicates so everything is accepted.
+     */
+    void
+    CRingItemFilter::clear()
+    {
+        m_typeFilter = false;
+        m_typeBits.assign(TYPE_BITMAP_SIZE/64, ~uint64_t(0));
+        m_bigTypes.clear();
+        m_listedAccepted   = false;
+        m_sourceFilter      = false;
+        m_sourceIds.clear();
+        m_timestampFilter   = false;
+        m_lowTimestamp      = 0;
+        m_highTimestamp     = 0;
+        m_barrierFilter     = false;
+        m_barrierTypes.clear();
+        m_requireBodyHeader = false;
+    }
+    /**
+     * setVersion
+     *  @param version - new format of the items filtered.
+     */
+    void
+    CRingItemFilter::setVersion(FormatSelector::SupportedVersions version)
+    {
+        m_version = version;
+    }
+    /**
+     * getVersion
+     *  @return FormatSelector::SupportedVersions - format of the items.
+     */
+    FormatSelector::SupportedVersions
+    CRingItemFilter::getVersion() const
+    {
+        return m_version;
+    }
+    /**
+     * acceptsAll
+     *  @return bool - true if no predicates are set.
+     */
+    bool
+    CRingItemFilter::acceptsAll() const
+    {
+        return !(m_typeFilter || m_sourceFilter || m_timestampFilter ||
+            m_barrierFilter || m_requireBodyHeader);
+    }
+    /**
+     * headerBytes
+     *  @return size_t - bytes from the start of an item that accept looks
+     *           at (or the item size if that's smaller).
+     */
+    size_t
+    CRingItemFilter::headerBytes() const
+    {
+        if (m_version == FormatSelector::v10) {
+            return sizeof(RingItemHeader);
+        }
+        return sizeof(RingItemHeader) + sizeof(BodyHeader);
+    }
+    /**
+     * acceptType
+     *  @param type - an item type.
+     *  @return bool - true if the type predicate accepts the type.
+     */
+    bool
+    CRingItemFilter::acceptType(uint32_t type) const
+    {
+        if (type < TYPE_BITMAP_SIZE) {
+            return (m_typeBits[type >> 6] >> (type & 63)) & 1;
+        }
+        bool listed = std::binary_search(m_bigTypes.begin(), m_bigTypes.end(), type);
+        return listed == m_listedAccepted;
+    }
+    /**
+     * accept
+     *  @param pItem - points to a ring item.  Only the first
+     *               headerBytes() bytes (or the whole item if it's
+     *               smaller) need be there.
+     *  @return bool - true if the item passes all the predicates.
+     */
+    bool
+    CRingItemFilter::accept(const void* pItem) const
+    {
+        const RingItem* p = static_cast<const RingItem*>(pItem);
+        if (m_typeFilter && !acceptType(p->s_header.s_type)) {
+            return false;
+        }
+        if (!(m_sourceFilter || m_timestampFilter || m_barrierFilter ||
+            m_requireBodyHeader)) {
+            return true;
+        }
+        // Body header predicates.  The body header size is only looked at
+        // if the item is big enough to have one, and the body header only
+        // if that size says all of it is there:
+
+        if ((m_version == FormatSelector::v10) ||
+            (p->s_header.s_size < sizeof(RingItemHeader) + sizeof(BodyHeader)) ||
+            (p->s_body.u_noBodyHeader.s_empty < sizeof(BodyHeader))) {
+            return !m_requireBodyHeader;
+        }
+        const BodyHeader& bh = p->s_body.u_hasBodyHeader.s_bodyHeader;
+        if (m_sourceFilter && !std::binary_search(
+                m_sourceIds.begin(), m_sourceIds.end(), bh.s_sourceId)) {
+            return false;
+        }
+        if (m_timestampFilter && (bh.s_timestamp != NULL_TIMESTAMP) &&
+            ((bh.s_timestamp < m_lowTimestamp) || (bh.s_timestamp > m_highTimestamp))) {
+            return false;
+        }
+        if (m_barrierFilter && !std::binary_search(
+                m_barrierTypes.begin(), m_barrierTypes.end(), bh.s_barrier)) {
+            return false;
+        }
+        return true;
+    }
+    /**
+     * accept
+     *    Filter the items in a set of header columns.
+     *  @param columns - the item headers.
+     *  @param[out] accepted - resized to the number of items and set to 1
+     *               for each item that passes all the predicates, 0 for
+     *               the others.
+     *  @return size_t - number of items accepted.
+     */
+    size_t
+    CRingItemFilter::accept(
+        const CRingHeaderColumns& columns, std::vector<uint8_t>& accepted
+    ) const
+    {
+        size_t n = columns.size();
+        accepted.assign(n, 1);
+        uint8_t* pOk = accepted.data();
+        if (m_typeFilter) {
+            const uint32_t* pTypes = columns.getTypes();
+            for (size_t i = 0; i < n; i++) {
+                pOk[i] = acceptType(pTypes[i]);
+            }
+        }
+        // Items without body headers only face requireBodyHeader:
+
+        const uint8_t* pBh = columns.getBodyHeaders();
+        bool noBodyHeaders = m_version == FormatSelector::v10;
+        if (m_requireBodyHeader) {
+            for (size_t i = 0; i < n; i++) {
+                pOk[i] &= pBh[i] && !noBodyHeaders;
+            }
+        }
+        if (!noBodyHeaders && m_sourceFilter) {
+            const uint32_t* pSids = columns.getSourceIds();
+            for (size_t i = 0; i < n; i++) {
+                pOk[i] &= !pBh[i] || std::binary_search(
+                    m_sourceIds.begin(), m_sourceIds.end(), pSids[i]
+                );
+            }
+        }
+        if (!noBodyHeaders && m_timestampFilter) {
+            const uint64_t* pStamps = columns.getTimestamps();
+            for (size_t i = 0; i < n; i++) {
+                pOk[i] &= !pBh[i] || (pStamps[i] == NULL_TIMESTAMP) ||
+                    ((pStamps[i] >= m_lowTimestamp) && (pStamps[i] <= m_highTimestamp));
+            }
+        }
+        if (!noBodyHeaders && m_barrierFilter) {
+            const uint32_t* pBarriers = columns.getBarriers();
+            for (size_t i = 0; i < n; i++) {
+                pOk[i] &= !pBh[i] || std::binary_search(
+                    m_barrierTypes.begin(), m_barrierTypes.end(), pBarriers[i]
+                );
+            }
+        }
+        return std::count(accepted.begin(), accepted.end(), 1);
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods:
+
+    /**
+     * setTypes
+     *    Compile a type predicate into the bitmap.
+     *  @param types - the listed types.
+     *  @param listedAccepted - true if the listed types are the ones
+     *               accepted, false if they're the ones rejected.
+     */
+    void
+    CRingItemFilter::setTypes(const std::vector<uint32_t>& types, bool listedAccepted)
+    {
+        m_typeBits.assign(TYPE_BITMAP_SIZE/64, listedAccepted ? 0 : ~uint64_t(0));
+        m_bigTypes.clear();
+        for (auto type : types) {
+            if (type < TYPE_BITMAP_SIZE) {
+                uint64_t bit = uint64_t(1) << (type & 63);
+                if (listedAccepted) {
+                    m_typeBits[type >> 6] |= bit;
+                } else {
+                    m_typeBits[type >> 6] &= ~bit;
+                }
+            } else {
+                m_bigTypes.push_back(type);
+            }
+        }
+        std::sort(m_bigTypes.begin(), m_bigTypes.end());
+        m_listedAccepted = listedAccepted;
+        m_typeFilter       = true;
+    }
+}
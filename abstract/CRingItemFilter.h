@@ -0,0 +1,106 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemFilter.h
+ *  @brief: Selection of ring items by their header and body header.
+ */
+#ifndef CRINGITEMFILTER_H
+#define CRINGITEMFILTER_H
+
+#include <NSCLDAQFormatFactorySelector.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+namespace ufmt {
+    class CRingHeaderColumns;
+
+    /**
+     * @class CRingItemFilter
+     *    Decides from the ring item header and body header alone whether
+     *    an item is wanted.  Because only those bytes are looked at, readers
+     *    can apply the filter before the body is read or copied and just
+     *    step over rejected items (see CRingBlockReader::setFilter and
+     *    DataSource::setFilter).  An item is accepted if it passes all of
+     *    the predicates that have been set:
+     *    - Types: either only the selected types or all but the excluded
+     *      types.  The type predicate is compiled into a bitmap so the
+     *      test is a single lookup for types up to TYPE_BITMAP_SIZE.
+     *    - Source ids: the body header source id is one of a set.
+     *    - Timestamps: the body header timestamp is in [low, high].
+     *    - Barrier types: the body header barrier type is one of a set.
+     *
+     *    Items without a body header (and all v10 items) pass the body
+     *    header predicates unless requireBodyHeader is set; so do
+     *    items whose timestamp is NULL_TIMESTAMP for the timestamp range.
+     *    That keeps e.g. state change items in a one source replay.
+     *
+     *    Headers already extracted into a CRingHeaderColumns are filtered
+     *    a predicate at a time over whole columns rather than an item at a
+     *    time.
+     */
+    class CRingItemFilter {
+    public:
+        static const uint32_t TYPE_BITMAP_SIZE = 0x10000;
+    private:
+        FormatSelector::SupportedVersions m_version;
+        bool                  m_typeFilter;
+        std::vector<uint64_t> m_typeBits;     // Bit set if type is accepted.
+        std::vector<uint32_t> m_bigTypes;     // Listed types past the bitmap.
+        bool                  m_listedAccepted;     // Else listed are rejected.
+        bool                  m_sourceFilter;
+        std::vector<uint32_t> m_sourceIds;    // Sorted.
+        bool                  m_timestampFilter;
+        uint64_t              m_lowTimestamp;
+        uint64_t              m_highTimestamp;
+        bool                  m_barrierFilter;
+        std::vector<uint32_t> m_barrierTypes; // Sorted.
+        bool                  m_requireBodyHeader;
+    public:
+        CRingItemFilter(
+            FormatSelector::SupportedVersions version = FormatSelector::v12
+        );
+
+        // Setting the predicates:
+
+        void selectTypes(const std::vector<uint32_t>& types);
+        void excludeTypes(const std::vector<uint32_t>& types);
+        void selectSourceIds(const std::vector<uint32_t>& ids);
+        void setTimestampRange(uint64_t low, uint64_t high);
+        void selectBarrierTypes(const std::vector<uint32_t>& types);
+        void requireBodyHeader(bool require = true);
+        void clear();
+        void setVersion(FormatSelector::SupportedVersions version);
+
+        // Selectors:
+
+        FormatSelector::SupportedVersions getVersion() const;
+        bool   acceptsAll() const;
+        size_t headerBytes() const;
+
+        // Filtering:
+
+        bool acceptType(uint32_t type) const;
+        bool accept(const void* pItem) const;
+        size_t accept(
+            const CRingHeaderColumns& columns, std::vector<uint8_t>& accepted
+        ) const;
+    private:
+        void setTypes(const std::vector<uint32_t>& types, bool listedAccepted);
+    };
+}
+#endif
@@ -0,0 +1,425 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemPool.cpp
+ *  @brief: Implement the ring item recycling allocator.
+ */
+#include "CRingItemPool.h"
+#include "CMutex.h"
+#include <new>
+#include <set>
+
+namespace ufmt {
+    // Each block starts with this header.  The caller gets the memory
+    // just past it.  The header keeps the user memory 16 byte aligned.
+
+    struct BlockHeader {
+        CRingItemPool* s_pPool;          // nullptr if from the system.
+        uint32_t       s_class;          // Size class if pooled.
+        uint32_t       s_magic;
+    };
+    static_assert(sizeof(BlockHeader) == 16, "Block header must be 16 bytes");
+
+    static const uint32_t BLOCK_MAGIC = 0x706f6f6c;   // 'pool'
+    static const uint32_t UNPOOLED    = 0xffffffff;
+
+    // Thread's current pool (see Scope):
+
+    static thread_local CRingItemPool* pCurrentPool(nullptr);
+
+    // Pools that are alive.  Thread caches use this to know if they
+    // can give their blocks back to their pool when their thread exits.
+
+    static CMutex&
+    registryLock()
+    {
+        static CMutex lock;
+        return lock;
+    }
+    static std::set<CRingItemPool*>&
+    livePools()
+    {
+        static std::set<CRingItemPool*> pools;
+        return pools;
+    }
+
+    /**
+     * ThreadCache
+     *    Per thread free lists.  A thread's cache holds blocks for one pool
+     *    at a time (programs generally only use one pool per thread); if a
+     *    thread switches pools, its blocks are given back to the old pool.
+     */
+    struct CRingItemPool::ThreadCache {
+        CRingItemPool*     s_pPool;
+        std::vector<void*> s_blocks[NUM_CLASSES];
+
+        ThreadCache() : s_pPool(nullptr) {}
+        ~ThreadCache() {
+            unbind();
+        }
+        void bind(CRingItemPool* pPool) {
+            if (s_pPool != pPool) {
+                unbind();
+                s_pPool = pPool;
+                for (unsigned i = 0; i < NUM_CLASSES; i++) {
+                    s_blocks[i].reserve(pPool->m_threadCacheDepth);
+                }
+            }
+        }
+        void unbind() {
+            if (!s_pPool) return;
+            CriticalSection l(registryLock());
+            bool alive = livePools().count(s_pPool) > 0;
+            for (unsigned i = 0; i < NUM_CLASSES; i++) {
+                std::vector<void*>& blocks(s_blocks[i]);
+                if (alive) {
+                    s_pPool->putShared(blocks.data(), blocks.size(), i);
+                } else {
+                    for (size_t b = 0; b < blocks.size(); b++) {
+                        ::operator delete(blocks[b]);
+                    }
+                }
+                blocks.clear();
+            }
+            s_pPool = nullptr;
+        }
+    };
+
+    /**
+     * threadCache
+     *   @return ThreadCache& - the calling thread's cache.
+     */
+    CRingItemPool::ThreadCache&
+    CRingItemPool::threadCache()
+    {
+        static thread_local ThreadCache cache;
+        return cache;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // Scope implementation.
+
+    /**
+     * constructor
+     *   @param pPool - the pool to make current (may be nullptr).
+     */
+    CRingItemPool::Scope::Scope(CRingItemPool* pPool) :
+        m_pPrior(pCurrentPool)
+    {
+        pCurrentPool = pPool;
+    }
+    /**
+     * destructor
+     *    Restore the prior current pool.
+     */
+    CRingItemPool::Scope::~Scope()
+    {
+        pCurrentPool = m_pPrior;
+    }
+
+    ///////////////////////////////////////////////////////////////////////
+    // CRingItemPool implementation.
+
+    /**
+     * constructor
+     *   @param threadCacheDepth - Maximum blocks per size class each thread
+     *               caches.  Larger values mean less locking.
+     *   @param sharedDepth - Maximum blocks per size class on the shared
+     *               free lists.  Blocks freed beyond this go back to the
+     *               system.
+     */
+    CRingItemPool::CRingItemPool(size_t threadCacheDepth, size_t sharedDepth) :
+        m_threadCacheDepth(threadCacheDepth), m_sharedDepth(sharedDepth),
+        m_hits(0), m_threadCacheHits(0), m_misses(0), m_frees(0),
+        m_oversized(0)
+    {
+        CriticalSection l(registryLock());
+        livePools().insert(this);
+    }
+    /**
+     * destructor
+     *    The calling thread's cached blocks come back to us and all
+     *    shared free blocks are released.  Other threads will release their
+     *    cached blocks to the system when they exit or change pools.
+     */
+    CRingItemPool::~CRingItemPool()
+    {
+        ThreadCache& cache(threadCache());
+        if (cache.s_pPool == this) {
+            cache.unbind();
+        }
+        {
+            CriticalSection l(registryLock());
+            livePools().erase(this);
+        }
+        trim();
+    }
+
+    /**
+     * allocate
+     *    Allocate memory from a pool.
+     * @param pPool - the pool, if nullptr the memory comes from the system
+     *                but can still be freed with release.
+     * @param nBytes - number of bytes needed.
+     * @return void* - the memory.
+     * @throw std::bad_alloc - if the system is out of memory.
+     */
+    void*
+    CRingItemPool::allocate(CRingItemPool* pPool, size_t nBytes)
+    {
+        size_t total = nBytes + sizeof(BlockHeader);
+        BlockHeader* pHeader;
+        if (pPool && (total <= MAX_POOLED)) {
+            unsigned c = sizeClass(total);
+            pHeader = static_cast<BlockHeader*>(pPool->get(c));
+            pHeader->s_pPool = pPool;
+            pHeader->s_class = c;
+        } else {
+            if (pPool) pPool->m_oversized++;
+            pHeader = static_cast<BlockHeader*>(::operator new(total));
+            pHeader->s_pPool = nullptr;
+            pHeader->s_class = UNPOOLED;
+        }
+        pHeader->s_magic = BLOCK_MAGIC;
+        return pHeader + 1;
+    }
+    /**
+     * release
+     *    Free memory gotten from allocate.  The block goes back to the
+     *    pool it came from (if any).
+     * @param p - pointer returned by allocate (nullptr is ok).
+     */
+    void
+    CRingItemPool::release(void* p)
+    {
+        if (!p) return;
+        BlockHeader* pHeader = static_cast<BlockHeader*>(p) - 1;
+        if (pHeader->s_pPool) {
+            pHeader->s_pPool->put(pHeader, pHeader->s_class);
+        } else {
+            ::operator delete(pHeader);
+        }
+    }
+    /**
+     * current
+     *   @return CRingItemPool* - the thread's current pool (nullptr if none).
+     */
+    CRingItemPool*
+    CRingItemPool::current()
+    {
+        return pCurrentPool;
+    }
+    /**
+     * getStatistics
+     *   @return Statistics - the counters and the current contents of the
+     *             shared free lists.
+     */
+    CRingItemPool::Statistics
+    CRingItemPool::getStatistics()
+    {
+        Statistics result;
+        result.s_hits            = m_hits;
+        result.s_threadCacheHits = m_threadCacheHits;
+        result.s_misses          = m_misses;
+        result.s_frees           = m_frees;
+        result.s_oversized       = m_oversized;
+        result.s_sharedBlocks    = 0;
+        result.s_sharedBytes     = 0;
+
+        std::lock_guard<std::mutex> l(m_lock);
+        for (unsigned i = 0; i < NUM_CLASSES; i++) {
+            result.s_sharedBlocks += m_freeLists[i].size();
+            result.s_sharedBytes  += m_freeLists[i].size() * classSize(i);
+        }
+        return result;
+    }
+    /**
+     * clearStatistics
+     *    Zero the counters.
+     */
+    void
+    CRingItemPool::clearStatistics()
+    {
+        m_hits = 0;
+        m_threadCacheHits = 0;
+        m_misses = 0;
+        m_frees = 0;
+        m_oversized = 0;
+    }
+    /**
+     * trim
+     *    Give the blocks on the shared free lists back to the system.
+     *    The calling thread's cached blocks are given back as well.
+     */
+    void
+    CRingItemPool::trim()
+    {
+        ThreadCache& cache(threadCache());
+        if (cache.s_pPool == this) {
+            cache.unbind();
+        }
+        std::lock_guard<std::mutex> l(m_lock);
+        for (unsigned i = 0; i < NUM_CLASSES; i++) {
+            std::vector<void*>& blocks(m_freeLists[i]);
+            for (size_t b = 0; b < blocks.size(); b++) {
+                ::operator delete(blocks[b]);
+            }
+            blocks.clear();
+            blocks.shrink_to_fit();
+        }
+    }
+    /**
+     * sizeClass
+     *    Size classes are MIN_BLOCK and then four evenly spaced sizes
+     *    per power of two.
+     * @param nBytes - number of bytes needed.
+     * @return unsigned - smallest size class that holds nBytes.
+     */
+    unsigned
+    CRingItemPool::sizeClass(size_t nBytes)
+    {
+        if (nBytes <= MIN_BLOCK) return 0;
+        unsigned k = 63 - __builtin_clzll(nBytes - 1);   // 2^k < nBytes <= 2^(k+1)
+        size_t   base = size_t(1) << k;
+        size_t   step = base >> 2;
+        unsigned j    = (nBytes - base + step - 1) / step; // 1-4
+        return (k - 6)*4 + j;
+    }
+    /**
+     * classSize
+     *   @param sizeClass - a size class.
+     *   @return size_t - the block size of that class.
+     */
+    size_t
+    CRingItemPool::classSize(unsigned sizeClass)
+    {
+        if (sizeClass == 0) return MIN_BLOCK;
+        unsigned k = 6 + (sizeClass - 1)/4;
+        unsigned j = (sizeClass - 1) % 4 + 1;
+        return (size_t(1) << k) + j*(size_t(1) << (k - 2));
+    }
+    ///////////////////////////////////////////////////////////////////////
+    // Private utilities.
+
+    /**
+     * get
+     *    Get a block of a size class.  The thread cache is tried first,
+     *    then the shared list (taking a batch of blocks into the thread
+     *    cache) and finally the system.
+     * @param sizeClass - the size class.
+     * @return void* - the block (header included).
+     */
+    void*
+    CRingItemPool::get(unsigned sizeClass)
+    {
+        ThreadCache& cache(threadCache());
+        cache.bind(this);
+        std::vector<void*>& blocks(cache.s_blocks[sizeClass]);
+        if (!blocks.empty()) {
+            m_hits++;
+            m_threadCacheHits++;
+            void* p = blocks.back();
+            blocks.pop_back();
+            return p;
+        }
+        // Refill half the thread cache from the shared list:
+
+        size_t nWanted = m_threadCacheDepth/2 + 1;
+        blocks.resize(nWanted);
+        size_t nGot = getShared(blocks.data(), nWanted, sizeClass);
+        blocks.resize(nGot);
+        if (!blocks.empty()) {
+            m_hits++;
+            void* p = blocks.back();
+            blocks.pop_back();
+            return p;
+        }
+        m_misses++;
+        return ::operator new(classSize(sizeClass));
+    }
+    /**
+     * put
+     *    Free a block into the calling thread's cache.  If the cache is
+     *    full half of it is moved to the shared list.  If the thread's
+     *    cache belongs to a different pool the block goes straight to
+     *    the shared list.
+     * @param pBlock - the block (header included).
+     * @param sizeClass - its size class.
+     */
+    void
+    CRingItemPool::put(void* pBlock, unsigned sizeClass)
+    {
+        m_frees++;
+        ThreadCache& cache(threadCache());
+        if (!cache.s_pPool) {
+            cache.bind(this);
+        }
+        if ((cache.s_pPool != this) || (m_threadCacheDepth == 0)) {
+            putShared(&pBlock, 1, sizeClass);
+            return;
+        }
+        std::vector<void*>& blocks(cache.s_blocks[sizeClass]);
+        if (blocks.size() >= m_threadCacheDepth) {
+            size_t nMove = blocks.size()/2;
+            if (nMove == 0) nMove = 1;
+            putShared(blocks.data() + blocks.size() - nMove, nMove, sizeClass);
+            blocks.resize(blocks.size() - nMove);
+        }
+        blocks.push_back(pBlock);
+    }
+    /**
+     * putShared
+     *    Put blocks on the shared free list for their class.  Blocks that
+     *    don't fit are given back to the system.
+     * @param pBlocks - pointer to the block pointers.
+     * @param nBlocks - number of blocks.
+     * @param sizeClass - their size class.
+     */
+    void
+    CRingItemPool::putShared(void** pBlocks, size_t nBlocks, unsigned sizeClass)
+    {
+        std::lock_guard<std::mutex> l(m_lock);
+        std::vector<void*>& list(m_freeLists[sizeClass]);
+        for (size_t i = 0; i < nBlocks; i++) {
+            if (list.size() < m_sharedDepth) {
+                list.push_back(pBlocks[i]);
+            } else {
+                ::operator delete(pBlocks[i]);
+            }
+        }
+    }
+    /**
+     * getShared
+     *    Take blocks from the shared free list of a class.
+     * @param pBlocks - where to put the block pointers.
+     * @param nBlocks - most blocks wanted.
+     * @param sizeClass - the size class.
+     * @return size_t - number of blocks gotten.
+     */
+    size_t
+    CRingItemPool::getShared(void** pBlocks, size_t nBlocks, unsigned sizeClass)
+    {
+        std::lock_guard<std::mutex> l(m_lock);
+        std::vector<void*>& list(m_freeLists[sizeClass]);
+        size_t n = 0;
+        while ((n < nBlocks) && !list.empty()) {
+            pBlocks[n++] = list.back();
+            list.pop_back();
+        }
+        return n;
+    }
+}
@@ -0,0 +1,127 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemPool.h
+ *  @brief: Recycling allocator for ring item objects and their storage.
+ */
+#ifndef CRINGITEMPOOL_H
+#define CRINGITEMPOOL_H
+
+#include <mutex>
+#include <stddef.h>
+#include <stdint.h>
+#include <atomic>
+#include <vector>
+
+namespace ufmt {
+    /**
+     * @class CRingItemPool
+     *    Recycles the memory used by ring item objects and by the dynamic
+     *    storage of big ring items.  Requests are rounded up to one of a set
+     *    of size classes (four per power of two).  Freed blocks go on a
+     *    free list for their size class and are handed out again to later
+     *    requests of that class.
+     *
+     *    Each thread has a small cache of free blocks so that most
+     *    allocations and frees don't touch the pool's mutex.  Blocks may be
+     *    freed in a different thread than the one that allocated them; they
+     *    go to the freeing thread's cache.  When a thread's cache for a
+     *    class fills, half of it is moved to the pool's shared free list
+     *    for that class.  When that list is full, blocks go back to the system.
+     *
+     *    Pools are selected per factory (RingItemFactoryBase::setItemPool).
+     *    While a factory creates an item the pool is made current for the
+     *    thread by a Scope object.  CRingItem's operator new and the
+     *    storage management in CRingItem use the current pool.  Every block
+     *    records the pool it came from so delete returns it to that pool.
+     *
+     * @note A pool must outlive all items allocated from it.
+     */
+    class CRingItemPool {
+    public:
+        static const size_t   MIN_BLOCK  = 64;            // Smallest class.
+        static const size_t   MAX_POOLED = 4*1024*1024;   // Bigger isn't pooled.
+        static const unsigned NUM_CLASSES = 65;
+
+        /**
+         *  Counters that help size the pool.  A hit is an allocation
+         *  satisfied from a free list, a miss had to get memory from the
+         *  system.
+         */
+        struct Statistics {
+            uint64_t s_hits;
+            uint64_t s_threadCacheHits;   // Subset of hits.
+            uint64_t s_misses;
+            uint64_t s_frees;
+            uint64_t s_oversized;         // Too big to pool.
+            uint64_t s_sharedBlocks;      // Blocks now on the shared lists.
+            uint64_t s_sharedBytes;
+        };
+        /**
+         *  Making an object of this type makes a pool the current pool for
+         *  the thread until the object is destroyed.  A null pool means
+         *  allocations come from the system.
+         */
+        class Scope {
+        private:
+            CRingItemPool* m_pPrior;
+        public:
+            Scope(CRingItemPool* pPool);
+            ~Scope();
+        private:
+            Scope(const Scope&);
+            Scope& operator=(const Scope&);
+        };
+    private:
+        struct ThreadCache;
+        friend struct ThreadCache;
+    private:
+        std::mutex            m_lock;
+        std::vector<void*>    m_freeLists[NUM_CLASSES];
+        size_t                m_threadCacheDepth;   // per class per thread.
+        size_t                m_sharedDepth;        // per class.
+        std::atomic<uint64_t> m_hits;
+        std::atomic<uint64_t> m_threadCacheHits;
+        std::atomic<uint64_t> m_misses;
+        std::atomic<uint64_t> m_frees;
+        std::atomic<uint64_t> m_oversized;
+    public:
+        CRingItemPool(size_t threadCacheDepth = 32, size_t sharedDepth = 1024);
+        virtual ~CRingItemPool();
+    private:
+        CRingItemPool(const CRingItemPool&);
+        CRingItemPool& operator=(const CRingItemPool&);
+    public:
+        static void* allocate(CRingItemPool* pPool, size_t nBytes);
+        static void  release(void* p);
+        static CRingItemPool* current();
+
+        Statistics getStatistics();
+        void       clearStatistics();
+        void       trim();
+
+        static unsigned sizeClass(size_t nBytes);
+        static size_t   classSize(unsigned sizeClass);
+    private:
+        static ThreadCache& threadCache();
+        void* get(unsigned sizeClass);
+        void  put(void* pBlock, unsigned sizeClass);
+        void  putShared(void** pBlocks, size_t nBlocks, unsigned sizeClass);
+        size_t getShared(void** pBlocks, size_t nBlocks, unsigned sizeClass);
+    };
+}
+#endif
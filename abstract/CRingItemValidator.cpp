@@ -0,0 +1,267 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemValidator.cpp
+ *  @brief: Implement the ring item plausibility checks.
+ */
+#include "CRingItemValidator.h"
+#include "DataFormat.h"
+#include <string.h>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param version - format of the items.
+     *   @param maxItemSize - largest item size that's believable.
+     */
+    CRingItemValidator::CRingItemValidator(
+        FormatSelector::SupportedVersions version, uint32_t maxItemSize
+    ) :
+        m_version(version), m_maxItemSize(maxItemSize)
+    {}
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - format we check.
+     */
+    FormatSelector::SupportedVersions
+    CRingItemValidator::getVersion() const
+    {
+        return m_version;
+    }
+    /**
+     * getMaxItemSize
+     *   @return uint32_t - largest plausible item.
+     */
+    uint32_t
+    CRingItemValidator::getMaxItemSize() const
+    {
+        return m_maxItemSize;
+    }
+    /**
+     * headerBytes
+     *   @return size_t - number of bytes check needs to look at.  This is
+     *             the ring item header and, for v11/v12, the body header
+     *             size word.
+     */
+    size_t
+    CRingItemValidator::headerBytes() const
+    {
+        if (m_version == FormatSelector::v10) {
+            return sizeof(RingItemHeader);
+        }
+        return sizeof(RingItemHeader) + sizeof(uint32_t);
+    }
+    /**
+     * check
+     *   @param pItem - points to at least headerBytes() bytes.
+     *   @return Problem - what's implausible about them (ok if nothing).
+     */
+    CRingItemValidator::Problem
+    CRingItemValidator::check(const void* pItem) const
+    {
+        const RingItem* p = reinterpret_cast<const RingItem*>(pItem);
+        uint32_t size = p->s_header.s_size;
+        if (size < headerBytes()) {
+            return tooSmall;
+        }
+        if (size > m_maxItemSize) {
+            return tooBig;
+        }
+        if (!isKnownType(p->s_header.s_type)) {
+            return unknownType;
+        }
+        if (m_version != FormatSelector::v10) {
+            uint32_t bhSize = p->s_body.u_noBodyHeader.s_empty;
+            if ((bhSize != 0) && (bhSize != sizeof(uint32_t))) {
+                // Body headers bigger than a BodyHeader carry extension
+                // data; they just have to fit in the item.
+                
+                if ((bhSize < sizeof(BodyHeader)) ||
+                    (size < sizeof(RingItemHeader) + bhSize)) {
+                    return badBodyHeader;
+                }
+            }
+        }
+        return ok;
+    }
+    /**
+     * isPlausible
+     *   @param pItem - points to at least headerBytes() bytes.
+     *   @return bool - true if they could be the start of an item.
+     */
+    bool
+    CRingItemValidator::isPlausible(const void* pItem) const
+    {
+        return check(pItem) == ok;
+    }
+    /**
+     * isKnownType
+     *   @param type - an item type.
+     *   @return bool - true if the version defines that type or it's a
+     *                  user item type.
+     */
+    bool
+    CRingItemValidator::isKnownType(uint32_t type) const
+    {
+        if ((type >= FIRST_USER_ITEM_CODE) && (type <= 0xffff)) {
+            return true;
+        }
+        switch (type) {
+        case BEGIN_RUN:
+        case END_RUN:
+        case PAUSE_RUN:
+        case RESUME_RUN:
+        case PACKET_TYPES:
+        case MONITORED_VARIABLES:
+        case PERIODIC_SCALERS:         // INCREMENTAL_SCALERS in v10.
+        case PHYSICS_EVENT:
+        case PHYSICS_EVENT_COUNT:
+        case EVB_FRAGMENT:
+        case EVB_UNKNOWN_PAYLOAD:
+            return true;
+        case TIMESTAMPED_NONINCR_SCALERS:
+            return m_version == FormatSelector::v10;
+        case ABNORMAL_ENDRUN:
+        case RING_FORMAT:
+        case EVB_GLOM_INFO:
+            return m_version != FormatSelector::v10;
+        default:
+            return false;
+        }
+    }
+    /**
+     * problemString
+     *   @param problem - a check result.
+     *   @return const char* - describes it.
+     */
+    const char*
+    CRingItemValidator::problemString(Problem problem)
+    {
+        switch (problem) {
+        case ok:
+            return "plausible";
+        case tooSmall:
+            return "item size is smaller than a header";
+        case tooBig:
+            return "item size is larger than the maximum item size";
+        case unknownType:
+            return "item type is not known to the format";
+        case badBodyHeader:
+            return "body header size is not valid";
+        case truncated:
+            return "item runs past the end of the data";
+        default:
+            return "unknown problem";
+        }
+    }
+    /**
+     * findSync
+     *    Find the first offset in a buffer from which confirm consecutive
+     *    plausible items follow.  A shorter run of plausible items that
+     *    exactly reaches the end of the data also counts.
+     * @param pData - the data.
+     * @param nBytes - bytes of data.
+     * @param atEnd - true if there's no data after the buffer.
+     * @param[out] offset - syncFound: where the items start.
+     *                      needMoreData: first offset that's still a
+     *                      candidate; call again with data from here.
+     *                      noSync: nBytes.
+     * @param confirm - number of consecutive plausible items needed.
+     * @return SyncResult
+     */
+    CRingItemValidator::SyncResult
+    CRingItemValidator::findSync(
+        const void* pData, size_t nBytes, bool atEnd, size_t& offset,
+        unsigned confirm
+    ) const
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(pData);
+        const size_t   typeHigh = sizeof(uint32_t) + sizeof(uint16_t);
+        size_t need = headerBytes();
+        if (confirm == 0) confirm = 1;
+
+        // Positions whose header is entirely in the buffer:
+
+        size_t i = 0;
+        while (nBytes >= need && i <= nBytes - need) {
+            // Plausible types are < 0x10000 so skip to the next position
+            // whose type field has two zero high bytes:
+
+            const uint8_t* pZero = reinterpret_cast<const uint8_t*>(
+                memchr(p + i + typeHigh, 0, nBytes - i - typeHigh)
+            );
+            if (!pZero) break;
+            size_t candidate = (pZero - p) - typeHigh;
+            if (candidate > nBytes - need) break;
+            if (pZero[1] != 0) {
+                i = candidate + 1;
+                continue;
+            }
+            i = candidate;
+            if (isPlausible(p + i)) {
+                SyncResult r = checkChain(p + i, nBytes - i, atEnd, confirm);
+                if (r != noSync) {
+                    offset = i;
+                    return r;
+                }
+            }
+            i++;
+        }
+        // Positions whose header is cut off by the end of the buffer
+        // can't be checked:
+
+        if (atEnd) {
+            offset = nBytes;
+            return noSync;
+        }
+        offset = (nBytes >= need) ? (nBytes - need + 1) : 0;
+        return needMoreData;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods.
+
+    /**
+     * checkChain
+     *    See if a run of plausible items starts at the beginning of a buffer.
+     * @return SyncResult - syncFound if there is, noSync if not and
+     *             needMoreData if the buffer ends before we can tell.
+     */
+    CRingItemValidator::SyncResult
+    CRingItemValidator::checkChain(
+        const uint8_t* pData, size_t nBytes, bool atEnd, unsigned confirm
+    ) const
+    {
+        size_t need = headerBytes();
+        size_t pos  = 0;
+        for (unsigned i = 0; i < confirm; i++) {
+            if (pos == nBytes) {               // Items end with the data.
+                return atEnd ? syncFound : needMoreData;
+            }
+            if (nBytes - pos < need) {
+                return atEnd ? noSync : needMoreData;
+            }
+            if (!isPlausible(pData + pos)) {
+                return noSync;
+            }
+            pos += reinterpret_cast<const RingItemHeader*>(pData + pos)->s_size;
+            if (pos > nBytes) {
+                return atEnd ? noSync : needMoreData;
+            }
+        }
+        return syncFound;
+    }
+}
@@ -0,0 +1,92 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemValidator.h
+ *  @brief: Plausibility checks of raw ring item headers.
+ */
+#ifndef CRINGITEMVALIDATOR_H
+#define CRINGITEMVALIDATOR_H
+
+#include <NSCLDAQFormatFactorySelector.h>
+#include <stdint.h>
+#include <stddef.h>
+
+namespace ufmt {
+    /**
+     * @class CRingItemValidator
+     *    Decides whether bytes could be the start of a ring item of a
+     *    format version.  An item header is plausible if:
+     *    - Its size holds at least the header (and for v11/v12 the body
+     *      header size word) and is no bigger than a maximum item size.
+     *    - Its type is one of the version's item types or a user type
+     *      (FIRST_USER_ITEM_CODE through 0xffff).
+     *    - (v11/v12) The body header size is 0 or sizeof(uint32_t)  (no body
+     *      header) or at least sizeof(BodyHeader) (larger ones carry
+     *      extension data) and fits in the item.
+     *
+     *    A single plausible header can easily occur by chance in the middle
+     *    of an item.  findSync therefore looks for a point from which
+     *    several consecutive plausible items follow.  This is how a reader
+     *    that starts at an arbitrary offset (or after damaged data) gets
+     *    back in step with the items.  The search first looks for the
+     *    zero high half of the type field with memchr (which the C
+     *    library vectorizes) so garbage is skipped quickly; only the
+     *    positions that pass are checked in full.
+     */
+    class CRingItemValidator {
+    public:
+        static const uint32_t DEFAULT_MAX_ITEM_SIZE = 64*1024*1024;
+        static const unsigned DEFAULT_CONFIRM = 4;
+
+        enum Problem {
+            ok, tooSmall, tooBig, unknownType, badBodyHeader,
+            truncated          // Item runs past the end of the data.
+        };
+        enum SyncResult {
+            syncFound,         // offset is where items resume.
+            needMoreData,      // Can't tell without data beyond the buffer.
+            noSync             // Nothing in the buffer.
+        };
+    private:
+        FormatSelector::SupportedVersions m_version;
+        uint32_t m_maxItemSize;
+    public:
+        CRingItemValidator(
+            FormatSelector::SupportedVersions version,
+            uint32_t maxItemSize = DEFAULT_MAX_ITEM_SIZE
+        );
+
+        FormatSelector::SupportedVersions getVersion() const;
+        uint32_t getMaxItemSize() const;
+        size_t   headerBytes() const;
+
+        Problem check(const void* pItem) const;
+        bool    isPlausible(const void* pItem) const;
+        bool    isKnownType(uint32_t type) const;
+        static const char* problemString(Problem problem);
+
+        SyncResult findSync(
+            const void* pData, size_t nBytes, bool atEnd, size_t& offset,
+            unsigned confirm = DEFAULT_CONFIRM
+        ) const;
+    private:
+        SyncResult checkChain(
+            const uint8_t* pData, size_t nBytes, bool atEnd, unsigned confirm
+        ) const;
+    };
+}
+#endif
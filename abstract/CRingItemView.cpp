@@ -0,0 +1,241 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemView.cpp
+ *  @brief: Implement the non-owning ring item view.
+ */
+#include "CRingItemView.h"
+#include "CRingItem.h"
+#include "DataFormat.h"
+#include <string>
+
+namespace ufmt {
+    /**
+     * default constructor
+     *    Makes a null view.  Use setItem to point it at something.
+     */
+    CRingItemView::CRingItemView() :
+        m_pItem(nullptr), m_version(FormatSelector::v12)
+    {}
+    /**
+     * constructor
+     *  @param pItem - pointer to the raw ring item.
+     *  @param version - format version of the item.
+     */
+    CRingItemView::CRingItemView(
+        const void* pItem, FormatSelector::SupportedVersions version
+    ) :
+        m_pItem(reinterpret_cast<const RingItem*>(pItem)), m_version(version)
+    {}
+    /**
+     * constructor
+     *    View the storage of an existing ring item object.
+     *  @param item - the ring item object.
+     *  @param version - format version of the item.
+     */
+    CRingItemView::CRingItemView(
+        const CRingItem& item, FormatSelector::SupportedVersions version
+    ) :
+        m_pItem(item.getItemPointer()), m_version(version)
+    {}
+
+    ///////////////////////////////////////////////////////////////////////
+    // Selectors:
+
+    /**
+     * getItemPointer
+     *   @return const RingItem* - pointer to the raw item being viewed.
+     */
+    const RingItem*
+    CRingItemView::getItemPointer() const
+    {
+        return m_pItem;
+    }
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - format of the item.
+     */
+    FormatSelector::SupportedVersions
+    CRingItemView::getVersion() const
+    {
+        return m_version;
+    }
+    /**
+     * isNull
+     *   @return bool - true if the view does not point at an item.
+     */
+    bool
+    CRingItemView::isNull() const
+    {
+        return m_pItem == nullptr;
+    }
+    /**
+     * type
+     *   @return uint32_t - the ring item type.
+     */
+    uint32_t
+    CRingItemView::type() const
+    {
+        return m_pItem->s_header.s_type;
+    }
+    /**
+     * size
+     *   @return uint32_t - the ring item size in bytes (including header).
+     */
+    uint32_t
+    CRingItemView::size() const
+    {
+        return m_pItem->s_header.s_size;
+    }
+    /**
+     * getBodyPointer
+     *    @return const void* - pointer to the body of the item.  This is
+     *          just past the ring item header for v10 and just past the
+     *          body header (or the empty body header word) for v11/v12.
+     *          As with CRingItem, body header extensions are honored.
+     */
+    const void*
+    CRingItemView::getBodyPointer() const
+    {
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(m_pItem)
+            + sizeof(RingItemHeader);
+        if (m_version != FormatSelector::v10) {
+            uint32_t bhdrSize = m_pItem->s_body.u_noBodyHeader.s_empty;
+            if (bhdrSize < sizeof(uint32_t)) bhdrSize = sizeof(uint32_t);
+            p += bhdrSize;
+        }
+        return p;
+    }
+    /**
+     * getBodySize
+     *   @return size_t - number of bytes in the body.
+     */
+    size_t
+    CRingItemView::getBodySize() const
+    {
+        return size() - (
+            reinterpret_cast<const uint8_t*>(getBodyPointer()) -
+            reinterpret_cast<const uint8_t*>(m_pItem)
+        );
+    }
+    /**
+     * hasBodyHeader
+     *   @return bool - true if the item has a body header.
+     */
+    bool
+    CRingItemView::hasBodyHeader() const
+    {
+        return (m_version != FormatSelector::v10) &&
+            (m_pItem->s_body.u_noBodyHeader.s_empty > sizeof(uint32_t));
+    }
+    /**
+     * getBodyHeader
+     *   @return const void* - pointer to the body header.  This is a
+     *                 BodyHeader for v11 and v12.
+     *   @retval nullptr - the item has no body header.
+     */
+    const void*
+    CRingItemView::getBodyHeader() const
+    {
+        if (hasBodyHeader()) {
+            return &(m_pItem->s_body.u_hasBodyHeader.s_bodyHeader);
+        }
+        return nullptr;
+    }
+    /**
+     * getEventTimestamp
+     *   @return uint64_t - timestamp from the body header.
+     *   @throw std::string - if the item has no body header.
+     */
+    uint64_t
+    CRingItemView::getEventTimestamp() const
+    {
+        throwIfNoBodyHeader(
+            "Attempted to get a timestamp from an event that does not have one"
+        );
+        return m_pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_timestamp;
+    }
+    /**
+     * getSourceId
+     *   @return uint32_t - source id from the body header.
+     *   @throw std::string - if the item has no body header.
+     */
+    uint32_t
+    CRingItemView::getSourceId() const
+    {
+        throwIfNoBodyHeader(
+            "Attempted to get the source ID from an event that does not have one"
+        );
+        return m_pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_sourceId;
+    }
+    /**
+     * getBarrierType
+     *   @return uint32_t - barrier type from the body header.
+     *   @throw std::string - if the item has no body header.
+     */
+    uint32_t
+    CRingItemView::getBarrierType() const
+    {
+        throwIfNoBodyHeader(
+            "Attempted to get the barrier type from an event that does not have one"
+        );
+        return m_pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_barrier;
+    }
+    ///////////////////////////////////////////////////////////////////////
+    // Mutators:
+
+    /**
+     * setItem
+     *    Point the view at a different item of the same format.
+     *  @param pItem - the new item.
+     */
+    void
+    CRingItemView::setItem(const void* pItem)
+    {
+        m_pItem = reinterpret_cast<const RingItem*>(pItem);
+    }
+    /**
+     * setItem
+     *    Point the view at a different item and possibly format.
+     *  @param pItem - the new item.
+     *  @param version - format version of the new item.
+     */
+    void
+    CRingItemView::setItem(
+        const void* pItem, FormatSelector::SupportedVersions version
+    )
+    {
+        m_pItem   = reinterpret_cast<const RingItem*>(pItem);
+        m_version = version;
+    }
+    ///////////////////////////////////////////////////////////////////////
+    // Private utilities:
+
+    /**
+     * throwIfNoBodyHeader
+     *    Throw the same way CRingItem does when a body header is needed
+     *    but there isn't one.
+     * @param msg - the message to throw.
+     */
+    void
+    CRingItemView::throwIfNoBodyHeader(const char* msg) const
+    {
+        if (!hasBodyHeader()) {
+            throw std::string(msg);
+        }
+    }
+}
@@ -0,0 +1,91 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingItemView.h
+ *  @brief: Lightweight non-owning read-only view of a raw ring item.
+ */
+#ifndef CRINGITEMVIEW_H
+#define CRINGITEMVIEW_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <NSCLDAQFormatFactorySelector.h>
+
+namespace ufmt {
+    struct _RingItem;
+    typedef _RingItem RingItem, *pRingItem;
+    class CRingItem;
+
+    /**
+     * @class CRingItemView
+     *    Provides the read-only selectors of CRingItem for a raw ring item
+     *    that lives in someone else's storage (a block buffer, a memory
+     *    mapped file, a ring buffer, a queue of raw items...).  A view is
+     *    just a pointer and a format version so it's cheap to copy and
+     *    to hold in large numbers.  The body header conventions of the
+     *    format version are used to locate the body and body header:
+     *    -  v10 items have no body header.
+     *    -  v11/v12 items have a body header if the word following the
+     *       ring item header is larger than sizeof(uint32_t). That word
+     *       is the size of the body header.
+     *
+     * @note The view does not own the item; the item must outlive the view.
+     */
+    class CRingItemView {
+    private:
+        const RingItem*                   m_pItem;
+        FormatSelector::SupportedVersions m_version;
+    public:
+        CRingItemView();
+        CRingItemView(
+            const void* pItem,
+            FormatSelector::SupportedVersions version = FormatSelector::v12
+        );
+        CRingItemView(
+            const CRingItem& item,
+            FormatSelector::SupportedVersions version = FormatSelector::v12
+        );
+
+        // Selectors:
+
+    public:
+        const RingItem* getItemPointer() const;
+        FormatSelector::SupportedVersions getVersion() const;
+        bool  isNull() const;
+
+        uint32_t    type() const;
+        uint32_t    size() const;
+        const void* getBodyPointer() const;
+        size_t      getBodySize() const;
+        bool        hasBodyHeader() const;
+        const void* getBodyHeader() const;
+        uint64_t    getEventTimestamp() const;
+        uint32_t    getSourceId() const;
+        uint32_t    getBarrierType() const;
+
+        // Mutators:
+
+    public:
+        void setItem(const void* pItem);
+        void setItem(
+            const void* pItem, FormatSelector::SupportedVersions version
+        );
+    private:
+        void throwIfNoBodyHeader(const char* msg) const;
+    };
+}
+#endif
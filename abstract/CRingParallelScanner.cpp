@@ -0,0 +1,336 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingParallelScanner.cpp
+ *  @brief: Implement the multi-threaded event file scanner.
+ */
+#include "CRingParallelScanner.h"
+#include "CRingRangeReader.h"
+#include "CRingItem.h"
+#include "RingItemFactoryBase.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sstream>
+#include <stdexcept>
+#include <system_error>
+#include <thread>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param fd - file descriptor open on the event file.  The caller
+     *               owns it.  Only pread is used on it.
+     *   @param version - format of the file's items.
+     *   @param nThreads - number of scanning threads.  0 means one per
+     *               hardware thread.
+     *   @param nChunks - number of chunks to split the file into.  0 means
+     *               four per thread but no smaller than MIN_CHUNK_SIZE.
+     *               There may be fewer chunks than this if items span
+     *               several chunk boundaries.
+     *   @param blockSize - read size used when scanning the chunks.
+     *   @throw std::system_error - the file can't be stat-ed.
+     *   @throw int - errno on read errors finding chunk starts.
+     */
+    CRingParallelScanner::CRingParallelScanner(
+        int fd, FormatSelector::SupportedVersions version,
+        unsigned nThreads, unsigned nChunks, size_t blockSize
+    ) :
+        m_fd(fd), m_closeFd(false), m_validator(version), m_fileSize(0),
+        m_nThreads(nThreads), m_blockSize(blockSize), m_nextChunk(0),
+        m_failed(false)
+    {
+        init(nThreads, nChunks);
+    }
+    /**
+     * constructor
+     *    Scan a file by name.
+     *   @param path - path to the event file.
+     *   @throw std::system_error - the file can't be opened.
+     *   See the other constructor for the rest.
+     */
+    CRingParallelScanner::CRingParallelScanner(
+        const std::string& path, FormatSelector::SupportedVersions version,
+        unsigned nThreads, unsigned nChunks, size_t blockSize
+    ) :
+        m_fd(-1), m_closeFd(true), m_validator(version), m_fileSize(0),
+        m_nThreads(nThreads), m_blockSize(blockSize), m_nextChunk(0),
+        m_failed(false)
+    {
+        m_fd = open(path.c_str(), O_RDONLY);
+        if (m_fd < 0) {
+            throw std::system_error(
+                errno, std::generic_category(),
+                "CRingParallelScanner opening event file"
+            );
+        }
+        try {
+            init(nThreads, nChunks);
+        }
+        catch (...) {
+            close(m_fd);
+            throw;
+        }
+    }
+    /**
+     * destructor
+     */
+    CRingParallelScanner::~CRingParallelScanner()
+    {
+        if (m_closeFd) {
+            close(m_fd);
+        }
+    }
+    /**
+     * getThreadCount
+     *   @return unsigned - number of threads scan uses.
+     */
+    unsigned
+    CRingParallelScanner::getThreadCount() const
+    {
+        return m_nThreads;
+    }
+    /**
+     * getFileSize
+     *   @return uint64_t - size of the file when the scanner was made.
+     */
+    uint64_t
+    CRingParallelScanner::getFileSize() const
+    {
+        return m_fileSize;
+    }
+    /**
+     * getChunks
+     *   @return const std::vector<Chunk>& - the chunks in file order.
+     *              Item counts are valid after scan.
+     */
+    const std::vector<CRingParallelScanner::Chunk>&
+    CRingParallelScanner::getChunks() const
+    {
+        return m_chunks;
+    }
+    /**
+     * scan
+     *    Process all the items of the file.
+     * @param factory - makes the ring item factories and workers.
+     * @return std::vector<Worker*> - the worker of each chunk in file order.
+     *              The caller must delete these.
+     * @throw - whatever the first failing thread threw.  Workers are
+     *          deleted in that case.  std::runtime_error is thrown if a
+     *          chunk's items don't end at the start of the next chunk
+     *          (the chunk start found was not really an item boundary).
+     */
+    std::vector<CRingParallelScanner::Worker*>
+    CRingParallelScanner::scan(WorkerFactory& factory)
+    {
+        std::vector<Worker*>              workers;
+        std::vector<RingItemFactoryBase*> factories;
+        std::vector<std::exception_ptr>   errors(m_nThreads);
+        std::vector<std::thread>          threads;
+        try {
+            for (auto& c : m_chunks) {
+                c.s_itemCount = 0;
+                workers.push_back(factory.makeWorker(c));
+            }
+            for (unsigned i = 0; i < m_nThreads; i++) {
+                factories.push_back(factory.makeFactory());
+            }
+            m_nextChunk = 0;
+            m_failed    = false;
+            for (unsigned i = 0; i < m_nThreads; i++) {
+                threads.emplace_back(
+                    &CRingParallelScanner::scanThread, this, factories[i],
+                    std::ref(workers), std::ref(errors[i])
+                );
+            }
+        }
+        catch (...) {
+            m_failed = true;
+            errors.push_back(std::current_exception());
+        }
+        for (auto& t : threads) {
+            t.join();
+        }
+        for (auto p : factories) {
+            delete p;
+        }
+        for (auto& e : errors) {
+            if (e) {
+                for (auto p : workers) {
+                    delete p;
+                }
+                std::rethrow_exception(e);
+            }
+        }
+        return workers;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods.
+
+    /**
+     * init
+     *    Size the thread pool and find the chunk boundaries.
+     */
+    void
+    CRingParallelScanner::init(unsigned nThreads, unsigned nChunks)
+    {
+        struct stat s;
+        if (fstat(m_fd, &s)) {
+            throw std::system_error(
+                errno, std::generic_category(),
+                "CRingParallelScanner stat-ing event file"
+            );
+        }
+        m_fileSize = s.st_size;
+        if (nThreads == 0) {
+            nThreads = std::thread::hardware_concurrency();
+            if (nThreads == 0) nThreads = 1;
+        }
+        m_nThreads = nThreads;
+        if (nChunks == 0) {
+            nChunks = 4*nThreads;
+            uint64_t most = m_fileSize/MIN_CHUNK_SIZE;
+            if (nChunks > most) nChunks = most;
+            if (nChunks == 0) nChunks = 1;
+        }
+        // Chunk i nominally starts at i*size/nChunks. Items that span
+        // those points can make chunks empty; those are dropped.
+
+        uint64_t begin = 0;
+        for (unsigned i = 1; i <= nChunks; i++) {
+            uint64_t end = m_fileSize;
+            if (i < nChunks) {
+                uint64_t nominal = (m_fileSize * i)/nChunks;
+                end = (nominal > begin) ? syncPoint(nominal) : begin;
+            }
+            if (end > begin) {
+                Chunk c = {unsigned(m_chunks.size()), begin, end, 0};
+                m_chunks.push_back(c);
+                begin = end;
+            }
+        }
+    }
+    /**
+     * syncPoint
+     *    Find the first item boundary at or after an offset.
+     * @param offset - where to start looking.
+     * @return uint64_t - offset of the boundary (the file size if there's
+     *             none).
+     */
+    uint64_t
+    CRingParallelScanner::syncPoint(uint64_t offset)
+    {
+        size_t window = SYNC_WINDOW;
+        std::vector<uint8_t> data;
+        while (offset < m_fileSize) {
+            if (window > m_fileSize - offset) {
+                window = m_fileSize - offset;
+            }
+            data.resize(window);
+            size_t nRead = 0;
+            while (nRead < window) {
+                ssize_t n = pread(m_fd, data.data() + nRead, window - nRead, offset + nRead);
+                if (n < 0) {
+                    if (errno == EINTR) continue;
+                    throw errno;
+                }
+                if (n == 0) break;
+                nRead += n;
+            }
+            bool atEnd = (offset + nRead) >= m_fileSize;
+            size_t found;
+            switch (m_validator.findSync(data.data(), nRead, atEnd, found)) {
+            case CRingItemValidator::syncFound:
+                return offset + found;
+            case CRingItemValidator::needMoreData:
+                if (found == 0) {
+                    window *= 2;               // Candidate needs a longer look.
+                }
+                offset += found;
+                break;
+            case CRingItemValidator::noSync:
+                if (atEnd) {
+                    return m_fileSize;
+                }
+                offset += found;
+                break;
+            }
+        }
+        return m_fileSize;
+    }
+    /**
+     * scanThread
+     *    Scan chunks until there are none left.
+     * @param pFactory - this thread's ring item factory.
+     * @param workers - the chunk workers.
+     * @param error   - where to put an exception that stops the thread.
+     */
+    void
+    CRingParallelScanner::scanThread(
+        RingItemFactoryBase* pFactory, std::vector<Worker*>& workers,
+        std::exception_ptr& error
+    )
+    {
+        CRingItem* pItem = nullptr;
+        try {
+            pItem = pFactory->makeRingItem(uint16_t(0), size_t(0));
+            unsigned i;
+            while (!m_failed && ((i = m_nextChunk++) < m_chunks.size())) {
+                scanChunk(m_chunks[i], *pFactory, *pItem, *workers[i]);
+            }
+        }
+        catch (...) {
+            m_failed = true;
+            error = std::current_exception();
+        }
+        delete pItem;
+    }
+    /**
+     * scanChunk
+     *    Give the items of a chunk to its worker.
+     * @param chunk - the chunk.
+     * @param factory - gets the items.
+     * @param item - item refilled with each item of the chunk.
+     * @param worker - processes them.
+     * @throw std::runtime_error - the items overran the end of the chunk.
+     */
+    void
+    CRingParallelScanner::scanChunk(
+        Chunk& chunk, RingItemFactoryBase& factory, CRingItem& item,
+        Worker& worker
+    )
+    {
+        CRingRangeReader reader(m_fd, chunk.s_begin, chunk.s_end, m_blockSize);
+        uint64_t offset = chunk.s_begin;
+        while (!m_failed && factory.getRingItem(reader, item)) {
+            worker.process(item, offset);
+            offset += item.size();
+            chunk.s_itemCount++;
+        }
+        if (m_failed) {
+            return;
+        }
+        if (offset != chunk.s_end) {
+            std::stringstream msg;
+            msg << "CRingParallelScanner - items of chunk " << chunk.s_index
+                << " end at " << offset << " not at the chunk end " << chunk.s_end;
+            throw std::runtime_error(msg.str());
+        }
+        worker.done();
+    }
+}
@@ -0,0 +1,134 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingParallelScanner.h
+ *  @brief: Scan the items of an event file with several threads.
+ */
+#ifndef CRINGPARALLELSCANNER_H
+#define CRINGPARALLELSCANNER_H
+
+#include "CRingItemValidator.h"
+#include "CRingBlockReader.h"
+#include <NSCLDAQFormatFactorySelector.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <exception>
+#include <string>
+#include <vector>
+
+namespace ufmt {
+    class CRingItem;
+    class RingItemFactoryBase;
+
+    /**
+     * @class CRingParallelScanner
+     *    Passes over all of the items of a file using a pool of threads.
+     *    The file is split into chunks of about equal size.  The start of
+     *    each chunk (but the first) is moved forward to the first item
+     *    boundary after it, found with a CRingItemValidator, so every item
+     *    belongs to exactly one chunk.  Threads take chunks one at a time
+     *    and read their items with a CRingRangeReader.
+     *
+     *    The caller supplies a WorkerFactory.  It makes a ring item factory
+     *    for each thread, so no factory (or its item pool) is shared
+     *    between threads, and a Worker for each chunk which is given the
+     *    chunk's items in order.  scan returns the workers in file order
+     *    so their results can be merged in that order; e.g. concatenating
+     *    per-worker output gives the output of a single threaded pass.
+     *
+     *    Chunks do not know the run state at their start, so work that
+     *    depends on earlier items (e.g. the current run number) must be
+     *    resolved when merging.
+     */
+    class CRingParallelScanner {
+    public:
+        static const size_t MIN_CHUNK_SIZE = 1024*1024;   // For default chunking.
+        static const size_t SYNC_WINDOW    = 64*1024;     // First sync read.
+
+        struct Chunk {
+            unsigned s_index;
+            uint64_t s_begin;          // Offset of the first item.
+            uint64_t s_end;            // Offset just past the last item.
+            uint64_t s_itemCount;      // Set by scan.
+        };
+        /**
+         *  Processes the items of one chunk.  Each worker is only used by
+         *  one thread at a time.
+         */
+        class Worker {
+        public:
+            virtual ~Worker() {}
+            virtual void process(CRingItem& item, uint64_t offset) = 0;
+            virtual void done() {}            // After the chunk's last item.
+        };
+        /**
+         *  Makes the per thread factories and per chunk workers.  These
+         *  are called from the thread that calls scan, before the scan
+         *  starts.
+         */
+        class WorkerFactory {
+        public:
+            virtual ~WorkerFactory() {}
+            virtual RingItemFactoryBase* makeFactory() = 0;
+            virtual Worker* makeWorker(const Chunk& chunk) = 0;
+        };
+    private:
+        int                m_fd;
+        bool               m_closeFd;
+        CRingItemValidator m_validator;
+        uint64_t           m_fileSize;
+        unsigned           m_nThreads;
+        size_t             m_blockSize;
+        std::vector<Chunk> m_chunks;
+        std::atomic<unsigned> m_nextChunk;
+        std::atomic<bool>     m_failed;
+    public:
+        CRingParallelScanner(
+            int fd, FormatSelector::SupportedVersions version,
+            unsigned nThreads = 0, unsigned nChunks = 0,
+            size_t blockSize = CRingBlockReader::DEFAULT_BLOCK_SIZE
+        );
+        CRingParallelScanner(
+            const std::string& path, FormatSelector::SupportedVersions version,
+            unsigned nThreads = 0, unsigned nChunks = 0,
+            size_t blockSize = CRingBlockReader::DEFAULT_BLOCK_SIZE
+        );
+        virtual ~CRingParallelScanner();
+    private:
+        CRingParallelScanner(const CRingParallelScanner& rhs);
+        CRingParallelScanner& operator=(const CRingParallelScanner& rhs);
+    public:
+        unsigned getThreadCount() const;
+        uint64_t getFileSize() const;
+        const std::vector<Chunk>& getChunks() const;
+
+        std::vector<Worker*> scan(WorkerFactory& factory);
+    private:
+        void     init(unsigned nThreads, unsigned nChunks);
+        uint64_t syncPoint(uint64_t offset);
+        void     scanThread(
+            RingItemFactoryBase* pFactory, std::vector<Worker*>& workers,
+            std::exception_ptr& error
+        );
+        void     scanChunk(
+            Chunk& chunk, RingItemFactoryBase& factory, CRingItem& item,
+            Worker& worker
+        );
+    };
+}
+#endif
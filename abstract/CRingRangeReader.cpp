@@ -0,0 +1,100 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingRangeReader.cpp
+ *  @brief: Implement the byte range block reader.
+ */
+#include "CRingRangeReader.h"
+#include <errno.h>
+#include <algorithm>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param fd - file descriptor open on the file (caller owns it).
+     *   @param begin - offset of the first byte to read, which should be
+     *                the start of a ring item.
+     *   @param end  - offset just past the last byte to read.
+     *   @param blockSize - most bytes to read at a time.
+     */
+    CRingRangeReader::CRingRangeReader(
+        int fd, uint64_t begin, uint64_t end, size_t blockSize
+    ) :
+        CRingBlockReader(fd, blockSize), m_offset(begin), m_end(end)
+    {}
+    /**
+     * getOffset
+     *   @return uint64_t - file offset of the next byte to be read from the
+     *             file.  Bytes read but not yet consumed are bytesBuffered().
+     */
+    uint64_t
+    CRingRangeReader::getOffset() const
+    {
+        return m_offset;
+    }
+    /**
+     * getEnd
+     *   @return uint64_t - offset just past the range.
+     */
+    uint64_t
+    CRingRangeReader::getEnd() const
+    {
+        return m_end;
+    }
+    /**
+     * readBlock
+     *    Read the next bytes of the range.
+     * @param pDest - where to put the data.
+     * @param nBytes - most bytes to read.
+     * @return ssize_t - number of bytes read, 0 at the end of the range
+     *                (or of the file).
+     * @throw int - errno on read errors.
+     */
+    ssize_t
+    CRingRangeReader::readBlock(void* pDest, size_t nBytes)
+    {
+        if (m_offset >= m_end) {
+            return 0;
+        }
+        if (nBytes > m_end - m_offset) {
+            nBytes = m_end - m_offset;
+        }
+        ssize_t nRead;
+        do {
+            nRead = pread(m_fd, pDest, nBytes, m_offset);
+        } while ((nRead < 0) && (errno == EINTR));
+        if (nRead < 0) {
+            throw errno;
+        }
+        m_offset += nRead;
+        return nRead;
+    }
+    /**
+     * skipData
+     *    Skip bytes of the range without reading them.
+     * @param nBytes - number of bytes to skip.
+     * @return uint64_t - bytes skipped, fewer than nBytes if the range
+     *                ends first.
+     */
+    uint64_t
+    CRingRangeReader::skipData(uint64_t nBytes)
+    {
+        uint64_t n = std::min(nBytes, m_end > m_offset ? m_end - m_offset : 0);
+        m_offset += n;
+        return n;
+    }
+}
@@ -0,0 +1,52 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingRangeReader.h
+ *  @brief: Block reader of the ring items in a byte range of a file.
+ */
+#ifndef CRINGRANGEREADER_H
+#define CRINGRANGEREADER_H
+
+#include "CRingBlockReader.h"
+#include <stdint.h>
+
+namespace ufmt {
+    /**
+     * @class CRingRangeReader
+     *    A CRingBlockReader that only reads the bytes [begin, end) of a
+     *    file; the end of the range looks like the end of the file.  Reads
+     *    are done with pread(2) so the descriptor's file offset is neither
+     *    used nor changed and several readers can share one descriptor
+     *    (e.g. from different threads).
+     */
+    class CRingRangeReader : public CRingBlockReader {
+    private:
+        uint64_t m_offset;             // Of the next read.
+        uint64_t m_end;
+    public:
+        CRingRangeReader(
+            int fd, uint64_t begin, uint64_t end,
+            size_t blockSize = DEFAULT_BLOCK_SIZE
+        );
+        uint64_t getOffset() const;
+        uint64_t getEnd() const;
+    protected:
+        virtual ssize_t readBlock(void* pDest, size_t nBytes);
+        virtual uint64_t skipData(uint64_t nBytes);
+    };
+}
+#endif
@@ -0,0 +1,329 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingReadAheadReader.cpp
+ *  @brief: Implement the read-ahead block reader.
+ */
+#include "CRingReadAheadReader.h"
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <algorithm>
+#include <stdexcept>
+
+namespace ufmt {
+    /**
+     * constructor
+     *    Allocates the buffers and starts the reader thread.
+     *   @param fd - file descriptor open on the ring item source.
+     *   @param bufferSize - size of each read-ahead buffer.  This is also
+     *                 the block size of the underlying block reader.
+     *   @param depth - number of read-ahead buffers.
+     *   @throw std::invalid_argument - the buffer size or depth is zero.
+     */
+    CRingReadAheadReader::CRingReadAheadReader(
+        int fd, size_t bufferSize, unsigned depth
+    ) :
+        CRingBlockReader(fd, bufferSize), m_bufferSize(bufferSize),
+        m_carrySize(std::min(bufferSize, MAX_CARRY_SIZE)),
+        m_fillIndex(0), m_drainIndex(0), m_nReady(0), m_done(false),
+        m_stalls(0), m_exchanges(0), m_stopping(false)
+    {
+        if (depth == 0) {
+            throw std::invalid_argument(
+                "CRingReadAheadReader depth must be non-zero"
+            );
+        }
+        // The block reader's buffer must be interchangeable with ours:
+
+        delete []CRingBlockReader::m_pBuffer;
+        CRingBlockReader::m_pBuffer    = new uint8_t[m_carrySize + m_bufferSize];
+        CRingBlockReader::m_bufferSize = m_carrySize + m_bufferSize;
+
+        m_buffers.resize(depth);
+        for (auto& b : m_buffers) {
+            b.s_pData    = new uint8_t[m_carrySize + m_bufferSize];
+            b.s_nBytes   = 0;
+            b.s_consumed = 0;
+        }
+        m_reader = std::thread(&CRingReadAheadReader::readAheadThread, this);
+    }
+    /**
+     * destructor
+     *    Stop the reader thread and release the buffers.  The thread
+     *    notices within a poll interval even if it's waiting for data.
+     */
+    CRingReadAheadReader::~CRingReadAheadReader()
+    {
+        {
+            std::lock_guard<std::mutex> s(m_lock);
+            m_stopping = true;
+        }
+        m_spaceFree.notify_one();
+        m_reader.join();
+        for (auto& b : m_buffers) {
+            delete []b.s_pData;
+        }
+    }
+    /**
+     * getDepth
+     *  @return unsigned - number of read-ahead buffers.
+     */
+    unsigned
+    CRingReadAheadReader::getDepth() const
+    {
+        return m_buffers.size();
+    }
+    /**
+     * getBufferSize
+     *  @return size_t - size of each read-ahead buffer.
+     */
+    size_t
+    CRingReadAheadReader::getBufferSize() const
+    {
+        return m_bufferSize;
+    }
+    /**
+     * buffersReady
+     *  @return size_t - number of buffers read but not fully consumed.
+     */
+    size_t
+    CRingReadAheadReader::buffersReady()
+    {
+        std::lock_guard<std::mutex> s(m_lock);
+        return m_nReady;
+    }
+    /**
+     * getStalls
+     *  @return uint64_t - number of times readBlock had to wait for the
+     *                reader thread.  If this grows steadily the source is
+     *                slower than the consumer and more depth won't help.
+     */
+    uint64_t
+    CRingReadAheadReader::getStalls()
+    {
+        std::lock_guard<std::mutex> s(m_lock);
+        return m_stalls;
+    }
+    /**
+     * getExchanges
+     *  @return uint64_t - number of filled buffers handed to the block
+     *                reader without copying their data.
+     */
+    uint64_t
+    CRingReadAheadReader::getExchanges()
+    {
+        std::lock_guard<std::mutex> s(m_lock);
+        return m_exchanges;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Protected methods:
+
+    /**
+     * skipData
+     *    The reader thread owns the file position so skipped data are
+     *    taken from the buffers and thrown away.
+     * @param nBytes - number of bytes to skip.
+     * @return uint64_t - bytes skipped, fewer than nBytes at end of file.
+     */
+    uint64_t
+    CRingReadAheadReader::skipData(uint64_t nBytes)
+    {
+        return discardData(nBytes);
+    }
+
+    /**
+     * readBlock
+     *    Take data from the oldest ready buffer, waiting for the reader
+     *    thread if there is none.  The copy is done outside the lock; the
+     *    reader thread never touches a ready buffer.
+     * @param pDest - where to put the data.
+     * @param nBytes - most bytes to take.
+     * @return ssize_t - number of bytes taken, 0 on end of file.
+     * @throw int - errno if the reader thread had a read error.
+     */
+    ssize_t
+    CRingReadAheadReader::readBlock(void* pDest, size_t nBytes)
+    {
+        const uint8_t* pSrc;
+        size_t n;
+        {
+            std::unique_lock<std::mutex> s(m_lock);
+            if (!waitForData(s)) {
+                return 0;
+            }
+            Buffer& b = m_buffers[m_drainIndex];
+            pSrc = b.s_pData + m_carrySize + b.s_consumed;
+            n    = std::min(nBytes, b.s_nBytes - b.s_consumed);
+        }
+        memcpy(pDest, pSrc, n);
+
+        std::lock_guard<std::mutex> s(m_lock);
+        Buffer& b = m_buffers[m_drainIndex];
+        b.s_consumed += n;
+        if (b.s_consumed == b.s_nBytes) {
+            m_drainIndex = (m_drainIndex + 1) % m_buffers.size();
+            m_nReady--;
+            m_spaceFree.notify_one();
+        }
+        return n;
+    }
+    /**
+     * exchangeBuffer
+     *    Give the block reader the oldest filled buffer in place of its
+     *    own, which becomes free for the reader thread.  The unconsumed
+     *    bytes of the block reader's buffer are copied into the room in
+     *    front of the new data.
+     *    If the block reader grew its buffer for a big item, that buffer
+     *    is freed and the reader thread gets a new one of the usual size.
+     * @return bool - false if there's no filled buffer (end of file or an
+     *                error, which readBlock reports) or the unconsumed bytes
+     *                don't fit in front of the data.
+     * @throw int - errno if the reader thread had a read error.
+     */
+    bool
+    CRingReadAheadReader::exchangeBuffer()
+    {
+        std::unique_lock<std::mutex> s(m_lock);
+        if (!waitForData(s)) {
+            return false;
+        }
+        Buffer& b = m_buffers[m_drainIndex];
+        size_t keep  = m_endData - m_cursor;
+        size_t start = m_carrySize + b.s_consumed;
+        if (keep > start) {
+            return false;
+        }
+        memcpy(b.s_pData + start - keep, CRingBlockReader::m_pBuffer + m_cursor, keep);
+        std::swap(b.s_pData, CRingBlockReader::m_pBuffer);
+        if (CRingBlockReader::m_bufferSize != m_carrySize + m_bufferSize) {
+            delete []b.s_pData;
+            b.s_pData = new uint8_t[m_carrySize + m_bufferSize];
+            CRingBlockReader::m_bufferSize = m_carrySize + m_bufferSize;
+        }
+        m_cursor  = start - keep;
+        m_endData = m_carrySize + b.s_nBytes;
+
+        m_drainIndex = (m_drainIndex + 1) % m_buffers.size();
+        m_nReady--;
+        m_exchanges++;
+        m_spaceFree.notify_one();
+        return true;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods:
+
+    /**
+     * waitForData
+     *    Wait until there's a filled buffer or the reader thread is done.
+     * @param lock - lock on m_lock, held.
+     * @return bool - true if there's a filled buffer, false at end of file.
+     * @throw int - errno if the reader thread had a read error (once).
+     */
+    bool
+    CRingReadAheadReader::waitForData(std::unique_lock<std::mutex>& lock)
+    {
+        if ((m_nReady == 0) && !m_done) {
+            m_stalls++;
+            while ((m_nReady == 0) && !m_done) {
+                m_dataReady.wait(lock);
+            }
+        }
+        if (m_nReady == 0) {
+            if (m_error) {
+                std::exception_ptr e = m_error;
+                m_error = nullptr;
+                std::rethrow_exception(e);
+            }
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * readAheadThread
+     *    Fill free buffers until end of file, an error or we're stopped.
+     *    The read itself is done without holding the lock.
+     */
+    void
+    CRingReadAheadReader::readAheadThread()
+    {
+        while (true) {
+            size_t slot;
+            uint8_t* pData;
+            {
+                std::unique_lock<std::mutex> s(m_lock);
+                while (!m_stopping && (m_nReady == m_buffers.size())) {
+                    m_spaceFree.wait(s);
+                }
+                if (m_stopping) return;
+                slot  = m_fillIndex;
+                pData = m_buffers[slot].s_pData;   // exchangeBuffer changes it.
+            }
+            Buffer& b = m_buffers[slot];
+            ssize_t nRead;
+            std::exception_ptr error;
+            try {
+                nRead = waitAndRead(pData + m_carrySize, m_bufferSize);
+            }
+            catch (...) {
+                error = std::current_exception();
+                nRead = 0;
+            }
+
+            std::lock_guard<std::mutex> s(m_lock);
+            if (m_stopping) return;
+            if (nRead <= 0) {
+                m_error = error;
+                m_done  = true;
+                m_dataReady.notify_one();
+                return;
+            }
+            b.s_nBytes   = nRead;
+            b.s_consumed = 0;
+            m_fillIndex  = (slot + 1) % m_buffers.size();
+            m_nReady++;
+            m_dataReady.notify_one();
+        }
+    }
+    /**
+     * waitAndRead
+     *    Wait for the descriptor to be readable, then read it.  The wait
+     *    is done in short polls so that a stop request isn't held up by
+     *    a pipe or socket with no data.
+     * @param pDest - where to read.
+     * @param nBytes - most bytes to read.
+     * @return ssize_t - bytes read, 0 on end of file, -1 if stopping.
+     * @throw int - errno on non-retriable errors.
+     */
+    ssize_t
+    CRingReadAheadReader::waitAndRead(void* pDest, size_t nBytes)
+    {
+        if (m_fd >= 0) {                 // poll ignores negative fds.
+            pollfd p = {m_fd, POLLIN, 0};
+            while (true) {
+                if (m_stopping) return -1;
+                int status = poll(&p, 1, 100);
+                if (status > 0) break;
+                if ((status < 0) && (errno != EINTR)) {
+                    throw errno;
+                }
+            }
+        }
+        return CRingBlockReader::readBlock(pDest, nBytes);
+    }
+}
@@ -0,0 +1,109 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingReadAheadReader.h
+ *  @brief: Block reader whose reads are done ahead by a background thread.
+ */
+#ifndef CRINGREADAHEADREADER_H
+#define CRINGREADAHEADREADER_H
+
+#include "CRingBlockReader.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace ufmt {
+    /**
+     * @class CRingReadAheadReader
+     *    A CRingBlockReader that doesn't make its consumer wait on the
+     *    kernel.  A background thread reads the file descriptor into a
+     *    ring of buffers (depth of them, each bufferSize bytes) as long
+     *    as there's a free buffer.  readBlock takes data from the oldest
+     *    full buffer, only waiting if the reader thread has fallen behind.
+     *    A depth of 2 is double buffering, 3 triple buffering and so on.
+     *
+     *    Filled buffers are not copied into the block reader's buffer.
+     *    Instead the block reader's buffer is exchanged for the filled one
+     *    (see exchangeBuffer) and goes back to the reader thread to be
+     *    refilled.  Each buffer has room in front of its data for the
+     *    start of an item that straddles two buffers, which is the only
+     *    data copied.  Items that straddle with more than that are put
+     *    together by the ordinary copying readBlock.
+     *
+     *    Reading starts when the object is constructed.  End of file and
+     *    read errors are reported to the consumer once it has taken all
+     *    the data read before them.
+     *
+     *  @note the file descriptor is owned by the caller and must not be
+     *        read by anything else while the reader exists.
+     */
+    class CRingReadAheadReader : public CRingBlockReader {
+    public:
+        static const unsigned DEFAULT_DEPTH = 3;
+        static const size_t   MAX_CARRY_SIZE = 64*1024;
+    private:
+        struct Buffer {
+            uint8_t* s_pData;          // Data start at s_pData + m_carrySize.
+            size_t   s_nBytes;         // Bytes read into the buffer.
+            size_t   s_consumed;       // Bytes taken by the consumer.
+        };
+        std::vector<Buffer>         m_buffers;
+        size_t                      m_bufferSize;
+        size_t                      m_carrySize;   // Room before the data.
+        size_t                      m_fillIndex;   // Next buffer to read into.
+        size_t                      m_drainIndex;  // Next buffer to consume.
+        size_t                      m_nReady;      // Full buffers.
+        bool                        m_done;        // Reader hit EOF or error.
+        std::exception_ptr          m_error;
+        uint64_t                    m_stalls;
+        uint64_t                    m_exchanges;
+        std::atomic<bool>           m_stopping;
+        std::mutex                  m_lock;
+        std::condition_variable     m_dataReady;
+        std::condition_variable     m_spaceFree;
+        std::thread                 m_reader;
+    public:
+        CRingReadAheadReader(
+            int fd, size_t bufferSize = DEFAULT_BLOCK_SIZE,
+            unsigned depth = DEFAULT_DEPTH
+        );
+        virtual ~CRingReadAheadReader();
+    private:
+        CRingReadAheadReader(const CRingReadAheadReader& rhs);
+        CRingReadAheadReader& operator=(const CRingReadAheadReader& rhs);
+    public:
+        unsigned getDepth() const;
+        size_t   getBufferSize() const;
+        size_t   buffersReady();
+        uint64_t getStalls();
+        uint64_t getExchanges();
+    protected:
+        virtual ssize_t readBlock(void* pDest, size_t nBytes);
+        virtual uint64_t skipData(uint64_t nBytes);
+        virtual bool exchangeBuffer();
+    private:
+        bool    waitForData(std::unique_lock<std::mutex>& lock);
+        void    readAheadThread();
+        ssize_t waitAndRead(void* pDest, size_t nBytes);
+    };
+}
+#endif
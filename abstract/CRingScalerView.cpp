@@ -0,0 +1,177 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingScalerView.cpp
+ *  @brief: Implement the in place scaler item view.
+ */
+#include "CRingScalerView.h"
+#include <typeinfo>
+#include <stdexcept>
+#include <sstream>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param item - view of the item to interpret as a scaler item.
+     *   @param decoder - decoder for the item's format.
+     *   @throw std::bad_cast - the item is not a scaler item for its format.
+     */
+    CRingScalerView::CRingScalerView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    ) :
+        CRingItemView(item), m_pDecoder(&decoder)
+    {
+        if (item.isNull() || !decoder.decodeScaler(item, m_info)) {
+            throw std::bad_cast();
+        }
+    }
+    /**
+     * canView
+     *   @param item - a ring item view.
+     *   @param decoder - decoder for the item's format.
+     *   @return bool - true if the item is a scaler item of its format.
+     */
+    bool
+    CRingScalerView::canView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    )
+    {
+        RingViewDecoderBase::ScalerInfo info;
+        return !item.isNull() && decoder.decodeScaler(item, info);
+    }
+    /**
+     * getStartTime
+     *   @return uint32_t - interval start offset in ticks of getTimeDivisor.
+     */
+    uint32_t
+    CRingScalerView::getStartTime() const
+    {
+        return m_info.s_startTime;
+    }
+    /**
+     * computeStartTime
+     *   @return float - interval start offset in seconds.
+     */
+    float
+    CRingScalerView::computeStartTime() const
+    {
+        return float(getStartTime())/float(getTimeDivisor());
+    }
+    /**
+     * getEndTime
+     *   @return uint32_t - interval end offset in ticks of getTimeDivisor.
+     */
+    uint32_t
+    CRingScalerView::getEndTime() const
+    {
+        return m_info.s_endTime;
+    }
+    /**
+     * computeEndTime
+     *   @return float - interval end offset in seconds.
+     */
+    float
+    CRingScalerView::computeEndTime() const
+    {
+        return float(getEndTime())/float(getTimeDivisor());
+    }
+    /**
+     * getTimeDivisor
+     *   @return uint32_t - ticks per second of the interval offsets.
+     *                      v10 incremental scalers are always in seconds.
+     */
+    uint32_t
+    CRingScalerView::getTimeDivisor() const
+    {
+        return m_info.s_divisor;
+    }
+    /**
+     * getTimestamp
+     *   @return time_t - clock time at which the scalers were read.
+     */
+    time_t
+    CRingScalerView::getTimestamp() const
+    {
+        return m_info.s_timestamp;
+    }
+    /**
+     * isIncremental
+     *   @return bool - true if the scalers are cleared after each read.
+     *                  In v10 this is given by the item type.
+     */
+    bool
+    CRingScalerView::isIncremental() const
+    {
+        return m_info.s_isIncremental;
+    }
+    /**
+     * getScalerCount
+     *   @return uint32_t - number of scalers in the item.
+     */
+    uint32_t
+    CRingScalerView::getScalerCount() const
+    {
+        return m_info.s_scalerCount;
+    }
+    /**
+     * getScaler
+     *   @param channel - scaler channel number.
+     *   @return uint32_t - the value of that scaler.
+     *   @throw std::logic_error - channel is out of range (as
+     *                CRingScalerItem::getScaler does).
+     */
+    uint32_t
+    CRingScalerView::getScaler(uint32_t channel) const
+    {
+        if (channel >= getScalerCount()) {
+            std::stringstream msg;
+            msg << "Attempting to get a scaler value"
+                << " : Requested scaler " << channel << " but there are only "
+                << getScalerCount() << " scalers in the item";
+            throw std::logic_error(msg.str());
+        }
+        return m_pDecoder->getScaler(*this, channel);
+    }
+    /**
+     * getScalers
+     *   @return std::vector<uint32_t> - copy of the scalers.  As with
+     *                CRingScalerItem these are copied one at a time as
+     *                they're in packed structs.
+     */
+    std::vector<uint32_t>
+    CRingScalerView::getScalers() const
+    {
+        std::vector<uint32_t> result;
+        uint32_t n = getScalerCount();
+        result.reserve(n);
+        for (uint32_t i = 0; i < n; i++) {
+            result.push_back(m_pDecoder->getScaler(*this, i));
+        }
+        return result;
+    }
+    /**
+     * getOriginalSourceId
+     *   @return uint32_t - id of the source that made the item.  v10 has
+     *                none (0), v11 uses the body header source id if
+     *                there is one.
+     */
+    uint32_t
+    CRingScalerView::getOriginalSourceId() const
+    {
+        return m_info.s_originalSid;
+    }
+}
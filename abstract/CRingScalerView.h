@@ -0,0 +1,69 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingScalerView.h
+ *  @brief: Read-only view of a scaler ring item in place.
+ */
+#ifndef CRINGSCALERVIEW_H
+#define CRINGSCALERVIEW_H
+
+#include "CRingItemView.h"
+#include "RingViewDecoderBase.h"
+#include <time.h>
+#include <vector>
+
+namespace ufmt {
+    /**
+     * @class CRingScalerView
+     *    Provides the selectors of CRingScalerItem directly on the storage
+     *    of a scaler item without making a CRingScalerItem from it
+     *    (which copies the item).  The layout of each format version is
+     *    understood:
+     *    - v10 incremental (INCREMENTAL_SCALERS) and non incremental
+     *      (TIMESTAMPED_NONINCR_SCALERS) items.
+     *    - v11 and v12 PERIODIC_SCALERS items with or without body headers.
+     *    The layouts are decoded by the format's RingViewDecoder which,
+     *    like the item, must outlive the view.
+     */
+    class CRingScalerView : public CRingItemView {
+    private:
+        const RingViewDecoderBase*      m_pDecoder;
+        RingViewDecoderBase::ScalerInfo m_info;
+    public:
+        CRingScalerView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        static bool canView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        uint32_t getStartTime() const;
+        float    computeStartTime() const;
+        uint32_t getEndTime() const;
+        float    computeEndTime() const;
+        uint32_t getTimeDivisor() const;
+        time_t   getTimestamp() const;
+        bool     isIncremental() const;
+
+        uint32_t getScalerCount() const;
+        uint32_t getScaler(uint32_t channel) const;
+        std::vector<uint32_t> getScalers() const;
+        uint32_t getOriginalSourceId() const;
+    };
+}
+#endif
@@ -0,0 +1,128 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingStateChangeView.cpp
+ *  @brief: Implement the in place state change item view.
+ */
+#include "CRingStateChangeView.h"
+#include <typeinfo>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param item - view of the item to interpret as a state change.
+     *   @param decoder - decoder for the item's format.
+     *   @throw std::bad_cast - the item is not a state change item.
+     */
+    CRingStateChangeView::CRingStateChangeView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    ) :
+        CRingItemView(item)
+    {
+        if (item.isNull() || !decoder.decodeStateChange(item, m_info)) {
+            throw std::bad_cast();
+        }
+    }
+    /**
+     * canView
+     *   @param item - a ring item view.
+     *   @param decoder - decoder for the item's format.
+     *   @return bool - true if the item is a state change item.
+     */
+    bool
+    CRingStateChangeView::canView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    )
+    {
+        RingViewDecoderBase::StateChangeInfo info;
+        return !item.isNull() && decoder.decodeStateChange(item, info);
+    }
+    /**
+     * getRunNumber
+     *   @return uint32_t - the run number.
+     */
+    uint32_t
+    CRingStateChangeView::getRunNumber() const
+    {
+        return m_info.s_runNumber;
+    }
+    /**
+     * getElapsedTime
+     *   @return uint32_t - run time offset in ticks of getTimeDivisor.
+     */
+    uint32_t
+    CRingStateChangeView::getElapsedTime() const
+    {
+        return m_info.s_timeOffset;
+    }
+    /**
+     * getTimeDivisor
+     *   @return uint32_t - ticks per second of the elapsed time (1 for v10).
+     */
+    uint32_t
+    CRingStateChangeView::getTimeDivisor() const
+    {
+        return m_info.s_divisor;
+    }
+    /**
+     * computeElapsedTime
+     *   @return float - run time offset in seconds.
+     */
+    float
+    CRingStateChangeView::computeElapsedTime() const
+    {
+        return float(getElapsedTime())/float(getTimeDivisor());
+    }
+    /**
+     * getTitlePointer
+     *   @return const char* - the null terminated run title in the item.
+     */
+    const char*
+    CRingStateChangeView::getTitlePointer() const
+    {
+        return m_info.s_pTitle;
+    }
+    /**
+     * getTitle
+     *   @return std::string - copy of the run title.
+     */
+    std::string
+    CRingStateChangeView::getTitle() const
+    {
+        return std::string(getTitlePointer());
+    }
+    /**
+     * getTimestamp
+     *   @return time_t - clock time of the state change.
+     */
+    time_t
+    CRingStateChangeView::getTimestamp() const
+    {
+        return m_info.s_timestamp;
+    }
+    /**
+     * getOriginalSourceId
+     *   @return uint32_t - id of the source that made the item.  v10 has
+     *                none (0), v11 uses the body header source id if
+     *                there is one.
+     */
+    uint32_t
+    CRingStateChangeView::getOriginalSourceId() const
+    {
+        return m_info.s_originalSid;
+    }
+}
@@ -0,0 +1,58 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingStateChangeView.h
+ *  @brief: Read-only view of a state change ring item in place.
+ */
+#ifndef CRINGSTATECHANGEVIEW_H
+#define CRINGSTATECHANGEVIEW_H
+
+#include "CRingItemView.h"
+#include "RingViewDecoderBase.h"
+#include <time.h>
+#include <string>
+
+namespace ufmt {
+    /**
+     * @class CRingStateChangeView
+     *    Provides the selectors of CRingStateChangeItem directly on the
+     *    storage of a BEGIN_RUN, END_RUN, PAUSE_RUN or RESUME_RUN item in
+     *    any format version.
+     */
+    class CRingStateChangeView : public CRingItemView {
+    private:
+        RingViewDecoderBase::StateChangeInfo m_info;
+    public:
+        CRingStateChangeView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        static bool canView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        uint32_t    getRunNumber() const;
+        uint32_t    getElapsedTime() const;
+        uint32_t    getTimeDivisor() const;
+        float       computeElapsedTime() const;
+        const char* getTitlePointer() const;
+        std::string getTitle() const;
+        time_t      getTimestamp() const;
+        uint32_t    getOriginalSourceId() const;
+    };
+}
+#endif
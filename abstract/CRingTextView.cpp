@@ -0,0 +1,138 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingTextView.cpp
+ *  @brief: Implement the in place text item view.
+ */
+#include "CRingTextView.h"
+#include <typeinfo>
+#include <string.h>
+
+namespace ufmt {
+    /**
+     * constructor
+     *   @param item - view of the item to interpret as a text item.
+     *   @param decoder - decoder for the item's format.
+     *   @throw std::bad_cast - the item is not a text item.
+     */
+    CRingTextView::CRingTextView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    ) :
+        CRingItemView(item)
+    {
+        if (item.isNull() || !decoder.decodeText(item, m_info)) {
+            throw std::bad_cast();
+        }
+    }
+    /**
+     * canView
+     *   @param item - a ring item view.
+     *   @param decoder - decoder for the item's format.
+     *   @return bool - true if the item is a text item.
+     */
+    bool
+    CRingTextView::canView(
+        const CRingItemView& item, const RingViewDecoderBase& decoder
+    )
+    {
+        RingViewDecoderBase::TextInfo info;
+        return !item.isNull() && decoder.decodeText(item, info);
+    }
+    /**
+     * getStringCount
+     *   @return uint32_t - number of strings in the item.
+     */
+    uint32_t
+    CRingTextView::getStringCount() const
+    {
+        return m_info.s_stringCount;
+    }
+    /**
+     * getStringsPointer
+     *   @return const char* - pointer to the first of the strings.
+     */
+    const char*
+    CRingTextView::getStringsPointer() const
+    {
+        return m_info.s_pStrings;
+    }
+    /**
+     * getStrings
+     *   @return std::vector<std::string> - copies of the strings.
+     */
+    std::vector<std::string>
+    CRingTextView::getStrings() const
+    {
+        std::vector<std::string> result;
+        uint32_t n = getStringCount();
+        result.reserve(n);
+        const char* pNextString = getStringsPointer();
+        for (uint32_t i = 0; i < n; i++) {
+            size_t len = strlen(pNextString);
+            result.emplace_back(pNextString, len);
+            pNextString += len + 1;            // +1 for the trailing null.
+        }
+        return result;
+    }
+    /**
+     * getTimeOffset
+     *   @return uint32_t - run time offset in ticks of getTimeDivisor.
+     */
+    uint32_t
+    CRingTextView::getTimeOffset() const
+    {
+        return m_info.s_timeOffset;
+    }
+    /**
+     * computeElapsedTime
+     *   @return float - run time offset in seconds.
+     */
+    float
+    CRingTextView::computeElapsedTime() const
+    {
+        return float(getTimeOffset())/float(getTimeDivisor());
+    }
+    /**
+     * getTimeDivisor
+     *   @return uint32_t - ticks per second of the time offset (1 for v10).
+     */
+    uint32_t
+    CRingTextView::getTimeDivisor() const
+    {
+        return m_info.s_divisor;
+    }
+    /**
+     * getTimestamp
+     *   @return time_t - clock time at which the item was made.
+     */
+    time_t
+    CRingTextView::getTimestamp() const
+    {
+        return m_info.s_timestamp;
+    }
+    /**
+     * getOriginalSourceId
+     *   @return uint32_t - id of the source that made the item.  v10 has
+     *                none (0), v11 uses the body header source id if
+     *                there is one.
+     */
+    uint32_t
+    CRingTextView::getOriginalSourceId() const
+    {
+        return m_info.s_originalSid;
+    }
+}
@@ -0,0 +1,61 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRingTextView.h
+ *  @brief: Read-only view of a text ring item in place.
+ */
+#ifndef CRINGTEXTVIEW_H
+#define CRINGTEXTVIEW_H
+
+#include "CRingItemView.h"
+#include "RingViewDecoderBase.h"
+#include <time.h>
+#include <string>
+#include <vector>
+
+namespace ufmt {
+    /**
+     * @class CRingTextView
+     *    Provides the selectors of CRingTextItem directly on the storage of
+     *    a PACKET_TYPES or MONITORED_VARIABLES item in any format version.
+     *    The strings are back to back null terminated strings beginning
+     *    at getStringsPointer(); getStrings copies them into a vector.
+     */
+    class CRingTextView : public CRingItemView {
+    private:
+        RingViewDecoderBase::TextInfo m_info;
+    public:
+        CRingTextView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        static bool canView(
+            const CRingItemView& item, const RingViewDecoderBase& decoder
+        );
+
+        uint32_t    getStringCount() const;
+        const char* getStringsPointer() const;
+        std::vector<std::string> getStrings() const;
+
+        uint32_t getTimeOffset() const;
+        float    computeElapsedTime() const;
+        uint32_t getTimeDivisor() const;
+        time_t   getTimestamp() const;
+        uint32_t getOriginalSourceId() const;
+    };
+}
+#endif
@@ -0,0 +1,456 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRunSegmentIndex.cpp
+ *  @brief: Implement the run segment index.
+ */
+#include "CRunSegmentIndex.h"
+#include "CRingBlockReader.h"
+#include "CRingItemView.h"
+#include "CRingStateChangeView.h"
+#include "DataFormat.h"
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+
+namespace ufmt {
+    static const char MAGIC[8] = {'U', 'F', 'M', 'T', 'R', 'U', 'N', '1'};
+
+    // Helpers to read/write the saved index:
+
+    template<typename T> static void
+    put(std::ostream& out, const T& value)
+    {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+    }
+    static void
+    putString(std::ostream& out, const std::string& s)
+    {
+        put(out, uint32_t(s.size()));
+        out.write(s.data(), s.size());
+    }
+    template<typename T> static T
+    get(std::istream& in)
+    {
+        T value;
+        in.read(reinterpret_cast<char*>(&value), sizeof(T));
+        if (!in) {
+            throw std::runtime_error("Run segment index file is truncated");
+        }
+        return value;
+    }
+    static std::string
+    getString(std::istream& in)
+    {
+        uint32_t n = get<uint32_t>(in);
+        std::string result(n, ' ');
+        in.read(&result[0], n);
+        if (!in) {
+            throw std::runtime_error("Run segment index file is truncated");
+        }
+        return result;
+    }
+
+    /**
+     * constructor
+     *    Makes an empty index; use build or read to fill it in.
+     */
+    CRunSegmentIndex::CRunSegmentIndex() :
+        m_version(FormatSelector::v12), m_pDecoder(nullptr)
+    {}
+    /**
+     * build
+     *    Scan a set of files and index their run segments.
+     *  @param files - paths to the files in the order their data were taken.
+     *  @param decoder - decoder for the state change items of the data's
+     *                format (see FormatSelector::selectViewDecoder).
+     *  @throw std::system_error - a file can't be opened or stat-ed.
+     *  @throw int - errno on read errors.
+     *  @throw std::runtime_error - an item is too small to be one.
+     */
+    void
+    CRunSegmentIndex::build(
+        const std::vector<std::string>& files,
+        const RingViewDecoderBase& decoder
+    )
+    {
+        m_version  = decoder.getVersion();
+        m_pDecoder = &decoder;
+        m_files.clear();
+        m_segments.clear();
+        for (auto& f : files) {
+            FileInfo info;
+            info.s_path = f;
+            m_files.push_back(info);
+        }
+        // Anything before the first state change is in an implicit segment:
+
+        startSegment(0, 0, nullptr);
+        for (uint32_t i = 0; i < m_files.size(); i++) {
+            if (i > 0) {
+                m_current.s_extents.push_back({i, 0, 0});  // Continues here.
+            }
+            indexFile(i);
+        }
+        uint64_t end = m_current.s_extents.back().s_end;
+        endSegment(end, nullptr);
+    }
+    /**
+     * build
+     *    Index a single file.
+     */
+    void
+    CRunSegmentIndex::build(
+        const std::string& file, const RingViewDecoderBase& decoder
+    )
+    {
+        build(std::vector<std::string>(1, file), decoder);
+    }
+    /**
+     * write
+     *    Save the index.
+     *  @param indexFile - path to the file to write.
+     *  @throw std::runtime_error - the file can't be written.
+     */
+    void
+    CRunSegmentIndex::write(const std::string& indexFile) const
+    {
+        std::ofstream out(indexFile.c_str(), std::ios::binary | std::ios::trunc);
+        if (!out) {
+            throw std::runtime_error(
+                std::string("CRunSegmentIndex unable to create ") + indexFile
+            );
+        }
+        out.write(MAGIC, sizeof(MAGIC));
+        put(out, uint32_t(m_version));
+        put(out, uint32_t(m_files.size()));
+        for (auto& f : m_files) {
+            putString(out, f.s_path);
+            put(out, f.s_size);
+            put(out, f.s_mtime);
+            put(out, f.s_mtimeNs);
+        }
+        put(out, uint32_t(m_segments.size()));
+        for (auto& s : m_segments) {
+            put(out, s.s_runNumber);
+            put(out, s.s_segment);
+            putString(out, s.s_title);
+            put(out, s.s_startType);
+            put(out, s.s_endType);
+            put(out, s.s_startTime);
+            put(out, s.s_endTime);
+            put(out, int64_t(s.s_startClock));
+            put(out, int64_t(s.s_endClock));
+            put(out, uint32_t(s.s_extents.size()));
+            for (auto& e : s.s_extents) {
+                put(out, e.s_file);
+                put(out, e.s_begin);
+                put(out, e.s_end);
+            }
+        }
+        out.close();
+        if (!out) {
+            throw std::runtime_error(
+                std::string("CRunSegmentIndex failed writing ") + indexFile
+            );
+        }
+    }
+    /**
+     * read
+     *    Replace the index with a saved one.
+     *  @param indexFile - path to the saved index.
+     *  @throw std::runtime_error - the file can't be read or isn't an index.
+     */
+    void
+    CRunSegmentIndex::read(const std::string& indexFile)
+    {
+        std::ifstream in(indexFile.c_str(), std::ios::binary);
+        if (!in) {
+            throw std::runtime_error(
+                std::string("CRunSegmentIndex unable to open ") + indexFile
+            );
+        }
+        char magic[sizeof(MAGIC)];
+        in.read(magic, sizeof(magic));
+        if (!in || memcmp(magic, MAGIC, sizeof(MAGIC))) {
+            throw std::runtime_error(indexFile + " is not a run segment index");
+        }
+        auto version = FormatSelector::SupportedVersions(get<uint32_t>(in));
+        std::vector<FileInfo> files(get<uint32_t>(in));
+        for (auto& f : files) {
+            f.s_path    = getString(in);
+            f.s_size    = get<uint64_t>(in);
+            f.s_mtime   = get<int64_t>(in);
+            f.s_mtimeNs = get<int64_t>(in);
+        }
+        std::vector<Segment> segments(get<uint32_t>(in));
+        for (auto& s : segments) {
+            s.s_runNumber  = get<uint32_t>(in);
+            s.s_segment    = get<uint32_t>(in);
+            s.s_title      = getString(in);
+            s.s_startType  = get<uint32_t>(in);
+            s.s_endType    = get<uint32_t>(in);
+            s.s_startTime  = get<float>(in);
+            s.s_endTime    = get<float>(in);
+            s.s_startClock = get<int64_t>(in);
+            s.s_endClock   = get<int64_t>(in);
+            s.s_extents.resize(get<uint32_t>(in));
+            for (auto& e : s.s_extents) {
+                e.s_file  = get<uint32_t>(in);
+                e.s_begin = get<uint64_t>(in);
+                e.s_end   = get<uint64_t>(in);
+            }
+        }
+        m_version = version;
+        m_files.swap(files);
+        m_segments.swap(segments);
+    }
+    /**
+     * isCurrent
+     *   @return bool - true if all the files still have the size and
+     *                  modification time they had when indexed.
+     */
+    bool
+    CRunSegmentIndex::isCurrent() const
+    {
+        for (auto& f : m_files) {
+            FileInfo now;
+            try {
+                statFile(f.s_path, now);
+            }
+            catch (...) {
+                return false;
+            }
+            if ((now.s_size != f.s_size) || (now.s_mtime != f.s_mtime) ||
+                (now.s_mtimeNs != f.s_mtimeNs)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - format of the data.
+     */
+    FormatSelector::SupportedVersions
+    CRunSegmentIndex::getVersion() const
+    {
+        return m_version;
+    }
+    /**
+     * getFiles
+     *   @return std::vector<std::string> - the indexed files in order.
+     */
+    std::vector<std::string>
+    CRunSegmentIndex::getFiles() const
+    {
+        std::vector<std::string> result;
+        for (auto& f : m_files) {
+            result.push_back(f.s_path);
+        }
+        return result;
+    }
+    /**
+     * getSegments
+     *   @return const std::vector<Segment>& - segments in the order found.
+     */
+    const std::vector<CRunSegmentIndex::Segment>&
+    CRunSegmentIndex::getSegments() const
+    {
+        return m_segments;
+    }
+    /**
+     * getRuns
+     *   @return std::vector<uint32_t> - run numbers in the order first seen.
+     */
+    std::vector<uint32_t>
+    CRunSegmentIndex::getRuns() const
+    {
+        std::vector<uint32_t> result;
+        for (auto& s : m_segments) {
+            if (std::find(result.begin(), result.end(), s.s_runNumber) == result.end()) {
+                result.push_back(s.s_runNumber);
+            }
+        }
+        return result;
+    }
+    /**
+     * getSegmentCount
+     *   @param run - a run number.
+     *   @return unsigned - number of segments that run has.
+     */
+    unsigned
+    CRunSegmentIndex::getSegmentCount(uint32_t run) const
+    {
+        return std::count_if(
+            m_segments.begin(), m_segments.end(),
+            [run](const Segment& s) { return s.s_runNumber == run; }
+        );
+    }
+    /**
+     * find
+     *   @param run - run number.
+     *   @param segment - segment number within the run.
+     *   @return const Segment* - the segment or nullptr if there's none.
+     */
+    const CRunSegmentIndex::Segment*
+    CRunSegmentIndex::find(uint32_t run, unsigned segment) const
+    {
+        for (auto& s : m_segments) {
+            if ((s.s_runNumber == run) && (s.s_segment == segment)) {
+                return &s;
+            }
+        }
+        return nullptr;
+    }
+    ////////////////////////////////////////////////////////////////////////
+    // Private methods:
+
+    /**
+     * indexFile
+     *    Scan one file of the set, starting and ending segments at its
+     *    state change items.
+     * @param file - index of the file in m_files.
+     */
+    void
+    CRunSegmentIndex::indexFile(uint32_t file)
+    {
+        FileInfo& info = m_files[file];
+        statFile(info.s_path, info);
+        int fd = open(info.s_path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::system_error(
+                errno, std::generic_category(), "CRunSegmentIndex opening file"
+            );
+        }
+        uint64_t offset = 0;
+        try {
+            CRingBlockReader reader(fd);
+            while (const RingItem* pRaw = reader.nextItem()) {
+                CRingItemView item(pRaw, m_version);
+                uint32_t type = item.type();
+                uint32_t size = item.size();
+                if (CRingStateChangeView::canView(item, *m_pDecoder)) {
+                    if ((type == BEGIN_RUN) || (type == RESUME_RUN)) {
+                        endSegment(offset, nullptr);
+                        startSegment(file, offset, &item);
+                    } else if ((type == PAUSE_RUN) || (type == END_RUN)) {
+                        endSegment(offset + size, &item);
+                        startSegment(file, offset + size, nullptr);
+                    }
+                }
+                offset += size;
+            }
+        }
+        catch (...) {
+            close(fd);
+            throw;
+        }
+        close(fd);
+        m_current.s_extents.back().s_end = offset;
+    }
+    /**
+     * startSegment
+     *    Start a new current segment.
+     * @param file - file it starts in.
+     * @param offset - where it starts.
+     * @param pItem - the BEGIN_RUN/RESUME_RUN item that starts it or
+     *                nullptr for an implicit segment.
+     */
+    void
+    CRunSegmentIndex::startSegment(
+        uint32_t file, uint64_t offset, const CRingItemView* pItem
+    )
+    {
+        m_current = Segment();
+        m_current.s_runNumber  = 0;
+        m_current.s_segment    = 0;
+        m_current.s_startType  = 0;
+        m_current.s_endType    = 0;
+        m_current.s_startTime  = 0;
+        m_current.s_endTime    = 0;
+        m_current.s_startClock = 0;
+        m_current.s_endClock   = 0;
+        m_current.s_extents.push_back({file, offset, offset});
+        if (pItem) {
+            CRingStateChangeView start(*pItem, *m_pDecoder);
+            m_current.s_runNumber  = start.getRunNumber();
+            m_current.s_title      = start.getTitle();
+            m_current.s_startType  = start.type();
+            m_current.s_startTime  = start.computeElapsedTime();
+            m_current.s_startClock = start.getTimestamp();
+        }
+    }
+    /**
+     * endSegment
+     *    End the current segment.  It's kept if it was started by a state
+     *    change item or is ended by one.
+     * @param offset - offset just past its last item.
+     * @param pItem  - the PAUSE_RUN/END_RUN item that ends it or nullptr
+     *                 if it's cut short.
+     */
+    void
+    CRunSegmentIndex::endSegment(uint64_t offset, const CRingItemView* pItem)
+    {
+        auto& extents = m_current.s_extents;
+        extents.back().s_end = offset;
+        extents.erase(
+            std::remove_if(
+                extents.begin(), extents.end(),
+                [](const Extent& e) { return e.s_begin == e.s_end; }
+            ),
+            extents.end()
+        );
+        if (pItem) {
+            CRingStateChangeView end(*pItem, *m_pDecoder);
+            if (m_current.s_startType == 0) {     // Only know the run now.
+                m_current.s_runNumber = end.getRunNumber();
+                m_current.s_title     = end.getTitle();
+            }
+            m_current.s_endType  = end.type();
+            m_current.s_endTime  = end.computeElapsedTime();
+            m_current.s_endClock = end.getTimestamp();
+        }
+        if (m_current.s_startType || m_current.s_endType) {
+            m_current.s_segment = getSegmentCount(m_current.s_runNumber);
+            m_segments.push_back(m_current);
+        }
+    }
+    /**
+     * statFile
+     *    Get the size and modification time of a file.
+     */
+    void
+    CRunSegmentIndex::statFile(const std::string& path, FileInfo& info)
+    {
+        struct stat s;
+        if (stat(path.c_str(), &s)) {
+            throw std::system_error(
+                errno, std::generic_category(), "CRunSegmentIndex stat-ing file"
+            );
+        }
+        info.s_size    = s.st_size;
+        info.s_mtime   = s.st_mtim.tv_sec;
+        info.s_mtimeNs = s.st_mtim.tv_nsec;
+    }
+}
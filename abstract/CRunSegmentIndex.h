@@ -0,0 +1,122 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  CRunSegmentIndex.h
+ *  @brief: Index of the run segments in a set of event files.
+ */
+#ifndef CRUNSEGMENTINDEX_H
+#define CRUNSEGMENTINDEX_H
+
+#include <NSCLDAQFormatFactorySelector.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+#include <string>
+#include <vector>
+
+namespace ufmt {
+    class CRingItemView;
+    class RingViewDecoderBase;
+
+    /**
+     * @class CRunSegmentIndex
+     *    Locates the run segments in a set of event files using their
+     *    state change items.  A segment runs from a BEGIN_RUN or
+     *    RESUME_RUN item through the PAUSE_RUN or END_RUN item that ends
+     *    it.  For each segment the index has its run number, segment
+     *    number within the run (0 for the segment begun by BEGIN_RUN,
+     *    1 for the first resume...), title, elapsed run times and clock
+     *    times at its start and end and the byte ranges (extents) of the
+     *    files it occupies.  A segment has more than one extent when a run
+     *    is split across the files of the set (the files must be given in
+     *    order).
+     *
+     *    Data that ends with a PAUSE_RUN or END_RUN but whose start isn't
+     *    in the files (e.g. the set starts mid-run) is a segment whose
+     *    start type is 0.  A segment cut short by a BEGIN/RESUME or by the
+     *    end of the data has an end type of 0.  Items outside of any
+     *    segment (e.g. ring format items, or items between a pause and
+     *    resume) are not indexed.
+     *
+     *    The index can be saved to and read back from a file, so
+     *    that a segment can be opened (see RunSegmentDataSource) without
+     *    scanning the files.  The size and modification time of each file
+     *    are saved so stale indices can be detected (isCurrent).
+     */
+    class CRunSegmentIndex {
+    public:
+        /** A byte range in one of the files. */
+        struct Extent {
+            uint32_t s_file;             // Index into getFiles().
+            uint64_t s_begin;            // Offset of the first item.
+            uint64_t s_end;              // Offset just past the last item.
+        };
+        struct Segment {
+            uint32_t    s_runNumber;
+            uint32_t    s_segment;       // 0 - from BEGIN_RUN, 1.. resumes.
+            std::string s_title;
+            uint32_t    s_startType;     // BEGIN_RUN/RESUME_RUN or 0.
+            uint32_t    s_endType;       // PAUSE_RUN/END_RUN or 0.
+            float       s_startTime;     // Elapsed run seconds at start.
+            float       s_endTime;
+            time_t      s_startClock;    // Clock time at start (0 unknown).
+            time_t      s_endClock;
+            std::vector<Extent> s_extents;
+        };
+    private:
+        struct FileInfo {
+            std::string s_path;
+            uint64_t    s_size;
+            int64_t     s_mtime;
+            int64_t     s_mtimeNs;
+        };
+        FormatSelector::SupportedVersions m_version;
+        std::vector<FileInfo> m_files;
+        std::vector<Segment>  m_segments;
+
+        // Used while building:
+
+        const RingViewDecoderBase* m_pDecoder;
+        Segment m_current;
+    public:
+        CRunSegmentIndex();
+
+        void build(
+            const std::vector<std::string>& files,
+            const RingViewDecoderBase& decoder
+        );
+        void build(
+            const std::string& file, const RingViewDecoderBase& decoder
+        );
+        void write(const std::string& indexFile) const;
+        void read(const std::string& indexFile);
+        bool isCurrent() const;
+
+        FormatSelector::SupportedVersions getVersion() const;
+        std::vector<std::string>    getFiles() const;
+        const std::vector<Segment>& getSegments() const;
+        std::vector<uint32_t>       getRuns() const;
+        unsigned getSegmentCount(uint32_t run) const;
+        const Segment* find(uint32_t run, unsigned segment) const;
+    private:
+        void indexFile(uint32_t file);
+        void startSegment(uint32_t file, uint64_t offset, const CRingItemView* pItem);
+        void endSegment(uint64_t offset, const CRingItemView* pItem);
+        static void statFile(const std::string& path, FileInfo& info);
+    };
+}
+#endif
@@ -71,7 +71,7 @@ namespace ufmt {
       info.s_sourceId  = frag->s_header.s_sourceId;
       info.s_size      = frag->s_header.s_size;
       info.s_barrier   = frag->s_header.s_barrier;
-      info.s_itemhdr   = reinterpret_cast<const uint16_t*>(frag->s_body);
+      info.s_itemhdr   = data + sizeof(FragmentHeader)/sizeof(uint16_t);
       
       
       //daqdev/SpecTcl#378 - Compute the size of the header in
@@ -119,4 +119,55 @@ namespace ufmt {
     return (payload_size + fraghdr_size)/sizeof(uint16_t);
 
   }
+
+  /**! Decode the current fragment's header.
+  * The body pointers are computed from the fragment address rather than
+  * taken from the packed s_body member.
+  */
+  FragmentIterator::reference FragmentIterator::operator*() const
+  {
+    const FlatFragment* frag = reinterpret_cast<const FlatFragment*>(m_pos);
+    m_info.s_timestamp = frag->s_header.s_timestamp;
+    m_info.s_sourceId  = frag->s_header.s_sourceId;
+    m_info.s_size      = frag->s_header.s_size;
+    m_info.s_barrier   = frag->s_header.s_barrier;
+    m_info.s_itemhdr   = m_pos + sizeof(FragmentHeader)/sizeof(uint16_t);
+    m_info.s_itembody  =
+      m_info.s_itemhdr + sizeof(RingItemHeader)/sizeof(uint16_t);
+    return m_info;
+  }
+
+  size_t FragmentIterator::wordsInFragment(const uint16_t* data)
+  {
+    const FlatFragment* frag = reinterpret_cast<const FlatFragment*>(data);
+    return (frag->s_header.s_size + sizeof(FragmentHeader))/sizeof(uint16_t);
+  }
+
+  /**! Throw if the fragment at m_pos doesn't fit before m_end. */
+  void FragmentIterator::check() const
+  {
+    if ((m_pos != m_end) &&
+        ((size_t(m_end - m_pos) < sizeof(FragmentHeader)/sizeof(uint16_t)) ||
+         (wordsInFragment(m_pos) > size_t(m_end - m_pos)))) {
+      throwOverrun();
+    }
+  }
+
+  FragmentRange::FragmentRange(const uint16_t* body)
+  {
+    uint32_t nBytes = *(reinterpret_cast<const uint32_t*>(body));
+    m_begin = body + sizeof(uint32_t)/sizeof(uint16_t);
+    m_end   = m_begin;
+    if (nBytes >= sizeof(uint32_t)) {
+      m_end += (nBytes - sizeof(uint32_t))/sizeof(uint16_t);
+    }
+  }
+
+  /**! Report a fragment that runs past the end of the data
+  * @throw std::runtime_error always.
+  */
+  void FragmentIterator::throwOverrun()
+  {
+    throw std::runtime_error("FragmentIterator insufficient data in buffer for next fragment!");
+  }
 }
@@ -8,8 +8,10 @@
 #define FRAGMENTINDEX_H
 
 #include <vector>
+#include <iterator>
 #include <stdint.h>
 #include <cstdlib>
+#include <cstddef>
 
 
 namespace ufmt {
@@ -118,5 +120,113 @@ namespace ufmt {
     iterator end() { return m_frags.end(); }
     const_iterator end() const { return m_frags.end(); }
   };
+
+  /**! FragmentIterator
+  *
+  * Forward iterator over the fragments of a built ring item body.  Unlike
+  * FragmentIndex nothing is stored: each fragment header is decoded
+  * when the iterator is dereferenced and the iterator only holds a pointer
+  * to the current fragment, so iterating allocates nothing.  The data
+  * must outlive the iterator.
+  */
+  class FragmentIterator
+  {
+    public:
+    typedef ::std::forward_iterator_tag iterator_category;
+    typedef FragmentInfo                value_type;
+    typedef ::std::ptrdiff_t            difference_type;
+    typedef const FragmentInfo*         pointer;
+    typedef const FragmentInfo&         reference;
+
+    private:
+    const uint16_t* m_pos;   ///< Current fragment (== m_end at the end).
+    const uint16_t* m_end;   ///< Just past the last fragment.
+    mutable FragmentInfo m_info;
+
+    public:
+    /**! End (or singular) iterator. */
+    FragmentIterator() : m_pos(0), m_end(0) {}
+
+    /**! Iterator at the first fragment of [begin, end).
+     * @throw std::runtime_error if the first fragment doesn't fit.
+     */
+    FragmentIterator(const uint16_t* begin, const uint16_t* end) :
+      m_pos(begin), m_end(end)
+    {
+      check();
+    }
+
+    reference operator*() const;
+    pointer operator->() const { return &(**this); }
+
+    /**! Advance to the next fragment.
+     * @throw std::runtime_error if the next fragment doesn't fit.
+     */
+    FragmentIterator& operator++()
+    {
+      m_pos += wordsInFragment(m_pos);
+      check();
+      return *this;
+    }
+    FragmentIterator operator++(int)
+    {
+      FragmentIterator result(*this);
+      ++(*this);
+      return result;
+    }
+
+    bool operator==(const FragmentIterator& rhs) const { return m_pos == rhs.m_pos; }
+    bool operator!=(const FragmentIterator& rhs) const { return m_pos != rhs.m_pos; }
+
+    /**! @return pointer to the current fragment's FlatFragment. */
+    const uint16_t* getPointer() const { return m_pos; }
+
+    /**! @return size of the fragment at data in uint16_t words. */
+    static size_t wordsInFragment(const uint16_t* data);
+
+    private:
+    void check() const;
+    static void throwOverrun();
+  };
+
+  /**! FragmentRange
+  *
+  * The fragments of a built ring item body as something a range for can
+  * iterate over, e.g.:
+  *
+  *    for (auto& frag : event.fragments()) { ... }
+  *
+  * This is the allocation free alternative to FragmentIndex and
+  * CPhysicsEventItem::getFragments.
+  */
+  class FragmentRange
+  {
+    private:
+    const uint16_t* m_begin;
+    const uint16_t* m_end;
+
+    public:
+    typedef FragmentIterator iterator;
+    typedef FragmentIterator const_iterator;
+
+    /**! Range over a built body.
+     * @param body pointer to the first word of the body (the uint32_t
+     *             byte count that precedes the first fragment).  The range
+     *             is empty if the byte count is too small to count itself.
+     */
+    FragmentRange(const uint16_t* body);
+    /**! Range over raw fragments.
+     * @param pFragments pointer to the first fragment.
+     * @param nBytes bytes from the first fragment to the end of the last.
+     */
+    FragmentRange(const void* pFragments, size_t nBytes) :
+      m_begin(reinterpret_cast<const uint16_t*>(pFragments)),
+      m_end(m_begin + nBytes/sizeof(uint16_t))
+    {}
+
+    iterator begin() const { return iterator(m_begin, m_end); }
+    iterator end() const   { return iterator(m_end, m_end); }
+    bool empty() const     { return m_begin == m_end; }
+  };
 }
 #endif
@@ -0,0 +1,326 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  RingItemBatch.cpp
+ *  @brief: Implement the contiguous ring item batch.
+ */
+#include "RingItemBatch.h"
+#include "CRingItem.h"
+#include "DataFormat.h"
+#include <stdlib.h>
+#include <string.h>
+#include <new>
+#include <stdexcept>
+
+namespace ufmt {
+    /**
+     * constructor
+     *  @param version - format version of the items (used for the views
+     *                   the iterators give).
+     *  @param capacity - initial number of bytes to allocate.
+     *  @throw std::bad_alloc - allocation failed.
+     */
+    RingItemBatch::RingItemBatch(
+        FormatSelector::SupportedVersions version, size_t capacity
+    ) :
+        m_pBuffer(nullptr), m_capacity(0), m_bytes(0), m_nItems(0),
+        m_version(version)
+    {
+        reserve(capacity);
+    }
+    /**
+     * destructor
+     */
+    RingItemBatch::~RingItemBatch()
+    {
+        free(m_pBuffer);
+    }
+    /**
+     * move constructor
+     *    Take over the buffer of rhs which is left empty.
+     */
+    RingItemBatch::RingItemBatch(RingItemBatch&& rhs) :
+        m_pBuffer(rhs.m_pBuffer), m_capacity(rhs.m_capacity),
+        m_bytes(rhs.m_bytes), m_nItems(rhs.m_nItems), m_version(rhs.m_version)
+    {
+        rhs.m_pBuffer  = nullptr;
+        rhs.m_capacity = 0;
+        rhs.m_bytes    = 0;
+        rhs.m_nItems   = 0;
+    }
+    /**
+     * move assignment
+     */
+    RingItemBatch&
+    RingItemBatch::operator=(RingItemBatch&& rhs)
+    {
+        if (this != &rhs) {
+            free(m_pBuffer);
+            m_pBuffer  = rhs.m_pBuffer;
+            m_capacity = rhs.m_capacity;
+            m_bytes    = rhs.m_bytes;
+            m_nItems   = rhs.m_nItems;
+            m_version  = rhs.m_version;
+            rhs.m_pBuffer  = nullptr;
+            rhs.m_capacity = 0;
+            rhs.m_bytes    = 0;
+            rhs.m_nItems   = 0;
+        }
+        return *this;
+    }
+    ///////////////////////////////////////////////////////////////////////
+    // Selectors:
+
+    /**
+     * size
+     *   @return size_t - number of items in the batch.
+     */
+    size_t
+    RingItemBatch::size() const
+    {
+        return m_nItems;
+    }
+    /**
+     * empty
+     *   @return bool - true if there are no items.
+     */
+    bool
+    RingItemBatch::empty() const
+    {
+        return m_nItems == 0;
+    }
+    /**
+     * bytes
+     *   @return size_t - number of bytes of items in the batch.
+     */
+    size_t
+    RingItemBatch::bytes() const
+    {
+        return m_bytes;
+    }
+    /**
+     * capacity
+     *   @return size_t - bytes the batch can hold before it must grow.
+     */
+    size_t
+    RingItemBatch::capacity() const
+    {
+        return m_capacity;
+    }
+    /**
+     * data
+     *   @return const void* - the items (bytes() bytes of them).
+     */
+    const void*
+    RingItemBatch::data() const
+    {
+        return m_pBuffer;
+    }
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - format of the items.
+     */
+    FormatSelector::SupportedVersions
+    RingItemBatch::getVersion() const
+    {
+        return m_version;
+    }
+    /**
+     * begin
+     *   @return const_iterator - at the first item.
+     */
+    RingItemBatch::const_iterator
+    RingItemBatch::begin() const
+    {
+        return const_iterator(m_pBuffer, m_version);
+    }
+    /**
+     * end
+     *   @return const_iterator - just past the last item.
+     */
+    RingItemBatch::const_iterator
+    RingItemBatch::end() const
+    {
+        return const_iterator(m_pBuffer + m_bytes, m_version);
+    }
+    ///////////////////////////////////////////////////////////////////////
+    // Mutators:
+
+    /**
+     * append
+     *   @param item - ring item object to copy to the end of the batch.
+     */
+    void
+    RingItemBatch::append(const CRingItem& item)
+    {
+        append(item.getItemPointer());
+    }
+    /**
+     * append
+     *   @param item - view of the item to copy to the end of the batch.
+     */
+    void
+    RingItemBatch::append(const CRingItemView& item)
+    {
+        append(item.getItemPointer());
+    }
+    /**
+     * append
+     *   @param pRawItem - raw ring item to copy to the end of the batch.
+     *                This may be an item already in the batch.
+     *   @throw std::invalid_argument - the item size is smaller than a header.
+     */
+    void
+    RingItemBatch::append(const void* pRawItem)
+    {
+        const RingItemHeader* pHeader =
+            reinterpret_cast<const RingItemHeader*>(pRawItem);
+        uint32_t size = pHeader->s_size;
+        if (size < sizeof(RingItemHeader)) {
+            throw std::invalid_argument(
+                "RingItemBatch::append - item is smaller than a ring item header"
+            );
+        }
+        // Growing moves our storage so an item in it is found again by
+        // its offset:
+        
+        const uint8_t* pSrc = static_cast<const uint8_t*>(pRawItem);
+        bool   inBatch = (pSrc >= m_pBuffer) && (pSrc < m_pBuffer + m_bytes);
+        size_t offset  = inBatch ? pSrc - m_pBuffer : 0;
+        reserve(m_bytes + size);
+        if (inBatch) {
+            pSrc = m_pBuffer + offset;
+        }
+        memcpy(m_pBuffer + m_bytes, pSrc, size);
+        m_bytes += size;
+        m_nItems++;
+    }
+    /**
+     * appendItem
+     *    Add space for an item at the end of the batch.  The header is
+     *    filled in, the caller fills in the rest.
+     *  @param type - ring item type.
+     *  @param size - complete size of the item (including the header).
+     *  @return pRingItem - pointer to the new item.  The pointer is valid
+     *                  until the next append.
+     *  @throw std::invalid_argument - size is smaller than a header.
+     */
+    pRingItem
+    RingItemBatch::appendItem(uint32_t type, uint32_t size)
+    {
+        if (size < sizeof(RingItemHeader)) {
+            throw std::invalid_argument(
+                "RingItemBatch::appendItem - size is smaller than a ring item header"
+            );
+        }
+        reserve(m_bytes + size);
+        pRingItem pItem = reinterpret_cast<pRingItem>(m_pBuffer + m_bytes);
+        pItem->s_header.s_size = size;
+        pItem->s_header.s_type = type;
+        m_bytes += size;
+        m_nItems++;
+        return pItem;
+    }
+    /**
+     * clear
+     *    Remove all items.  The storage is kept for reuse.
+     */
+    void
+    RingItemBatch::clear()
+    {
+        m_bytes  = 0;
+        m_nItems = 0;
+    }
+    /**
+     * reserve
+     *    Ensure the batch can hold at least nBytes without growing.  The
+     *    buffer at least doubles when it grows so appends are amortized
+     *    constant time.
+     * @param nBytes - bytes needed.
+     * @throw std::bad_alloc - allocation failed.
+     */
+    void
+    RingItemBatch::reserve(size_t nBytes)
+    {
+        if (nBytes <= m_capacity) {
+            return;
+        }
+        size_t newCapacity = m_capacity*2;
+        if (newCapacity < nBytes) {
+            newCapacity = nBytes;
+        }
+        void* p = realloc(m_pBuffer, newCapacity);
+        if (!p) {
+            throw std::bad_alloc();
+        }
+        m_pBuffer  = static_cast<uint8_t*>(p);
+        m_capacity = newCapacity;
+    }
+    ///////////////////////////////////////////////////////////////////////
+    // const_iterator implementation:
+
+    /**
+     * constructor
+     *   @param pItem - item the iterator is at.
+     *   @param version - format of the items.
+     */
+    RingItemBatch::const_iterator::const_iterator(
+        const uint8_t* pItem, FormatSelector::SupportedVersions version
+    ) :
+        m_pItem(pItem), m_version(version)
+    {}
+    /**
+     * operator*
+     *   @return CRingItemView - view of the current item.
+     */
+    CRingItemView
+    RingItemBatch::const_iterator::operator*() const
+    {
+        return CRingItemView(m_pItem, m_version);
+    }
+    /**
+     * operator++ (prefix)
+     *    Step over the current item.
+     */
+    RingItemBatch::const_iterator&
+    RingItemBatch::const_iterator::operator++()
+    {
+        m_pItem += reinterpret_cast<const RingItemHeader*>(m_pItem)->s_size;
+        return *this;
+    }
+    /**
+     * operator++ (postfix)
+     */
+    RingItemBatch::const_iterator
+    RingItemBatch::const_iterator::operator++(int)
+    {
+        const_iterator result(*this);
+        ++(*this);
+        return result;
+    }
+    bool
+    RingItemBatch::const_iterator::operator==(const const_iterator& rhs) const
+    {
+        return m_pItem == rhs.m_pItem;
+    }
+    bool
+    RingItemBatch::const_iterator::operator!=(const const_iterator& rhs) const
+    {
+        return m_pItem != rhs.m_pItem;
+    }
+}
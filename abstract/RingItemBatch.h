@@ -0,0 +1,116 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  RingItemBatch.h
+ *  @brief: Contiguous buffer of many ring items.
+ */
+#ifndef RINGITEMBATCH_H
+#define RINGITEMBATCH_H
+
+#include "CRingItemView.h"
+#include <stdint.h>
+#include <stddef.h>
+#include <iterator>
+
+namespace ufmt {
+    struct _RingItem;
+    typedef _RingItem RingItem, *pRingItem;
+    class CRingItem;
+
+    /**
+     * @class RingItemBatch
+     *    Holds many ring items back to back in one growable buffer.  That's
+     *    exactly the layout of an event file so a batch can be written with
+     *    a single write (see the factories' putRingItem(const RingItemBatch&...)).
+     *    Iterating over a batch gives a CRingItemView of each item.
+     *
+     *    Builders either append existing items or use appendItem to reserve
+     *    space for an item and fill it in place.
+     *
+     * @note Appending may move the buffer so pointers into the batch and
+     *       views of its items are invalid after an append.
+     */
+    class RingItemBatch {
+    public:
+        static const size_t DEFAULT_CAPACITY = 64*1024;
+
+        /**
+         * Forward iterator over the items in the batch.
+         */
+        class const_iterator {
+        public:
+            typedef std::forward_iterator_tag iterator_category;
+            typedef CRingItemView             value_type;
+            typedef std::ptrdiff_t            difference_type;
+            typedef const CRingItemView*      pointer;
+            typedef CRingItemView             reference;
+        private:
+            const uint8_t*                    m_pItem;
+            FormatSelector::SupportedVersions m_version;
+        public:
+            const_iterator(
+                const uint8_t* pItem, FormatSelector::SupportedVersions version
+            );
+            CRingItemView   operator*() const;
+            const_iterator& operator++();
+            const_iterator  operator++(int);
+            bool operator==(const const_iterator& rhs) const;
+            bool operator!=(const const_iterator& rhs) const;
+        };
+        typedef const_iterator iterator;
+    private:
+        uint8_t* m_pBuffer;
+        size_t   m_capacity;               // Bytes allocated.
+        size_t   m_bytes;                  // Bytes used.
+        size_t   m_nItems;
+        FormatSelector::SupportedVersions m_version;
+    public:
+        explicit RingItemBatch(
+            FormatSelector::SupportedVersions version = FormatSelector::v12,
+            size_t capacity = DEFAULT_CAPACITY
+        );
+        virtual ~RingItemBatch();
+        RingItemBatch(RingItemBatch&& rhs);
+        RingItemBatch& operator=(RingItemBatch&& rhs);
+    private:
+        RingItemBatch(const RingItemBatch& rhs);
+        RingItemBatch& operator=(const RingItemBatch& rhs);
+    public:
+
+        // Selectors:
+
+        size_t      size() const;
+        bool        empty() const;
+        size_t      bytes() const;
+        size_t      capacity() const;
+        const void* data() const;
+        FormatSelector::SupportedVersions getVersion() const;
+        const_iterator begin() const;
+        const_iterator end() const;
+
+        // Mutators:
+
+        void append(const CRingItem& item);
+        void append(const CRingItemView& item);
+        void append(const void* pRawItem);
+        pRingItem appendItem(uint32_t type, uint32_t size);
+        void clear();
+        void reserve(size_t nBytes);
+    };
+}
+#endif
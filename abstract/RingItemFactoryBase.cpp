@@ -0,0 +1,89 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  RingItemFactoryBase.cpp
+ *  @brief: Format independent parts of the ring item factory base class.
+ */
+#include "RingItemFactoryBase.h"
+#include "RingItemBatch.h"
+#include "CRingBlockWriter.h"
+#include "io.h"
+#ifdef HAVE_NSCLDAQ
+#include <CRingBuffer.h>
+#endif
+
+namespace ufmt {
+    /**
+     * putRingItem
+     *    Put all the items in a batch to an ostream with one write.
+     * @param batch - the items.
+     * @param out   - stream to write to; errors must be checked by the caller.
+     * @return std::ostream& - out.
+     */
+    ::std::ostream&
+    RingItemFactoryBase::putRingItem(const RingItemBatch& batch, ::std::ostream& out)
+    {
+        out.write(reinterpret_cast<const char*>(batch.data()), batch.bytes());
+        return out;
+    }
+    /**
+     * putRingItem
+     *    Put all the items in a batch to a file descriptor.  The batch is
+     *    already laid out as the items would be in a file so this is one
+     *    write rather than one per item.
+     * @param batch - the items.
+     * @param fd    - file descriptor to write to.
+     * @throw errors from fmtio::writeData are thrown as exceptions.
+     */
+    void
+    RingItemFactoryBase::putRingItem(const RingItemBatch& batch, int fd)
+    {
+        if (batch.bytes()) {
+            fmtio::writeData(fd, batch.data(), batch.bytes());
+        }
+    }
+    /**
+     * putRingItem
+     *    Put all the items in a batch through a block writer.
+     * @param batch - the items.
+     * @param writer - buffered writer they're put to.
+     */
+    void
+    RingItemFactoryBase::putRingItem(
+        const RingItemBatch& batch, CRingBlockWriter& writer
+    )
+    {
+        writer.put(batch.data(), batch.bytes());
+    }
+#ifdef HAVE_NSCLDAQ
+    /**
+     * putRingItem
+     *    Put the items of a batch to a ring buffer.  These are put one at a
+     *    time as a whole batch might not fit in the ring.
+     * @param batch - the items.
+     * @param ringbuf - ring buffer to put them in.
+     */
+    void
+    RingItemFactoryBase::putRingItem(const RingItemBatch& batch, CRingBuffer& ringbuf)
+    {
+        for (auto item : batch) {
+            ringbuf.put(item.getItemPointer(), item.size());
+        }
+    }
+#endif
+}
@@ -25,7 +25,9 @@
 #include <iostream>
 #include <vector>
 #include <climits>
+#include <utility>
 #include <fmtconfig.h>
+#include "CRingItemPool.h"
 #include <NSCLDAQFormatFactorySelector.h>
 class CRingBuffer;
 namespace ufmt {
@@ -44,6 +46,9 @@ namespace ufmt {
     class CRingTextItem;
     class CUnknownFragment;
     class CRingStateChangeItem;
+    class CRingBlockReader;
+    class RingItemBatch;
+    class CRingBlockWriter;
 
     /**
      * RingItemFactoryBase
@@ -51,9 +56,17 @@ namespace ufmt {
      *    Each ring item data format will have its factory class which
      *    can instantiate all members of the ring item class hierarchy.
      *
-     *   
+     *    A factory can be given a CRingItemPool; items it makes (and their
+     *    dynamic storage) then come from and are deleted back into that pool.
+     *    The pool must outlive the items.
+     *
+     *    The make*Item(CRingItem&&) conversions take over the storage of
+     *    the source item rather than copying it.  Factories that can't do
+     *    that get the default implementations that copy.
      */
     class RingItemFactoryBase {
+    private:
+        CRingItemPool* m_pItemPool = nullptr;
     public:
         virtual ~RingItemFactoryBase() {
             ufmt::FormatSelector::unregisterFactory(*this);  // Remove from cache.
@@ -63,6 +76,9 @@ namespace ufmt {
         virtual CRingItem* makeRingItem(uint16_t type, uint64_t timestamp, uint32_t sourceId,
                 size_t maxBody, uint32_t barrierType = 0 ) = 0;
         virtual CRingItem* makeRingItem(const CRingItem& rhs) = 0;
+        virtual CRingItem* makeRingItem(CRingItem&& rhs) {
+            const CRingItem& r(rhs); return makeRingItem(r);
+        }
         virtual CRingItem* makeRingItem(const RingItem* pRawRing) = 0;
         
     #ifdef HAVE_NSCLDAQ
@@ -70,13 +86,77 @@ namespace ufmt {
     #endif
         virtual CRingItem* getRingItem(int fd) = 0;
         virtual CRingItem* getRingItem(::std::istream& in) = 0;
+        virtual CRingItem* getRingItem(CRingBlockReader& reader) = 0;
+        
+        // Refill an existing item - these return false at end of data.
+        
+    #ifdef HAVE_NSCLDAQ
+        virtual bool getRingItem(
+            CRingBuffer& ringbuf, CRingItem& item, unsigned long timeout=ULONG_MAX
+        ) = 0;
+    #endif
+        virtual bool getRingItem(int fd, CRingItem& item) = 0;
+        virtual bool getRingItem(::std::istream& in, CRingItem& item) = 0;
+        virtual bool getRingItem(CRingBlockReader& reader, CRingItem& item) = 0;
+        
+        // Batch reads - refill items[0], items[1]... with up to maxItems
+        // items; items are made as needed to lengthen the vector.  The
+        // caller owns the items and should keep the vector from batch to
+        // batch so that items are reused.  These return the number of items
+        // gotten, which is less than maxItems only at end of data (for ring
+        // buffers, when no more data is immediately available).
+        
+    #ifdef HAVE_NSCLDAQ
+        virtual size_t getRingItems(
+            CRingBuffer& ringbuf, ::std::vector<CRingItem*>& items,
+            size_t maxItems, unsigned long timeout=ULONG_MAX
+        ) {
+            size_t n = 0;
+            while (n < maxItems) {
+                if (!getRingItem(ringbuf, *batchItem(items, n), n ? 0 : timeout)) {
+                    break;
+                }
+                n++;
+            }
+            return n;
+        }
+    #endif
+        virtual size_t getRingItems(
+            int fd, ::std::vector<CRingItem*>& items, size_t maxItems
+        ) {
+            return fillBatch(fd, items, maxItems);
+        }
+        virtual size_t getRingItems(
+            ::std::istream& in, ::std::vector<CRingItem*>& items, size_t maxItems
+        ) {
+            return fillBatch(in, items, maxItems);
+        }
+        virtual size_t getRingItems(
+            CRingBlockReader& reader, ::std::vector<CRingItem*>& items,
+            size_t maxItems
+        ) {
+            return fillBatch(reader, items, maxItems);
+        }
         
         virtual ::std::ostream& putRingItem(const CRingItem* pItem, ::std::ostream& out) = 0;
         virtual void putRingItem(const CRingItem* pItem, int fd) = 0;
+        virtual void putRingItem(const CRingItem* pItem, CRingBlockWriter& writer) = 0;
     #ifdef HAVE_NSCLDAQ
         virtual void putRingItem(const CRingItem* pItem, CRingBuffer& ringbuf) = 0;
     #endif
         
+        // Put all the items of a batch.  A batch is already laid out as
+        // its items are in a file so these don't depend on the format:
+        
+        virtual ::std::ostream& putRingItem(
+            const RingItemBatch& batch, ::std::ostream& out
+        );
+        virtual void putRingItem(const RingItemBatch& batch, int fd);
+        virtual void putRingItem(const RingItemBatch& batch, CRingBlockWriter& writer);
+    #ifdef HAVE_NSCLDAQ
+        virtual void putRingItem(const RingItemBatch& batch, CRingBuffer& ringbuf);
+    #endif
+        
         virtual CAbnormalEndItem* makeAbnormalEndItem() = 0;
         virtual CAbnormalEndItem* makeAbnormalEndItem(const CRingItem& rhs) = 0;
         
@@ -93,12 +173,18 @@ namespace ufmt {
             uint64_t timestamp, uint32_t source, uint32_t barrier, size_t maxBody
         ) = 0;
         virtual CPhysicsEventItem* makePhysicsEventItem(const CRingItem& rhs) = 0;
+        virtual CPhysicsEventItem* makePhysicsEventItem(CRingItem&& rhs) {
+            const CRingItem& r(rhs); return makePhysicsEventItem(r);
+        }
         
         virtual CRingFragmentItem* makeRingFragmentItem(
             uint64_t timestamp, uint32_t source, uint32_t payloadSize,
             const void* payload, uint32_t barrier=0
         ) = 0;
         virtual CRingFragmentItem* makeRingFragmentItem(const CRingItem& rhs) = 0;
+        virtual CRingFragmentItem* makeRingFragmentItem(CRingItem&& rhs) {
+            const CRingItem& r(rhs); return makeRingFragmentItem(r);
+        }
 
         
         virtual CRingPhysicsEventCountItem* makePhysicsEventCountItem(
@@ -118,6 +204,9 @@ namespace ufmt {
             uint32_t              timeOffsetDivisor = 1
         ) = 0;
         virtual CRingScalerItem* makeScalerItem(const CRingItem& rhs) = 0;
+        virtual CRingScalerItem* makeScalerItem(CRingItem&& rhs) {
+            const CRingItem& r(rhs); return makeScalerItem(r);
+        }
         
         virtual CRingTextItem* makeTextItem(
             uint16_t type,
@@ -130,6 +219,9 @@ namespace ufmt {
             time_t                   timestamp, uint32_t divisor=1
         ) = 0;
         virtual CRingTextItem* makeTextItem(const CRingItem& rhs) = 0;
+        virtual CRingTextItem* makeTextItem(CRingItem&& rhs) {
+            const CRingItem& r(rhs); return makeTextItem(r);
+        }
         
         virtual CUnknownFragment* makeUnknownFragment(
             uint64_t timestamp, uint32_t sourceid, uint32_t barrier,
@@ -144,8 +236,54 @@ namespace ufmt {
             ::std::string title
         ) = 0;
         virtual CRingStateChangeItem* makeStateChangeItem(const CRingItem& rhs) = 0;
+        virtual CRingStateChangeItem* makeStateChangeItem(CRingItem&& rhs) {
+            const CRingItem& r(rhs); return makeStateChangeItem(r);
+        }
         
         virtual ufmt::FormatSelector::SupportedVersions version() = 0;
+        
+        // Item pool selection (nullptr means use the system allocator):
+        
+        void setItemPool(CRingItemPool* pPool) { m_pItemPool = pPool; }
+        CRingItemPool* getItemPool() const     { return m_pItemPool; }
+    protected:
+        // Concrete factories create items with this so they come from our pool.
+        // Arguments are taken by value as they're often packed struct fields.
+        
+        template<typename T, typename... Args>
+        T* newItem(Args... args) {
+            CRingItemPool::Scope pool(m_pItemPool);
+            return new T(std::move(args)...);
+        }
+        // Batch read helpers:
+        
+        CRingItem* batchItem(::std::vector<CRingItem*>& items, size_t index) {
+            if (index == items.size()) {
+                items.push_back(makeRingItem(uint16_t(0), size_t(0)));
+            }
+            return items[index];
+        }
+        template<typename Source>
+        size_t fillBatch(
+            Source& src, ::std::vector<CRingItem*>& items, size_t maxItems
+        ) {
+            size_t n = 0;
+            while ((n < maxItems) && getRingItem(src, *batchItem(items, n))) {
+                n++;
+            }
+            return n;
+        }
+        
+        // Typed conversions from an rvalue item make a minimal T and
+        // give it rhs's storage (see CRingItem::operator=(CRingItem&&)).
+        // rhs is left empty.
+        
+        template<typename T, typename... Args>
+        T* adoptItem(CRingItem&& rhs, Args... args) {
+            T* pResult = newItem<T>(std::move(args)...);
+            pResult->::ufmt::CRingItem::operator=(std::move(rhs));
+            return pResult;
+        }
     };
 }
 
@@ -0,0 +1,102 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  RingViewDecoderBase.h
+ *  @brief: Interface to the format specific layouts used by the typed views.
+ */
+#ifndef RINGVIEWDECODERBASE_H
+#define RINGVIEWDECODERBASE_H
+
+#include <NSCLDAQFormatFactorySelector.h>
+#include <stdint.h>
+#include <stddef.h>
+#include <time.h>
+
+namespace ufmt {
+    class CRingItemView;
+
+    /**
+     * @class RingViewDecoderBase
+     *    The typed views (CRingScalerView etc.) are format independent;
+     *    the layouts of their items are known only to the format
+     *    libraries.  Each format library implements this interface
+     *    (e.g. v12::RingViewDecoder) the way it implements
+     *    RingItemFactoryBase, and FormatSelector::selectViewDecoder
+     *    chooses one by version.
+     *
+     *    Each decode method fills in the fields of its item type and
+     *    returns false if the item is not of that type (or of a different
+     *    format version).  Pointers in the results point into the item.
+     */
+    class RingViewDecoderBase {
+    public:
+        struct ScalerInfo {
+            uint32_t    s_startTime;
+            uint32_t    s_endTime;
+            uint32_t    s_divisor;
+            time_t      s_timestamp;
+            bool        s_isIncremental;
+            uint32_t    s_scalerCount;
+            uint32_t    s_originalSid;
+        };
+        struct TextInfo {
+            uint32_t    s_stringCount;
+            const char* s_pStrings;
+            uint32_t    s_timeOffset;
+            uint32_t    s_divisor;
+            time_t      s_timestamp;
+            uint32_t    s_originalSid;
+        };
+        struct StateChangeInfo {
+            uint32_t    s_runNumber;
+            uint32_t    s_timeOffset;
+            uint32_t    s_divisor;
+            const char* s_pTitle;
+            time_t      s_timestamp;
+            uint32_t    s_originalSid;
+        };
+        struct FragmentInfo {
+            uint64_t    s_timestamp;
+            uint32_t    s_sourceId;
+            uint32_t    s_barrier;
+            size_t      s_payloadSize;
+            const void* s_pPayload;
+        };
+    public:
+        virtual ~RingViewDecoderBase() {}
+
+        virtual FormatSelector::SupportedVersions getVersion() const = 0;
+
+        virtual bool decodeScaler(
+            const CRingItemView& item, ScalerInfo& info
+        ) const = 0;
+        virtual uint32_t getScaler(
+            const CRingItemView& item, uint32_t channel
+        ) const = 0;
+        virtual bool decodeText(
+            const CRingItemView& item, TextInfo& info
+        ) const = 0;
+        virtual bool decodeStateChange(
+            const CRingItemView& item, StateChangeInfo& info
+        ) const = 0;
+        virtual bool decodeFragment(
+            const CRingItemView& item, FragmentInfo& info
+        ) const = 0;
+    };
+}
+#endif
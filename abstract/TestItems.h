@@ -0,0 +1,180 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  TestItems.h
+ *  @brief: Raw ring item builders shared by the unit tests.
+ */
+#ifndef TESTITEMS_H
+#define TESTITEMS_H
+#include "DataFormat.h"
+#include <v12/DataFormat.h>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+namespace testitems {
+    typedef std::vector<uint8_t> Bytes;
+
+    // A raw ring item with a body of bodyBytes bytes each set to fill.
+
+    inline Bytes
+    makeItem(uint32_t type, uint32_t bodyBytes, uint8_t fill)
+    {
+        Bytes result(sizeof(ufmt::RingItemHeader) + bodyBytes, fill);
+        ufmt::RingItemHeader* pH =
+            reinterpret_cast<ufmt::RingItemHeader*>(result.data());
+        pH->s_size = result.size();
+        pH->s_type = type;
+        return result;
+    }
+    // A v12 item, with a body header whose timestamp is 100*sid or just the
+    // body header size word, and a body of bodyBytes bytes of 0xaa.
+
+    inline Bytes
+    makeV12Item(uint32_t type, uint32_t bodyBytes, bool bodyHeader, uint32_t sid = 0)
+    {
+        Bytes result(sizeof(ufmt::RingItemHeader), 0);
+        if (bodyHeader) {
+            ufmt::BodyHeader bh = {sizeof(ufmt::BodyHeader), uint64_t(100*sid), sid, 0};
+            result.insert(result.end(), (uint8_t*)&bh, (uint8_t*)(&bh + 1));
+        } else {
+            uint32_t word = sizeof(uint32_t);
+            result.insert(result.end(), (uint8_t*)&word, (uint8_t*)(&word + 1));
+        }
+        result.insert(result.end(), bodyBytes, uint8_t(0xaa));
+        ufmt::RingItemHeader* pH =
+            reinterpret_cast<ufmt::RingItemHeader*>(result.data());
+        pH->s_size = result.size();
+        pH->s_type = type;
+        return result;
+    }
+    // Write items one after the other.
+
+    inline void
+    writeItems(int fd, const std::vector<Bytes>& items)
+    {
+        for (size_t i = 0; i < items.size(); i++) {
+            write(fd, items[i].data(), items[i].size());
+        }
+    }
+    inline void
+    rewind(int fd)
+    {
+        lseek(fd, 0, SEEK_SET);
+    }
+
+    /**
+     * RunFiles
+     *    Temporary v12 event files with runs in them for the run segment
+     *    tests.  Fixtures derive from this and call clear in tearDown.
+     */
+    class RunFiles {
+    protected:
+        std::vector<std::string> m_files;
+        int m_fd;                          // Open on m_files.back().
+    public:
+        RunFiles() : m_fd(-1) {}
+        ~RunFiles() { clear(); }
+
+        // Close and remove the files.
+
+        void clear()
+        {
+            if (m_fd >= 0) close(m_fd);
+            m_fd = -1;
+            for (auto& f : m_files) {
+                unlink(f.c_str());
+            }
+            m_files.clear();
+        }
+        // Start writing a new file:
+
+        void newFile()
+        {
+            if (m_fd >= 0) close(m_fd);
+            char name[] = "/tmp/runfilesXXXXXX";
+            m_fd = mkstemp(name);
+            m_files.push_back(name);
+        }
+        uint64_t here()
+        {
+            return lseek(m_fd, 0, SEEK_CUR);
+        }
+        // Write an item without a body header whose body bytes are all
+        // its size:
+
+        void writeItem(uint32_t type, uint32_t bodyBytes)
+        {
+            Bytes item(sizeof(ufmt::RingItemHeader) + sizeof(uint32_t), 0);
+            item.resize(item.size() + bodyBytes, uint8_t(bodyBytes));
+            ufmt::RingItemHeader* pH =
+                reinterpret_cast<ufmt::RingItemHeader*>(item.data());
+            pH->s_size = item.size();
+            pH->s_type = type;
+            item[sizeof(ufmt::RingItemHeader)] = sizeof(uint32_t);
+            write(m_fd, item.data(), item.size());
+        }
+        // Write a v12 state change item without a body header:
+
+        void writeStateChange(
+            uint32_t type, uint32_t run, uint32_t elapsed, uint32_t clock,
+            const char* title
+        )
+        {
+            ufmt::v12::StateChangeItem item;
+            memset(&item, 0, sizeof(item));
+            item.s_header.s_size = sizeof(ufmt::RingItemHeader) +
+                sizeof(uint32_t) + sizeof(ufmt::v12::StateChangeItemBody);
+            item.s_header.s_type = type;
+            item.s_body.u_noBodyHeader.s_empty = sizeof(uint32_t);
+            ufmt::v12::StateChangeItemBody& body = item.s_body.u_noBodyHeader.s_body;
+            body.s_runNumber     = run;
+            body.s_timeOffset    = elapsed;
+            body.s_Timestamp     = clock;
+            body.s_offsetDivisor = 1;
+            strncpy(body.s_title, title, ufmt::v12::TITLE_MAXSIZE);
+            write(m_fd, &item, item.s_header.s_size);
+        }
+        // Two files:  run 7 is paused in the first and resumed, ending in
+        // the second which also has run 8.  Physics items have distinct
+        // body sizes 10-12, 4, 20-23 and 30 in that order.
+
+        void writeRuns()
+        {
+            newFile();
+            writeItem(ufmt::RING_FORMAT, 8);
+            writeStateChange(ufmt::BEGIN_RUN, 7, 0, 1000, "Run seven");
+            for (int i = 0; i < 3; i++) writeItem(ufmt::PHYSICS_EVENT, 10 + i);
+            writeStateChange(ufmt::PAUSE_RUN, 7, 10, 1010, "Run seven");
+            writeItem(ufmt::PHYSICS_EVENT, 4);          // Between pause and resume.
+            writeStateChange(ufmt::RESUME_RUN, 7, 10, 1100, "Run seven");
+            for (int i = 0; i < 2; i++) writeItem(ufmt::PHYSICS_EVENT, 20 + i);
+
+            newFile();
+            for (int i = 0; i < 2; i++) writeItem(ufmt::PHYSICS_EVENT, 22 + i);
+            writeStateChange(ufmt::END_RUN, 7, 25, 1115, "Run seven");
+            writeStateChange(ufmt::BEGIN_RUN, 8, 0, 1200, "Run eight");
+            writeItem(ufmt::PHYSICS_EVENT, 30);
+            writeStateChange(ufmt::END_RUN, 8, 5, 1205, "Run eight");
+        }
+    };
+}
+#endif
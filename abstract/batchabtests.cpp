@@ -0,0 +1,245 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  batchabtests.cpp
+ *  @brief: Test the contiguous ring item batch.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "RingItemBatch.h"
+#include "CRingItem.h"
+#include "DataFormat.h"
+#include <stdexcept>
+#include <string.h>
+#include <utility>
+
+using namespace ufmt;
+
+// CRingItem is abstract so:
+
+class CBatchTestItem : public CRingItem {
+public:
+    CBatchTestItem(uint16_t type, size_t maxBody = CRingItemStaticBufferSize -100) :
+        CRingItem(type, maxBody) {}
+    virtual void* getBodyHeader() const {return nullptr;}
+    virtual void setBodyHeader(uint64_t timestamp, uint32_t sourceId,
+                         uint32_t barrierType = 0) {}
+};
+
+class batchabtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(batchabtest);
+    CPPUNIT_TEST(construct_1);
+    CPPUNIT_TEST(append_1);
+    CPPUNIT_TEST(append_2);
+    CPPUNIT_TEST(append_3);
+    CPPUNIT_TEST(append_4);
+    CPPUNIT_TEST(grow_1);
+    CPPUNIT_TEST(grow_2);
+    CPPUNIT_TEST(iterate_1);
+    CPPUNIT_TEST(clear_1);
+    CPPUNIT_TEST(move_1);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+
+    }
+    void tearDown() {
+
+    }
+protected:
+    void construct_1();
+    void append_1();
+    void append_2();
+    void append_3();
+    void append_4();
+    void grow_1();
+    void grow_2();
+    void iterate_1();
+    void clear_1();
+    void move_1();
+private:
+    void fill(CRingItem& item, uint32_t nWords, uint32_t first);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(batchabtest);
+
+// Put nWords counting from first in the body of an item:
+
+void batchabtest::fill(CRingItem& item, uint32_t nWords, uint32_t first)
+{
+    uint32_t* p = static_cast<uint32_t*>(item.getBodyCursor());
+    for (uint32_t i = 0; i < nWords; i++) {
+        *p++ = first + i;
+    }
+    item.setBodyCursor(p);
+    item.updateSize();
+}
+// A new batch is empty:
+
+void batchabtest::construct_1()
+{
+    RingItemBatch batch(FormatSelector::v11, 100);
+    EQ(size_t(0), batch.size());
+    ASSERT(batch.empty());
+    EQ(size_t(0), batch.bytes());
+    EQ(size_t(100), batch.capacity());
+    EQ(FormatSelector::v11, batch.getVersion());
+    ASSERT(batch.begin() == batch.end());
+}
+// Appending an item object copies it to the end of the buffer:
+
+void batchabtest::append_1()
+{
+    CBatchTestItem item(PHYSICS_EVENT);
+    fill(item, 10, 0);
+    RingItemBatch batch;
+    batch.append(item);
+    batch.append(item);
+    EQ(size_t(2), batch.size());
+    EQ(size_t(2*item.size()), batch.bytes());
+    const uint8_t* p = static_cast<const uint8_t*>(batch.data());
+    EQ(0, memcmp(p, item.getItemPointer(), item.size()));
+    EQ(0, memcmp(p + item.size(), item.getItemPointer(), item.size()));
+}
+// Appending views and raw items:
+
+void batchabtest::append_2()
+{
+    CBatchTestItem item(BEGIN_RUN);
+    fill(item, 5, 1);
+    CRingItemView view(item);
+    RingItemBatch batch;
+    batch.append(view);
+    batch.append(static_cast<const void*>(item.getItemPointer()));
+    EQ(size_t(2), batch.size());
+    for (auto v : batch) {
+        EQ(BEGIN_RUN, v.type());
+        EQ(item.size(), v.size());
+    }
+}
+// Items can be built in place:
+
+void batchabtest::append_3()
+{
+    RingItemBatch batch(FormatSelector::v10);      // No body header word.
+    pRingItem p = batch.appendItem(PHYSICS_EVENT, sizeof(RingItemHeader) + 8);
+    uint32_t* pBody = reinterpret_cast<uint32_t*>(&(p->s_header) + 1);
+    pBody[0] = 1;
+    pBody[1] = 2;
+    EQ(size_t(1), batch.size());
+    CRingItemView v = *batch.begin();
+    EQ(PHYSICS_EVENT, v.type());
+    EQ(uint32_t(sizeof(RingItemHeader) + 8), v.size());
+    EQ(uint32_t(2), static_cast<const uint32_t*>(v.getBodyPointer())[1]);
+}
+// Items too small to be items are rejected:
+
+void batchabtest::append_4()
+{
+    RingItemBatch batch;
+    CPPUNIT_ASSERT_THROW(
+        batch.appendItem(PHYSICS_EVENT, 4), std::invalid_argument
+    );
+    RingItemHeader bad = {4, PHYSICS_EVENT};
+    CPPUNIT_ASSERT_THROW(
+        batch.append(static_cast<const void*>(&bad)), std::invalid_argument
+    );
+    ASSERT(batch.empty());
+}
+// The buffer grows to hold what's appended:
+
+void batchabtest::grow_1()
+{
+    CBatchTestItem item(PHYSICS_EVENT, 400);
+    fill(item, 100, 0);
+    RingItemBatch batch(FormatSelector::v12, 16);
+    for (int i = 0; i < 100; i++) {
+        batch.append(item);
+    }
+    EQ(size_t(100), batch.size());
+    EQ(size_t(100*item.size()), batch.bytes());
+    ASSERT(batch.capacity() >= batch.bytes());
+}
+// An item already in the batch can be appended even if that grows it:
+
+void batchabtest::grow_2()
+{
+    CBatchTestItem item(PHYSICS_EVENT, 400);
+    fill(item, 100, 0);
+    RingItemBatch batch(FormatSelector::v12, 16);
+    batch.append(item);
+    size_t capacity = batch.capacity();
+    for (int i = 0; i < 10; i++) {
+        batch.append(batch.data());          // Grows some of these times.
+    }
+    ASSERT(batch.capacity() > capacity);
+    EQ(size_t(11), batch.size());
+    for (auto v : batch) {
+        EQ(0, memcmp(item.getItemPointer(), v.getItemPointer(), item.size()));
+    }
+}
+// Iteration visits the items in order:
+
+void batchabtest::iterate_1()
+{
+    RingItemBatch batch(FormatSelector::v10);      // No body header word.
+    for (uint32_t i = 0; i < 10; i++) {
+        CBatchTestItem item(PHYSICS_EVENT);
+        fill(item, i+1, i);
+        batch.append(item);
+    }
+    uint32_t i = 0;
+    for (auto p = batch.begin(); p != batch.end(); p++) {
+        CRingItemView v = *p;
+        EQ(size_t((i+1)*sizeof(uint32_t)), v.getBodySize());
+        EQ(i, *static_cast<const uint32_t*>(v.getBodyPointer()));
+        i++;
+    }
+    EQ(uint32_t(10), i);
+}
+// clear empties but keeps the storage:
+
+void batchabtest::clear_1()
+{
+    CBatchTestItem item(PHYSICS_EVENT);
+    RingItemBatch batch;
+    batch.append(item);
+    size_t capacity = batch.capacity();
+    const void* p   = batch.data();
+    batch.clear();
+    ASSERT(batch.empty());
+    EQ(size_t(0), batch.bytes());
+    EQ(capacity, batch.capacity());
+    EQ(p, batch.data());
+}
+// Moving hands over the buffer:
+
+void batchabtest::move_1()
+{
+    CBatchTestItem item(PHYSICS_EVENT);
+    RingItemBatch batch;
+    batch.append(item);
+    const void* p = batch.data();
+    RingItemBatch moved(std::move(batch));
+    EQ(p, moved.data());
+    EQ(size_t(1), moved.size());
+    ASSERT(batch.empty());
+    EQ(size_t(0), batch.capacity());
+}
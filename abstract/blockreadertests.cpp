@@ -0,0 +1,494 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  blockreadertests.cpp
+ *  @brief: Test the block buffered ring item reader.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingBlockReader.h"
+#include "CRingRangeReader.h"
+#include "CRingItemValidator.h"
+#include "CRingItemFilter.h"
+#include "DataFormat.h"
+#include "TestItems.h"
+#include <stdexcept>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+using namespace ufmt;
+using testitems::makeItem;
+using testitems::writeItems;
+
+class blockreadertest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(blockreadertest);
+    CPPUNIT_TEST(construct_1);
+    CPPUNIT_TEST(construct_2);
+    CPPUNIT_TEST(empty_1);
+    CPPUNIT_TEST(read_1);
+    CPPUNIT_TEST(read_2);
+    CPPUNIT_TEST(read_3);
+    CPPUNIT_TEST(truncated_1);
+    CPPUNIT_TEST(truncated_2);
+    CPPUNIT_TEST(bad_1);
+    CPPUNIT_TEST(pipe_1);
+    CPPUNIT_TEST(range_1);
+    CPPUNIT_TEST(range_2);
+    CPPUNIT_TEST(resync_1);
+    CPPUNIT_TEST(resync_2);
+    CPPUNIT_TEST(resync_3);
+    CPPUNIT_TEST(resync_4);
+    CPPUNIT_TEST(peek_1);
+    CPPUNIT_TEST(filter_1);
+    CPPUNIT_TEST(filter_2);
+    CPPUNIT_TEST(filter_3);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    int m_fd;
+public:
+    void setUp() {
+        m_fd = memfd_create("blockreadertest", 0);
+    }
+    void tearDown() {
+        close(m_fd);
+    }
+protected:
+    void construct_1();
+    void construct_2();
+    void empty_1();
+    void read_1();
+    void read_2();
+    void read_3();
+    void truncated_1();
+    void truncated_2();
+    void bad_1();
+    void pipe_1();
+    void range_1();
+    void range_2();
+    void resync_1();
+    void resync_2();
+    void resync_3();
+    void resync_4();
+    void peek_1();
+    void filter_1();
+    void filter_2();
+    void filter_3();
+private:
+    void rewind() { testitems::rewind(m_fd); }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blockreadertest);
+
+// Construction remembers the fd and block size:
+void blockreadertest::construct_1()
+{
+    CRingBlockReader r(m_fd, 1000);
+    EQ(m_fd, r.getFd());
+    EQ(size_t(1000), r.getBlockSize());
+    EQ(size_t(0), r.bytesBuffered());
+    ASSERT(!r.eof());
+}
+// block must at least hold a header:
+
+void blockreadertest::construct_2()
+{
+    CPPUNIT_ASSERT_THROW(
+        CRingBlockReader r(m_fd, sizeof(RingItemHeader) -1),
+        std::invalid_argument
+    );
+}
+// Empty file gives nullptr and eof.
+
+void blockreadertest::empty_1()
+{
+    CRingBlockReader r(m_fd);
+    ASSERT(r.nextItem() == nullptr);
+    ASSERT(r.eof());
+}
+// Several items that fit in a single block:
+
+void blockreadertest::read_1()
+{
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 10; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, 10*i, i));
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingBlockReader r(m_fd);
+    for (int i =0; i < items.size(); i++) {
+        const RingItem* p = r.nextItem();
+        ASSERT(p);
+        EQ(uint32_t(items[i].size()), p->s_header.s_size);
+        EQ(0, memcmp(items[i].data(), p, items[i].size()));
+    }
+    ASSERT(r.nextItem() == nullptr);
+    ASSERT(r.eof());
+}
+// Small block size forces items to straddle block boundaries.
+
+void blockreadertest::read_2()
+{
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 50; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, (i*7) % 40, i));
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingBlockReader r(m_fd, 32);
+    for (int i =0; i < items.size(); i++) {
+        const RingItem* p = r.nextItem();
+        ASSERT(p);
+        EQ(uint32_t(items[i].size()), p->s_header.s_size);
+        EQ(0, memcmp(items[i].data(), p, items[i].size()));
+    }
+    ASSERT(r.nextItem() == nullptr);
+}
+// Item bigger than a block grows the buffer and the items after it
+// are still fine.
+
+void blockreadertest::read_3()
+{
+    std::vector<std::vector<uint8_t>> items;
+    items.push_back(makeItem(PHYSICS_EVENT, 8, 1));
+    items.push_back(makeItem(PHYSICS_EVENT, 1000, 2));
+    items.push_back(makeItem(PHYSICS_EVENT, 8, 3));
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingBlockReader r(m_fd, 64);
+    for (int i =0; i < items.size(); i++) {
+        const RingItem* p = r.nextItem();
+        ASSERT(p);
+        EQ(0, memcmp(items[i].data(), p, items[i].size()));
+    }
+    ASSERT(r.nextItem() == nullptr);
+}
+// Truncated header is eof:
+
+void blockreadertest::truncated_1()
+{
+    auto item = makeItem(PHYSICS_EVENT, 10, 1);
+    write(m_fd, item.data(), item.size());
+    write(m_fd, item.data(), sizeof(uint32_t));
+    rewind();
+
+    CRingBlockReader r(m_fd);
+    ASSERT(r.nextItem());
+    ASSERT(r.nextItem() == nullptr);
+}
+// Truncated body is eof:
+
+void blockreadertest::truncated_2()
+{
+    auto item = makeItem(PHYSICS_EVENT, 10, 1);
+    write(m_fd, item.data(), item.size());
+    write(m_fd, item.data(), item.size() - 1);
+    rewind();
+
+    CRingBlockReader r(m_fd);
+    ASSERT(r.nextItem());
+    ASSERT(r.nextItem() == nullptr);
+}
+// Item size smaller than a header is an error:
+
+void blockreadertest::bad_1()
+{
+    auto item = makeItem(PHYSICS_EVENT, 10, 1);
+    reinterpret_cast<RingItemHeader*>(item.data())->s_size = 2;
+    write(m_fd, item.data(), item.size());
+    rewind();
+
+    CRingBlockReader r(m_fd);
+    CPPUNIT_ASSERT_THROW(r.nextItem(), std::runtime_error);
+}
+// Reads from a pipe return whatever's there - we must be able to
+// assemble items from several short reads.
+
+void blockreadertest::pipe_1()
+{
+    int fds[2];
+    ASSERT(pipe(fds) == 0);
+    auto item = makeItem(PHYSICS_EVENT, 100, 0x5a);
+
+    // Write the item in dribs and drabs before and while reading.
+
+    write(fds[1], item.data(), 3);
+    write(fds[1], item.data() + 3, 20);
+    write(fds[1], item.data() + 23, item.size() - 23);
+    close(fds[1]);
+
+    CRingBlockReader r(fds[0]);
+    const RingItem* p = r.nextItem();
+    ASSERT(p);
+    EQ(0, memcmp(item.data(), p, item.size()));
+    ASSERT(r.nextItem() == nullptr);
+    close(fds[0]);
+}
+// A range reader only gives the items in its range and doesn't move the
+// file offset:
+
+void blockreadertest::range_1()
+{
+    std::vector<std::vector<uint8_t>> items;
+    uint64_t begin = 0;
+    for (int i = 0; i < 10; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, 10 + i, i));
+        if (i < 3) begin += items.back().size();
+    }
+    uint64_t end = begin;
+    for (int i = 3; i < 7; i++) end += items[i].size();
+    writeItems(m_fd, items);
+    off_t here = lseek(m_fd, 0, SEEK_CUR);
+
+    CRingRangeReader r(m_fd, begin, end, 16);
+    EQ(end, r.getEnd());
+    for (int i = 3; i < 7; i++) {
+        const RingItem* p = r.nextItem();
+        ASSERT(p);
+        EQ(0, memcmp(items[i].data(), p, items[i].size()));
+    }
+    ASSERT(r.nextItem() == nullptr);
+    EQ(end, r.getOffset());
+    EQ(here, lseek(m_fd, 0, SEEK_CUR));
+}
+// An item that runs past the end of the range is not given:
+
+void blockreadertest::range_2()
+{
+    std::vector<std::vector<uint8_t>> items;
+    items.push_back(makeItem(PHYSICS_EVENT, 10, 1));
+    items.push_back(makeItem(PHYSICS_EVENT, 10, 2));
+    writeItems(m_fd, items);
+
+    CRingRangeReader r(m_fd, 0, items[0].size() + 5);
+    ASSERT(r.nextItem());
+    ASSERT(r.nextItem() == nullptr);
+    ASSERT(r.eof());
+}
+// Garbage between items is skipped and reported:
+
+void blockreadertest::resync_1()
+{
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 20; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, 4 + i, 0));
+    }
+    writeItems(m_fd, std::vector<std::vector<uint8_t>>(items.begin(), items.begin() + 10));
+    off_t badOffset = lseek(m_fd, 0, SEEK_CUR);
+    std::vector<uint8_t> garbage(1000, 0xee);
+    write(m_fd, garbage.data(), garbage.size());
+    writeItems(m_fd, std::vector<std::vector<uint8_t>>(items.begin() + 10, items.end()));
+    rewind();
+
+    CRingItemValidator v(FormatSelector::v12);
+    CRingBlockReader r(m_fd, 64);
+    r.setValidator(&v);
+    EQ((const CRingItemValidator*)&v, r.getValidator());
+    for (int i = 0; i < items.size(); i++) {
+        const RingItem* p = r.nextItem();
+        ASSERT(p);
+        EQ(0, memcmp(items[i].data(), p, items[i].size()));
+    }
+    ASSERT(r.nextItem() == nullptr);
+
+    auto& skipped = r.getSkipped();
+    EQ(size_t(1), skipped.size());
+    EQ(uint64_t(badOffset), skipped[0].s_offset);
+    EQ(uint64_t(1000), skipped[0].s_nBytes);
+    EQ(CRingItemValidator::tooBig, skipped[0].s_problem);
+    EQ(uint64_t(1000), r.getSkippedBytes());
+    EQ(uint64_t(lseek(m_fd, 0, SEEK_END)), r.getConsumed());
+    r.clearSkipped();
+    EQ(size_t(0), r.getSkipped().size());
+}
+// A truncated last item is reported rather than looking like the end:
+
+void blockreadertest::resync_2()
+{
+    auto item = makeItem(PHYSICS_EVENT, 100, 0);
+    write(m_fd, item.data(), item.size());
+    write(m_fd, item.data(), 50);
+    rewind();
+
+    CRingItemValidator v(FormatSelector::v12);
+    CRingBlockReader r(m_fd);
+    r.setValidator(&v);
+    ASSERT(r.nextItem());
+    ASSERT(r.nextItem() == nullptr);
+    EQ(size_t(1), r.getSkipped().size());
+    EQ(uint64_t(item.size()), r.getSkipped()[0].s_offset);
+    EQ(uint64_t(50), r.getSkipped()[0].s_nBytes);
+    EQ(CRingItemValidator::truncated, r.getSkipped()[0].s_problem);
+}
+// Garbage at the start, and an unknown type:
+
+void blockreadertest::resync_3()
+{
+    auto bad = makeItem(99, 20, 0);
+    write(m_fd, bad.data(), bad.size());
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 5; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, 8, 0));
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingItemValidator v(FormatSelector::v12);
+    CRingBlockReader r(m_fd);
+    r.setValidator(&v);
+    for (int i = 0; i < items.size(); i++) {
+        ASSERT(r.nextItem());
+    }
+    ASSERT(r.nextItem() == nullptr);
+    EQ(size_t(1), r.getSkipped().size());
+    EQ(uint64_t(0), r.getSkipped()[0].s_offset);
+    EQ(uint64_t(bad.size()), r.getSkipped()[0].s_nBytes);
+    EQ(CRingItemValidator::unknownType, r.getSkipped()[0].s_problem);
+}
+// Without a validator a garbage size is believed; with one it isn't:
+
+void blockreadertest::resync_4()
+{
+    auto item = makeItem(PHYSICS_EVENT, 8, 0);
+    RingItemHeader* pH = reinterpret_cast<RingItemHeader*>(item.data());
+    pH->s_size = 0x7ffffff0;
+    write(m_fd, item.data(), item.size());
+    auto good = makeItem(PHYSICS_EVENT, 8, 0);
+    for (int i = 0; i < 5; i++) {
+        write(m_fd, good.data(), good.size());
+    }
+    rewind();
+
+    CRingItemValidator v(FormatSelector::v12);
+    CRingBlockReader r(m_fd, 128);
+    r.setValidator(&v);
+    for (int i = 0; i < 5; i++) {
+        ASSERT(r.nextItem());
+    }
+    ASSERT(r.nextItem() == nullptr);
+    EQ(uint64_t(item.size()), r.getSkippedBytes());
+}
+// Peeking doesn't consume data:
+
+void blockreadertest::peek_1()
+{
+    std::vector<std::vector<uint8_t>> items;
+    items.push_back(makeItem(PHYSICS_EVENT, 10, 1));
+    items.push_back(makeItem(PHYSICS_EVENT, 10, 2));
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingBlockReader r(m_fd, 1000);
+    uint8_t data[1000];
+    size_t total = items[0].size() + items[1].size();
+    EQ(total, r.peek(data, sizeof(data)));
+    EQ(0, memcmp(items[0].data(), data, items[0].size()));
+    EQ(size_t(4), r.peek(data, 4));
+
+    const RingItem* p = r.nextItem();
+    ASSERT(p);
+    EQ(0, memcmp(items[0].data(), p, items[0].size()));
+    EQ(items[1].size(), r.peek(data, sizeof(data)));
+    EQ(0, memcmp(items[1].data(), data, items[1].size()));
+    ASSERT(r.nextItem());
+    EQ(size_t(0), r.peek(data, sizeof(data)));
+    ASSERT(r.nextItem() == nullptr);
+}
+// Rejected items, big or small, are stepped over:
+
+void blockreadertest::filter_1()
+{
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 10; i++) {
+        items.push_back(
+            (i % 2) ? makeItem(PHYSICS_EVENT, 100000, i) :
+                makeItem(PERIODIC_SCALERS, 10 + i, i)
+        );
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingItemFilter filter;
+    filter.excludeTypes(std::vector<uint32_t>(1, PHYSICS_EVENT));
+    CRingBlockReader r(m_fd, 64);
+    r.setFilter(&filter);
+    EQ((const CRingItemFilter*)&filter, r.getFilter());
+    for (int i = 0; i < 10; i += 2) {
+        const RingItem* p = r.nextItem();
+        ASSERT(p);
+        EQ(0, memcmp(items[i].data(), p, items[i].size()));
+    }
+    ASSERT(r.nextItem() == nullptr);
+    EQ(uint64_t(5), r.getFilteredCount());
+    EQ(uint64_t(lseek(m_fd, 0, SEEK_END)), r.getConsumed());
+}
+// Unseekable sources read and discard rejected items:
+
+void blockreadertest::filter_2()
+{
+    int fds[2];
+    ASSERT(pipe(fds) == 0);
+    std::vector<std::vector<uint8_t>> items;
+    items.push_back(makeItem(PHYSICS_EVENT, 1000, 1));
+    items.push_back(makeItem(PERIODIC_SCALERS, 10, 2));
+    items.push_back(makeItem(PHYSICS_EVENT, 1000, 3));
+    writeItems(fds[1], items);
+    close(fds[1]);
+
+    CRingItemFilter filter;
+    filter.selectTypes(std::vector<uint32_t>(1, PERIODIC_SCALERS));
+    CRingBlockReader r(fds[0], 32);
+    r.setFilter(&filter);
+    const RingItem* p = r.nextItem();
+    ASSERT(p);
+    EQ(0, memcmp(items[1].data(), p, items[1].size()));
+    ASSERT(r.nextItem() == nullptr);
+    EQ(uint64_t(2), r.getFilteredCount());
+    close(fds[0]);
+}
+// Range readers skip within their range:
+
+void blockreadertest::filter_3()
+{
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 6; i++) {
+        items.push_back(makeItem((i % 3) ? PHYSICS_EVENT : PERIODIC_SCALERS, 200, i));
+    }
+    writeItems(m_fd, items);
+    uint64_t end = items.size() * items[0].size() - 1;   // Truncates the last.
+
+    CRingItemFilter filter;
+    filter.excludeTypes(std::vector<uint32_t>(1, PHYSICS_EVENT));
+    CRingRangeReader r(m_fd, 0, end, 16);
+    r.setFilter(&filter);
+    const RingItem* p = r.nextItem();
+    ASSERT(p);
+    EQ(0, memcmp(items[0].data(), p, items[0].size()));
+    p = r.nextItem();
+    ASSERT(p);
+    EQ(0, memcmp(items[3].data(), p, items[3].size()));
+    ASSERT(r.nextItem() == nullptr);
+    EQ(end, r.getOffset());
+}
@@ -0,0 +1,229 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  blockwritertests.cpp
+ *  @brief: Test the buffered ring item block writer.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingBlockWriter.h"
+#include <stdexcept>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+using namespace ufmt;
+
+// Writer that counts the writes it makes:
+
+class CCountingWriter : public CRingBlockWriter {
+public:
+    unsigned m_writes;
+    CCountingWriter(int fd, size_t blockSize, unsigned interval = 0) :
+        CRingBlockWriter(fd, blockSize, interval), m_writes(0) {}
+    ~CCountingWriter() {
+        flush();               // Our writeBlock is gone by the base destructor.
+    }
+protected:
+    virtual void writeBlock(const void* pData, size_t nBytes) {
+        m_writes++;
+        CRingBlockWriter::writeBlock(pData, nBytes);
+    }
+};
+
+class blockwritertest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(blockwritertest);
+    CPPUNIT_TEST(construct_1);
+    CPPUNIT_TEST(construct_2);
+    CPPUNIT_TEST(coalesce_1);
+    CPPUNIT_TEST(coalesce_2);
+    CPPUNIT_TEST(big_1);
+    CPPUNIT_TEST(flush_1);
+    CPPUNIT_TEST(interval_1);
+    CPPUNIT_TEST(destroy_1);
+    CPPUNIT_TEST(bad_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    int m_fd;
+public:
+    void setUp() {
+        m_fd = memfd_create("blockwritertest", 0);
+    }
+    void tearDown() {
+        close(m_fd);
+    }
+protected:
+    void construct_1();
+    void construct_2();
+    void coalesce_1();
+    void coalesce_2();
+    void big_1();
+    void flush_1();
+    void interval_1();
+    void destroy_1();
+    void bad_1();
+private:
+    std::vector<uint8_t> contents();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(blockwritertest);
+
+// What's been written to the memfd:
+
+std::vector<uint8_t>
+blockwritertest::contents()
+{
+    off_t size = lseek(m_fd, 0, SEEK_END);
+    std::vector<uint8_t> result(size);
+    if (size) {
+        EQ(ssize_t(size), pread(m_fd, result.data(), size, 0));
+    }
+    return result;
+}
+
+// Construction saves the parameters:
+
+void blockwritertest::construct_1()
+{
+    CRingBlockWriter w(m_fd);
+    EQ(m_fd, w.getFd());
+    EQ(CRingBlockWriter::DEFAULT_BLOCK_SIZE, w.getBlockSize());
+    EQ(unsigned(0), w.getFlushInterval());
+    EQ(size_t(0), w.bytesBuffered());
+}
+void blockwritertest::construct_2()
+{
+    CRingBlockWriter w(m_fd, 1024, 100);
+    EQ(size_t(1024), w.getBlockSize());
+    EQ(unsigned(100), w.getFlushInterval());
+}
+// Small puts are buffered until the block fills:
+
+void blockwritertest::coalesce_1()
+{
+    CCountingWriter w(m_fd, 1024);
+    uint8_t data[100];
+    memset(data, 1, sizeof(data));
+    for (int i = 0; i < 10; i++) {
+        w.put(data, sizeof(data));
+    }
+    EQ(unsigned(0), w.m_writes);
+    EQ(size_t(1000), w.bytesBuffered());
+    EQ(size_t(0), contents().size());
+
+    w.put(data, sizeof(data));              // Overflows -> one write.
+    EQ(unsigned(1), w.m_writes);
+    EQ(size_t(100), w.bytesBuffered());
+    EQ(size_t(1000), contents().size());
+}
+// Data come out in order:
+
+void blockwritertest::coalesce_2()
+{
+    std::vector<uint8_t> expected;
+    {
+        CCountingWriter w(m_fd, 256);
+        for (int i = 0; i < 100; i++) {
+            uint8_t data[37];
+            memset(data, i, sizeof(data));
+            w.put(data, sizeof(data));
+            expected.insert(expected.end(), data, data + sizeof(data));
+        }
+        w.flush();
+        EQ(unsigned((100 + 5)/6), w.m_writes);   // 6 items/block.
+    }
+    ASSERT(expected == contents());
+}
+// Data at least a block in size are written directly:
+
+void blockwritertest::big_1()
+{
+    CCountingWriter w(m_fd, 1024);
+    uint8_t small[10];
+    memset(small, 1, sizeof(small));
+    std::vector<uint8_t> big(2048, 2);
+
+    w.put(small, sizeof(small));
+    w.put(big.data(), big.size());
+    EQ(unsigned(2), w.m_writes);            // Buffered data first, then big.
+    EQ(size_t(0), w.bytesBuffered());
+
+    auto data = contents();
+    EQ(size_t(2058), data.size());
+    EQ(uint8_t(1), data[9]);
+    EQ(uint8_t(2), data[10]);
+}
+// Flush writes partial blocks and is a no-op when empty:
+
+void blockwritertest::flush_1()
+{
+    CCountingWriter w(m_fd, 1024);
+    w.flush();
+    EQ(unsigned(0), w.m_writes);
+
+    uint8_t data[10];
+    memset(data, 1, sizeof(data));
+    w.put(data, sizeof(data));
+    w.flush();
+    EQ(unsigned(1), w.m_writes);
+    EQ(size_t(0), w.bytesBuffered());
+    EQ(size_t(10), contents().size());
+}
+// The flush thread writes data that's been waiting for the interval:
+
+void blockwritertest::interval_1()
+{
+    CRingBlockWriter w(m_fd, 1024, 20);
+    uint8_t data[10];
+    memset(data, 1, sizeof(data));
+    w.put(data, sizeof(data));
+
+    for (int i = 0; i < 100 && w.bytesBuffered(); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    }
+    EQ(size_t(0), w.bytesBuffered());
+    EQ(size_t(10), contents().size());
+}
+// Destruction writes what's left:
+
+void blockwritertest::destroy_1()
+{
+    {
+        CRingBlockWriter w(m_fd, 1024);
+        uint8_t data[10];
+        memset(data, 1, sizeof(data));
+        w.put(data, sizeof(data));
+        EQ(size_t(0), contents().size());
+    }
+    EQ(size_t(10), contents().size());
+}
+// Write errors are reported by flush:
+
+void blockwritertest::bad_1()
+{
+    CRingBlockWriter w(-1, 1024);
+    uint8_t data[10];
+    memset(data, 1, sizeof(data));
+    w.put(data, sizeof(data));
+    CPPUNIT_ASSERT_THROW(w.flush(), int);   // errno from writeData.
+}
@@ -0,0 +1,270 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  columnsabtests.cpp
+ *  @brief: Test extraction of ring item headers into columns.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingHeaderColumns.h"
+#include "DataFormat.h"
+#include "fragment.h"
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+#include <string.h>
+
+using namespace ufmt;
+
+typedef std::vector<uint8_t> Bytes;
+
+class columnstest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(columnstest);
+    CPPUNIT_TEST(empty_1);
+    CPPUNIT_TEST(extract_1);
+    CPPUNIT_TEST(extract_2);
+    CPPUNIT_TEST(extract_3);
+    CPPUNIT_TEST(extract_4);
+    CPPUNIT_TEST(frag_1);
+    CPPUNIT_TEST(frag_2);
+    CPPUNIT_TEST(append_1);
+    CPPUNIT_TEST(bodyheader_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    CRingHeaderColumns* m_pColumns;
+public:
+    void setUp() {
+        m_pColumns = new CRingHeaderColumns;
+    }
+    void tearDown() {
+        delete m_pColumns;
+    }
+protected:
+    void empty_1();
+    void extract_1();
+    void extract_2();
+    void extract_3();
+    void extract_4();
+    void frag_1();
+    void frag_2();
+    void append_1();
+    void bodyheader_1();
+private:
+    Bytes item(
+        uint32_t type, size_t bodySize, bool bodyHeader,
+        uint64_t ts = 0, uint32_t sid = 0, uint32_t barrier = 0
+    );
+    Bytes someItems();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(columnstest);
+
+// A v12 item:
+
+Bytes
+columnstest::item(
+    uint32_t type, size_t bodySize, bool bodyHeader,
+    uint64_t ts, uint32_t sid, uint32_t barrier
+)
+{
+    Bytes result;
+    uint32_t bhSize = bodyHeader ? sizeof(BodyHeader) : sizeof(uint32_t);
+    uint32_t hdr[2] = {uint32_t(sizeof(RingItemHeader) + bhSize + bodySize), type};
+    result.insert(result.end(), (uint8_t*)hdr, (uint8_t*)(hdr + 2));
+    if (bodyHeader) {
+        BodyHeader bh = {sizeof(BodyHeader), ts, sid, barrier};
+        result.insert(result.end(), (uint8_t*)&bh, (uint8_t*)(&bh + 1));
+    } else {
+        result.insert(result.end(), (uint8_t*)&bhSize, (uint8_t*)(&bhSize + 1));
+    }
+    result.insert(result.end(), bodySize, uint8_t(0x55));
+    return result;
+}
+// Odd sized items, with and without body headers:
+
+Bytes
+columnstest::someItems()
+{
+    Bytes result;
+    for (int i = 0; i < 10; i++) {
+        Bytes it = (i % 3) ?
+            item(PHYSICS_EVENT, i + 1, true, 1000 + i, i, i == 0 ? 1 : 0) :
+            item(PERIODIC_SCALERS, i + 3, false);
+        result.insert(result.end(), it.begin(), it.end());
+    }
+    return result;
+}
+
+void columnstest::empty_1()
+{
+    EQ(size_t(0), m_pColumns->size());
+    EQ(size_t(0), m_pColumns->extract(nullptr, 0));
+    EQ(size_t(0), m_pColumns->size());
+}
+// Every field of every item:
+
+void columnstest::extract_1()
+{
+    Bytes data = someItems();
+    EQ(data.size(), m_pColumns->extract(data.data(), data.size(), 100));
+    EQ(size_t(10), m_pColumns->size());
+
+    size_t offset = 0;
+    for (size_t i = 0; i < 10; i++) {
+        const RingItemHeader* pH =
+            reinterpret_cast<const RingItemHeader*>(data.data() + offset);
+        EQ(uint64_t(100 + offset), m_pColumns->getOffsets()[i]);
+        EQ(pH->s_size, m_pColumns->getSizes()[i]);
+        EQ(pH->s_type, m_pColumns->getTypes()[i]);
+        if (i % 3) {
+            EQ(uint64_t(1000 + i), m_pColumns->getTimestamps()[i]);
+            EQ(uint32_t(i), m_pColumns->getSourceIds()[i]);
+        } else {
+            EQ(uint64_t(NULL_TIMESTAMP), m_pColumns->getTimestamps()[i]);
+            EQ(uint32_t(0), m_pColumns->getSourceIds()[i]);
+            EQ(uint32_t(0), m_pColumns->getBarriers()[i]);
+        }
+        offset += pH->s_size;
+    }
+}
+// A partial item at the end is left for the next buffer:
+
+void columnstest::extract_2()
+{
+    Bytes data = someItems();
+    size_t last = data.size() - item(PERIODIC_SCALERS, 12, false).size();
+    EQ(last, m_pColumns->extract(data.data(), data.size() - 1));
+    EQ(size_t(9), m_pColumns->size());
+
+    EQ(data.size() - last, m_pColumns->extract(data.data() + last, data.size() - last, last));
+    EQ(size_t(10), m_pColumns->size());
+    EQ(uint64_t(last), m_pColumns->getOffsets()[9]);
+    EQ(PERIODIC_SCALERS, m_pColumns->getTypes()[9]);
+}
+// clear empties the columns:
+
+void columnstest::extract_3()
+{
+    Bytes data = someItems();
+    m_pColumns->extract(data.data(), data.size());
+    m_pColumns->clear();
+    EQ(size_t(0), m_pColumns->size());
+    m_pColumns->extract(data.data(), data.size());
+    EQ(size_t(10), m_pColumns->size());
+}
+// Garbage sizes are an error:
+
+void columnstest::extract_4()
+{
+    uint32_t bad[4] = {4, PHYSICS_EVENT, 0, 0};
+    CPPUNIT_ASSERT_THROW(
+        m_pColumns->extract(bad, sizeof(bad)), std::runtime_error
+    );
+}
+// The fragments of a built event:
+
+void columnstest::frag_1()
+{
+    Bytes body(sizeof(uint32_t));
+    for (int i = 0; i < 3; i++) {
+        Bytes payload = item(PHYSICS_EVENT, 4*i, true, 500 + i, 7 + i);
+        EVB::FragmentHeader fh = {
+            uint64_t(500 + i), uint32_t(7 + i), uint32_t(payload.size()),
+            uint32_t(i == 2 ? BARRIER_END : 0)
+        };
+        body.insert(body.end(), (uint8_t*)&fh, (uint8_t*)(&fh + 1));
+        body.insert(body.end(), payload.begin(), payload.end());
+    }
+    uint32_t n = body.size();
+    memcpy(body.data(), &n, sizeof(n));
+
+    EQ(size_t(3), m_pColumns->extractFragments(body.data(), 1000));
+    size_t offset = sizeof(uint32_t);
+    for (int i = 0; i < 3; i++) {
+        offset += sizeof(EVB::FragmentHeader);
+        EQ(uint64_t(1000 + offset), m_pColumns->getOffsets()[i]);
+        EQ(uint64_t(500 + i), m_pColumns->getTimestamps()[i]);
+        EQ(uint32_t(7 + i), m_pColumns->getSourceIds()[i]);
+        EQ(uint32_t(i == 2 ? BARRIER_END : 0), m_pColumns->getBarriers()[i]);
+        EQ(PHYSICS_EVENT, m_pColumns->getTypes()[i]);
+        offset += m_pColumns->getSizes()[i];
+    }
+    EQ(size_t(n), offset);
+}
+// Fragments that overrun the body throw:
+
+void columnstest::frag_2()
+{
+    EVB::FragmentHeader fh = {1, 2, 100, 0};
+    CPPUNIT_ASSERT_THROW(
+        m_pColumns->extractFragments(&fh, sizeof(fh), 0), std::runtime_error
+    );
+}
+// Adding items one at a time from their headers fills the same columns
+// as extracting them:
+
+void columnstest::append_1()
+{
+    Bytes data = someItems();
+    CRingHeaderColumns extracted;
+    extracted.extract(data.data(), data.size(), 100);
+
+    size_t offset = 0;
+    while (offset < data.size()) {
+        uint32_t size;
+        memcpy(&size, data.data() + offset, sizeof(size));
+        size_t n = std::min(size_t(size), sizeof(RingItemHeader) + sizeof(BodyHeader));
+        m_pColumns->append(data.data() + offset, n, 100 + offset);
+        offset += size;
+    }
+    EQ(extracted.size(), m_pColumns->size());
+    for (size_t i = 0; i < extracted.size(); i++) {
+        EQ(extracted.getOffsets()[i], m_pColumns->getOffsets()[i]);
+        EQ(extracted.getSizes()[i], m_pColumns->getSizes()[i]);
+        EQ(extracted.getTypes()[i], m_pColumns->getTypes()[i]);
+        EQ(extracted.getTimestamps()[i], m_pColumns->getTimestamps()[i]);
+        EQ(extracted.getSourceIds()[i], m_pColumns->getSourceIds()[i]);
+        EQ(extracted.getBarriers()[i], m_pColumns->getBarriers()[i]);
+        EQ(extracted.getBodyHeaders()[i], m_pColumns->getBodyHeaders()[i]);
+        EQ(uint8_t(i % 3 != 0), m_pColumns->getBodyHeaders()[i]);
+    }
+    uint32_t tiny[1] = {4};
+    CPPUNIT_ASSERT_THROW(
+        m_pColumns->append(tiny, sizeof(tiny), 0), std::runtime_error
+    );
+    CPPUNIT_ASSERT_THROW(
+        m_pColumns->append(data.data(), sizeof(RingItemHeader), 0),
+        std::runtime_error
+    );
+}
+// Body headers with extension data are still body headers:
+
+void columnstest::bodyheader_1()
+{
+    Bytes data = item(PHYSICS_EVENT, 16, true, 1234, 5, 0);
+    uint32_t bhSize = sizeof(BodyHeader) + 8;
+    memcpy(data.data() + sizeof(RingItemHeader), &bhSize, sizeof(bhSize));
+    m_pColumns->extract(data.data(), data.size());
+    m_pColumns->append(data.data(), data.size(), 0);
+    for (size_t i = 0; i < 2; i++) {
+        EQ(uint8_t(1), m_pColumns->getBodyHeaders()[i]);
+        EQ(uint64_t(1234), m_pColumns->getTimestamps()[i]);
+        EQ(uint32_t(5), m_pColumns->getSourceIds()[i]);
+    }
+}
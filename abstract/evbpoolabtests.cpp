@@ -0,0 +1,211 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  evbpoolabtests.cpp
+ *  @brief: Test the event builder fragment storage pools.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "fragment.h"
+#include <thread>
+#include <vector>
+
+using namespace ufmt;
+
+class evbpooltest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(evbpooltest);
+    CPPUNIT_TEST(alloc_1);
+    CPPUNIT_TEST(alloc_2);
+    CPPUNIT_TEST(alloc_3);
+    CPPUNIT_TEST(depot_1);
+    CPPUNIT_TEST(depot_2);
+    CPPUNIT_TEST(depot_3);
+    CPPUNIT_TEST(trim_1);
+    CPPUNIT_TEST(thread_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    EVB::FragmentPoolStatistics m_stats;
+public:
+    void setUp() {
+        trimFragmentPool();
+        clearFragmentPoolStatistics();
+    }
+    void tearDown() {
+        trimFragmentPool();
+    }
+protected:
+    void alloc_1();
+    void alloc_2();
+    void alloc_3();
+    void depot_1();
+    void depot_2();
+    void depot_3();
+    void trim_1();
+    void thread_1();
+private:
+    EVB::FragmentPoolStatistics& stats() {
+        getFragmentPoolStatistics(&m_stats);
+        return m_stats;
+    }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(evbpooltest);
+
+// A freed fragment's header and body are reused:
+
+void evbpooltest::alloc_1()
+{
+    EVB::pFragment p1 = newFragment(1, 2, 100);
+    EQ(uint64_t(1), p1->s_header.s_timestamp);
+    EQ(uint32_t(2), p1->s_header.s_sourceId);
+    EQ(uint32_t(100), p1->s_header.s_size);
+    void* pBody = p1->s_pBody;
+    freeFragment(p1);
+
+    EVB::pFragment p2 = newFragment(3, 4, 120);    // Same size class.
+    EQ(p1, p2);
+    EQ(pBody, p2->s_pBody);
+    freeFragment(p2);
+
+    auto& s(stats());
+    EQ(uint64_t(4), s.s_allocations);
+    EQ(uint64_t(4), s.s_frees);
+    EQ(uint64_t(2), s.s_magazineHits);
+    EQ(uint64_t(2), s.s_systemAllocations);
+}
+// Different size classes don't share blocks:
+
+void evbpooltest::alloc_2()
+{
+    EVB::pFragment p1 = newFragment(1, 2, 100);
+    void* pBody = p1->s_pBody;
+    freeFragment(p1);
+
+    EVB::pFragment p2 = newFragment(1, 2, 1000);
+    ASSERT(pBody != p2->s_pBody);
+    EQ(uint64_t(1), stats().s_magazineHits);        // Just the header.
+    freeFragment(p2);
+}
+// Huge bodies aren't pooled:
+
+void evbpooltest::alloc_3()
+{
+    EVB::pFragment p = newFragment(1, 2, 16*1024*1024);
+    freeFragment(p);
+    auto& s(stats());
+    EQ(uint64_t(1), s.s_oversized);
+    EQ(uint64_t(1), s.s_systemFrees);
+}
+// Freeing more than two magazines worth moves magazines to the depot,
+// allocating them again takes them back:
+
+void evbpooltest::depot_1()
+{
+    std::vector<EVB::pFragment> frags;
+    for (int i = 0; i < 100; i++) {
+        frags.push_back(newFragment(i, 0, 64));
+    }
+    for (auto p : frags) {
+        freeFragment(p);
+    }
+    auto& s(stats());
+    ASSERT(s.s_depotUnloads > 0);
+    ASSERT(s.s_depotMagazines > 0);
+    ASSERT(s.s_depotBytes > 0);
+    EQ(uint64_t(0), s.s_systemFrees);
+
+    for (int i = 0; i < 100; i++) {
+        frags[i] = newFragment(i, 0, 64);
+    }
+    auto& s2(stats());
+    ASSERT(s2.s_depotLoads > 0);
+    EQ(uint64_t(200), s2.s_systemAllocations);     // No new ones.
+    EQ(uint64_t(200), s2.s_magazineHits);
+    for (auto p : frags) {
+        freeFragment(p);
+    }
+}
+// The depot is bounded, past that blocks go back to the system:
+
+void evbpooltest::depot_2()
+{
+    std::vector<EVB::pFragment> frags;
+    for (int i = 0; i < 5000; i++) {
+        frags.push_back(newFragment(i, 0, 8));
+    }
+    for (auto p : frags) {
+        freeFragment(p);
+    }
+    // Each class keeps two magazines in the thread and 64 in the depot:
+
+    auto& s(stats());
+    EQ(uint64_t(2*64), s.s_depotMagazines);
+    EQ(uint64_t(2*(5000 - 64*32 - 2*32)), s.s_systemFrees);
+}
+// Big blocks are pooled by bytes, not blocks: 2MB blocks go one to a
+// magazine and 16 magazines fill the depot's 32MB:
+
+void evbpooltest::depot_3()
+{
+    std::vector<EVB::pFragment> frags;
+    for (int i = 0; i < 40; i++) {
+        frags.push_back(newFragment(i, 0, 1024*1024));
+    }
+    for (auto p : frags) {
+        freeFragment(p);
+    }
+    auto& s(stats());
+    EQ(uint64_t(16), s.s_depotMagazines);
+    EQ(uint64_t(32*1024*1024), s.s_depotBytes);
+    EQ(uint64_t(40 - 16 - 2), s.s_systemFrees);
+}
+// Trimming empties the depot:
+
+void evbpooltest::trim_1()
+{
+    std::vector<EVB::pFragment> frags;
+    for (int i = 0; i < 100; i++) {
+        frags.push_back(newFragment(i, 0, 64));
+    }
+    for (auto p : frags) {
+        freeFragment(p);
+    }
+    trimFragmentPool();
+    auto& s(stats());
+    EQ(uint64_t(0), s.s_depotMagazines);
+    EQ(uint64_t(0), s.s_depotBytes);
+    EQ(uint64_t(200), s.s_systemFrees);
+}
+// Blocks freed in another thread come back through the depot when that
+// thread exits; its counters aren't lost:
+
+void evbpooltest::thread_1()
+{
+    EVB::pFragment p = newFragment(1, 2, 100);
+    std::thread t([p]() { freeFragment(p); });
+    t.join();
+
+    auto& s(stats());
+    EQ(uint64_t(2), s.s_frees);
+    EQ(uint64_t(2), s.s_depotMagazines);
+
+    EVB::pFragment p2 = newFragment(1, 2, 100);
+    EQ(p, p2);
+    freeFragment(p2);
+}
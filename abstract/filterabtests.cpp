@@ -0,0 +1,274 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  filterabtests.cpp
+ *  @brief: Test selection of ring items by their headers.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingItemFilter.h"
+#include "CRingHeaderColumns.h"
+#include "DataFormat.h"
+#include "fragment.h"
+#include <vector>
+
+using namespace ufmt;
+
+class filtertest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(filtertest);
+    CPPUNIT_TEST(empty_1);
+    CPPUNIT_TEST(type_1);
+    CPPUNIT_TEST(type_2);
+    CPPUNIT_TEST(type_3);
+    CPPUNIT_TEST(sid_1);
+    CPPUNIT_TEST(ts_1);
+    CPPUNIT_TEST(barrier_1);
+    CPPUNIT_TEST(bodyheader_1);
+    CPPUNIT_TEST(v10_1);
+    CPPUNIT_TEST(clear_1);
+    CPPUNIT_TEST(columns_1);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+
+    }
+    void tearDown() {
+
+    }
+protected:
+    void empty_1();
+    void type_1();
+    void type_2();
+    void type_3();
+    void sid_1();
+    void ts_1();
+    void barrier_1();
+    void bodyheader_1();
+    void v10_1();
+    void clear_1();
+    void columns_1();
+private:
+    struct Item {
+        RingItemHeader s_header;
+        BodyHeader     s_bodyHeader;
+    };
+    Item item(uint32_t type, uint64_t ts, uint32_t sid, uint32_t barrier = 0);
+    Item noBodyHeader(uint32_t type);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(filtertest);
+
+filtertest::Item
+filtertest::item(uint32_t type, uint64_t ts, uint32_t sid, uint32_t barrier)
+{
+    Item result = {{sizeof(Item), type}, {sizeof(BodyHeader), ts, sid, barrier}};
+    return result;
+}
+filtertest::Item
+filtertest::noBodyHeader(uint32_t type)
+{
+    Item result = {{sizeof(Item), type}, {sizeof(uint32_t), 0, 0, 0}};
+    return result;
+}
+
+// With no predicates everything's accepted:
+
+void filtertest::empty_1()
+{
+    CRingItemFilter f;
+    ASSERT(f.acceptsAll());
+    EQ(FormatSelector::v12, f.getVersion());
+    EQ(sizeof(Item), f.headerBytes());
+    Item i = item(PHYSICS_EVENT, 1, 2);
+    ASSERT(f.accept(&i));
+    ASSERT(f.acceptType(0xffffffff));
+}
+// Selected types:
+
+void filtertest::type_1()
+{
+    CRingItemFilter f;
+    std::vector<uint32_t> types = {PERIODIC_SCALERS, BEGIN_RUN};
+    f.selectTypes(types);
+    ASSERT(!f.acceptsAll());
+    ASSERT(f.acceptType(PERIODIC_SCALERS));
+    ASSERT(f.acceptType(BEGIN_RUN));
+    ASSERT(!f.acceptType(PHYSICS_EVENT));
+    ASSERT(!f.acceptType(0x12345678));
+    Item i = item(PHYSICS_EVENT, 1, 2);
+    ASSERT(!f.accept(&i));
+    i = item(BEGIN_RUN, 1, 2);
+    ASSERT(f.accept(&i));
+}
+// Excluded types:
+
+void filtertest::type_2()
+{
+    CRingItemFilter f;
+    f.excludeTypes(std::vector<uint32_t>(1, PHYSICS_EVENT));
+    ASSERT(!f.acceptType(PHYSICS_EVENT));
+    ASSERT(f.acceptType(PERIODIC_SCALERS));
+    ASSERT(f.acceptType(0x12345678));
+}
+// Types past the bitmap and the latest type predicate wins:
+
+void filtertest::type_3()
+{
+    CRingItemFilter f;
+    std::vector<uint32_t> types = {0x12345678, CRingItemFilter::TYPE_BITMAP_SIZE - 1};
+    f.excludeTypes(types);
+    ASSERT(!f.acceptType(0x12345678));
+    ASSERT(!f.acceptType(CRingItemFilter::TYPE_BITMAP_SIZE - 1));
+    ASSERT(f.acceptType(0x12345679));
+
+    f.selectTypes(types);
+    ASSERT(f.acceptType(0x12345678));
+    ASSERT(f.acceptType(CRingItemFilter::TYPE_BITMAP_SIZE - 1));
+    ASSERT(!f.acceptType(0x12345679));
+    ASSERT(!f.acceptType(PHYSICS_EVENT));
+}
+// Source ids; items without a body header pass:
+
+void filtertest::sid_1()
+{
+    CRingItemFilter f;
+    std::vector<uint32_t> ids = {5, 2};
+    f.selectSourceIds(ids);
+    Item i = item(PHYSICS_EVENT, 1, 2);
+    ASSERT(f.accept(&i));
+    i = item(PHYSICS_EVENT, 1, 5);
+    ASSERT(f.accept(&i));
+    i = item(PHYSICS_EVENT, 1, 3);
+    ASSERT(!f.accept(&i));
+    i = noBodyHeader(BEGIN_RUN);
+    ASSERT(f.accept(&i));
+}
+// Timestamp range is inclusive and null timestamps pass:
+
+void filtertest::ts_1()
+{
+    CRingItemFilter f;
+    f.setTimestampRange(100, 200);
+    Item i = item(PHYSICS_EVENT, 100, 1);
+    ASSERT(f.accept(&i));
+    i = item(PHYSICS_EVENT, 200, 1);
+    ASSERT(f.accept(&i));
+    i = item(PHYSICS_EVENT, 99, 1);
+    ASSERT(!f.accept(&i));
+    i = item(PHYSICS_EVENT, 201, 1);
+    ASSERT(!f.accept(&i));
+    i = item(PHYSICS_EVENT, NULL_TIMESTAMP, 1);
+    ASSERT(f.accept(&i));
+}
+// Barrier types:
+
+void filtertest::barrier_1()
+{
+    CRingItemFilter f;
+    std::vector<uint32_t> barriers = {BARRIER_START, BARRIER_END};
+    f.selectBarrierTypes(barriers);
+    Item i = item(BEGIN_RUN, 1, 1, BARRIER_START);
+    ASSERT(f.accept(&i));
+    i = item(PHYSICS_EVENT, 1, 1, BARRIER_NOTBARRIER);
+    ASSERT(!f.accept(&i));
+}
+// Requiring a body header; tiny items never have one:
+
+void filtertest::bodyheader_1()
+{
+    CRingItemFilter f;
+    f.requireBodyHeader();
+    ASSERT(!f.acceptsAll());
+    Item i = noBodyHeader(BEGIN_RUN);
+    ASSERT(!f.accept(&i));
+    i = item(PHYSICS_EVENT, 1, 1);
+    ASSERT(f.accept(&i));
+    i.s_header.s_size = sizeof(RingItemHeader) + sizeof(uint32_t);
+    ASSERT(!f.accept(&i));
+
+    // A body header size too small to hold one means there isn't one:
+
+    i = item(PHYSICS_EVENT, 1, 1);
+    i.s_bodyHeader.s_size = sizeof(uint32_t) + sizeof(uint64_t);
+    ASSERT(!f.accept(&i));
+    f.requireBodyHeader(false);
+    f.selectSourceIds(std::vector<uint32_t>(1, 7));
+    ASSERT(f.accept(&i));
+}
+// v10 items have no body headers:
+
+void filtertest::v10_1()
+{
+    CRingItemFilter f(FormatSelector::v10);
+    EQ(sizeof(RingItemHeader), f.headerBytes());
+    f.selectSourceIds(std::vector<uint32_t>(1, 7));
+    Item i = item(PHYSICS_EVENT, 1, 3);
+    ASSERT(f.accept(&i));
+    f.requireBodyHeader();
+    ASSERT(!f.accept(&i));
+}
+// clear removes all predicates:
+
+void filtertest::clear_1()
+{
+    CRingItemFilter f;
+    f.selectTypes(std::vector<uint32_t>(1, BEGIN_RUN));
+    f.selectSourceIds(std::vector<uint32_t>(1, 7));
+    f.setTimestampRange(0, 1);
+    f.clear();
+    ASSERT(f.acceptsAll());
+    Item i = item(PHYSICS_EVENT, 100, 3);
+    ASSERT(f.accept(&i));
+}
+// Filtering header columns agrees with filtering the items one at a time:
+
+void filtertest::columns_1()
+{
+    std::vector<Item> items;
+    for (uint32_t i = 0; i < 40; i++) {
+        items.push_back((i % 4) ?
+            item((i % 3) ? PHYSICS_EVENT : PERIODIC_SCALERS, 10*i, i % 5, i % 2) :
+            noBodyHeader(BEGIN_RUN)
+        );
+    }
+    items[5].s_bodyHeader.s_timestamp = NULL_TIMESTAMP;
+    CRingHeaderColumns columns;
+    columns.extract(items.data(), items.size()*sizeof(Item));
+
+    std::vector<CRingItemFilter> filters(5);
+    filters[0].selectTypes(std::vector<uint32_t>(1, PHYSICS_EVENT));
+    filters[1].selectSourceIds({1, 3});
+    filters[2].setTimestampRange(100, 250);
+    filters[3].selectBarrierTypes(std::vector<uint32_t>(1, 1));
+    filters[3].excludeTypes(std::vector<uint32_t>(1, PERIODIC_SCALERS));
+    filters[4].requireBodyHeader();
+    filters[4].setVersion(FormatSelector::v11);
+    for (auto& f : filters) {
+        std::vector<uint8_t> accepted;
+        size_t n = f.accept(columns, accepted);
+        EQ(items.size(), accepted.size());
+        size_t count = 0;
+        for (size_t i = 0; i < items.size(); i++) {
+            EQ(f.accept(&items[i]), bool(accepted[i]));
+            count += accepted[i];
+        }
+        EQ(count, n);
+        ASSERT((n > 0) && (n < items.size()));
+    }
+}
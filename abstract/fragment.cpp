@@ -17,12 +17,14 @@
 #include <stdlib.h>
 #include <string.h>
 
-#include <list>
+#include <algorithm>
+#include <atomic>
+#include <utility>
+#include <set>
 #include <vector>
 #include "CMutex.h"
 #include <thread>
 #include <iostream>
-#include <memory>
 
 using namespace ufmt;
 namespace ufmt::EVB {
@@ -34,71 +36,82 @@ bool threadsafe=true;   // By default threadsafe.
  * 
  *  almost 50% of event builder time was spent in dynamic memory allocation
  *  Here's the idea:
- *    Allocation of fragment headers is done by first checking to see if the
- *    fragmentHeaderPool list has a header.  If so, the front of that list is
- *    given to the caller.  If not, a new one is allocated with malloc.
- *    When freed, a fragment header goes unconditionally back to the back of the
- *    fragmentHeaderPool.
+ *    Fragment bodies are of variable size so there are several size classes.
+ *    Each holds fixed length power of two blocks (e.g.  1, 2, 4, 8, 16...
+ *    bytes).  The most significant set bit (+1) of the size of the requested
+ *    block selects the class.  Fragment headers have a class of their own.
+ *    Bodies bigger than the largest class are malloc-ed and freed directly.
  *
- *    Fragment bodies are a bit trickier as they are of variable size.  We therefore
- *    have several fragment body pools.  Each contains zero or more fixed length
- *    power of two fragments (e.g.  2, 4, 8, 16, 32... bytes).  The most significant
- *    set bit (+1) of the size of the requested block is used to select a pool.
- *    After that the algorithm is the same as for fragment header... but
- *    fixed sized blocks appropriate to the pool are used.
+ *    Free blocks are kept in magazines: fixed capacity stacks of blocks of
+ *    one class.  Each thread has two magazines per class, the loaded one,
+ *    which allocations pop from and frees push on, and the previous one.
+ *    When the loaded magazine is empty (allocation) or full (free) the two
+ *    are swapped if that helps.  Only when it doesn't does the thread go to
+ *    the depot, which holds magazines shared by all threads, and exchange
+ *    an empty magazine for a full one or vice versa.  So most allocations
+ *    and frees touch only the calling thread's magazines and the depot's
+ *    mutex is taken at most once every MAGAZINE_SIZE operations.
  *
- *    Similarly on free, the size of the block is used to determine the
- *    pool into which the block is returned.  The set of pools itself is
- *    resized as needed to ensure we have sufficient pools to satsify the
- *    memory request so far.
+ *    So that big blocks don't pin large amounts of memory, magazines of
+ *    big classes hold fewer blocks (at most MAX_MAGAZINE_BYTES of them) and
+ *    the depot holds at most MAX_DEPOT_BYTES of full magazines per class
+ *    (and never more than MAX_DEPOT_MAGAZINES); past that, freed blocks go
+ *    back to the system.  trimFragmentPool gives everything in the depot
+ *    (and the calling thread's magazines) back to the system.  When a
+ *    thread exits its magazines go to the depot.
  */ 
-  
-// The pool below is for fragment headers:
 
-typedef std::vector<pFragment> FragmentHeaderPool;
-typedef std::vector<void*>     FragmentBodyPool;
+static const unsigned MAGAZINE_SIZE       = 32;
+static const unsigned MAX_MAGAZINE_BYTES  = 1024*1024;
+static const unsigned MAX_DEPOT_MAGAZINES = 64;   // Full ones, per class.
+static const uint64_t MAX_DEPOT_BYTES     = 32*1024*1024;   // Per class.
+static const unsigned MAX_POOLED_CLASS    = 22;   // 4MB bodies.
+static const unsigned HEADER_CLASS        = MAX_POOLED_CLASS + 1;
+static const unsigned NUM_CLASSES         = HEADER_CLASS + 1;
 
-FragmentHeaderPool fragmentHeaderPool;
+struct Magazine {
+  unsigned s_count;
+  void*    s_blocks[MAGAZINE_SIZE];
+};
 
-// The vector below contains the fragment body pools. The size of fragments
-// from each pool is 2x the size of the prior pool.
+// Counters are per thread and only changed by their thread so the atomic
+// increments don't contend:
 
-std::vector<FragmentBodyPool> fragmentBodyPools;
+enum Counter {
+  allocations, frees, magazineHits, depotLoads, depotUnloads,
+  systemAllocations, systemFrees, oversized, NUM_COUNTERS
+};
 
-CMutex poolProtector;             // So we're threadsafe.
+struct ThreadCache;
 
 /**
- *  resetFragmentPool
- *     For testing purposes - frees all elements of the header and body pools:
+ * The depot.  Its mutex also protects the registry of live thread caches
+ * and the counters of threads that have exited.
  */
-void
-resetFragmentPool()
-{
-  while(!fragmentHeaderPool.empty()) {
-    free(fragmentHeaderPool.back());
-    fragmentHeaderPool.pop_back();
-  }
-  while(!fragmentBodyPools.empty()) {
-    FragmentBodyPool& pool(fragmentBodyPools.back());
-    while(!pool.empty()) {
-      free(pool.back());
-      pool.pop_back();
-    }
-    fragmentBodyPools.pop_back();
+struct Depot {
+  CMutex                 s_lock;
+  std::vector<Magazine*> s_full[NUM_CLASSES];
+  std::vector<Magazine*> s_empty;
+  std::set<ThreadCache*> s_caches;
+  uint64_t               s_retired[NUM_COUNTERS];
+
+  Depot() {
+    memset(s_retired, 0, sizeof(s_retired));
   }
-}
+  ~Depot();
+  void trim();
+};
+
+static Depot depot;
 
 /**
  * getPoolNumber
- *    Return the index of the pool in fragmentBodyPools that will have
- *    the smallest storage region at least as big as the size passed in.
+ *    Return the class whose blocks are the smallest storage region at
+ *    least as big as the size passed in.
  *
  * @param size   - Number of bytes needed.
- * @return unsigned - index into fragmentBodyPools
- * @note there's no assurance the indicated element exists.  Callers should use
- *       getPool to obtain a reference to the indexed pool as that will enlarge
- *       the vecstor of pools if needed.
- *       
+ * @return unsigned - class number; bodies above MAX_POOLED_CLASS aren't
+ *                    pooled.
  */
 static unsigned
 getPoolNumber(unsigned size)
@@ -115,70 +128,255 @@ getPoolNumber(unsigned size)
   return n;
 }
 /**
- * getPool
- *    Given a pool number returns a reference to the pool -- even if we
- *    have to enlarge the fragmentBodyPools vector to do that.
+ * poolSize
+ *   Returns the size to use when allocating elements for this class.
  *
- * @param unsigned poolNo - pool number
- * @return FragmentBodyPool& - reference to the appropriate pool number.
+ * @param poolNo - Pool number.
+ * @return unsigned - number of bytes of blocks in each pool.
  */
-static FragmentBodyPool&
-getPool(unsigned poolNo)
+static unsigned
+poolSize(unsigned poolNo)
 {
-    
-   static std::vector<void*> emptyList;           // Used to expand the pools. 
+  if (poolNo == HEADER_CLASS) return sizeof(Fragment);
+  return (1 << poolNo);
+}
+/**
+ * magazineCapacity
+ *   @param poolNo - pool number.
+ *   @return unsigned - blocks a magazine of that class holds.
+ */
+static unsigned
+magazineCapacity(unsigned poolNo)
+{
+  unsigned n = MAX_MAGAZINE_BYTES / poolSize(poolNo);
+  return std::max(1U, std::min(n, MAGAZINE_SIZE));
+}
+/**
+ * depotCapacity
+ *   @param poolNo - pool number.
+ *   @return size_t - full magazines of that class the depot holds.
+ */
+static size_t
+depotCapacity(unsigned poolNo)
+{
+  uint64_t n = MAX_DEPOT_BYTES / (uint64_t(magazineCapacity(poolNo)) * poolSize(poolNo));
+  return std::max(uint64_t(1), std::min(n, uint64_t(MAX_DEPOT_MAGAZINES)));
+}
+/**
+ * DepotLock
+ *    Locks the depot if we're being threadsafe.
+ */
+class DepotLock {
+  bool m_locked;
+public:
+  DepotLock() : m_locked(threadsafe) {
+    if (m_locked) depot.s_lock.lock();
+  }
+  ~DepotLock() {
+    if (m_locked) depot.s_lock.unlock();
+  }
+};
+/**
+ * freeMagazineBlocks
+ *    Give the blocks in a magazine back to the system.
+ */
+static void
+freeMagazineBlocks(Magazine* pMag, std::atomic<uint64_t>* pCounters)
+{
+  for (unsigned i = 0; i < pMag->s_count; i++) {
+    free(pMag->s_blocks[i]);
+  }
+  if (pCounters) pCounters[systemFrees].fetch_add(pMag->s_count, std::memory_order_relaxed);
+  pMag->s_count = 0;
+}
+/**
+ * ThreadCache
+ *    A thread's magazines and counters.
+ */
+struct ThreadCache {
+  Magazine*             s_loaded[NUM_CLASSES];
+  Magazine*             s_previous[NUM_CLASSES];
+  std::atomic<uint64_t> s_counters[NUM_COUNTERS];
 
-    while (poolNo >= fragmentBodyPools.size()) {
-      
-      fragmentBodyPools.push_back(emptyList);
+  ThreadCache() {
+    for (unsigned i = 0; i < NUM_CLASSES; i++) {
+      s_loaded[i]   = new Magazine;
+      s_loaded[i]->s_count = 0;
+      s_previous[i] = new Magazine;
+      s_previous[i]->s_count = 0;
     }
-    try {
-      return fragmentBodyPools.at(poolNo);
+    for (unsigned i = 0; i < NUM_COUNTERS; i++) {
+      s_counters[i] = 0;
     }
-    catch (...) {
-      std::cerr << "getPool - no fragmentBody Pool for " << poolNo << std::endl;
-      std::cerr.flush();
-      throw;               // Likely crashes us.
+    DepotLock l;
+    depot.s_caches.insert(this);
+  }
+  ~ThreadCache() {
+    DepotLock l;
+    for (unsigned i = 0; i < NUM_CLASSES; i++) {
+      retire(s_loaded[i], i);
+      retire(s_previous[i], i);
+    }
+    for (unsigned i = 0; i < NUM_COUNTERS; i++) {
+      depot.s_retired[i] += s_counters[i];
+    }
+    depot.s_caches.erase(this);
+  }
+  void count(Counter c) {
+    s_counters[c].fetch_add(1, std::memory_order_relaxed);
+  }
+  // Called with the depot locked: magazine to depot if there's room.
+  void retire(Magazine* pMag, unsigned poolNo) {
+    if (pMag->s_count && (depot.s_full[poolNo].size() < depotCapacity(poolNo))) {
+      depot.s_full[poolNo].push_back(pMag);
+      s_counters[depotUnloads]++;
+    } else {
+      freeMagazineBlocks(pMag, s_counters);
+      delete pMag;
+    }
+  }
+  // Return the calling thread's blocks to the system.
+  void trim() {
+    for (unsigned i = 0; i < NUM_CLASSES; i++) {
+      freeMagazineBlocks(s_loaded[i], s_counters);
+      freeMagazineBlocks(s_previous[i], s_counters);
     }
+  }
+  void* allocate(unsigned poolNo);
+  void  release(void* pBlock, unsigned poolNo);
+};
+
+/**
+ * threadCache
+ *   @return ThreadCache& - the calling thread's magazines.
+ */
+static ThreadCache&
+threadCache()
+{
+  static thread_local ThreadCache cache;
+  return cache;
 }
+
 /**
- * poolSize
- *   Returns the size to use when allocating elements for this pool.
+ * Depot destructor - at exit give back all the memory.
+ */
+Depot::~Depot()
+{
+  trim();
+}
+/**
+ * Depot::trim
+ *   Free the blocks and magazines in the depot.  Must be called with
+ *   the depot locked.
+ */
+void
+Depot::trim()
+{
+  for (unsigned i = 0; i < NUM_CLASSES; i++) {
+    for (auto pMag : s_full[i]) {
+      s_retired[systemFrees] += pMag->s_count;
+      freeMagazineBlocks(pMag, nullptr);
+      delete pMag;
+    }
+    s_full[i].clear();
+  }
+  for (auto pMag : s_empty) {
+    delete pMag;
+  }
+  s_empty.clear();
+}
+
+/**
+ * ThreadCache::allocate
+ *    Get a block of a class.
  *
- * @param poolNo - Pool number.
- * @return unsigned - number of bytes of blocks in each pool.
+ * @param poolNo - class of the block.
+ * @return void* - the block.
  */
-static unsigned
-poolSize(unsigned poolNo)
+void*
+ThreadCache::allocate(unsigned poolNo)
 {
-  return (1 << poolNo);
+  count(allocations);
+  Magazine*& loaded(s_loaded[poolNo]);
+  Magazine*& previous(s_previous[poolNo]);
+  
+  if (!loaded->s_count && previous->s_count) {
+    std::swap(loaded, previous);
+  }
+  if (!loaded->s_count) {
+    // Exchange our empty previous magazine for a full one from the depot:
+    
+    DepotLock l;
+    std::vector<Magazine*>& full(depot.s_full[poolNo]);
+    if (!full.empty()) {
+      depot.s_empty.push_back(previous);
+      previous = loaded;
+      loaded   = full.back();
+      full.pop_back();
+      count(depotLoads);
+    }
+  }
+  if (loaded->s_count) {
+    count(magazineHits);
+    return loaded->s_blocks[--loaded->s_count];
+  }
+  if (debug) std::cerr << std::this_thread::get_id() << " pool " << poolNo << " empty\n";
+  count(systemAllocations);
+  return malloc(poolSize(poolNo));
 }
 /**
- * getFragmentDescription [static] - get a new fragment header
+ * ThreadCache::release
+ *    Give back a block of a class.
  *
- * @return pFragment
+ * @param pBlock - the block.
+ * @param poolNo - its class.
  */
-static pFragment
-getFragmentDescription()
+void
+ThreadCache::release(void* pBlock, unsigned poolNo)
 {
-  pFragment result(0);
-  if (!fragmentHeaderPool.empty()) {
-    result = fragmentHeaderPool.back();
-    fragmentHeaderPool.pop_back();
+  count(frees);
+  Magazine*& loaded(s_loaded[poolNo]);
+  Magazine*& previous(s_previous[poolNo]);
+  unsigned   capacity = magazineCapacity(poolNo);
+  
+  if ((loaded->s_count == capacity) && (previous->s_count < capacity)) {
+    std::swap(loaded, previous);
+  }
+  if (loaded->s_count == capacity) {
+    // Both are full, give the previous one to the depot if it has room:
+    
+    DepotLock l;
+    std::vector<Magazine*>& full(depot.s_full[poolNo]);
+    if (full.size() < depotCapacity(poolNo)) {
+      full.push_back(previous);
+      previous = loaded;
+      if (depot.s_empty.empty()) {
+        loaded = new Magazine;
+      } else {
+        loaded = depot.s_empty.back();
+        depot.s_empty.pop_back();
+      }
+      loaded->s_count = 0;
+      count(depotUnloads);
+    }
+  }
+  if (loaded->s_count < capacity) {
+    loaded->s_blocks[loaded->s_count++] = pBlock;
   } else {
-    result = static_cast<pFragment>(malloc(sizeof(Fragment)));
+    count(systemFrees);
+    free(pBlock);
   }
-  return result;
 }
 
 /**
- * freeFragmentDescription
- *    Releses a fragment description by putting it on the back of the fragmentHeaderPool
+ *  resetFragmentPool
+ *     For testing purposes - frees all free blocks of the depot and the
+ *     calling thread's magazines.
  */
-static void
-freeFragmentHeader(pFragment pHeader)
+void
+resetFragmentPool()
 {
-  fragmentHeaderPool.push_back(pHeader);
+  trimFragmentPool();
 }
 
 /**
@@ -192,21 +390,15 @@ freeFragmentHeader(pFragment pHeader)
 static void*
 getFragmentBody(size_t bytes)
 {
-  void* result(nullptr);
-  
-  int poolNo = getPoolNumber(bytes);
-  FragmentBodyPool& pool(getPool(poolNo));          // Makes more pools if needed.
-  
-  if (pool.empty()) {
-    if (debug) std::cerr << std::this_thread::get_id() << " pool " << poolNo << " empty\n";
-    result = malloc(poolSize(poolNo));
-  } else {
-    if (debug) std::cerr << std::this_thread::get_id() << " Satsified body from pool\n";
-    result = pool.back();
-    pool.pop_back();
+  unsigned poolNo = getPoolNumber(bytes);
+  ThreadCache& cache(threadCache());
+  if (poolNo > MAX_POOLED_CLASS) {
+    cache.count(allocations);
+    cache.count(oversized);
+    cache.count(systemAllocations);
+    return malloc(bytes);
   }
-  if (debug) std::cerr.flush();
-  return result;
+  return cache.allocate(poolNo);
 }
 
 /**
@@ -220,8 +412,14 @@ static void
 freeFragmentBody(pFragment pFrag)
 {
   unsigned poolNo = getPoolNumber(pFrag->s_header.s_size);
-  FragmentBodyPool& pool(getPool(poolNo));
-  pool.push_back(pFrag->s_pBody);
+  ThreadCache& cache(threadCache());
+  if (poolNo > MAX_POOLED_CLASS) {
+    cache.count(frees);
+    cache.count(systemFrees);
+    free(pFrag->s_pBody);
+  } else {
+    cache.release(pFrag->s_pBody, poolNo);
+  }
 }
 /**
  * Free a fragment.  The assumption is that  both the header and the body 
@@ -233,11 +431,9 @@ freeFragmentBody(pFragment pFrag)
 extern "C" {
 void freeFragment(pFragment p) 
 {
-  std::unique_ptr<CriticalSection> l;
-  if (threadsafe) l.reset(new CriticalSection(poolProtector));
   freeFragmentBody(p);
   p->s_pBody = 0;
-  freeFragmentHeader(p);
+  threadCache().release(p, HEADER_CLASS);
 
 }
 }
@@ -255,9 +451,7 @@ void freeFragment(pFragment p)
 extern "C" {
 pFragment allocateFragment(const FragmentHeader* pHeader)
 {
-  std::unique_ptr<CriticalSection> l;
-  if (threadsafe) l.reset(new CriticalSection(poolProtector));
-  pFragment p = getFragmentDescription();
+  pFragment p = static_cast<pFragment>(threadCache().allocate(HEADER_CLASS));
   memcpy(&(p->s_header), pHeader, sizeof(FragmentHeader));
 
   p->s_pBody = getFragmentBody(pHeader->s_size);
@@ -300,5 +494,72 @@ fragmentChainLength(pFragmentChain p)
   return result;
 }
 }
+/**
+ * getFragmentPoolStatistics
+ *    Sum the counters of all threads (including those that have exited).
+ *
+ * @param pStats - where to put the statistics.
+ */
+extern "C" {
+void
+getFragmentPoolStatistics(pFragmentPoolStatistics pStats)
+{
+  uint64_t counters[NUM_COUNTERS];
+  DepotLock l;
+  memcpy(counters, depot.s_retired, sizeof(counters));
+  for (auto pCache : depot.s_caches) {
+    for (unsigned i = 0; i < NUM_COUNTERS; i++) {
+      counters[i] += pCache->s_counters[i].load(std::memory_order_relaxed);
+    }
+  }
+  pStats->s_allocations       = counters[allocations];
+  pStats->s_frees             = counters[frees];
+  pStats->s_magazineHits      = counters[magazineHits];
+  pStats->s_depotLoads        = counters[depotLoads];
+  pStats->s_depotUnloads      = counters[depotUnloads];
+  pStats->s_systemAllocations = counters[systemAllocations];
+  pStats->s_systemFrees       = counters[systemFrees];
+  pStats->s_oversized         = counters[oversized];
+  pStats->s_depotMagazines    = 0;
+  pStats->s_depotBytes        = 0;
+  for (unsigned i = 0; i < NUM_CLASSES; i++) {
+    pStats->s_depotMagazines += depot.s_full[i].size();
+    for (auto pMag : depot.s_full[i]) {
+      pStats->s_depotBytes += uint64_t(pMag->s_count) * poolSize(i);
+    }
+  }
+}
+}
+/**
+ * clearFragmentPoolStatistics
+ *    Zero the counters of all threads.
+ */
+extern "C" {
+void
+clearFragmentPoolStatistics()
+{
+  DepotLock l;
+  memset(depot.s_retired, 0, sizeof(depot.s_retired));
+  for (auto pCache : depot.s_caches) {
+    for (unsigned i = 0; i < NUM_COUNTERS; i++) {
+      pCache->s_counters[i] = 0;
+    }
+  }
+}
+}
+/**
+ * trimFragmentPool
+ *    Give the free blocks in the depot and in the calling thread's
+ *    magazines back to the system.  Other threads' magazines are not
+ *    touched.
+ */
+extern "C" {
+void
+trimFragmentPool()
+{
+  threadCache().trim();
+  DepotLock l;
+  depot.trim();
+}
+}
 }
-
@@ -97,6 +97,24 @@ namespace ufmt{
     int            s_body[0];
   } FlatFragment, *pFlatFragment;
 
+  /**
+   * Counters describing the use of the fragment storage pools
+   * (see getFragmentPoolStatistics).  Allocations and frees count
+   * headers and bodies separately.
+   */
+  typedef struct _FragmentPoolStatistics {
+    uint64_t s_allocations;
+    uint64_t s_frees;
+    uint64_t s_magazineHits;      /* Allocations from a thread's magazine.   */
+    uint64_t s_depotLoads;        /* Magazines taken from the depot.         */
+    uint64_t s_depotUnloads;      /* Magazines given to the depot.           */
+    uint64_t s_systemAllocations; /* Blocks malloc-ed.                       */
+    uint64_t s_systemFrees;       /* Blocks given back with free.            */
+    uint64_t s_oversized;         /* Bodies too big to pool.                 */
+    uint64_t s_depotMagazines;    /* Magazines now in the depot...           */
+    uint64_t s_depotBytes;        /* ...and the bytes of the blocks in them. */
+  } FragmentPoolStatistics, *pFragmentPoolStatistics;
+
 #ifdef __cplusplus
   }}
 #endif
@@ -115,6 +133,13 @@ namespace ufmt{
     NS(pFragment) newFragment(uint64_t timestamp, uint32_t sourceId, uint32_t size);
 
     size_t fragmentChainLength(NS(pFragmentChain) p);
+
+    void getFragmentPoolStatistics(NS(pFragmentPoolStatistics) pStats);
+    void clearFragmentPoolStatistics();
+    /* Frees the pooled blocks in the shared depot and the calling thread's
+       magazines.  Other threads keep theirs (at most two magazines of
+       1MB each per size class) until they exit. */
+    void trimFragmentPool();
 #ifdef __cplusplus
   }
 #endif
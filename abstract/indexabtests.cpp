@@ -0,0 +1,346 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  indexabtests.cpp
+ *  @brief: Test the sidecar event file index.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingFileIndex.h"
+#include "DataFormat.h"
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+using namespace ufmt;
+
+class indexabtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(indexabtest);
+    CPPUNIT_TEST(build_1);
+    CPPUNIT_TEST(build_2);
+    CPPUNIT_TEST(item_1);
+    CPPUNIT_TEST(physics_1);
+    CPPUNIT_TEST(time_1);
+    CPPUNIT_TEST(time_2);
+    CPPUNIT_TEST(file_1);
+    CPPUNIT_TEST(file_2);
+    CPPUNIT_TEST(file_3);
+    CPPUNIT_TEST(file_4);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    int m_fd;
+    std::vector<uint64_t> m_offsets;         // of each item.
+    std::vector<uint64_t> m_physicsOffsets;  // of each physics event.
+public:
+    void setUp() {
+        m_fd = memfd_create("indexabtest", 0);
+        m_offsets.clear();
+        m_physicsOffsets.clear();
+    }
+    void tearDown() {
+        close(m_fd);
+    }
+protected:
+    void build_1();
+    void build_2();
+    void item_1();
+    void physics_1();
+    void time_1();
+    void time_2();
+    void file_1();
+    void file_2();
+    void file_3();
+    void file_4();
+private:
+    void writeItem(uint32_t type, bool bodyHeader, uint64_t ts, uint32_t bodyBytes);
+    void writeRun();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(indexabtest);
+
+// Write a v11/v12 style item with or without a body header:
+
+void
+indexabtest::writeItem(uint32_t type, bool bodyHeader, uint64_t ts, uint32_t bodyBytes)
+{
+    std::vector<uint8_t> item(sizeof(RingItemHeader));
+    if (bodyHeader) {
+        BodyHeader bh = {sizeof(BodyHeader), ts, 1, 0};
+        uint8_t* p = reinterpret_cast<uint8_t*>(&bh);
+        item.insert(item.end(), p, p + sizeof(bh));
+    } else {
+        uint32_t empty = sizeof(uint32_t);
+        uint8_t* p = reinterpret_cast<uint8_t*>(&empty);
+        item.insert(item.end(), p, p + sizeof(empty));
+    }
+    item.resize(item.size() + bodyBytes, 0xaa);
+    RingItemHeader* pH = reinterpret_cast<RingItemHeader*>(item.data());
+    pH->s_size = item.size();
+    pH->s_type = type;
+
+    off_t offset = lseek(m_fd, 0, SEEK_CUR);
+    m_offsets.push_back(offset);
+    if (type == PHYSICS_EVENT) m_physicsOffsets.push_back(offset);
+    write(m_fd, item.data(), item.size());
+}
+// A begin run, 20 physics events (timestamps 100, 110...) with a
+// scaler item without a body header every 5, and an end run.
+
+void
+indexabtest::writeRun()
+{
+    writeItem(BEGIN_RUN, false, 0, 100);
+    for (int i = 0; i < 20; i++) {
+        writeItem(PHYSICS_EVENT, true, 100 + 10*i, i);
+        if ((i % 5) == 4) {
+            writeItem(PERIODIC_SCALERS, false, 0, 20);
+        }
+    }
+    writeItem(END_RUN, false, 0, 100);
+}
+
+// Counts and blocks:
+
+void indexabtest::build_1()
+{
+    writeRun();
+    CRingFileIndex index;
+    index.build(m_fd, FormatSelector::v12, 4);
+
+    EQ(uint64_t(26), index.getItemCount());
+    EQ(uint64_t(20), index.getTypeCount(PHYSICS_EVENT));
+    EQ(uint64_t(4),  index.getTypeCount(PERIODIC_SCALERS));
+    EQ(uint64_t(1),  index.getTypeCount(BEGIN_RUN));
+    EQ(uint64_t(0),  index.getTypeCount(PACKET_TYPES));
+    EQ(unsigned(4), index.getStride());
+
+    auto& blocks = index.getBlocks();
+    EQ(size_t(7), blocks.size());
+    for (int i = 0; i < blocks.size(); i++) {
+        EQ(m_offsets[4*i], blocks[i].s_offset);
+        EQ(uint64_t(4*i), blocks[i].s_firstItem);
+    }
+    EQ(uint32_t(2), blocks.back().s_itemCount);
+    // First block is begin run and events 0,1,2:
+
+    EQ(uint64_t(100), blocks[0].s_minTimestamp);
+    EQ(uint64_t(120), blocks[0].s_maxTimestamp);
+    EQ(uint64_t(0), blocks[0].s_physicsBefore);
+    EQ(uint64_t(3), blocks[1].s_physicsBefore);
+
+    // The file is positioned after the last item:
+
+    EQ(off_t(lseek(m_fd, 0, SEEK_END)), lseek(m_fd, 0, SEEK_CUR));
+}
+// v10 has no body headers so there are no timestamps:
+
+void indexabtest::build_2()
+{
+    writeRun();
+    CRingFileIndex index;
+    index.build(m_fd, FormatSelector::v10, 4);
+    EQ(uint64_t(26), index.getItemCount());
+    for (auto& b : index.getBlocks()) {
+        EQ(CRingFileIndex::NO_TIMESTAMP, b.s_minTimestamp);
+        EQ(CRingFileIndex::NO_TIMESTAMP, b.s_maxTimestamp);
+    }
+    uint64_t offset;
+    ASSERT(!index.findTimestamp(m_fd, 0, offset));
+}
+// Find every item by number:
+
+void indexabtest::item_1()
+{
+    writeRun();
+    CRingFileIndex index;
+    index.build(m_fd, FormatSelector::v12, 4);
+    off_t here = lseek(m_fd, 0, SEEK_CUR);
+
+    for (uint64_t i = 0; i < m_offsets.size(); i++) {
+        uint64_t offset;
+        ASSERT(index.findItem(m_fd, i, offset));
+        EQ(m_offsets[i], offset);
+    }
+    uint64_t offset;
+    ASSERT(!index.findItem(m_fd, m_offsets.size(), offset));
+    EQ(here, lseek(m_fd, 0, SEEK_CUR));        // pread only.
+}
+// Find every physics event by number:
+
+void indexabtest::physics_1()
+{
+    writeRun();
+    CRingFileIndex index;
+    index.build(m_fd, FormatSelector::v12, 4);
+
+    for (uint64_t i = 0; i < m_physicsOffsets.size(); i++) {
+        uint64_t offset;
+        ASSERT(index.findPhysicsEvent(m_fd, i, offset));
+        EQ(m_physicsOffsets[i], offset);
+    }
+    uint64_t offset;
+    ASSERT(!index.findPhysicsEvent(m_fd, 20, offset));
+}
+// Exact and in between timestamps:
+
+void indexabtest::time_1()
+{
+    writeRun();
+    CRingFileIndex index;
+    index.build(m_fd, FormatSelector::v12, 4);
+
+    uint64_t offset;
+    ASSERT(index.findTimestamp(m_fd, 0, offset));
+    EQ(m_physicsOffsets[0], offset);           // Begin run has none.
+    ASSERT(index.findTimestamp(m_fd, 150, offset));
+    EQ(m_physicsOffsets[5], offset);
+    ASSERT(index.findTimestamp(m_fd, 151, offset));
+    EQ(m_physicsOffsets[6], offset);
+    ASSERT(index.findTimestamp(m_fd, 290, offset));
+    EQ(m_physicsOffsets[19], offset);
+    ASSERT(!index.findTimestamp(m_fd, 291, offset));
+}
+// Out of order timestamps still find the first item at/after:
+
+void indexabtest::time_2()
+{
+    writeItem(PHYSICS_EVENT, true, 50, 0);
+    writeItem(PHYSICS_EVENT, true, 10, 0);
+    writeItem(PHYSICS_EVENT, true, 20, 0);
+    writeItem(PHYSICS_EVENT, true, 60, 0);
+    writeItem(PHYSICS_EVENT, true, 30, 0);
+    CRingFileIndex index;
+    index.build(m_fd, FormatSelector::v12, 2);
+
+    uint64_t offset;
+    ASSERT(index.findTimestamp(m_fd, 55, offset));
+    EQ(m_offsets[3], offset);
+    ASSERT(index.findTimestamp(m_fd, 15, offset));
+    EQ(m_offsets[0], offset);
+}
+// Write/read round trip and currency:
+
+void indexabtest::file_1()
+{
+    char eventName[] = "/tmp/indexabtestXXXXXX";
+    int fd = mkstemp(eventName);
+    close(m_fd);
+    m_fd = fd;
+    writeRun();
+    std::string indexName = CRingFileIndex::indexPath(eventName);
+    EQ(std::string(eventName) + ".idx", indexName);
+
+    CRingFileIndex index;
+    index.build(eventName, FormatSelector::v12, 4);
+    index.write(indexName);
+
+    CRingFileIndex copy;
+    copy.read(indexName);
+    ASSERT(copy.isCurrent(eventName));
+    EQ(index.getItemCount(), copy.getItemCount());
+    EQ(index.getStride(), copy.getStride());
+    EQ(FormatSelector::v12, copy.getVersion());
+    EQ(index.getBlocks().size(), copy.getBlocks().size());
+    for (int i = 0; i < index.getBlocks().size(); i++) {
+        auto& a = index.getBlocks()[i];
+        auto& b = copy.getBlocks()[i];
+        EQ(a.s_offset, b.s_offset);
+        EQ(a.s_physicsBefore, b.s_physicsBefore);
+        EQ(a.s_minTimestamp, b.s_minTimestamp);
+        EQ(a.s_maxTimestamp, b.s_maxTimestamp);
+        ASSERT(a.s_typeCounts == b.s_typeCounts);
+    }
+    uint64_t offset;
+    ASSERT(copy.findPhysicsEvent(m_fd, 7, offset));
+    EQ(m_physicsOffsets[7], offset);
+
+    // Adding to the file makes the index stale:
+
+    writeItem(END_RUN, false, 0, 0);
+    ASSERT(!copy.isCurrent(eventName));
+
+    unlink(indexName.c_str());
+    unlink(eventName);
+}
+// Reading something that's not an index fails:
+
+void indexabtest::file_2()
+{
+    char name[] = "/tmp/indexabtestXXXXXX";
+    int fd = mkstemp(name);
+    write(fd, "not an index file at all, no not at all...", 40);
+    close(fd);
+
+    CRingFileIndex index;
+    CPPUNIT_ASSERT_THROW(index.read(name), std::runtime_error);
+    CPPUNIT_ASSERT_THROW(index.read("/no/such/index"), std::runtime_error);
+    unlink(name);
+}
+// Stride must be non-zero.
+
+void indexabtest::file_3()
+{
+    CRingFileIndex index;
+    CPPUNIT_ASSERT_THROW(
+        index.build(m_fd, FormatSelector::v12, 0), std::invalid_argument
+    );
+    ASSERT(!index.isCurrent("/no/such/file"));
+}
+// Sidecars whose header or blocks don't fit the event file are rejected.
+// Offsets are those of the FileHeader fields and first BlockHeader:
+
+void indexabtest::file_4()
+{
+    char eventName[] = "/tmp/indexabtestXXXXXX";
+    int fd = mkstemp(eventName);
+    close(m_fd);
+    m_fd = fd;
+    writeRun();
+    std::string indexName = CRingFileIndex::indexPath(eventName);
+    CRingFileIndex index;
+    index.build(eventName, FormatSelector::v12, 4);
+
+    struct {
+        off_t    offset;
+        uint64_t value;
+        size_t   bytes;
+    } damage[] = {
+        {12, 0, sizeof(uint32_t)},               // Stride.
+        {40, 1000000, sizeof(uint64_t)},         // Items in the file.
+        {48, 2, sizeof(uint64_t)},               // Blocks.
+        {56, 1000000, sizeof(uint64_t)},         // Block 0 offset.
+        {64, 3, sizeof(uint64_t)}                // Block 0 first item.
+    };
+    for (auto& d : damage) {
+        index.write(indexName);
+        int idx = open(indexName.c_str(), O_WRONLY);
+        pwrite(idx, &d.value, d.bytes, d.offset);
+        close(idx);
+        CRingFileIndex copy;
+        CPPUNIT_ASSERT_THROW(copy.read(indexName), std::runtime_error);
+    }
+    unlink(indexName.c_str());
+    unlink(eventName);
+}
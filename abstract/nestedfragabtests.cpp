@@ -0,0 +1,260 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  nestedfragabtests.cpp
+ *  @brief: Test the nested built event index.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CNestedFragmentIndex.h"
+#include "DataFormat.h"
+#include "fragment.h"
+#include <stdexcept>
+#include <vector>
+#include <string.h>
+
+using namespace ufmt;
+
+typedef std::vector<uint8_t> Bytes;
+
+class nestedfragtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(nestedfragtest);
+    CPPUNIT_TEST(flat_1);
+    CPPUNIT_TEST(nested_1);
+    CPPUNIT_TEST(nested_2);
+    CPPUNIT_TEST(depth_1);
+    CPPUNIT_TEST(body_1);
+    CPPUNIT_TEST(body_2);
+    CPPUNIT_TEST(notbuilt_1);
+    CPPUNIT_TEST(bad_1);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+
+    }
+    void tearDown() {
+
+    }
+protected:
+    void flat_1();
+    void nested_1();
+    void nested_2();
+    void depth_1();
+    void body_1();
+    void body_2();
+    void notbuilt_1();
+    void bad_1();
+private:
+    Bytes item(uint32_t type, const Bytes& body, bool bodyHeader = false);
+    Bytes fragment(uint64_t ts, uint32_t sid, const Bytes& payload);
+    Bytes built(const std::vector<Bytes>& fragments);
+    Bytes leaf(uint32_t value);
+    Bytes twoLevels();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(nestedfragtest);
+
+// A v12 ring item:
+
+Bytes
+nestedfragtest::item(uint32_t type, const Bytes& body, bool bodyHeader)
+{
+    Bytes result;
+    uint32_t bhSize = bodyHeader ? sizeof(BodyHeader) : sizeof(uint32_t);
+    uint32_t hdr[2] = {uint32_t(sizeof(RingItemHeader) + bhSize + body.size()), type};
+    result.insert(result.end(), (uint8_t*)hdr, (uint8_t*)(hdr + 2));
+    if (bodyHeader) {
+        BodyHeader bh = {sizeof(BodyHeader), 0x1234, 5, 0};
+        result.insert(result.end(), (uint8_t*)&bh, (uint8_t*)(&bh + 1));
+    } else {
+        result.insert(result.end(), (uint8_t*)&bhSize, (uint8_t*)(&bhSize + 1));
+    }
+    result.insert(result.end(), body.begin(), body.end());
+    return result;
+}
+Bytes
+nestedfragtest::fragment(uint64_t ts, uint32_t sid, const Bytes& payload)
+{
+    EVB::FragmentHeader h = {ts, sid, uint32_t(payload.size()), 0};
+    Bytes result((uint8_t*)&h, (uint8_t*)(&h + 1));
+    result.insert(result.end(), payload.begin(), payload.end());
+    return result;
+}
+// Built body: byte count then the fragments.
+
+Bytes
+nestedfragtest::built(const std::vector<Bytes>& fragments)
+{
+    Bytes result(sizeof(uint32_t));
+    for (auto& f : fragments) {
+        result.insert(result.end(), f.begin(), f.end());
+    }
+    uint32_t n = result.size();
+    memcpy(result.data(), &n, sizeof(n));
+    return result;
+}
+Bytes
+nestedfragtest::leaf(uint32_t value)
+{
+    return item(PHYSICS_EVENT, Bytes((uint8_t*)&value, (uint8_t*)(&value + 1)));
+}
+// Top level: a first stage built event from sources 1-3 then a
+// leaf from source 4:
+
+Bytes
+nestedfragtest::twoLevels()
+{
+    std::vector<Bytes> inner;
+    for (int i = 1; i <= 3; i++) {
+        inner.push_back(fragment(100 + i, i, leaf(i)));
+    }
+    std::vector<Bytes> outer;
+    outer.push_back(fragment(100, 10, item(PHYSICS_EVENT, built(inner))));
+    outer.push_back(fragment(200, 4, leaf(4)));
+    return built(outer);
+}
+
+// One level looks like FragmentIndex:
+
+void nestedfragtest::flat_1()
+{
+    std::vector<Bytes> frags;
+    frags.push_back(fragment(1, 1, leaf(1)));
+    frags.push_back(fragment(2, 2, leaf(2)));
+    Bytes body = built(frags);
+
+    CNestedFragmentIndex idx;
+    idx.index(body.data());
+    EQ(size_t(2), idx.size());
+    for (size_t i = 0; i < 2; i++) {
+        EQ(uint32_t(0), idx[i].s_depth);
+        EQ(int32_t(-1), idx[i].s_parent);
+        EQ(uint32_t(0), idx[i].s_nDescendants);
+        EQ(uint64_t(i + 1), idx[i].s_timestamp);
+        EQ(uint32_t(i + 1), idx[i].s_sourceId);
+        EQ(uint32_t(i + 1), *reinterpret_cast<const uint32_t*>(idx[i].s_body));
+        EQ(uint32_t(sizeof(uint32_t)), idx[i].s_bodySize);
+    }
+}
+// Nested events are in depth first order:
+
+void nestedfragtest::nested_1()
+{
+    Bytes body = twoLevels();
+    CNestedFragmentIndex idx;
+    idx.index(body.data());
+    EQ(size_t(5), idx.size());
+
+    uint32_t depths[5]  = {0, 1, 1, 1, 0};
+    int32_t  parents[5] = {-1, 0, 0, 0, -1};
+    uint32_t sids[5]    = {10, 1, 2, 3, 4};
+    for (size_t i = 0; i < 5; i++) {
+        EQ(depths[i], idx[i].s_depth);
+        EQ(parents[i], idx[i].s_parent);
+        EQ(sids[i], idx[i].s_sourceId);
+    }
+    EQ(uint32_t(3), idx[0].s_nDescendants);
+    EQ(size_t(4), idx.nextSibling(0));
+    EQ(size_t(2), idx.nextSibling(1));
+    EQ(size_t(5), idx.nextSibling(4));
+    EQ(uint32_t(3), *reinterpret_cast<const uint32_t*>(idx[3].s_body));
+}
+// The table is reused:
+
+void nestedfragtest::nested_2()
+{
+    Bytes body = twoLevels();
+    CNestedFragmentIndex idx;
+    idx.index(body.data());
+    idx.index(body.data());
+    EQ(size_t(5), idx.size());
+    EQ(ptrdiff_t(5), idx.end() - idx.begin());
+}
+// The depth limit stops the descent:
+
+void nestedfragtest::depth_1()
+{
+    Bytes body = twoLevels();
+    CNestedFragmentIndex idx(FormatSelector::v12, 1);
+    idx.index(body.data());
+    EQ(size_t(2), idx.size());
+    EQ(uint32_t(0), idx[0].s_nDescendants);
+    EQ(uint32_t(4), idx[1].s_sourceId);
+}
+// Body headers are skipped:
+
+void nestedfragtest::body_1()
+{
+    uint32_t value = 0xdeadbeef;
+    std::vector<Bytes> frags;
+    frags.push_back(fragment(
+        1, 1, item(PHYSICS_EVENT, Bytes((uint8_t*)&value, (uint8_t*)(&value+1)), true)
+    ));
+    Bytes body = built(frags);
+    CNestedFragmentIndex idx;
+    idx.index(body.data());
+    EQ(size_t(1), idx.size());
+    EQ(value, *reinterpret_cast<const uint32_t*>(idx[0].s_body));
+    EQ(uint32_t(sizeof(uint32_t)), idx[0].s_bodySize);
+    EQ(
+        (const uint8_t*)idx[0].s_payload + sizeof(RingItemHeader) + sizeof(BodyHeader),
+        (const uint8_t*)idx[0].s_body
+    );
+}
+// v10 items have no body header word:
+
+void nestedfragtest::body_2()
+{
+    uint32_t v10item[3] = {3*sizeof(uint32_t), PHYSICS_EVENT, 42};
+    std::vector<Bytes> frags;
+    frags.push_back(fragment(1, 1, Bytes((uint8_t*)v10item, (uint8_t*)(v10item + 3))));
+    Bytes body = built(frags);
+    CNestedFragmentIndex idx(FormatSelector::v10);
+    idx.index(body.data());
+    EQ(uint32_t(42), *reinterpret_cast<const uint32_t*>(idx[0].s_body));
+    EQ(uint32_t(sizeof(uint32_t)), idx[0].s_bodySize);
+}
+// A payload whose body only looks like it's built is a leaf:
+
+void nestedfragtest::notbuilt_1()
+{
+    uint32_t fake[3] = {3*sizeof(uint32_t), 0x100, 0x200};   // Not a fragment.
+    std::vector<Bytes> frags;
+    frags.push_back(fragment(
+        1, 1, item(PHYSICS_EVENT, Bytes((uint8_t*)fake, (uint8_t*)(fake + 3)))
+    ));
+    frags.push_back(fragment(2, 2, leaf(2)));
+    Bytes body = built(frags);
+    CNestedFragmentIndex idx;
+    idx.index(body.data());
+    EQ(size_t(2), idx.size());
+    EQ(uint32_t(0), idx[0].s_nDescendants);
+    EQ(uint32_t(0), idx[1].s_depth);
+}
+// Top level fragments that don't fit are an error:
+
+void nestedfragtest::bad_1()
+{
+    Bytes body = twoLevels();
+    CNestedFragmentIndex idx;
+    CPPUNIT_ASSERT_THROW(
+        idx.indexFragments(body.data() + sizeof(uint32_t), body.size() - 6),
+        std::runtime_error
+    );
+}
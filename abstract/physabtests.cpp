@@ -22,8 +22,13 @@
 #include <cppunit/Asserter.h>
 #include "Asserts.h"
 #include "CPhysicsEventItem.h"
+#include "FragmentIndex.h"
+#include "fragment.h"
+#include "DataFormat.h"
 #include <stdexcept>
 #include <string>
+#include <vector>
+#include <string.h>
 
 using namespace ufmt;
 
@@ -32,6 +37,11 @@ class phyabtest : public CppUnit::TestFixture {
     CPPUNIT_TEST(name);
     CPPUNIT_TEST(getBodyHeader);
     CPPUNIT_TEST(setBodyHeader);
+    CPPUNIT_TEST(fragiter_1);
+    CPPUNIT_TEST(fragiter_2);
+    CPPUNIT_TEST(fragiter_3);
+    CPPUNIT_TEST(fragiter_4);
+    CPPUNIT_TEST(fragiter_5);
     CPPUNIT_TEST_SUITE_END();
     
 private:
@@ -47,6 +57,14 @@ protected:
     void name();
     void getBodyHeader();
     void setBodyHeader();
+    void fragiter_1();
+    void fragiter_2();
+    void fragiter_3();
+    void fragiter_4();
+    void fragiter_5();
+private:
+    std::vector<uint8_t> makeFragments(int n);
+    void makeBuiltEvent(int n);
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(phyabtest);
@@ -66,4 +84,105 @@ void phyabtest::setBodyHeader()
         m_pItem->setBodyHeader(12345, 0, 0),
         std::logic_error
     );
-}
\ No newline at end of file
+}
+// Make n flat fragments, each holding a small ring item:
+
+std::vector<uint8_t>
+phyabtest::makeFragments(int n)
+{
+    std::vector<uint8_t> result;
+    for (int i = 0; i < n; i++) {
+        EVB::FragmentHeader fh;
+        uint32_t payload[4] = {sizeof(payload), PHYSICS_EVENT, 0, uint32_t(i)};
+        fh.s_timestamp = 100 + i;
+        fh.s_sourceId  = i;
+        fh.s_size      = sizeof(payload);
+        fh.s_barrier   = (i == 0) ? BARRIER_START : BARRIER_NOTBARRIER;
+        const uint8_t* p = reinterpret_cast<const uint8_t*>(&fh);
+        result.insert(result.end(), p, p + sizeof(fh));
+        p = reinterpret_cast<const uint8_t*>(payload);
+        result.insert(result.end(), p, p + sizeof(payload));
+    }
+    return result;
+}
+// Put a built body in the item:
+
+void
+phyabtest::makeBuiltEvent(int n)
+{
+    auto frags = makeFragments(n);
+    uint8_t* p = reinterpret_cast<uint8_t*>(m_pItem->getBodyCursor());
+    uint32_t nBytes = frags.size() + sizeof(uint32_t);
+    memcpy(p, &nBytes, sizeof(uint32_t));
+    memcpy(p + sizeof(uint32_t), frags.data(), frags.size());
+    m_pItem->setBodyCursor(p + nBytes);
+    m_pItem->updateSize();
+}
+// The fragment range sees what getFragments sees:
+
+void phyabtest::fragiter_1()
+{
+    makeBuiltEvent(3);
+    auto frags = m_pItem->getFragments();
+    EQ(size_t(3), frags.size());
+    
+    size_t i = 0;
+    for (auto& f : m_pItem->fragments()) {
+        ASSERT(i < frags.size());
+        EQ(frags[i].s_timestamp, f.s_timestamp);
+        EQ(frags[i].s_sourceId, f.s_sourceId);
+        EQ(frags[i].s_size, f.s_size);
+        EQ(frags[i].s_barrier, f.s_barrier);
+        EQ(frags[i].s_itemhdr, f.s_itemhdr);
+        EQ(frags[i].s_itembody, f.s_itembody);
+        EQ(uint64_t(100 + i), f.s_timestamp);
+        EQ(uint32_t(i), reinterpret_cast<const uint32_t*>(f.s_itembody)[1]);
+        i++;
+    }
+    EQ(size_t(3), i);
+}
+// Ranges can be over raw fragments too:
+
+void phyabtest::fragiter_2()
+{
+    auto frags = makeFragments(4);
+    FragmentRange range(frags.data(), frags.size());
+    ASSERT(!range.empty());
+    EQ(std::ptrdiff_t(4), std::distance(range.begin(), range.end()));
+    
+    auto p = range.begin();
+    EQ(uint32_t(BARRIER_START), p->s_barrier);
+    auto prior = p++;
+    EQ(uint32_t(0), prior->s_sourceId);
+    EQ(uint32_t(1), p->s_sourceId);
+    EQ(uint32_t(BARRIER_NOTBARRIER), p->s_barrier);
+}
+// A fragment that runs past the end of the data throws:
+
+void phyabtest::fragiter_3()
+{
+    auto frags = makeFragments(2);
+    FragmentRange range(frags.data(), frags.size() - 2);
+    auto p = range.begin();
+    CPPUNIT_ASSERT_THROW(++p, std::runtime_error);
+    
+    FragmentRange tiny(frags.data(), sizeof(EVB::FragmentHeader) - 2);
+    CPPUNIT_ASSERT_THROW(tiny.begin(), std::runtime_error);
+}
+// A built body with no fragments:
+
+void phyabtest::fragiter_4()
+{
+    makeBuiltEvent(0);
+    FragmentRange range(m_pItem->fragments());
+    ASSERT(range.empty());
+    ASSERT(range.begin() == range.end());
+}
+// A byte count too small to count itself is an empty range:
+
+void phyabtest::fragiter_5()
+{
+    uint16_t body[2] = {2, 0};
+    FragmentRange range(body);
+    ASSERT(range.empty());
+}
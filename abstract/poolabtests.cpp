@@ -0,0 +1,282 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  poolabtests.cpp
+ *  @brief: Test the ring item recycling allocator.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingItemPool.h"
+#include "CRingItem.h"
+#include "DataFormat.h"
+#include <thread>
+#include <string.h>
+
+using namespace ufmt;
+
+// CRingItem is abstract so:
+
+class CPoolTestItem : public CRingItem {
+public:
+    CPoolTestItem(uint16_t type, size_t maxBody = CRingItemStaticBufferSize -100) :
+        CRingItem(type, maxBody) {}
+    virtual void* getBodyHeader() const {return nullptr;}
+    virtual void setBodyHeader(uint64_t timestamp, uint32_t sourceId,
+                         uint32_t barrierType = 0) {}
+};
+
+class poolabtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(poolabtest);
+    CPPUNIT_TEST(sizeclass_1);
+    CPPUNIT_TEST(sizeclass_2);
+    CPPUNIT_TEST(alloc_1);
+    CPPUNIT_TEST(alloc_2);
+    CPPUNIT_TEST(alloc_3);
+    CPPUNIT_TEST(stats_1);
+    CPPUNIT_TEST(shared_1);
+    CPPUNIT_TEST(shared_2);
+    CPPUNIT_TEST(thread_1);
+    CPPUNIT_TEST(scope_1);
+    CPPUNIT_TEST(item_1);
+    CPPUNIT_TEST(item_2);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+
+    }
+    void tearDown() {
+
+    }
+protected:
+    void sizeclass_1();
+    void sizeclass_2();
+    void alloc_1();
+    void alloc_2();
+    void alloc_3();
+    void stats_1();
+    void shared_1();
+    void shared_2();
+    void thread_1();
+    void scope_1();
+    void item_1();
+    void item_2();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(poolabtest);
+
+// Some specific size classes:
+
+void poolabtest::sizeclass_1()
+{
+    EQ(unsigned(0), CRingItemPool::sizeClass(1));
+    EQ(unsigned(0), CRingItemPool::sizeClass(CRingItemPool::MIN_BLOCK));
+    EQ(unsigned(1), CRingItemPool::sizeClass(65));
+    EQ(size_t(80), CRingItemPool::classSize(1));
+    EQ(unsigned(4), CRingItemPool::sizeClass(128));
+    EQ(unsigned(5), CRingItemPool::sizeClass(129));
+    EQ(size_t(160), CRingItemPool::classSize(5));
+    EQ(
+        CRingItemPool::NUM_CLASSES - 1,
+        CRingItemPool::sizeClass(CRingItemPool::MAX_POOLED)
+    );
+    EQ(
+        CRingItemPool::MAX_POOLED,
+        CRingItemPool::classSize(CRingItemPool::NUM_CLASSES -1)
+    );
+}
+// Each size maps to the smallest class that holds it:
+
+void poolabtest::sizeclass_2()
+{
+    for (size_t n = 1; n < 70000; n++) {
+        unsigned c = CRingItemPool::sizeClass(n);
+        ASSERT(CRingItemPool::classSize(c) >= n);
+        if (c > 0) {
+            ASSERT(CRingItemPool::classSize(c-1) < n);
+        }
+    }
+}
+// With no pool, memory comes from the system and can be released:
+
+void poolabtest::alloc_1()
+{
+    void* p = CRingItemPool::allocate(nullptr, 100);
+    ASSERT(p);
+    memset(p, 0xff, 100);
+    CRingItemPool::release(p);
+    CRingItemPool::release(nullptr);       // no-op.
+}
+// A freed block is reused by the next allocation of its class:
+
+void poolabtest::alloc_2()
+{
+    CRingItemPool pool;
+    void* p1 = CRingItemPool::allocate(&pool, 100);
+    auto stats = pool.getStatistics();
+    EQ(uint64_t(1), stats.s_misses);
+    EQ(uint64_t(0), stats.s_hits);
+
+    CRingItemPool::release(p1);
+    void* p2 = CRingItemPool::allocate(&pool, 110);   // Same class.
+    EQ(p1, p2);
+    stats = pool.getStatistics();
+    EQ(uint64_t(1), stats.s_misses);
+    EQ(uint64_t(1), stats.s_hits);
+    EQ(uint64_t(1), stats.s_threadCacheHits);
+    EQ(uint64_t(1), stats.s_frees);
+
+    CRingItemPool::release(p2);
+}
+// Too big to pool comes from the system:
+
+void poolabtest::alloc_3()
+{
+    CRingItemPool pool;
+    void* p = CRingItemPool::allocate(&pool, CRingItemPool::MAX_POOLED);
+    CRingItemPool::release(p);
+    auto stats = pool.getStatistics();
+    EQ(uint64_t(1), stats.s_oversized);
+    EQ(uint64_t(0), stats.s_misses);
+    EQ(uint64_t(0), stats.s_frees);
+}
+// clearStatistics zeroes the counters.
+
+void poolabtest::stats_1()
+{
+    CRingItemPool pool;
+    CRingItemPool::release(CRingItemPool::allocate(&pool, 100));
+    CRingItemPool::release(CRingItemPool::allocate(&pool, 100));
+    pool.clearStatistics();
+    auto stats = pool.getStatistics();
+    EQ(uint64_t(0), stats.s_hits);
+    EQ(uint64_t(0), stats.s_misses);
+    EQ(uint64_t(0), stats.s_frees);
+}
+// With no thread cache, blocks go to the shared list and trim
+// gives them back.
+
+void poolabtest::shared_1()
+{
+    CRingItemPool pool(0);
+    void* p1 = CRingItemPool::allocate(&pool, 100);
+    void* p2 = CRingItemPool::allocate(&pool, 1000);
+    CRingItemPool::release(p1);
+    CRingItemPool::release(p2);
+
+    auto stats = pool.getStatistics();
+    EQ(uint64_t(2), stats.s_sharedBlocks);
+    EQ(
+        uint64_t(
+            CRingItemPool::classSize(CRingItemPool::sizeClass(100 + 16)) +
+            CRingItemPool::classSize(CRingItemPool::sizeClass(1000 + 16))
+        ),
+        stats.s_sharedBytes
+    );
+    void* p3 = CRingItemPool::allocate(&pool, 100);
+    EQ(p1, p3);
+    EQ(uint64_t(1), pool.getStatistics().s_hits);
+    CRingItemPool::release(p3);
+
+    pool.trim();
+    EQ(uint64_t(0), pool.getStatistics().s_sharedBlocks);
+}
+// A full thread cache spills half its blocks to the shared list:
+
+void poolabtest::shared_2()
+{
+    CRingItemPool pool(4);
+    void* blocks[5];
+    for (int i = 0; i < 5; i++) {
+        blocks[i] = CRingItemPool::allocate(&pool, 100);
+    }
+    for (int i =0; i < 5; i++) {
+        CRingItemPool::release(blocks[i]);
+    }
+    EQ(uint64_t(2), pool.getStatistics().s_sharedBlocks);
+}
+// Blocks freed by another thread come back to the pool when that
+// thread exits.
+
+void poolabtest::thread_1()
+{
+    CRingItemPool pool;
+    void* p = CRingItemPool::allocate(&pool, 100);
+    std::thread t([p]() { CRingItemPool::release(p); });
+    t.join();
+
+    auto stats = pool.getStatistics();
+    EQ(uint64_t(1), stats.s_frees);
+    EQ(uint64_t(1), stats.s_sharedBlocks);
+
+    void* p2 = CRingItemPool::allocate(&pool, 100);
+    EQ(p, p2);
+    EQ(uint64_t(1), pool.getStatistics().s_hits);
+    CRingItemPool::release(p2);
+}
+// Scopes nest:
+
+void poolabtest::scope_1()
+{
+    CRingItemPool pool1;
+    CRingItemPool pool2;
+    ASSERT(CRingItemPool::current() == nullptr);
+    {
+        CRingItemPool::Scope s1(&pool1);
+        EQ(&pool1, CRingItemPool::current());
+        {
+            CRingItemPool::Scope s2(&pool2);
+            EQ(&pool2, CRingItemPool::current());
+        }
+        EQ(&pool1, CRingItemPool::current());
+    }
+    ASSERT(CRingItemPool::current() == nullptr);
+}
+// Items made while a pool is current recycle their object storage:
+
+void poolabtest::item_1()
+{
+    CRingItemPool pool;
+    CRingItemPool::Scope s(&pool);
+    CRingItem* p1 = new CPoolTestItem(PHYSICS_EVENT);
+    delete p1;
+    CRingItem* p2 = new CPoolTestItem(PHYSICS_EVENT);
+    EQ((void*)p1, (void*)p2);
+    delete p2;
+
+    auto stats = pool.getStatistics();
+    EQ(uint64_t(1), stats.s_misses);
+    EQ(uint64_t(1), stats.s_hits);
+}
+// ...and their dynamic storage:
+
+void poolabtest::item_2()
+{
+    CRingItemPool pool;
+    pRingItem pStorage;
+    {
+        CRingItemPool::Scope s(&pool);
+        CPoolTestItem item(PHYSICS_EVENT, CRingItemStaticBufferSize*2);
+        pStorage = item.getItemPointer();
+        EQ(uint64_t(1), pool.getStatistics().s_misses);
+    }
+    CRingItemPool::Scope s(&pool);
+    CPoolTestItem item(PHYSICS_EVENT, CRingItemStaticBufferSize*2);
+    EQ(pStorage, item.getItemPointer());
+    EQ(uint64_t(1), pool.getStatistics().s_hits);
+}
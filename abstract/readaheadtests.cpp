@@ -0,0 +1,259 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  readaheadtests.cpp
+ *  @brief: Test the read-ahead ring item block reader.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingReadAheadReader.h"
+#include "DataFormat.h"
+#include "TestItems.h"
+#include <stdexcept>
+#include <thread>
+#include <chrono>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+using namespace ufmt;
+using testitems::makeItem;
+
+class readaheadtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(readaheadtest);
+    CPPUNIT_TEST(construct_1);
+    CPPUNIT_TEST(construct_2);
+    CPPUNIT_TEST(empty_1);
+    CPPUNIT_TEST(read_1);
+    CPPUNIT_TEST(read_2);
+    CPPUNIT_TEST(read_3);
+    CPPUNIT_TEST(ahead_1);
+    CPPUNIT_TEST(bad_1);
+    CPPUNIT_TEST(pipe_1);
+    CPPUNIT_TEST(stop_1);
+    CPPUNIT_TEST(exchange_1);
+    CPPUNIT_TEST(exchange_2);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    int m_fd;
+public:
+    void setUp() {
+        m_fd = memfd_create("readaheadtest", 0);
+    }
+    void tearDown() {
+        close(m_fd);
+    }
+protected:
+    void construct_1();
+    void construct_2();
+    void empty_1();
+    void read_1();
+    void read_2();
+    void read_3();
+    void ahead_1();
+    void bad_1();
+    void pipe_1();
+    void stop_1();
+    void exchange_1();
+    void exchange_2();
+private:
+    std::vector<std::vector<uint8_t>> writeItems(int fd, int n, int maxBody);
+    void checkItems(
+        CRingBlockReader& r, const std::vector<std::vector<uint8_t>>& items
+    );
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(readaheadtest);
+
+// Write n items with varying body sizes and rewind; the items written
+// are returned.
+
+std::vector<std::vector<uint8_t>>
+readaheadtest::writeItems(int fd, int n, int maxBody)
+{
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < n; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, (i*7) % maxBody, i));
+        write(fd, items.back().data(), items.back().size());
+    }
+    lseek(fd, 0, SEEK_SET);
+    return items;
+}
+// Read all the items and be sure they're what was written:
+
+void
+readaheadtest::checkItems(
+    CRingBlockReader& r, const std::vector<std::vector<uint8_t>>& items
+)
+{
+    for (int i =0; i < items.size(); i++) {
+        const RingItem* p = r.nextItem();
+        ASSERT(p);
+        EQ(uint32_t(items[i].size()), p->s_header.s_size);
+        EQ(0, memcmp(items[i].data(), p, items[i].size()));
+    }
+    ASSERT(r.nextItem() == nullptr);
+    ASSERT(r.eof());
+}
+
+// Construction remembers the parameters:
+
+void readaheadtest::construct_1()
+{
+    CRingReadAheadReader r(m_fd, 1000, 2);
+    EQ(m_fd, r.getFd());
+    EQ(size_t(1000), r.getBlockSize());
+    EQ(size_t(1000), r.getBufferSize());
+    EQ(unsigned(2), r.getDepth());
+
+    CRingReadAheadReader d(m_fd);
+    EQ(CRingBlockReader::DEFAULT_BLOCK_SIZE, d.getBufferSize());
+    EQ(CRingReadAheadReader::DEFAULT_DEPTH, d.getDepth());
+}
+// Depth must be non-zero:
+
+void readaheadtest::construct_2()
+{
+    CPPUNIT_ASSERT_THROW(
+        CRingReadAheadReader r(m_fd, 1000, 0),
+        std::invalid_argument
+    );
+}
+// Empty file gives nullptr and eof.
+
+void readaheadtest::empty_1()
+{
+    CRingReadAheadReader r(m_fd);
+    ASSERT(r.nextItem() == nullptr);
+    ASSERT(r.eof());
+}
+// Items that fit in one buffer:
+
+void readaheadtest::read_1()
+{
+    auto items = writeItems(m_fd, 10, 40);
+    CRingReadAheadReader r(m_fd);
+    checkItems(r, items);
+}
+// Small buffers - items straddle buffers and the ring wraps many times:
+
+void readaheadtest::read_2()
+{
+    auto items = writeItems(m_fd, 500, 40);
+    CRingReadAheadReader r(m_fd, 32, 2);
+    checkItems(r, items);
+}
+// Item bigger than a buffer:
+
+void readaheadtest::read_3()
+{
+    std::vector<std::vector<uint8_t>> items;
+    items.push_back(makeItem(PHYSICS_EVENT, 8, 1));
+    items.push_back(makeItem(PHYSICS_EVENT, 1000, 2));
+    items.push_back(makeItem(PHYSICS_EVENT, 8, 3));
+    for (auto& item : items) {
+        write(m_fd, item.data(), item.size());
+    }
+    lseek(m_fd, 0, SEEK_SET);
+
+    CRingReadAheadReader r(m_fd, 64, 3);
+    checkItems(r, items);
+}
+// The reader thread fills all the buffers without the consumer asking:
+
+void readaheadtest::ahead_1()
+{
+    auto items = writeItems(m_fd, 100, 40);
+    CRingReadAheadReader r(m_fd, 64, 4);
+    for (int i = 0; i < 100 && (r.buffersReady() < 4); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EQ(size_t(4), r.buffersReady());
+    EQ(uint64_t(0), r.getStalls());
+    checkItems(r, items);
+}
+// Read errors are reported to the consumer:
+
+void readaheadtest::bad_1()
+{
+    CRingReadAheadReader r(-1, 100);
+    CPPUNIT_ASSERT_THROW(r.nextItem(), int);
+}
+// Live data through a pipe:
+
+void readaheadtest::pipe_1()
+{
+    int fds[2];
+    ASSERT(pipe(fds) == 0);
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 50; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, i, i));
+    }
+    std::thread writer([&items, fds]() {
+        for (auto& item : items) {
+            write(fds[1], item.data(), item.size());
+        }
+        close(fds[1]);
+    });
+    {
+        CRingReadAheadReader r(fds[0], 128, 2);
+        checkItems(r, items);
+    }
+    writer.join();
+    close(fds[0]);
+}
+// Destruction doesn't hang waiting on a source with no data:
+
+void readaheadtest::stop_1()
+{
+    int fds[2];
+    ASSERT(pipe(fds) == 0);
+    {
+        CRingReadAheadReader r(fds[0]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    close(fds[0]);
+    close(fds[1]);
+}
+// Filled buffers are handed over rather than copied:
+
+void readaheadtest::exchange_1()
+{
+    auto items = writeItems(m_fd, 2000, 100);
+    CRingReadAheadReader r(m_fd, 1024, 3);
+    checkItems(r, items);
+    ASSERT(r.getExchanges() > 0);
+}
+// Items bigger than the room for carried over data and than a buffer
+// still come out whole, and exchanges resume after them:
+
+void readaheadtest::exchange_2()
+{
+    std::vector<std::vector<uint8_t>> items;
+    for (int i = 0; i < 200; i++) {
+        items.push_back(makeItem(PHYSICS_EVENT, (i % 10) ? 10 + i : 5000, i));
+        write(m_fd, items.back().data(), items.back().size());
+    }
+    lseek(m_fd, 0, SEEK_SET);
+    CRingReadAheadReader r(m_fd, 256, 2);
+    checkItems(r, items);
+    ASSERT(r.getExchanges() > 0);
+}
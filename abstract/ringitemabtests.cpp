@@ -28,9 +28,11 @@
 #undef public
 #include "DataFormat.h"
 #include <stdint.h>
+#include <string.h>
 #include <vector>
 
 #include <sstream>
+#include <utility>
 
 using namespace ufmt;
 /** Since the CRingItem class is abstract we need a minimal concrete sublcass
@@ -43,6 +45,7 @@ public:
     CTestRingItem(uint16_t type, size_t maxBody = CRingItemStaticBufferSize -100) :
         CRingItem(type, maxBody) {}
     CTestRingItem(const CTestRingItem& rhs) : CRingItem(rhs) {}
+    CTestRingItem(CTestRingItem&& rhs) : CRingItem(std::move(rhs)) {}
     virtual void* getBodyHeader() const {return nullptr;}
     virtual void setBodyHeader(uint64_t timestamp, uint32_t sourceId,
                          uint32_t barrierType = 0) {}
@@ -56,6 +59,8 @@ class abringitemtest : public CppUnit::TestFixture {
     CPPUNIT_TEST(construct_2);
     CPPUNIT_TEST(construct_3);
     CPPUNIT_TEST(construct_4);
+    CPPUNIT_TEST(construct_5);
+    CPPUNIT_TEST(construct_6);
     
     // Selector tests:
     
@@ -101,6 +106,20 @@ class abringitemtest : public CppUnit::TestFixture {
     CPPUNIT_TEST(tostring);       // Some ambitious person can write this test.
     
     CPPUNIT_TEST(append_1);
+    
+    CPPUNIT_TEST(external_1);
+    CPPUNIT_TEST(external_2);
+    CPPUNIT_TEST(external_3);
+    CPPUNIT_TEST(external_4);
+    
+    CPPUNIT_TEST(refill_1);
+    CPPUNIT_TEST(refill_2);
+    CPPUNIT_TEST(refill_3);
+    
+    CPPUNIT_TEST(move_1);
+    CPPUNIT_TEST(move_2);
+    CPPUNIT_TEST(move_3);
+    CPPUNIT_TEST(move_4);
     CPPUNIT_TEST_SUITE_END();
     
 private:
@@ -118,6 +137,8 @@ protected:
     
     void construct_3();   // From type/size.
     void construct_4();   // Copy construction.
+    void construct_5();   // Raw items that fit stay in the static buffer.
+    void construct_6();   // Raw items that don't fit get slop.
     
     void getstoragesize_1();
     void getstoragesize_2();
@@ -160,6 +181,20 @@ protected:
     void tostring();      // Some ambitious person can actually write this.
     
     void append_1();
+    
+    void external_1();
+    void external_2();
+    void external_3();
+    void external_4();
+    
+    void refill_1();
+    void refill_2();
+    void refill_3();
+    
+    void move_1();       // Dynamic storage is taken.
+    void move_2();       // Static buffer is copied.
+    void move_3();       // External storage is shared.
+    void move_4();       // Move assignment.
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(abringitemtest);
@@ -265,6 +300,35 @@ void abringitemtest::construct_4()
 
 //  default storage:
 
+// A raw item that fits in the static buffer stays there even if the
+// slop would not fit:
+
+void abringitemtest::construct_5()
+{
+    std::vector<uint8_t> raw(CRingItemStaticBufferSize - 10, 0);
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw.data());
+    pRaw->s_header.s_size = raw.size();
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    
+    CTestRingItem item(pRaw);
+    ASSERT(item.m_pItem == pRingItem(&item.m_staticBuffer[0]));
+    EQ(raw.size(), item.getStorageSize());
+    EQ(uint32_t(raw.size()), item.size());
+}
+// Raw items that don't fit are given the slop in dynamic storage:
+
+void abringitemtest::construct_6()
+{
+    std::vector<uint8_t> raw(CRingItemStaticBufferSize + 10, 0);
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw.data());
+    pRaw->s_header.s_size = raw.size();
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    
+    CTestRingItem item(pRaw);
+    ASSERT(item.m_pItem != pRingItem(&item.m_staticBuffer[0]));
+    EQ(raw.size() + CRingItemFromRawSlop, item.getStorageSize());
+    EQ(0, memcmp(raw.data(), item.getItemPointer(), raw.size()));
+}
 void abringitemtest::getstoragesize_1()
 {
     CTestRingItem item(PHYSICS_EVENT);
@@ -551,4 +615,229 @@ void abringitemtest::append_1()
         EQ(data[i], *p);
         p++;
     }
-}
\ No newline at end of file
+}
+// Using external storage points the item at the raw item - no copy.
+
+void abringitemtest::external_1()
+{
+    uint8_t raw[sizeof(RingItemHeader) + 100];
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw);
+    pRaw->s_header.s_size = sizeof(raw);
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    for (int i =0; i < 100; i++) {
+        raw[sizeof(RingItemHeader) + i] = i;
+    }
+    
+    CTestRingItem item(PHYSICS_EVENT, 20000);     // Dynamic storage.
+    item.useExternalStorage(pRaw);
+    const CTestRingItem& citem(item);            // Reads don't copy.
+    ASSERT(item.isExternalStorage());
+    EQ((const RingItem*)(pRaw), citem.getItemPointer());
+    EQ(uint32_t(sizeof(raw)), item.size());
+    EQ(size_t(100), item.getBodySize());
+    EQ(sizeof(raw), item.getStorageSize());
+    EQ((const void*)(raw + sizeof(RingItemHeader)), citem.getBodyPointer());
+    ASSERT(item.isExternalStorage());
+}
+// Copying an item with external storage makes an item with its own storage.
+
+void abringitemtest::external_2()
+{
+    uint8_t raw[sizeof(RingItemHeader) + 100];
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw);
+    pRaw->s_header.s_size = sizeof(raw);
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    for (int i =0; i < 100; i++) {
+        raw[sizeof(RingItemHeader) + i] = i;
+    }
+    CTestRingItem item(PHYSICS_EVENT);
+    item.useExternalStorage(pRaw);
+    
+    CTestRingItem copy(item);
+    ASSERT(!copy.isExternalStorage());
+    ASSERT(pRaw != copy.getItemPointer());
+    EQ(0, memcmp(raw, copy.getItemPointer(), sizeof(raw)));
+    EQ(size_t(100), copy.getBodySize());
+}
+// The first writable access copies the item out of external storage so
+// extending it leaves the external storage (and what follows) alone:
+
+void abringitemtest::external_3()
+{
+    uint8_t raw[2*(sizeof(RingItemHeader) + 8)];
+    memset(raw, 0xff, sizeof(raw));
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw);
+    pRaw->s_header.s_size = sizeof(RingItemHeader) + 8;
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    
+    CTestRingItem item(PHYSICS_EVENT);
+    item.useExternalStorage(pRaw);
+    uint32_t more[4] = {1, 2, 3, 4};
+    item.appendBodyData(more, sizeof(more));
+    
+    ASSERT(!item.isExternalStorage());
+    EQ(pRingItem(&item.m_staticBuffer[0]), item.getItemPointer());
+    EQ(uint32_t(sizeof(RingItemHeader) + 8 + sizeof(more)), item.size());
+    EQ(size_t(8 + sizeof(more)), item.getBodySize());
+    const uint8_t* pBody = static_cast<const uint8_t*>(item.getBodyPointer());
+    for (int i = 0; i < 8; i++) {
+        EQ(uint8_t(0xff), pBody[i]);
+    }
+    EQ(0, memcmp(pBody + 8, more, sizeof(more)));
+    
+    EQ(uint32_t(sizeof(RingItemHeader) + 8), pRaw->s_header.s_size);
+    for (size_t i = sizeof(RingItemHeader) + 8; i < sizeof(raw); i++) {
+        EQ(uint8_t(0xff), raw[i]);
+    }
+}
+// Big items are copied to dynamic storage with room to grow:
+
+void abringitemtest::external_4()
+{
+    std::vector<uint8_t> raw(CRingItemStaticBufferSize*2);
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw.data());
+    pRaw->s_header.s_size = raw.size();
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    
+    CTestRingItem item(PHYSICS_EVENT);
+    item.useExternalStorage(pRaw);
+    pRingItem p = item.getItemPointer();
+    ASSERT(!item.isExternalStorage());
+    ASSERT(p != pRaw);
+    ASSERT(p != pRingItem(&item.m_staticBuffer[0]));
+    EQ(0, memcmp(raw.data(), p, raw.size()));
+    EQ(size_t(raw.size() + CRingItemFromRawSlop), item.getStorageSize());
+    EQ((void*)(reinterpret_cast<uint8_t*>(p) + raw.size()), item.getBodyCursor());
+}
+// Refilling with an item that fits keeps the static buffer:
+
+void abringitemtest::refill_1()
+{
+    CTestRingItem item(PHYSICS_EVENT, 100);
+    pRingItem p = item.prepareForRefill(CRingItemStaticBufferSize);
+    EQ(pRingItem(&item.m_staticBuffer[0]), p);
+    EQ((void*)p, item.getBodyCursor());
+}
+// Refilling with a big item goes to dynamic storage which is then
+// reused for smaller items:
+
+void abringitemtest::refill_2()
+{
+    CTestRingItem item(PHYSICS_EVENT, 100);
+    pRingItem p = item.prepareForRefill(CRingItemStaticBufferSize*2);
+    ASSERT(p != pRingItem(&item.m_staticBuffer[0]));
+    EQ(p, item.getItemPointer());
+    
+    EQ(p, item.prepareForRefill(100));
+    EQ(p, item.prepareForRefill(CRingItemStaticBufferSize*2));
+    
+    // Fill it in and be sure the size and cursor work:
+    
+    p->s_header.s_size = sizeof(RingItemHeader) + 10;
+    p->s_header.s_type = BEGIN_RUN;
+    item.setBodyCursor(reinterpret_cast<uint8_t*>(p) + p->s_header.s_size);
+    item.updateSize();
+    EQ(BEGIN_RUN, item.type());
+    EQ(size_t(10), item.getBodySize());
+}
+// Refilling an item using external storage gives it its own storage:
+
+void abringitemtest::refill_3()
+{
+    uint8_t raw[sizeof(RingItemHeader) + 10];
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw);
+    pRaw->s_header.s_size = sizeof(raw);
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    
+    CTestRingItem item(PHYSICS_EVENT);
+    item.useExternalStorage(pRaw);
+    pRingItem p = item.prepareForRefill(sizeof(raw));
+    ASSERT(p != pRaw);
+    ASSERT(!item.isExternalStorage());
+    EQ(pRingItem(&item.m_staticBuffer[0]), p);
+}
+// Moving an item with dynamic storage takes the storage; the
+// source is left an empty item of the same type:
+
+void abringitemtest::move_1()
+{
+    CTestRingItem item(PHYSICS_EVENT, CRingItemStaticBufferSize*2);
+    uint32_t* p = static_cast<uint32_t*>(item.getBodyCursor());
+    for (int i =0; i < 10; i++) {
+        *p++ = i;
+    }
+    item.setBodyCursor(p);
+    item.updateSize();
+    pRingItem pStorage = item.getItemPointer();
+    
+    CTestRingItem moved(std::move(item));
+    EQ(pStorage, moved.getItemPointer());
+    EQ(PHYSICS_EVENT, moved.type());
+    EQ(size_t(10*sizeof(uint32_t)), moved.getBodySize());
+    EQ((void*)p, moved.getBodyCursor());
+    EQ(size_t(CRingItemStaticBufferSize*2), moved.getStorageSize());
+    
+    EQ(pRingItem(&item.m_staticBuffer[0]), item.getItemPointer());
+    EQ(PHYSICS_EVENT, item.type());
+    EQ(uint32_t(sizeof(RingItemHeader)), item.size());
+    EQ(size_t(0), item.getBodySize());
+}
+// An item in the static buffer has to be copied:
+
+void abringitemtest::move_2()
+{
+    CTestRingItem item(BEGIN_RUN, 100);
+    uint32_t* p = static_cast<uint32_t*>(item.getBodyCursor());
+    for (int i =0; i < 10; i++) {
+        *p++ = i;
+    }
+    item.setBodyCursor(p);
+    item.updateSize();
+    
+    CTestRingItem moved(std::move(item));
+    EQ(pRingItem(&moved.m_staticBuffer[0]), moved.getItemPointer());
+    EQ(BEGIN_RUN, moved.type());
+    EQ(size_t(10*sizeof(uint32_t)), moved.getBodySize());
+    const uint32_t* pBody = static_cast<const uint32_t*>(moved.getBodyPointer());
+    for (uint32_t i =0; i < 10; i++) {
+        EQ(i, pBody[i]);
+    }
+    EQ(uint32_t(sizeof(RingItemHeader)), item.size());
+}
+// External storage stays external:
+
+void abringitemtest::move_3()
+{
+    uint8_t raw[sizeof(RingItemHeader) + 100];
+    pRingItem pRaw = reinterpret_cast<pRingItem>(raw);
+    pRaw->s_header.s_size = sizeof(raw);
+    pRaw->s_header.s_type = PHYSICS_EVENT;
+    
+    CTestRingItem item(PHYSICS_EVENT);
+    item.useExternalStorage(pRaw);
+    CTestRingItem moved(std::move(item));
+    ASSERT(moved.isExternalStorage());
+    EQ((const RingItem*)(pRaw), static_cast<const CTestRingItem&>(moved).getItemPointer());
+    EQ(size_t(100), moved.getBodySize());
+    
+    ASSERT(!item.isExternalStorage());
+    EQ(uint32_t(sizeof(RingItemHeader)), item.size());
+    EQ(uint32_t(sizeof(raw)), pRaw->s_header.s_size);  // Untouched.
+}
+// Move assignment releases the old storage and takes the new:
+
+void abringitemtest::move_4()
+{
+    CTestRingItem item(PHYSICS_EVENT, CRingItemStaticBufferSize*2);
+    CTestRingItem target(BEGIN_RUN, CRingItemStaticBufferSize*3);
+    pRingItem pStorage = item.getItemPointer();
+    
+    CRingItem& base(target);
+    base = std::move(item);
+    EQ(pStorage, target.getItemPointer());
+    EQ(PHYSICS_EVENT, target.type());
+    EQ(size_t(0), target.getBodySize());
+    
+    base = std::move(target);              // Self move does nothing.
+    EQ(pStorage, target.getItemPointer());
+}
@@ -0,0 +1,338 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  scannerabtests.cpp
+ *  @brief: Test the header only ring item scanner.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingHeaderScanner.h"
+#include "CRingHeaderColumns.h"
+#include "CRingItemFilter.h"
+#include "DataFormat.h"
+#include "TestItems.h"
+#include "fragment.h"
+#include <stdexcept>
+#include <vector>
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/mman.h>
+
+using namespace ufmt;
+
+using testitems::Bytes;
+using testitems::makeV12Item;
+using testitems::writeItems;
+
+class scannertest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(scannertest);
+    CPPUNIT_TEST(construct_1);
+    CPPUNIT_TEST(empty_1);
+    CPPUNIT_TEST(scan_1);
+    CPPUNIT_TEST(scan_2);
+    CPPUNIT_TEST(scan_3);
+    CPPUNIT_TEST(skip_1);
+    CPPUNIT_TEST(offset_1);
+    CPPUNIT_TEST(pipe_1);
+    CPPUNIT_TEST(truncated_1);
+    CPPUNIT_TEST(bad_1);
+    CPPUNIT_TEST(columns_1);
+    CPPUNIT_TEST(filter_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    int m_fd;
+public:
+    void setUp() {
+        m_fd = memfd_create("scannertest", 0);
+    }
+    void tearDown() {
+        close(m_fd);
+    }
+protected:
+    void construct_1();
+    void empty_1();
+    void scan_1();
+    void scan_2();
+    void scan_3();
+    void skip_1();
+    void offset_1();
+    void pipe_1();
+    void truncated_1();
+    void bad_1();
+    void columns_1();
+    void filter_1();
+private:
+    void rewind() { testitems::rewind(m_fd); }
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(scannertest);
+
+// The buffer must hold a header and body header:
+
+void scannertest::construct_1()
+{
+    CPPUNIT_ASSERT_THROW(
+        CRingHeaderScanner s(m_fd, FormatSelector::v12, CRingHeaderScanner::HEADER_SIZE - 1),
+        std::invalid_argument
+    );
+    CRingHeaderScanner s(m_fd);
+    ASSERT(s.isSeekable());
+    EQ(FormatSelector::v12, s.getVersion());
+}
+// Nothing to scan:
+
+void scannertest::empty_1()
+{
+    CRingHeaderScanner s(m_fd);
+    CRingItemView item;
+    ASSERT(!s.next(item));
+    EQ(uint64_t(0), s.getItemCount());
+}
+// Small items with and without body headers:
+
+void scannertest::scan_1()
+{
+    std::vector<Bytes> items;
+    for (int i = 0; i < 20; i++) {
+        items.push_back(makeV12Item(i % 2 ? PHYSICS_EVENT : PERIODIC_SCALERS, i, i % 2, i));
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingHeaderScanner s(m_fd);
+    CRingItemView item;
+    uint64_t offset = 0;
+    for (int i = 0; i < items.size(); i++) {
+        ASSERT(s.next(item));
+        EQ(offset, s.getItemOffset());
+        EQ(uint32_t(items[i].size()), item.size());
+        EQ(uint32_t(i % 2 ? PHYSICS_EVENT : PERIODIC_SCALERS), item.type());
+        EQ(bool(i % 2), item.hasBodyHeader());
+        if (i % 2) {
+            EQ(uint64_t(100*i), item.getEventTimestamp());
+            EQ(uint32_t(i), item.getSourceId());
+        }
+        offset += items[i].size();
+    }
+    ASSERT(!s.next(item));
+    EQ(uint64_t(items.size()), s.getItemCount());
+    EQ(offset, s.getOffset());
+}
+// Headers straddling the buffer end are carried over:
+
+void scannertest::scan_2()
+{
+    std::vector<Bytes> items;
+    for (int i = 0; i < 50; i++) {
+        items.push_back(makeV12Item(PHYSICS_EVENT, (i*7) % 40, true, i));
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingHeaderScanner s(m_fd, FormatSelector::v12, CRingHeaderScanner::HEADER_SIZE + 3);
+    CRingItemView item;
+    for (int i = 0; i < items.size(); i++) {
+        ASSERT(s.next(item));
+        EQ(uint32_t(items[i].size()), item.size());
+        EQ(uint32_t(i), item.getSourceId());
+    }
+    ASSERT(!s.next(item));
+}
+// Items smaller than a body header don't pick one up from the next item:
+
+void scannertest::scan_3()
+{
+    std::vector<Bytes> items;
+    Bytes tiny(sizeof(RingItemHeader));
+    RingItemHeader* pH = reinterpret_cast<RingItemHeader*>(tiny.data());
+    pH->s_size = tiny.size();
+    pH->s_type = PHYSICS_EVENT;
+    items.push_back(tiny);
+    items.push_back(makeV12Item(PHYSICS_EVENT, 10, true, 3));
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingHeaderScanner s(m_fd);
+    CRingItemView item;
+    ASSERT(s.next(item));
+    EQ(uint32_t(sizeof(RingItemHeader)), item.size());
+    ASSERT(!item.hasBodyHeader());
+    ASSERT(s.next(item));
+    EQ(uint32_t(3), item.getSourceId());
+}
+// Big bodies aren't read:
+
+void scannertest::skip_1()
+{
+    std::vector<Bytes> items;
+    uint64_t total = 0;
+    for (int i = 0; i < 20; i++) {
+        items.push_back(makeV12Item(PHYSICS_EVENT, 1024*1024, true, i));
+        total += items.back().size();
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingHeaderScanner s(m_fd);
+    CRingItemView item;
+    for (int i = 0; i < items.size(); i++) {
+        ASSERT(s.next(item));
+        EQ(uint32_t(i), item.getSourceId());
+    }
+    ASSERT(!s.next(item));
+    ASSERT(s.getBytesRead() * 10 < total);
+}
+// Scanning starts at the file offset, which isn't changed:
+
+void scannertest::offset_1()
+{
+    std::vector<Bytes> items;
+    for (int i = 0; i < 5; i++) {
+        items.push_back(makeV12Item(PHYSICS_EVENT, 100, true, i));
+    }
+    writeItems(m_fd, items);
+    off_t start = items[0].size() + items[1].size();
+    lseek(m_fd, start, SEEK_SET);
+
+    CRingHeaderScanner s(m_fd);
+    CRingItemView item;
+    ASSERT(s.next(item));
+    EQ(uint64_t(start), s.getItemOffset());
+    EQ(uint32_t(2), item.getSourceId());
+    while (s.next(item))
+        ;
+    EQ(uint64_t(5), s.getItemCount() + 2);
+    EQ(start, lseek(m_fd, 0, SEEK_CUR));
+}
+// Pipes are read sequentially:
+
+void scannertest::pipe_1()
+{
+    int fds[2];
+    ASSERT(pipe(fds) == 0);
+    std::vector<Bytes> items;
+    for (int i = 0; i < 10; i++) {
+        items.push_back(makeV12Item(PHYSICS_EVENT, 1000*i, true, i));
+    }
+    writeItems(m_fd, items);
+    rewind();
+    // The data fit in the pipe buffer so write it all before reading.
+
+    Bytes data(lseek(m_fd, 0, SEEK_END));
+    pread(m_fd, data.data(), data.size(), 0);
+    write(fds[1], data.data(), data.size());
+    close(fds[1]);
+
+    CRingHeaderScanner s(fds[0], FormatSelector::v12, 1024);
+    ASSERT(!s.isSeekable());
+    CRingItemView item;
+    for (int i = 0; i < items.size(); i++) {
+        ASSERT(s.next(item));
+        EQ(uint32_t(i), item.getSourceId());
+        EQ(uint32_t(items[i].size()), item.size());
+    }
+    ASSERT(!s.next(item));
+    EQ(uint64_t(data.size()), s.getBytesRead());
+    close(fds[0]);
+}
+// A partial header at the end looks like the end of the data:
+
+void scannertest::truncated_1()
+{
+    std::vector<Bytes> items;
+    items.push_back(makeV12Item(PHYSICS_EVENT, 10, true, 1));
+    items.push_back(makeV12Item(PHYSICS_EVENT, 10, true, 2));
+    items.back().resize(sizeof(RingItemHeader) + 4);
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingHeaderScanner s(m_fd);
+    CRingItemView item;
+    ASSERT(s.next(item));
+    ASSERT(!s.next(item));
+}
+// An impossible size can't be followed:
+
+void scannertest::bad_1()
+{
+    uint32_t bad[2] = {4, PHYSICS_EVENT};
+    write(m_fd, bad, sizeof(bad));
+    rewind();
+
+    CRingHeaderScanner s(m_fd);
+    CRingItemView item;
+    CPPUNIT_ASSERT_THROW(s.next(item), std::runtime_error);
+}
+// Scanning into columns, a few items at a time:
+
+void scannertest::columns_1()
+{
+    std::vector<Bytes> items;
+    for (int i = 0; i < 25; i++) {
+        items.push_back(makeV12Item(PHYSICS_EVENT, 100*i, i % 3, i));
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingHeaderScanner s(m_fd);
+    CRingHeaderColumns columns;
+    EQ(size_t(10), s.scan(columns, 10));
+    EQ(size_t(10), s.scan(columns, 10));
+    EQ(size_t(5), s.scan(columns, 10));
+    EQ(size_t(0), s.scan(columns, 10));
+    EQ(items.size(), columns.size());
+    uint64_t offset = 0;
+    for (int i = 0; i < items.size(); i++) {
+        EQ(offset, columns.getOffsets()[i]);
+        EQ(uint32_t(items[i].size()), columns.getSizes()[i]);
+        EQ(uint8_t(i % 3 != 0), columns.getBodyHeaders()[i]);
+        EQ(uint32_t((i % 3) ? i : 0), columns.getSourceIds()[i]);
+        offset += items[i].size();
+    }
+}
+// A filter steps over the items it rejects, bodies unread:
+
+void scannertest::filter_1()
+{
+    std::vector<Bytes> items;
+    uint64_t total = 0;
+    for (int i = 0; i < 20; i++) {
+        items.push_back(makeV12Item(PHYSICS_EVENT, 64*1024, true, i % 4));
+        total += items.back().size();
+    }
+    writeItems(m_fd, items);
+    rewind();
+
+    CRingItemFilter f;
+    f.selectSourceIds(std::vector<uint32_t>(1, 2));
+    CRingHeaderScanner s(m_fd);
+    s.setFilter(&f);
+    CRingItemView item;
+    for (int i = 2; i < items.size(); i += 4) {
+        ASSERT(s.next(item));
+        EQ(uint32_t(2), item.getSourceId());
+        EQ(uint64_t(i*items[0].size()), s.getItemOffset());
+    }
+    ASSERT(!s.next(item));
+    EQ(uint64_t(5), s.getItemCount());
+    EQ(uint64_t(15), s.getFilteredCount());
+    EQ(total, s.getOffset());
+    ASSERT(s.getBytesRead() * 5 < total);
+}
@@ -0,0 +1,238 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  segmentabtests.cpp
+ *  @brief: Test the run segment index.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRunSegmentIndex.h"
+#include "DataFormat.h"
+#include "TestItems.h"
+#include <v12/DataFormat.h>
+#include <v12/RingViewDecoder.h>
+#include <stdexcept>
+#include <vector>
+#include <string>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace ufmt;
+
+class segmentabtest : public CppUnit::TestFixture, public testitems::RunFiles {
+    CPPUNIT_TEST_SUITE(segmentabtest);
+    CPPUNIT_TEST(build_1);
+    CPPUNIT_TEST(build_2);
+    CPPUNIT_TEST(build_3);
+    CPPUNIT_TEST(file_1);
+    CPPUNIT_TEST(file_2);
+    CPPUNIT_TEST_SUITE_END();
+
+public:
+    void setUp() {
+    }
+    void tearDown() {
+        clear();
+    }
+protected:
+    void build_1();
+    void build_2();
+    void build_3();
+    void file_1();
+    void file_2();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(segmentabtest);
+
+// Segments of paused and split runs:
+
+void segmentabtest::build_1()
+{
+    writeRuns();
+    CRunSegmentIndex index;
+    index.build(m_files, v12::RingViewDecoder());
+
+    auto& segments = index.getSegments();
+    EQ(size_t(3), segments.size());
+    EQ(unsigned(2), index.getSegmentCount(7));
+    EQ(unsigned(1), index.getSegmentCount(8));
+    EQ(unsigned(0), index.getSegmentCount(9));
+    std::vector<uint32_t> runs = index.getRuns();
+    EQ(size_t(2), runs.size());
+    EQ(uint32_t(7), runs[0]);
+    EQ(uint32_t(8), runs[1]);
+    ASSERT(index.getFiles() == m_files);
+
+    // Item sizes:
+
+    uint64_t fmt   = sizeof(RingItemHeader) + sizeof(uint32_t) + 8;
+    uint64_t state = sizeof(RingItemHeader) + sizeof(uint32_t) +
+        sizeof(v12::StateChangeItemBody);
+    auto physics = [](uint32_t n) {
+        return uint64_t(sizeof(RingItemHeader) + sizeof(uint32_t) + n);
+    };
+
+    const CRunSegmentIndex::Segment* p = index.find(7, 0);
+    ASSERT(p);
+    EQ(uint32_t(BEGIN_RUN), p->s_startType);
+    EQ(uint32_t(PAUSE_RUN), p->s_endType);
+    EQ(std::string("Run seven"), p->s_title);
+    EQ(0.0f, p->s_startTime);
+    EQ(10.0f, p->s_endTime);
+    EQ(time_t(1000), p->s_startClock);
+    EQ(time_t(1010), p->s_endClock);
+    EQ(size_t(1), p->s_extents.size());
+    EQ(uint32_t(0), p->s_extents[0].s_file);
+    EQ(fmt, p->s_extents[0].s_begin);
+    uint64_t pauseEnd = fmt + 2*state + physics(10) + physics(11) + physics(12);
+    EQ(pauseEnd, p->s_extents[0].s_end);
+
+    p = index.find(7, 1);
+    ASSERT(p);
+    EQ(uint32_t(1), p->s_segment);
+    EQ(uint32_t(RESUME_RUN), p->s_startType);
+    EQ(uint32_t(END_RUN), p->s_endType);
+    EQ(25.0f, p->s_endTime);
+    EQ(size_t(2), p->s_extents.size());
+    EQ(uint32_t(0), p->s_extents[0].s_file);
+    EQ(pauseEnd + physics(4), p->s_extents[0].s_begin);
+    EQ(pauseEnd + physics(4) + state + physics(20) + physics(21), p->s_extents[0].s_end);
+    EQ(uint32_t(1), p->s_extents[1].s_file);
+    EQ(uint64_t(0), p->s_extents[1].s_begin);
+    EQ(physics(22) + physics(23) + state, p->s_extents[1].s_end);
+
+    p = index.find(8, 0);
+    ASSERT(p);
+    EQ(std::string("Run eight"), p->s_title);
+    EQ(size_t(1), p->s_extents.size());
+    EQ(uint32_t(1), p->s_extents[0].s_file);
+    EQ(physics(22) + physics(23) + state, p->s_extents[0].s_begin);
+    EQ(here(), p->s_extents[0].s_end);
+
+    ASSERT(index.find(8, 1) == nullptr);
+    ASSERT(index.find(9, 0) == nullptr);
+}
+// A segment whose start isn't in the file and one cut short by the
+// end of the data:
+
+void segmentabtest::build_2()
+{
+    newFile();
+    writeItem(PHYSICS_EVENT, 10);
+    writeStateChange(END_RUN, 3, 100, 500, "Run three");
+    uint64_t end3 = here();
+    writeStateChange(BEGIN_RUN, 4, 0, 600, "Run four");
+    writeItem(PHYSICS_EVENT, 10);
+
+    CRunSegmentIndex index;
+    index.build(m_files[0], v12::RingViewDecoder());
+    EQ(size_t(2), index.getSegments().size());
+
+    const CRunSegmentIndex::Segment* p = index.find(3, 0);
+    ASSERT(p);
+    EQ(uint32_t(0), p->s_startType);
+    EQ(uint32_t(END_RUN), p->s_endType);
+    EQ(std::string("Run three"), p->s_title);
+    EQ(uint64_t(0), p->s_extents[0].s_begin);
+    EQ(end3, p->s_extents[0].s_end);
+
+    p = index.find(4, 0);
+    ASSERT(p);
+    EQ(uint32_t(BEGIN_RUN), p->s_startType);
+    EQ(uint32_t(0), p->s_endType);
+    EQ(end3, p->s_extents[0].s_begin);
+    EQ(here(), p->s_extents[0].s_end);
+}
+// A begin run with no end run is cut short by the next begin run:
+
+void segmentabtest::build_3()
+{
+    newFile();
+    writeStateChange(BEGIN_RUN, 1, 0, 0, "One");
+    writeItem(PHYSICS_EVENT, 10);
+    uint64_t begin2 = here();
+    writeStateChange(BEGIN_RUN, 2, 0, 0, "Two");
+    writeStateChange(END_RUN, 2, 0, 0, "Two");
+
+    CRunSegmentIndex index;
+    index.build(m_files[0], v12::RingViewDecoder());
+    EQ(size_t(2), index.getSegments().size());
+    const CRunSegmentIndex::Segment* p = index.find(1, 0);
+    ASSERT(p);
+    EQ(uint32_t(0), p->s_endType);
+    EQ(begin2, p->s_extents[0].s_end);
+    p = index.find(2, 0);
+    ASSERT(p);
+    EQ(begin2, p->s_extents[0].s_begin);
+    EQ(uint32_t(END_RUN), p->s_endType);
+}
+// Write/read round trip and currency:
+
+void segmentabtest::file_1()
+{
+    writeRuns();
+    CRunSegmentIndex index;
+    index.build(m_files, v12::RingViewDecoder());
+    ASSERT(index.isCurrent());
+
+    std::string indexName = m_files[0] + ".runs";
+    index.write(indexName);
+    CRunSegmentIndex copy;
+    copy.read(indexName);
+    unlink(indexName.c_str());
+
+    ASSERT(copy.isCurrent());
+    EQ(FormatSelector::v12, copy.getVersion());
+    ASSERT(copy.getFiles() == m_files);
+    EQ(index.getSegments().size(), copy.getSegments().size());
+    for (int i = 0; i < index.getSegments().size(); i++) {
+        auto& a = index.getSegments()[i];
+        auto& b = copy.getSegments()[i];
+        EQ(a.s_runNumber, b.s_runNumber);
+        EQ(a.s_segment, b.s_segment);
+        EQ(a.s_title, b.s_title);
+        EQ(a.s_startType, b.s_startType);
+        EQ(a.s_endType, b.s_endType);
+        EQ(a.s_startTime, b.s_startTime);
+        EQ(a.s_endTime, b.s_endTime);
+        EQ(a.s_startClock, b.s_startClock);
+        EQ(a.s_endClock, b.s_endClock);
+        EQ(a.s_extents.size(), b.s_extents.size());
+        for (int e = 0; e < a.s_extents.size(); e++) {
+            EQ(a.s_extents[e].s_file, b.s_extents[e].s_file);
+            EQ(a.s_extents[e].s_begin, b.s_extents[e].s_begin);
+            EQ(a.s_extents[e].s_end, b.s_extents[e].s_end);
+        }
+    }
+    // Adding to the last file makes the index stale:
+
+    writeItem(PHYSICS_EVENT, 0);
+    ASSERT(!copy.isCurrent());
+}
+// Reading something that's not an index fails:
+
+void segmentabtest::file_2()
+{
+    newFile();
+    write(m_fd, "not an index file at all, no not at all...", 40);
+
+    CRunSegmentIndex index;
+    CPPUNIT_ASSERT_THROW(index.read(m_files[0]), std::runtime_error);
+    CPPUNIT_ASSERT_THROW(index.read("/no/such/index"), std::runtime_error);
+}
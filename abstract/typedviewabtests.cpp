@@ -0,0 +1,368 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  typedviewabtests.cpp
+ *  @brief: Test the in place typed ring item views.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingScalerView.h"
+#include "CRingTextView.h"
+#include "CRingStateChangeView.h"
+#include "CRingFragmentView.h"
+#include "DataFormat.h"
+#include <v10/DataFormat.h>
+#include <v11/DataFormat.h>
+#include <v12/DataFormat.h>
+#include <v10/RingViewDecoder.h>
+#include <v11/RingViewDecoder.h>
+#include <v12/RingViewDecoder.h>
+#include <typeinfo>
+#include <stdexcept>
+#include <string.h>
+
+using namespace ufmt;
+
+class typedviewabtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(typedviewabtest);
+    CPPUNIT_TEST(scaler_1);
+    CPPUNIT_TEST(scaler_2);
+    CPPUNIT_TEST(scaler_3);
+    CPPUNIT_TEST(scaler_4);
+    CPPUNIT_TEST(text_1);
+    CPPUNIT_TEST(text_2);
+    CPPUNIT_TEST(state_1);
+    CPPUNIT_TEST(state_2);
+    CPPUNIT_TEST(frag_1);
+    CPPUNIT_TEST(frag_2);
+    CPPUNIT_TEST(badtype_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    uint8_t m_item[1024];
+    v10::RingViewDecoder m_v10;
+    v11::RingViewDecoder m_v11;
+    v12::RingViewDecoder m_v12;
+public:
+    void setUp() {
+        memset(m_item, 0, sizeof(m_item));
+    }
+    void tearDown() {
+
+    }
+protected:
+    void scaler_1();
+    void scaler_2();
+    void scaler_3();
+    void scaler_4();
+    void text_1();
+    void text_2();
+    void state_1();
+    void state_2();
+    void frag_1();
+    void frag_2();
+    void badtype_1();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(typedviewabtest);
+
+// v12 scaler item with a body header:
+
+void typedviewabtest::scaler_1()
+{
+    v12::pScalerItem p = reinterpret_cast<v12::pScalerItem>(m_item);
+    p->s_header.s_type = v12::PERIODIC_SCALERS;
+    p->s_body.u_hasBodyHeader.s_bodyHeader.s_size = sizeof(v12::BodyHeader);
+    p->s_body.u_hasBodyHeader.s_bodyHeader.s_sourceId = 2;
+    v12::pScalerItemBody pBody = &(p->s_body.u_hasBodyHeader.s_body);
+    pBody->s_intervalStartOffset = 10;
+    pBody->s_intervalEndOffset   = 20;
+    pBody->s_timestamp           = 12345;
+    pBody->s_intervalDivisor     = 2;
+    pBody->s_scalerCount         = 4;
+    pBody->s_isIncremental       = 1;
+    pBody->s_originalSid         = 7;
+    for (int i =0; i < 4; i++) {
+        pBody->s_scalers[i] = i*10;
+    }
+    p->s_header.s_size = sizeof(RingItemHeader) + sizeof(v12::BodyHeader) +
+        sizeof(v12::ScalerItemBody) + 4*sizeof(uint32_t);
+
+    CRingScalerView v(CRingItemView(m_item, FormatSelector::v12), m_v12);
+    EQ(uint32_t(10), v.getStartTime());
+    EQ(float(5.0), v.computeStartTime());
+    EQ(uint32_t(20), v.getEndTime());
+    EQ(float(10.0), v.computeEndTime());
+    EQ(uint32_t(2), v.getTimeDivisor());
+    EQ(time_t(12345), v.getTimestamp());
+    ASSERT(v.isIncremental());
+    EQ(uint32_t(4), v.getScalerCount());
+    EQ(uint32_t(7), v.getOriginalSourceId());
+    for (int i =0; i < 4; i++) {
+        EQ(uint32_t(i*10), v.getScaler(i));
+    }
+    EQ(size_t(4), v.getScalers().size());
+    CPPUNIT_ASSERT_THROW(v.getScaler(4), std::logic_error);
+}
+// v11 scaler without a body header:
+
+void typedviewabtest::scaler_2()
+{
+    v11::pScalerItem p = reinterpret_cast<v11::pScalerItem>(m_item);
+    p->s_header.s_type = v11::PERIODIC_SCALERS;
+    p->s_body.u_noBodyHeader.s_mbz = 0;
+    v11::pScalerItemBody pBody = &(p->s_body.u_noBodyHeader.s_body);
+    pBody->s_intervalStartOffset = 1;
+    pBody->s_intervalEndOffset   = 3;
+    pBody->s_timestamp           = 666;
+    pBody->s_intervalDivisor     = 1;
+    pBody->s_scalerCount         = 2;
+    pBody->s_isIncremental       = 0;
+    pBody->s_scalers[0] = 100;
+    pBody->s_scalers[1] = 200;
+    p->s_header.s_size = sizeof(RingItemHeader) + sizeof(uint32_t) +
+        sizeof(v11::ScalerItemBody) + 2*sizeof(uint32_t);
+
+    CRingScalerView v(CRingItemView(m_item, FormatSelector::v11), m_v11);
+    EQ(uint32_t(1), v.getStartTime());
+    EQ(uint32_t(3), v.getEndTime());
+    EQ(time_t(666), v.getTimestamp());
+    ASSERT(!v.isIncremental());
+    EQ(uint32_t(2), v.getScalerCount());
+    EQ(uint32_t(200), v.getScaler(1));
+    EQ(uint32_t(0), v.getOriginalSourceId());
+}
+// v10 incremental scalers:
+
+void typedviewabtest::scaler_3()
+{
+    v10::pScalerItem p = reinterpret_cast<v10::pScalerItem>(m_item);
+    p->s_header.s_type = v10::INCREMENTAL_SCALERS;
+    p->s_intervalStartOffset = 5;
+    p->s_intervalEndOffset   = 15;
+    p->s_timestamp           = 999;
+    p->s_scalerCount         = 3;
+    p->s_scalers[0] = 1;
+    p->s_scalers[1] = 2;
+    p->s_scalers[2] = 3;
+    p->s_header.s_size = sizeof(v10::ScalerItem) + 2*sizeof(uint32_t);
+
+    CRingScalerView v(CRingItemView(m_item, FormatSelector::v10), m_v10);
+    EQ(uint32_t(5), v.getStartTime());
+    EQ(uint32_t(15), v.getEndTime());
+    EQ(uint32_t(1), v.getTimeDivisor());
+    EQ(time_t(999), v.getTimestamp());
+    ASSERT(v.isIncremental());
+    EQ(uint32_t(3), v.getScalerCount());
+    EQ(uint32_t(3), v.getScaler(2));
+    EQ(uint32_t(0), v.getOriginalSourceId());
+}
+// v10 non incremental scalers have a different layout:
+
+void typedviewabtest::scaler_4()
+{
+    v10::pNonIncrTimestampedScaler p =
+        reinterpret_cast<v10::pNonIncrTimestampedScaler>(m_item);
+    p->s_header.s_type = v10::TIMESTAMPED_NONINCR_SCALERS;
+    p->s_intervalStartOffset = 10;
+    p->s_intervalEndOffset   = 30;
+    p->s_intervalDivisor     = 10;
+    p->s_clockTimestamp      = 4321;
+    p->s_scalerCount         = 1;
+    p->s_scalers[0]          = 77;
+    p->s_header.s_size = sizeof(v10::NonIncrTimestampedScaler);
+
+    CRingScalerView v(CRingItemView(m_item, FormatSelector::v10), m_v10);
+    ASSERT(!v.isIncremental());
+    EQ(uint32_t(10), v.getTimeDivisor());
+    EQ(float(3.0), v.computeEndTime());
+    EQ(time_t(4321), v.getTimestamp());
+    EQ(uint32_t(1), v.getScalerCount());
+    EQ(uint32_t(77), v.getScaler(0));
+}
+// v12 text item without body header:
+
+void typedviewabtest::text_1()
+{
+    v12::pTextItem p = reinterpret_cast<v12::pTextItem>(m_item);
+    p->s_header.s_type = v12::MONITORED_VARIABLES;
+    p->s_body.u_noBodyHeader.s_empty = sizeof(uint32_t);
+    v12::pTextItemBody pBody = &(p->s_body.u_noBodyHeader.s_body);
+    pBody->s_timeOffset    = 30;
+    pBody->s_timestamp     = 1000;
+    pBody->s_stringCount   = 3;
+    pBody->s_offsetDivisor = 3;
+    pBody->s_originalSid   = 5;
+    const char strings[] = "one\0two\0three";
+    memcpy(pBody->s_strings, strings, sizeof(strings));
+    p->s_header.s_size = sizeof(RingItemHeader) + sizeof(uint32_t) +
+        sizeof(v12::TextItemBody) + sizeof(strings);
+
+    CRingTextView v(CRingItemView(m_item, FormatSelector::v12), m_v12);
+    EQ(uint32_t(3), v.getStringCount());
+    EQ(uint32_t(30), v.getTimeOffset());
+    EQ(uint32_t(3), v.getTimeDivisor());
+    EQ(float(10.0), v.computeElapsedTime());
+    EQ(time_t(1000), v.getTimestamp());
+    EQ(uint32_t(5), v.getOriginalSourceId());
+    EQ(std::string("one"), std::string(v.getStringsPointer()));
+
+    auto s = v.getStrings();
+    EQ(size_t(3), s.size());
+    EQ(std::string("one"), s[0]);
+    EQ(std::string("two"), s[1]);
+    EQ(std::string("three"), s[2]);
+}
+// v10 text item:
+
+void typedviewabtest::text_2()
+{
+    v10::pTextItem p = reinterpret_cast<v10::pTextItem>(m_item);
+    p->s_header.s_type = v10::PACKET_TYPES;
+    p->s_timeOffset    = 12;
+    p->s_timestamp     = 2000;
+    p->s_stringCount   = 2;
+    const char strings[] = "a\0bc";
+    memcpy(p->s_strings, strings, sizeof(strings));
+    p->s_header.s_size = sizeof(v10::TextItem) + sizeof(strings);
+
+    CRingTextView v(CRingItemView(m_item, FormatSelector::v10), m_v10);
+    EQ(uint32_t(12), v.getTimeOffset());
+    EQ(uint32_t(1), v.getTimeDivisor());
+    EQ(time_t(2000), v.getTimestamp());
+    auto s = v.getStrings();
+    EQ(size_t(2), s.size());
+    EQ(std::string("a"), s[0]);
+    EQ(std::string("bc"), s[1]);
+}
+// v11 state change with a body header:
+
+void typedviewabtest::state_1()
+{
+    v11::pStateChangeItem p = reinterpret_cast<v11::pStateChangeItem>(m_item);
+    p->s_header.s_type = v11::BEGIN_RUN;
+    p->s_body.u_hasBodyHeader.s_bodyHeader.s_size = sizeof(v11::BodyHeader);
+    p->s_body.u_hasBodyHeader.s_bodyHeader.s_sourceId = 3;
+    v11::pStateChangeItemBody pBody = &(p->s_body.u_hasBodyHeader.s_body);
+    pBody->s_runNumber     = 42;
+    pBody->s_timeOffset    = 0;
+    pBody->s_Timestamp     = 5555;
+    pBody->s_offsetDivisor = 1;
+    strcpy(pBody->s_title, "A run title");
+    p->s_header.s_size = sizeof(v11::StateChangeItem);
+
+    CRingStateChangeView v(CRingItemView(m_item, FormatSelector::v11), m_v11);
+    EQ(uint32_t(42), v.getRunNumber());
+    EQ(uint32_t(0), v.getElapsedTime());
+    EQ(uint32_t(1), v.getTimeDivisor());
+    EQ(time_t(5555), v.getTimestamp());
+    EQ(std::string("A run title"), v.getTitle());
+    EQ(uint32_t(3), v.getOriginalSourceId());
+}
+// v10 state change:
+
+void typedviewabtest::state_2()
+{
+    v10::pStateChangeItem p = reinterpret_cast<v10::pStateChangeItem>(m_item);
+    p->s_header.s_type = v10::END_RUN;
+    p->s_header.s_size = sizeof(v10::StateChangeItem);
+    p->s_runNumber  = 12;
+    p->s_timeOffset = 100;
+    p->s_Timestamp  = 777;
+    strcpy(p->s_title, "Old title");
+
+    CRingStateChangeView v(CRingItemView(m_item, FormatSelector::v10), m_v10);
+    EQ(uint32_t(12), v.getRunNumber());
+    EQ(uint32_t(100), v.getElapsedTime());
+    EQ(float(100.0), v.computeElapsedTime());
+    EQ(time_t(777), v.getTimestamp());
+    EQ(std::string("Old title"), v.getTitle());
+    EQ(uint32_t(0), v.getOriginalSourceId());
+}
+// v12 fragment:
+
+void typedviewabtest::frag_1()
+{
+    v12::pEventBuilderFragment p =
+        reinterpret_cast<v12::pEventBuilderFragment>(m_item);
+    p->s_header.s_type = v12::EVB_FRAGMENT;
+    p->s_bodyHeader.s_size      = sizeof(v12::BodyHeader);
+    p->s_bodyHeader.s_timestamp = 0x123456789abcdef0;
+    p->s_bodyHeader.s_sourceId  = 4;
+    p->s_bodyHeader.s_barrier   = 1;
+    for (int i = 0; i < 16; i++) {
+        p->s_body[i] = i;
+    }
+    p->s_header.s_size = sizeof(v12::EventBuilderFragment) + 16;
+
+    CRingFragmentView v(CRingItemView(m_item, FormatSelector::v12), m_v12);
+    EQ(uint64_t(0x123456789abcdef0), v.timestamp());
+    EQ(uint32_t(4), v.source());
+    EQ(uint32_t(1), v.barrierType());
+    EQ(size_t(16), v.payloadSize());
+    EQ((const void*)p->s_body, v.payloadPointer());
+}
+// v10 fragment:
+
+void typedviewabtest::frag_2()
+{
+    v10::pEventBuilderFragment p =
+        reinterpret_cast<v10::pEventBuilderFragment>(m_item);
+    p->s_header.s_type = v10::EVB_UNKNOWN_PAYLOAD;
+    p->s_timestamp   = 0x1234;
+    p->s_sourceId    = 2;
+    p->s_payloadSize = 8;
+    p->s_barrierType = 0;
+    p->s_header.s_size = sizeof(v10::EventBuilderFragment) - sizeof(uint32_t) + 8;
+
+    CRingFragmentView v(CRingItemView(m_item, FormatSelector::v10), m_v10);
+    EQ(uint64_t(0x1234), v.timestamp());
+    EQ(uint32_t(2), v.source());
+    EQ(uint32_t(0), v.barrierType());
+    EQ(size_t(8), v.payloadSize());
+    EQ((const void*)p->s_body, v.payloadPointer());
+}
+// Wrong item types are std::bad_cast:
+
+void typedviewabtest::badtype_1()
+{
+    pRingItem p = reinterpret_cast<pRingItem>(m_item);
+    p->s_header.s_type = PHYSICS_EVENT;
+    p->s_header.s_size = sizeof(RingItemHeader) + sizeof(uint32_t);
+    p->s_body.u_noBodyHeader.s_empty = sizeof(uint32_t);
+    CRingItemView item(m_item);
+
+    ASSERT(!CRingScalerView::canView(item, m_v12));
+    ASSERT(!CRingTextView::canView(item, m_v12));
+    ASSERT(!CRingStateChangeView::canView(item, m_v12));
+    ASSERT(!CRingFragmentView::canView(item, m_v12));
+    CPPUNIT_ASSERT_THROW(CRingScalerView v(item, m_v12), std::bad_cast);
+    CPPUNIT_ASSERT_THROW(CRingTextView v(item, m_v12), std::bad_cast);
+    CPPUNIT_ASSERT_THROW(CRingStateChangeView v(item, m_v12), std::bad_cast);
+    CPPUNIT_ASSERT_THROW(CRingFragmentView v(item, m_v12), std::bad_cast);
+
+    // Fragment too small for its header:
+
+    p->s_header.s_type = EVB_FRAGMENT;
+    ASSERT(!CRingFragmentView::canView(item, m_v12));
+
+    // A decoder only decodes its own format:
+
+    p->s_header.s_type = PERIODIC_SCALERS;
+    ASSERT(!CRingScalerView::canView(item, m_v11));
+}
@@ -0,0 +1,240 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  validatorabtests.cpp
+ *  @brief: Test the ring item plausibility checks.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingItemValidator.h"
+#include "DataFormat.h"
+#include <vector>
+#include <string.h>
+
+using namespace ufmt;
+
+class validatorabtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(validatorabtest);
+    CPPUNIT_TEST(check_1);
+    CPPUNIT_TEST(check_2);
+    CPPUNIT_TEST(check_3);
+    CPPUNIT_TEST(check_4);
+    CPPUNIT_TEST(type_1);
+    CPPUNIT_TEST(sync_1);
+    CPPUNIT_TEST(sync_2);
+    CPPUNIT_TEST(sync_3);
+    CPPUNIT_TEST(sync_4);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::vector<uint8_t> m_data;
+public:
+    void setUp() {
+        m_data.clear();
+    }
+    void tearDown() {
+
+    }
+protected:
+    void check_1();
+    void check_2();
+    void check_3();
+    void check_4();
+    void type_1();
+    void sync_1();
+    void sync_2();
+    void sync_3();
+    void sync_4();
+private:
+    void addItem(uint32_t type, uint32_t bodyHeaderSize, uint32_t bodyBytes);
+    void addGarbage(size_t nBytes);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(validatorabtest);
+
+// Append a v11/v12 style item; bodyHeaderSize is the body header size
+// word and the body header (if any) is included in the item.
+
+void
+validatorabtest::addItem(uint32_t type, uint32_t bodyHeaderSize, uint32_t bodyBytes)
+{
+    size_t start = m_data.size();
+    size_t bh = (bodyHeaderSize > sizeof(uint32_t)) ? bodyHeaderSize : sizeof(uint32_t);
+    m_data.resize(start + sizeof(RingItemHeader) + bh + bodyBytes, 0);
+    RingItem* p = reinterpret_cast<RingItem*>(m_data.data() + start);
+    p->s_header.s_size = sizeof(RingItemHeader) + bh + bodyBytes;
+    p->s_header.s_type = type;
+    p->s_body.u_noBodyHeader.s_empty = bodyHeaderSize;
+}
+// Bytes that are never a plausible header (size 0xffffffff):
+
+void
+validatorabtest::addGarbage(size_t nBytes)
+{
+    m_data.resize(m_data.size() + nBytes, 0xff);
+}
+
+// Good headers:
+
+void validatorabtest::check_1()
+{
+    CRingItemValidator v(FormatSelector::v12);
+    addItem(PHYSICS_EVENT, sizeof(uint32_t), 10);
+    EQ(CRingItemValidator::ok, v.check(m_data.data()));
+    m_data.clear();
+    addItem(PHYSICS_EVENT, sizeof(BodyHeader), 10);
+    ASSERT(v.isPlausible(m_data.data()));
+    m_data.clear();
+    addItem(FIRST_USER_ITEM_CODE + 3, 0, 0);
+    ASSERT(v.isPlausible(m_data.data()));
+    EQ(sizeof(RingItemHeader) + sizeof(uint32_t), v.headerBytes());
+}
+// Bad sizes and body headers:
+
+void validatorabtest::check_2()
+{
+    CRingItemValidator v(FormatSelector::v12, 1000);
+    EQ(uint32_t(1000), v.getMaxItemSize());
+    addItem(PHYSICS_EVENT, sizeof(uint32_t), 10);
+    RingItem* p = reinterpret_cast<RingItem*>(m_data.data());
+
+    p->s_header.s_size = sizeof(RingItemHeader);
+    EQ(CRingItemValidator::tooSmall, v.check(p));
+    p->s_header.s_size = 1001;
+    EQ(CRingItemValidator::tooBig, v.check(p));
+    p->s_header.s_size = 100;
+    p->s_header.s_type = 99;
+    EQ(CRingItemValidator::unknownType, v.check(p));
+    p->s_header.s_type = PHYSICS_EVENT;
+    p->s_body.u_noBodyHeader.s_empty = 12;
+    EQ(CRingItemValidator::badBodyHeader, v.check(p));
+    p->s_header.s_size = sizeof(RingItemHeader) + sizeof(BodyHeader) - 1;
+    p->s_body.u_noBodyHeader.s_empty = sizeof(BodyHeader);
+    EQ(CRingItemValidator::badBodyHeader, v.check(p));
+    ASSERT(strlen(CRingItemValidator::problemString(CRingItemValidator::badBodyHeader)));
+}
+// v10 has no body header word:
+
+void validatorabtest::check_3()
+{
+    CRingItemValidator v(FormatSelector::v10);
+    EQ(sizeof(RingItemHeader), v.headerBytes());
+    addItem(PHYSICS_EVENT, 12345, 0);     // Just body data in v10.
+    ASSERT(v.isPlausible(m_data.data()));
+}
+// Body headers with extension data are fine if they fit in the item:
+
+void validatorabtest::check_4()
+{
+    CRingItemValidator v(FormatSelector::v12);
+    addItem(PHYSICS_EVENT, sizeof(BodyHeader) + 8, 10);
+    EQ(CRingItemValidator::ok, v.check(m_data.data()));
+    
+    RingItem* p = reinterpret_cast<RingItem*>(m_data.data());
+    p->s_header.s_size = sizeof(RingItemHeader) + sizeof(BodyHeader) + 4;
+    EQ(CRingItemValidator::badBodyHeader, v.check(p));
+}
+// Types by version:
+
+void validatorabtest::type_1()
+{
+    CRingItemValidator v10(FormatSelector::v10);
+    CRingItemValidator v12(FormatSelector::v12);
+    ASSERT(v10.isKnownType(TIMESTAMPED_NONINCR_SCALERS));
+    ASSERT(!v12.isKnownType(TIMESTAMPED_NONINCR_SCALERS));
+    ASSERT(!v10.isKnownType(RING_FORMAT));
+    ASSERT(v12.isKnownType(RING_FORMAT));
+    ASSERT(v12.isKnownType(EVB_GLOM_INFO));
+    ASSERT(v12.isKnownType(0xffff));
+    ASSERT(!v12.isKnownType(0x10000));
+    ASSERT(!v12.isKnownType(0));
+}
+// Items after garbage are found:
+
+void validatorabtest::sync_1()
+{
+    addGarbage(13);
+    for (int i = 0; i < 6; i++) addItem(PHYSICS_EVENT, sizeof(uint32_t), i);
+    CRingItemValidator v(FormatSelector::v12);
+    size_t offset;
+    EQ(
+        CRingItemValidator::syncFound,
+        v.findSync(m_data.data(), m_data.size(), false, offset)
+    );
+    EQ(size_t(13), offset);
+}
+// A short run of items is enough if it ends with the data:
+
+void validatorabtest::sync_2()
+{
+    addGarbage(7);
+    addItem(BEGIN_RUN, sizeof(uint32_t), 100);
+    addItem(END_RUN, sizeof(uint32_t), 100);
+    CRingItemValidator v(FormatSelector::v12);
+    size_t offset;
+    EQ(
+        CRingItemValidator::syncFound,
+        v.findSync(m_data.data(), m_data.size(), true, offset)
+    );
+    EQ(size_t(7), offset);
+
+    // Unless there could be more:
+
+    EQ(
+        CRingItemValidator::needMoreData,
+        v.findSync(m_data.data(), m_data.size(), false, offset)
+    );
+    EQ(size_t(7), offset);
+}
+// Nothing plausible:
+
+void validatorabtest::sync_3()
+{
+    addGarbage(100);
+    CRingItemValidator v(FormatSelector::v12);
+    size_t offset;
+    EQ(
+        CRingItemValidator::noSync,
+        v.findSync(m_data.data(), m_data.size(), true, offset)
+    );
+    EQ(size_t(100), offset);
+    EQ(
+        CRingItemValidator::needMoreData,
+        v.findSync(m_data.data(), m_data.size(), false, offset)
+    );
+    EQ(size_t(100 - v.headerBytes() + 1), offset);
+}
+// A lone plausible header that isn't followed by items is skipped:
+
+void validatorabtest::sync_4()
+{
+    addItem(PHYSICS_EVENT, sizeof(uint32_t), 8);
+    RingItem* p = reinterpret_cast<RingItem*>(m_data.data());
+    p->s_header.s_size = 40;                   // Next "item" is garbage.
+    addGarbage(60);
+    size_t good = m_data.size();
+    for (int i = 0; i < 6; i++) addItem(PHYSICS_EVENT, sizeof(uint32_t), i);
+
+    CRingItemValidator v(FormatSelector::v12);
+    size_t offset;
+    EQ(
+        CRingItemValidator::syncFound,
+        v.findSync(m_data.data(), m_data.size(), false, offset)
+    );
+    EQ(good, offset);
+}
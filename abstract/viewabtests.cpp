@@ -0,0 +1,234 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  viewabtests.cpp
+ *  @brief: Test the non-owning ring item view.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "CRingItemView.h"
+#include "DataFormat.h"
+#include <stdint.h>
+#include <string.h>
+#include <string>
+
+using namespace ufmt;
+
+class viewabtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(viewabtest);
+    CPPUNIT_TEST(construct_1);
+    CPPUNIT_TEST(construct_2);
+    CPPUNIT_TEST(v10_1);
+    CPPUNIT_TEST(v10_2);
+    CPPUNIT_TEST(v11_1);
+    CPPUNIT_TEST(v11_2);
+    CPPUNIT_TEST(v12_1);
+    CPPUNIT_TEST(v12_2);
+    CPPUNIT_TEST(v12_3);
+    CPPUNIT_TEST(setitem_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    uint8_t m_item[200];
+public:
+    void setUp() {
+        memset(m_item, 0, sizeof(m_item));
+    }
+    void tearDown() {
+        
+    }
+protected:
+    void construct_1();
+    void construct_2();
+    void v10_1();
+    void v10_2();
+    void v11_1();
+    void v11_2();
+    void v12_1();
+    void v12_2();
+    void v12_3();
+    void setitem_1();
+private:
+    void makeItem(uint32_t bhdrWord, uint32_t bodySize, bool v10 = false);
+    void makeBhdrItem(uint32_t bhdrSize, uint32_t bodySize);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(viewabtest);
+
+// Make an item without a body header.  bhdrWord is the value of the
+// word after the header (0 for v11, sizeof(uint32_t) for v12).
+// v10 means there's no such word.
+
+void
+viewabtest::makeItem(uint32_t bhdrWord, uint32_t bodySize, bool v10)
+{
+    pRingItem p = reinterpret_cast<pRingItem>(m_item);
+    uint8_t* pBody = m_item + sizeof(RingItemHeader);
+    if (!v10) {
+        p->s_body.u_noBodyHeader.s_empty = bhdrWord;
+        pBody += sizeof(uint32_t);
+    }
+    for (int i =0; i < bodySize; i++) {
+        pBody[i] = i;
+    }
+    p->s_header.s_type = PHYSICS_EVENT;
+    p->s_header.s_size = (pBody + bodySize) - m_item;
+}
+// Make an item with a body header of the given size.
+
+void
+viewabtest::makeBhdrItem(uint32_t bhdrSize, uint32_t bodySize)
+{
+    pRingItem p = reinterpret_cast<pRingItem>(m_item);
+    pBodyHeader pB = &(p->s_body.u_hasBodyHeader.s_bodyHeader);
+    pB->s_size = bhdrSize;
+    pB->s_timestamp = 0x123456789a;
+    pB->s_sourceId  = 5;
+    pB->s_barrier   = 2;
+    uint8_t* pBody = reinterpret_cast<uint8_t*>(pB) + bhdrSize;
+    for (int i =0; i < bodySize; i++) {
+        pBody[i] = i;
+    }
+    p->s_header.s_type = PHYSICS_EVENT;
+    p->s_header.s_size = (pBody + bodySize) - m_item;
+}
+
+// Default construction is a null view:
+
+void viewabtest::construct_1()
+{
+    CRingItemView v;
+    ASSERT(v.isNull());
+    ASSERT(v.getItemPointer() == nullptr);
+}
+// Construct on an item:
+
+void viewabtest::construct_2()
+{
+    makeItem(0, 10);
+    CRingItemView v(m_item, FormatSelector::v11);
+    ASSERT(!v.isNull());
+    EQ(reinterpret_cast<const RingItem*>(m_item), v.getItemPointer());
+    EQ(FormatSelector::v11, v.getVersion());
+}
+// v10 item - body is right after the header:
+
+void viewabtest::v10_1()
+{
+    makeItem(0, 10, true);
+    CRingItemView v(m_item, FormatSelector::v10);
+    EQ(PHYSICS_EVENT, v.type());
+    EQ(uint32_t(sizeof(RingItemHeader) + 10), v.size());
+    EQ((const void*)(m_item + sizeof(RingItemHeader)), v.getBodyPointer());
+    EQ(size_t(10), v.getBodySize());
+    ASSERT(!v.hasBodyHeader());
+    ASSERT(v.getBodyHeader() == nullptr);
+}
+// v10 items never have body headers even if the first body word looks
+// like a body header size:
+
+void viewabtest::v10_2()
+{
+    makeBhdrItem(sizeof(BodyHeader), 10);
+    CRingItemView v(m_item, FormatSelector::v10);
+    ASSERT(!v.hasBodyHeader());
+    CPPUNIT_ASSERT_THROW(v.getEventTimestamp(), std::string);
+    CPPUNIT_ASSERT_THROW(v.getSourceId(), std::string);
+    CPPUNIT_ASSERT_THROW(v.getBarrierType(), std::string);
+}
+// v11 without body header (mbz word is zero):
+
+void viewabtest::v11_1()
+{
+    makeItem(0, 10);
+    CRingItemView v(m_item, FormatSelector::v11);
+    EQ((const void*)(m_item + sizeof(RingItemHeader) + sizeof(uint32_t)), v.getBodyPointer());
+    EQ(size_t(10), v.getBodySize());
+    ASSERT(!v.hasBodyHeader());
+    CPPUNIT_ASSERT_THROW(v.getEventTimestamp(), std::string);
+}
+// v11 with a body header:
+
+void viewabtest::v11_2()
+{
+    makeBhdrItem(sizeof(BodyHeader), 10);
+    CRingItemView v(m_item, FormatSelector::v11);
+    ASSERT(v.hasBodyHeader());
+    EQ((const void*)(m_item + sizeof(RingItemHeader)), v.getBodyHeader());
+    EQ(
+        (const void*)(m_item + sizeof(RingItemHeader) + sizeof(BodyHeader)),
+        v.getBodyPointer()
+    );
+    EQ(size_t(10), v.getBodySize());
+    EQ(uint64_t(0x123456789a), v.getEventTimestamp());
+    EQ(uint32_t(5), v.getSourceId());
+    EQ(uint32_t(2), v.getBarrierType());
+}
+// v12 without body header (empty word is sizeof(uint32_t)):
+
+void viewabtest::v12_1()
+{
+    makeItem(sizeof(uint32_t), 10);
+    CRingItemView v(m_item);
+    EQ(FormatSelector::v12, v.getVersion());
+    EQ((const void*)(m_item + sizeof(RingItemHeader) + sizeof(uint32_t)), v.getBodyPointer());
+    EQ(size_t(10), v.getBodySize());
+    ASSERT(!v.hasBodyHeader());
+}
+// v12 with body header:
+
+void viewabtest::v12_2()
+{
+    makeBhdrItem(sizeof(BodyHeader), 10);
+    CRingItemView v(m_item, FormatSelector::v12);
+    ASSERT(v.hasBodyHeader());
+    EQ(size_t(10), v.getBodySize());
+    EQ(uint64_t(0x123456789a), v.getEventTimestamp());
+    EQ(uint32_t(5), v.getSourceId());
+    EQ(uint32_t(2), v.getBarrierType());
+}
+// v12 with an extended body header - body is after the extension:
+
+void viewabtest::v12_3()
+{
+    makeBhdrItem(sizeof(BodyHeader) + 8, 10);
+    CRingItemView v(m_item, FormatSelector::v12);
+    EQ(
+        (const void*)(m_item + sizeof(RingItemHeader) + sizeof(BodyHeader) + 8),
+        v.getBodyPointer()
+    );
+    EQ(size_t(10), v.getBodySize());
+}
+// setItem repoints the view:
+
+void viewabtest::setitem_1()
+{
+    uint8_t other[sizeof(RingItemHeader)];
+    reinterpret_cast<pRingItemHeader>(other)->s_size = sizeof(other);
+    reinterpret_cast<pRingItemHeader>(other)->s_type = BEGIN_RUN;
+    
+    makeItem(0, 10);
+    CRingItemView v(m_item, FormatSelector::v11);
+    v.setItem(other);
+    EQ(BEGIN_RUN, v.type());
+    EQ(FormatSelector::v11, v.getVersion());
+    
+    v.setItem(m_item, FormatSelector::v10);
+    EQ(PHYSICS_EVENT, v.type());
+    EQ(FormatSelector::v10, v.getVersion());
+}
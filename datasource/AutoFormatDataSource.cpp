@@ -0,0 +1,232 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  AutoFormatDataSource.cpp
+ *  @brief: Implement the format detecting data source.
+ */
+#include "AutoFormatDataSource.h"
+#include "FdDataSource.h"
+#include <CRingBlockReader.h>
+#include <CRingItemValidator.h>
+#include <RingItemFactoryBase.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <memory>
+#include <utility>
+#include <vector>
+#include <stdint.h>
+
+namespace ufmt {
+/**
+ * constructor
+ *    Peek at the start of the source and give it a factory for the
+ *    format found there.
+ * @param pSource - the source to read.  We take ownership of it.  Its
+ *                  factory is the fallback if the format can't be detected.
+ */
+AutoFormatDataSource::AutoFormatDataSource(DataSource* pSource) :
+    DataSource(nullptr), m_pSource(pSource),
+    m_version(pSource->getFactory()->version()), m_detected(false)
+{
+    std::vector<uint8_t> data(PEEK_SIZE);
+    size_t nBytes = m_pSource->peek(data.data(), data.size());
+    FormatSelector::SupportedVersions version = m_version;
+    if (FormatSelector::detectVersion(data.data(), nBytes, version)) {
+        m_detected = true;
+        if (version != m_version) {
+            switchVersion(version);
+        }
+    }
+}
+/**
+ * destructor
+ *    The wrapped source owns the factory.
+ */
+AutoFormatDataSource::~AutoFormatDataSource()
+{
+    delete m_pSource;
+}
+/**
+ * getItem
+ * @return CRingItem* - next item, made by the factory for the format in
+ *               effect after the item.  nullptr if there are no more.
+ */
+CRingItem*
+AutoFormatDataSource::getItem()
+{
+    CRingItem* pItem = m_pSource->getItem();
+    if (pItem && checkFormat(*pItem)) {
+        std::unique_ptr<const CRingItem> pOld(pItem);  // const: no extra copy.
+        pItem = getFactory()->makeRingItem(pOld->getItemPointer());
+    }
+    return pItem;
+}
+/**
+ * getItem
+ * @param item - item to refill (it keeps its class; see the class comments).
+ * @return bool - false if there are no more items.
+ */
+bool
+AutoFormatDataSource::getItem(CRingItem& item)
+{
+    if (!m_pSource->getItem(item)) {
+        return false;
+    }
+    checkFormat(item);
+    return true;
+}
+/**
+ * getItems
+ *    Items are read one at a time so that a format change is seen before
+ *    the item after it is read.
+ * @param items - items to refill (see DataSource::getItems).
+ * @param maxItems - most items to get.
+ * @return size_t - number of items gotten.
+ */
+size_t
+AutoFormatDataSource::getItems(std::vector<CRingItem*>& items, size_t maxItems)
+{
+    size_t n = 0;
+    while (n < maxItems) {
+        if (n == items.size()) {
+            items.push_back(getFactory()->makeRingItem(uint16_t(0), size_t(0)));
+        }
+        if (!getItem(*items[n])) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+/**
+ * peek
+ *   @return size_t - see DataSource::peek; we peek the wrapped source.
+ */
+size_t
+AutoFormatDataSource::peek(void* pDest, size_t nBytes)
+{
+    return m_pSource->peek(pDest, nBytes);
+}
+/**
+ * setFactory
+ *    Our own factory pointer is unused, so the factory is handed to the
+ *    wrapped source which deletes its old one and owns the new one.
+ * @param pFactory - new factory.  Its version becomes the version read
+ *                   until a RING_FORMAT item says otherwise.
+ */
+void
+AutoFormatDataSource::setFactory(RingItemFactoryBase* pFactory)
+{
+    m_pSource->setFactory(pFactory);
+    m_version = pFactory->version();
+    retargetValidator();
+}
+/**
+ * getFactory
+ * @return RingItemFactoryBase* - the wrapped source's current factory.
+ */
+RingItemFactoryBase*
+AutoFormatDataSource::getFactory()
+{
+    return m_pSource->getFactory();
+}
+/**
+ * getVersion
+ * @return FormatSelector::SupportedVersions - format now being read.
+ */
+FormatSelector::SupportedVersions
+AutoFormatDataSource::getVersion() const
+{
+    return m_version;
+}
+/**
+ * wasDetected
+ * @return bool - true if the start of the data decided the format, false
+ *                if we fell back to the wrapped source's factory.
+ */
+bool
+AutoFormatDataSource::wasDetected() const
+{
+    return m_detected;
+}
+/**
+ * getSource
+ * @return DataSource* - the wrapped source (e.g. to get at its reader).
+ */
+DataSource*
+AutoFormatDataSource::getSource()
+{
+    return m_pSource;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * checkFormat
+ *    If an item is a format item for another version, switch the
+ *    wrapped source to a factory for that version.
+ * @param item - item just read.
+ * @return bool - true if the factory was switched.
+ */
+bool
+AutoFormatDataSource::checkFormat(const CRingItem& item)
+{
+    FormatSelector::SupportedVersions version;
+    if ((item.type() == RING_FORMAT) &&
+        FormatSelector::getFormatVersion(item.getItemPointer(), version) &&
+        (version != m_version)) {
+        switchVersion(version);
+        return true;
+    }
+    return false;
+}
+/**
+ * switchVersion
+ *    Give the wrapped source a factory (and validator) for a new version.
+ * @param version - the version now being read.
+ */
+void
+AutoFormatDataSource::switchVersion(FormatSelector::SupportedVersions version)
+{
+    m_pSource->setFactory(FormatSelector::makeFactory(version));
+    m_version = version;
+    retargetValidator();
+}
+/**
+ * retargetValidator
+ *    If the wrapped source checks items with a validator for some other
+ *    version, replace it with one (we own) for m_version with the same
+ *    maximum item size.
+ */
+void
+AutoFormatDataSource::retargetValidator()
+{
+    FdDataSource* pSource = dynamic_cast<FdDataSource*>(m_pSource);
+    if (!pSource || !pSource->getReader()) {
+        return;
+    }
+    const CRingItemValidator* pOld = pSource->getReader()->getValidator();
+    if (pOld && (pOld->getVersion() != m_version)) {
+        std::unique_ptr<CRingItemValidator> pValidator(
+            new CRingItemValidator(m_version, pOld->getMaxItemSize())
+        );
+        pSource->setValidator(pValidator.get());
+        m_pValidator = std::move(pValidator);      // Old one no longer used.
+    }
+}
+
+}           // ufmt namespace.
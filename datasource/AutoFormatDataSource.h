@@ -0,0 +1,87 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef AUTOFORMATDATASOURCE_H
+#define AUTOFORMATDATASOURCE_H
+/** @file:  AutoFormatDataSource.h
+ *  @brief: Data source that works out the format of the data it reads.
+ */
+#include "DataSource.h"
+#include <NSCLDAQFormatFactorySelector.h>
+#include <memory>
+#include <stddef.h>
+
+namespace ufmt {
+    class CRingItemValidator;
+/**
+ * AutoFormatDataSource
+ *    Wraps another data source and chooses its factory from the data
+ *    rather than trusting the caller:
+ *    - On construction the start of the source is peeked (see
+ *      DataSource::peek) and FormatSelector::detectVersion decides the
+ *      format.  Nothing is consumed.  If the source can't peek or the data
+ *      doesn't decide, the wrapped source's factory is kept.
+ *    - Each RING_FORMAT item read switches the wrapped source to a
+ *      factory for the version it declares.  This handles files of
+ *      different versions that have been concatenated.
+ *    - setFactory gives the wrapped source the factory (and so sets the
+ *      version being read) until the next RING_FORMAT item.
+ *    - If the wrapped source is an FdDataSource checking items with a
+ *      CRingItemValidator (see FdDataSource::setValidator), each version
+ *      change gives it a validator for the new version so that valid items
+ *      of that version are not taken for damaged data.
+ *
+ * @note getItem(CRingItem&) refills the caller's item, which keeps its
+ *       class.  Callers that refill should compare getFactory() before and
+ *       after each read and remake their item when it changes.
+ * @note setFilter is not passed on to the wrapped source (the default
+ *       refusal is kept) since a filter could hide the RING_FORMAT items
+ *       this class has to see.
+ */
+class AutoFormatDataSource : public DataSource
+{
+public:
+    static const size_t PEEK_SIZE = 64*1024;
+private:
+    DataSource* m_pSource;
+    FormatSelector::SupportedVersions m_version;
+    bool        m_detected;
+    std::unique_ptr<CRingItemValidator> m_pValidator;  // Given to m_pSource.
+public:
+    AutoFormatDataSource(DataSource* pSource);
+    virtual ~AutoFormatDataSource();
+    virtual CRingItem* getItem();
+    virtual bool getItem(CRingItem& item);
+    virtual size_t getItems(std::vector<CRingItem*>& items, size_t maxItems);
+    virtual size_t peek(void* pDest, size_t nBytes);
+    virtual void setFactory(RingItemFactoryBase* pFactory);
+    virtual RingItemFactoryBase* getFactory();
+
+    FormatSelector::SupportedVersions getVersion() const;
+    bool wasDetected() const;
+    DataSource* getSource();
+private:
+    bool checkFormat(const CRingItem& item);
+    void switchVersion(FormatSelector::SupportedVersions version);
+    void retargetValidator();
+private:
+    AutoFormatDataSource(const AutoFormatDataSource& rhs);
+    AutoFormatDataSource& operator=(const AutoFormatDataSource& rhs);
+};
+
+}           // ufmt namespace.
+#endif
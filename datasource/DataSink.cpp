@@ -0,0 +1,55 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  DataSink.cpp
+ *  @brief: Implementation of the non pure virtual methods of DataSink.
+ */
+
+#include "DataSink.h"
+
+namespace ufmt {
+/**
+ * constructor
+ *   @param pFactory - factory used to put items.  The caller keeps
+ *                     ownership.
+ */
+DataSink::DataSink(RingItemFactoryBase* pFactory) :
+    m_pFactory(pFactory)
+{}
+/**
+ * destructor
+ */
+DataSink::~DataSink()
+{}
+/**
+ * flush
+ *    Write anything buffered.  Unbuffered sinks need do nothing.
+ */
+void
+DataSink::flush()
+{}
+/**
+ * setFactory
+ *    Use a different factory - done if the format changes.
+ * @param pFactory - the new factory.
+ */
+void
+DataSink::setFactory(RingItemFactoryBase* pFactory)
+{
+    m_pFactory = pFactory;
+}
+}  // ufmt namespace.
@@ -0,0 +1,57 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef DATASINK_H
+#define DATASINK_H
+
+/** @file  DataSink.h
+ *  @brief Works with factories to put ring items to a data sink.
+ * @note Abstract base class for FdDataSink, StreamDataSink and RingDataSink
+ */
+
+namespace ufmt {
+    class CRingItem;
+    class RingItemBatch;
+    class RingItemFactoryBase;
+
+/**
+ * @class DataSink
+ *    The output counterpart of DataSource.  Ring items are put using the
+ *    factory's putRingItem methods:
+ *    - FdDataSink - buffered output to a file descriptor.
+ *    - StreamDataSink - output to a stream.
+ *    - RingDataSink - output to a ring buffer.
+ *
+ *    Sinks may buffer; flush() pushes out anything buffered.
+ *
+ * @note Unlike a DataSource, a sink does not own its factory as the same
+ *       factory is usually also used by the source that feeds the sink.
+ */
+class DataSink {
+protected:
+    RingItemFactoryBase* m_pFactory;
+public:
+    DataSink(RingItemFactoryBase* pFactory);
+    virtual ~DataSink();
+    virtual void putItem(const CRingItem& item) = 0;
+    virtual void putItems(const RingItemBatch& batch) = 0;
+    virtual void flush();
+    void setFactory(RingItemFactoryBase* pFactory);
+};
+
+}   // ufmt namespace.
+#endif
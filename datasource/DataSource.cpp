@@ -21,6 +21,10 @@
 
 #include "DataSource.h"
 #include <RingItemFactoryBase.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <memory>
+#include <string.h>
 
 /**
  * constructor
@@ -40,6 +44,54 @@ DataSource::~DataSource()
 {
     delete m_pFactory;
 }
+/**
+ * getItem
+ *    Refill an existing item with the next item from the source.
+ *    This default gets a new item and copies it, concrete sources
+ *    override this to read directly into the item.
+ * @param item - item to fill in.
+ * @return bool - false if there are no more items.
+ */
+bool
+DataSource::getItem(CRingItem& item)
+{
+    std::unique_ptr<CRingItem> pItem(getItem());
+    if (!pItem.get()) {
+        return false;
+    }
+    uint32_t size = pItem->size();
+    uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(size));
+    memcpy(p, pItem->getItemPointer(), size);
+    item.setBodyCursor(p + size);
+    item.updateSize();
+    return true;
+}
+/**
+ * getItems
+ *    Get a batch of items.  This default refills the items one at a
+ *    time with getItem(CRingItem&).  Concrete sources override it to use
+ *    the factory's batch reads.
+ * @param items - items to refill.  The caller owns these and new items
+ *                are added to the end of the vector if needed.
+ * @param maxItems - most items to get.
+ * @return size_t - number of items gotten; fewer than maxItems only if
+ *                the source has run out of items.
+ */
+size_t
+DataSource::getItems(std::vector<CRingItem*>& items, size_t maxItems)
+{
+    size_t n = 0;
+    while (n < maxItems) {
+        if (n == items.size()) {
+            items.push_back(m_pFactory->makeRingItem(uint16_t(0), size_t(0)));
+        }
+        if (!getItem(*items[n])) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
 /**
  * setFactory
  *   - delete the current factory
@@ -52,4 +104,157 @@ DataSource::setFactory(RingItemFactoryBase* pFactory)
     delete m_pFactory;
     m_pFactory = pFactory;
 }
+/**
+ * getFactory
+ * @return RingItemFactoryBase* - the factory items are made with.  We
+ *                   still own it.
+ */
+RingItemFactoryBase*
+DataSource::getFactory()
+{
+    return m_pFactory;
+}
+/**
+ * peek
+ *    Copy data from the front of the source without consuming it.  This
+ *    default can't.
+ * @param pDest - where to put the data.
+ * @param nBytes - most bytes wanted.
+ * @return size_t - bytes copied (0: none or the source can't peek).
+ */
+size_t
+DataSource::peek(void* pDest, size_t nBytes)
+{
+    return 0;
+}
+/**
+ * setFilter
+ *    Apply an item filter as items are read.  This default can't.
+ * @param pFilter - the filter (nullptr for none).  The caller owns it and
+ *                 it must live as long as it's set.
+ * @return bool - true if the source applies the filter, false if the
+ *                 caller must.
+ */
+bool
+DataSource::setFilter(const CRingItemFilter* pFilter)
+{
+    return false;
+}
+/**
+ * begin
+ * @param batchSize - number of items read at a time.
+ * @return iterator - iterator at the first item of the source (or end if
+ *                    there are none).
+ */
+DataSource::iterator
+DataSource::begin(size_t batchSize)
+{
+    return iterator(*this, batchSize);
+}
+/**
+ * end
+ * @return iterator - the end iterator.
+ */
+DataSource::iterator
+DataSource::end()
+{
+    return iterator();
+}
+///////////////////////////////////////////////////////////////////////////////
+// DataSourceIterator implementation.
+
+/**
+ * Batch destructor - the batch owns its items.
+ */
+DataSourceIterator::Batch::~Batch()
+{
+    for (auto p : s_items) {
+        delete p;
+    }
+}
+/**
+ * constructor
+ *    The end iterator.
+ */
+DataSourceIterator::DataSourceIterator()
+{}
+/**
+ * constructor
+ *    Reads the first batch.
+ * @param source - the source we iterate over.
+ * @param batchSize - items per batch (at least one).
+ */
+DataSourceIterator::DataSourceIterator(DataSource& source, size_t batchSize) :
+    m_pBatch(std::make_shared<Batch>())
+{
+    m_pBatch->s_pSource   = &source;
+    m_pBatch->s_batchSize = batchSize ? batchSize : 1;
+    m_pBatch->s_nItems    = 0;
+    m_pBatch->s_index     = 0;
+    nextBatch();
+}
+/**
+ * operator*
+ * @return CRingItem& - the current item.
+ */
+CRingItem&
+DataSourceIterator::operator*() const
+{
+    return *(m_pBatch->s_items[m_pBatch->s_index]);
+}
+/**
+ * operator->
+ * @return CRingItem* - the current item.
+ */
+CRingItem*
+DataSourceIterator::operator->() const
+{
+    return m_pBatch->s_items[m_pBatch->s_index];
+}
+/**
+ * operator++
+ *    Advance to the next item, reading the next batch if this
+ *    batch is used up.
+ * @return DataSourceIterator& - *this.
+ */
+DataSourceIterator&
+DataSourceIterator::operator++()
+{
+    m_pBatch->s_index++;
+    if (m_pBatch->s_index >= m_pBatch->s_nItems) {
+        nextBatch();
+    }
+    return *this;
+}
+/**
+ * operator==
+ *    Iterators are equal if both are at the end or if they share
+ *    a batch (copies of the same iterator).
+ */
+bool
+DataSourceIterator::operator==(const DataSourceIterator& rhs) const
+{
+    return m_pBatch == rhs.m_pBatch;
+}
+bool
+DataSourceIterator::operator!=(const DataSourceIterator& rhs) const
+{
+    return !(*this == rhs);
+}
+/**
+ * nextBatch
+ *    Read the next batch; at the end of the source we become the
+ *    end iterator.
+ */
+void
+DataSourceIterator::nextBatch()
+{
+    m_pBatch->s_index  = 0;
+    m_pBatch->s_nItems = m_pBatch->s_pSource->getItems(
+        m_pBatch->s_items, m_pBatch->s_batchSize
+    );
+    if (m_pBatch->s_nItems == 0) {
+        m_pBatch.reset();
+    }
+}
 }  // ufmt namespace.
\ No newline at end of file
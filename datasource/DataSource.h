@@ -22,9 +22,55 @@
  * @note Abstract base class for FdDataSource, StreamDataSource and RingDataSource
  */
 
+#include <stddef.h>
+#include <iterator>
+#include <memory>
+#include <vector>
+
 namespace ufmt {
     class CRingItem;
+    class CRingItemFilter;
     class RingItemFactoryBase;
+    class DataSource;
+
+/**
+ * @class DataSourceIterator
+ *    Input iterator over the items of a data source.  Items are read
+ *    a batch at a time with DataSource::getItems into items owned by the
+ *    iterator which are refilled by the next batch.  An item is therefore
+ *    only valid until the iterator is advanced past its batch; copy it
+ *    (e.g. with the factory's makeRingItem) to keep it longer.
+ *    Copies of an iterator share the batch.
+ */
+class DataSourceIterator {
+public:
+    typedef std::input_iterator_tag iterator_category;
+    typedef CRingItem               value_type;
+    typedef std::ptrdiff_t          difference_type;
+    typedef CRingItem*              pointer;
+    typedef CRingItem&              reference;
+private:
+    struct Batch {
+        DataSource*             s_pSource;
+        std::vector<CRingItem*> s_items;
+        size_t                  s_batchSize;
+        size_t                  s_nItems;      // Valid items in s_items.
+        size_t                  s_index;       // Current item.
+        ~Batch();
+    };
+    std::shared_ptr<Batch> m_pBatch;           // Null at end.
+public:
+    DataSourceIterator();                      // End iterator.
+    DataSourceIterator(DataSource& source, size_t batchSize);
+    
+    CRingItem& operator*() const;
+    CRingItem* operator->() const;
+    DataSourceIterator& operator++();
+    bool operator==(const DataSourceIterator& rhs) const;
+    bool operator!=(const DataSourceIterator& rhs) const;
+private:
+    void nextBatch();
+};
 
 
 /**
@@ -35,6 +81,27 @@ namespace ufmt {
  *    - FdDataSource - give data from a file descriptor.
  *    - StreamDataSource -give data from a stream.
  *    - RingDataSource -give data from a ringbuffer.
+ *    - MmapDataSource -give data from a memory mapped file.
+ *
+ *    getItem(CRingItem&) refills an existing item rather than making a new
+ *    one so that a read loop needn't allocate an item per read.  The
+ *    default implementation just copies from getItem() so concrete
+ *    classes should override it.
+ *
+ *    getItems gets a batch of items with one call, refilling the items
+ *    of a vector the caller keeps from batch to batch (see
+ *    RingItemFactoryBase::getRingItems).  begin/end iterate over the
+ *    items of the source a batch at a time.
+ *
+ *    peek copies data from the front of the source without consuming it
+ *    so the format of the data can be decided before items are read
+ *    (see AutoFormatDataSource).  Sources that can't do that return 0,
+ *    which is the default.
+ *
+ *    setFilter asks the source to apply a CRingItemFilter as it reads
+ *    item headers so rejected items are stepped over without their bodies
+ *    being read or copied.  Sources that can't return false (the default)
+ *    and the caller must apply the filter to the items it gets.
  */
 class DataSource {
 protected:
@@ -43,7 +110,17 @@ public:
     DataSource(RingItemFactoryBase* pFactory);
     virtual ~DataSource();
     virtual CRingItem* getItem() = 0;
-    void setFactory(RingItemFactoryBase* pFactory);
+    virtual bool getItem(CRingItem& item);
+    virtual size_t getItems(std::vector<CRingItem*>& items, size_t maxItems);
+    virtual size_t peek(void* pDest, size_t nBytes);
+    virtual bool setFilter(const CRingItemFilter* pFilter);
+    virtual void setFactory(RingItemFactoryBase* pFactory);
+    virtual RingItemFactoryBase* getFactory();
+    
+    typedef DataSourceIterator iterator;
+    static const size_t DEFAULT_BATCH_SIZE = 256;
+    iterator begin(size_t batchSize = DEFAULT_BATCH_SIZE);
+    iterator end();
 };
 
 }   // ufmt namespace.
@@ -0,0 +1,85 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  FdDataSink.cpp
+ *  @brief: Implementation of the buffered file descriptor data sink.
+ */
+#include "FdDataSink.h"
+#include <RingItemFactoryBase.h>
+
+namespace ufmt {
+/**
+ * constructor
+ * @param pFactory - factory used to put items.
+ * @param fd       - file descriptor to write.  The caller owns this.
+ * @param blockSize - bytes buffered before a write.
+ * @param flushIntervalMs - if non zero, the most milliseconds an item
+ *                 is buffered before it's written.
+ */
+FdDataSink::FdDataSink(
+    RingItemFactoryBase* pFactory, int fd, size_t blockSize,
+    unsigned flushIntervalMs
+) :
+    DataSink(pFactory),
+    m_pWriter(new CRingBlockWriter(fd, blockSize, flushIntervalMs))
+{}
+/**
+ * constructor
+ *    For derived classes that supply their own writer.
+ * @param pFactory - factory used to put items.
+ * @param pWriter  - dynamically allocated writer.  We own it.
+ */
+FdDataSink::FdDataSink(RingItemFactoryBase* pFactory, CRingBlockWriter* pWriter) :
+    DataSink(pFactory), m_pWriter(pWriter)
+{}
+/**
+ * destructor
+ *    The writer writes anything that's left.
+ */
+FdDataSink::~FdDataSink()
+{
+    delete m_pWriter;
+}
+/**
+ * putItem
+ * @param item - item to put.
+ */
+void
+FdDataSink::putItem(const CRingItem& item)
+{
+    m_pFactory->putRingItem(&item, *m_pWriter);
+}
+/**
+ * putItems
+ * @param batch - items to put.
+ */
+void
+FdDataSink::putItems(const RingItemBatch& batch)
+{
+    m_pFactory->putRingItem(batch, *m_pWriter);
+}
+/**
+ * flush
+ *    Write what's buffered.
+ */
+void
+FdDataSink::flush()
+{
+    m_pWriter->flush();
+}
+
+}   // ufmt namespace.
@@ -0,0 +1,58 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef FDDATASINK_H
+#define FDDATASINK_H
+/** @file:  FdDataSink.h
+ *  @brief: Buffered data sink for ring items to a file descriptor.
+ */
+#include "DataSink.h"
+#include <CRingBlockWriter.h>
+#include <stddef.h>
+
+namespace ufmt {
+
+/**
+ * FdDataSink
+ *    Puts ring items to a file descriptor through a CRingBlockWriter so
+ *    that many small items are written with one write(2).  A flush
+ *    interval bounds how long an item can wait in the buffer.
+ *    Anything left is written when the sink is destroyed.
+ */
+class FdDataSink : public DataSink
+{
+private:
+    CRingBlockWriter* m_pWriter;
+public:
+    FdDataSink(
+        RingItemFactoryBase* pFactory, int fd,
+        size_t blockSize = CRingBlockWriter::DEFAULT_BLOCK_SIZE,
+        unsigned flushIntervalMs = 0
+    );
+    virtual ~FdDataSink();
+    virtual void putItem(const CRingItem& item);
+    virtual void putItems(const RingItemBatch& batch);
+    virtual void flush();
+protected:
+    FdDataSink(RingItemFactoryBase* pFactory, CRingBlockWriter* pWriter);
+private:
+    FdDataSink(const FdDataSink& rhs);
+    FdDataSink& operator=(const FdDataSink& rhs);
+};
+
+}           // ufmt namespace.
+#endif
@@ -20,21 +20,64 @@
  */
 #include "FdDataSource.h"
 #include <RingItemFactoryBase.h>
+#include <CRingBlockReader.h>
+#include <CRingReadAheadReader.h>
+
+#include <unistd.h>
 
 namespace ufmt {
 /**
  * constructor
  * @param pFactory - pointer to the factory used to get items.
  * @param fd       - file descriptor open on the data source.
- *                   The caller owns this - we don't close it on destruction.
+ *                   The caller owns this (see setOwnsFd) - by default we
+ *                   don't close it on destruction.
+ * @param blockSize - If non-zero, the number of bytes to read at a time
+ *                   when block buffering.  If zero (default), each item is
+ *                   read with its own header and body reads.
+ * @param readAheadDepth - If non-zero, the number of blocks a background
+ *                   thread reads ahead of the consumer.  If blockSize is
+ *                   zero the default block size is used.
+ */
+FdDataSource::FdDataSource(
+    RingItemFactoryBase* pFactory, int fd, size_t blockSize,
+    unsigned readAheadDepth
+) :
+    DataSource(pFactory), m_fd(fd), m_pReader(nullptr), m_ownsFd(false)
+{
+    if (readAheadDepth) {
+        m_pReader = new CRingReadAheadReader(
+            fd, blockSize ? blockSize : CRingBlockReader::DEFAULT_BLOCK_SIZE,
+            readAheadDepth
+        );
+    } else if (blockSize) {
+        m_pReader = new CRingBlockReader(fd, blockSize);
+    }
+}
+/**
+ * constructor
+ *    For derived classes that supply their own block reader.
+ * @param pFactory - pointer to the factory used to get items.
+ * @param fd       - file descriptor open on the data source (not owned).
+ * @param pReader  - dynamically allocated reader of fd.  We own it.
  */
-FdDataSource::FdDataSource(RingItemFactoryBase* pFactory, int fd) :
-    DataSource(pFactory), m_fd(fd)
+FdDataSource::FdDataSource(
+    RingItemFactoryBase* pFactory, int fd, CRingBlockReader* pReader
+) :
+    DataSource(pFactory), m_fd(fd), m_pReader(pReader), m_ownsFd(false)
 {}
 /**
  * destructor
+ *    The reader goes first as a read ahead thread may still be using the
+ *    descriptor.
  */
-FdDataSource::~FdDataSource() {}
+FdDataSource::~FdDataSource()
+{
+    delete m_pReader;
+    if (m_ownsFd) {
+        close(m_fd);
+    }
+}
 
 /**
  *  getItem
@@ -45,7 +88,113 @@ FdDataSource::~FdDataSource() {}
 CRingItem*
 FdDataSource::getItem()
 {
+    if (m_pReader) {
+        return m_pFactory->getRingItem(*m_pReader);
+    }
     return m_pFactory->getRingItem(m_fd);
 }
+/**
+ * getItem
+ *    Refill an existing item with the next item.
+ *  @param item - item to fill in.
+ *  @return bool - false if there are no more items.
+ */
+bool
+FdDataSource::getItem(CRingItem& item)
+{
+    if (m_pReader) {
+        return m_pFactory->getRingItem(*m_pReader, item);
+    }
+    return m_pFactory->getRingItem(m_fd, item);
+}
+/**
+ * getItems
+ *    Get a batch of items with one factory call.  With block buffering
+ *    the whole batch usually comes from one or two reads.
+ * @param items - items to refill (see DataSource::getItems).
+ * @param maxItems - most items to get.
+ * @return size_t - number of items gotten.
+ */
+size_t
+FdDataSource::getItems(std::vector<CRingItem*>& items, size_t maxItems)
+{
+    if (m_pReader) {
+        return m_pFactory->getRingItems(*m_pReader, items, maxItems);
+    }
+    return m_pFactory->getRingItems(m_fd, items, maxItems);
+}
+
+/**
+ * setValidator
+ *    Check the items read and resynchronize after damaged data.
+ * @param pValidator - item checks (see CRingBlockReader::setValidator).
+ *                   The caller owns this; it must outlive the source or be
+ *                   replaced.  nullptr turns checking off.
+ */
+void
+FdDataSource::setValidator(const CRingItemValidator* pValidator)
+{
+    if (!m_pReader) {
+        m_pReader = new CRingBlockReader(m_fd);
+    }
+    m_pReader->setValidator(pValidator);
+}
+/**
+ * setOwnsFd
+ *    Say whether the source owns the descriptor.
+ * @param owns - if true, the descriptor is closed when the source is
+ *               destroyed (e.g. files opened by makeDataSource).
+ */
+void
+FdDataSource::setOwnsFd(bool owns)
+{
+    m_ownsFd = owns;
+}
+/**
+ * peek
+ *    Copy data from the front of the descriptor without consuming it.
+ *    The data must be kept for the item reads so the source becomes block
+ *    buffered if it isn't already.
+ * @param pDest - where to put the data.
+ * @param nBytes - most bytes wanted.
+ * @return size_t - bytes copied; may be fewer than nBytes for a live
+ *                source (see CRingBlockReader::peek).
+ */
+size_t
+FdDataSource::peek(void* pDest, size_t nBytes)
+{
+    if (!m_pReader) {
+        m_pReader = new CRingBlockReader(m_fd);
+    }
+    return m_pReader->peek(pDest, nBytes);
+}
+/**
+ * setFilter
+ *    Step over the items a filter rejects as they're read (see
+ *    CRingBlockReader::setFilter).  This needs block buffering so the
+ *    source becomes block buffered if it isn't already.
+ * @param pFilter - the filter (nullptr for none).  The caller owns it.
+ * @return bool - true, the filter is always applied.
+ */
+bool
+FdDataSource::setFilter(const CRingItemFilter* pFilter)
+{
+    if (!m_pReader) {
+        m_pReader = new CRingBlockReader(m_fd);
+    }
+    m_pReader->setFilter(pFilter);
+    return true;
+}
+/**
+ * getReader
+ * @return CRingBlockReader* - the block reader, e.g. to get the ranges
+ *                skipped by resynchronization.  nullptr if the source
+ *                isn't block buffered.
+ */
+CRingBlockReader*
+FdDataSource::getReader()
+{
+    return m_pReader;
+}
 
-}   // ufmt namespace.
\ No newline at end of file
+}   // ufmt namespace.
@@ -21,17 +21,53 @@
  *  
  */
 #include "DataSource.h"
+#include <stddef.h>
 
 namespace ufmt {
+class CRingBlockReader;
+class CRingItemValidator;
 
+/**
+ * FdDataSource
+ *    Gets ring items from a file descriptor.  If a non zero block size
+ *    is given, the descriptor is read in blocks of that size and items are
+ *    sliced out of the blocks rather than reading each header and body
+ *    separately.  If a non zero read-ahead depth is given as well, a
+ *    background thread reads that many blocks ahead of the consumer
+ *    (see CRingReadAheadReader).  setValidator makes the source check
+ *    items and skip over damaged data (see CRingBlockReader); that
+ *    needs block buffering, which is turned on if it's not already.
+ *    So do peek and setFilter.  The descriptor is the caller's unless
+ *    setOwnsFd hands it to the source.
+ */
 class FdDataSource : public DataSource
 {
 private:
     int m_fd;                         // File descrpitor data source.
+    CRingBlockReader* m_pReader;      // Non null if block buffered.
+    bool m_ownsFd;                    // Close m_fd on destruction.
 public:
-    FdDataSource(RingItemFactoryBase* pFactory, int fd);
+    FdDataSource(
+        RingItemFactoryBase* pFactory, int fd, size_t blockSize = 0,
+        unsigned readAheadDepth = 0
+    );
     virtual ~FdDataSource();
     virtual CRingItem* getItem();
+    virtual bool getItem(CRingItem& item);
+    virtual size_t getItems(std::vector<CRingItem*>& items, size_t maxItems);
+    virtual size_t peek(void* pDest, size_t nBytes);
+    virtual bool setFilter(const CRingItemFilter* pFilter);
+
+    void setValidator(const CRingItemValidator* pValidator);
+    void setOwnsFd(bool owns);
+    CRingBlockReader* getReader();
+protected:
+    FdDataSource(
+        RingItemFactoryBase* pFactory, int fd, CRingBlockReader* pReader
+    );
+private:
+    FdDataSource(const FdDataSource& rhs);
+    FdDataSource& operator=(const FdDataSource& rhs);
 };
 
 }           // ufmt namespace.
@@ -0,0 +1,298 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  IoUring.cpp
+ *  @brief: Implement the io_uring wrapper with raw system calls.
+ */
+#include "IoUring.h"
+#include <fmtconfig.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <system_error>
+#include <sys/mman.h>
+#ifdef HAVE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/syscall.h>
+#endif
+
+namespace ufmt {
+/**
+ * constructor
+ *    Set up the ring and map its queues.
+ * @param entries - number of submission queue entries; the most requests
+ *                  that can be queued at once.
+ * @throw std::system_error - io_uring could not be set up.
+ */
+IoUring::IoUring(unsigned entries) :
+    m_fd(-1), m_pSqRing(MAP_FAILED), m_sqRingSize(0),
+    m_pCqRing(MAP_FAILED), m_cqRingSize(0), m_pSqes(MAP_FAILED),
+    m_sqesSize(0), m_toSubmit(0)
+{
+#ifdef HAVE_IO_URING
+    io_uring_params params;
+    memset(&params, 0, sizeof(params));
+    m_fd = syscall(__NR_io_uring_setup, entries, &params);
+    if (m_fd < 0) {
+        throw std::system_error(
+            errno, std::generic_category(), "IoUring setting up ring"
+        );
+    }
+    // IORING_OP_READ/WRITE came with IORING_FEAT_RW_CUR_POS (5.6):
+
+    if (!(params.features & IORING_FEAT_RW_CUR_POS)) {
+        close(m_fd);
+        throw std::system_error(
+            ENOSYS, std::generic_category(), "IoUring kernel is too old"
+        );
+    }
+    m_sqRingSize = params.sq_off.array + params.sq_entries*sizeof(unsigned);
+    m_cqRingSize = params.cq_off.cqes + params.cq_entries*sizeof(io_uring_cqe);
+    m_sqesSize   = params.sq_entries*sizeof(io_uring_sqe);
+    bool single  = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+    if (single && (m_cqRingSize > m_sqRingSize)) {
+        m_sqRingSize = m_cqRingSize;
+    }
+    m_pSqRing = mmap(
+        nullptr, m_sqRingSize, PROT_READ | PROT_WRITE,
+        MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQ_RING
+    );
+    if (single) {
+        m_pCqRing = m_pSqRing;
+    } else if (m_pSqRing != MAP_FAILED) {
+        m_pCqRing = mmap(
+            nullptr, m_cqRingSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_CQ_RING
+        );
+    }
+    if (m_pCqRing != MAP_FAILED) {
+        m_pSqes = mmap(
+            nullptr, m_sqesSize, PROT_READ | PROT_WRITE,
+            MAP_SHARED | MAP_POPULATE, m_fd, IORING_OFF_SQES
+        );
+    }
+    if (m_pSqes == MAP_FAILED) {
+        int e = errno;
+        unmap();
+        close(m_fd);
+        throw std::system_error(e, std::generic_category(), "IoUring mapping ring");
+    }
+    uint8_t* pSq = static_cast<uint8_t*>(m_pSqRing);
+    uint8_t* pCq = static_cast<uint8_t*>(m_pCqRing);
+    m_pSqHead   = reinterpret_cast<unsigned*>(pSq + params.sq_off.head);
+    m_pSqTail   = reinterpret_cast<unsigned*>(pSq + params.sq_off.tail);
+    m_pSqArray  = reinterpret_cast<unsigned*>(pSq + params.sq_off.array);
+    m_sqMask    = *reinterpret_cast<unsigned*>(pSq + params.sq_off.ring_mask);
+    m_sqEntries = params.sq_entries;
+    m_pCqHead   = reinterpret_cast<unsigned*>(pCq + params.cq_off.head);
+    m_pCqTail   = reinterpret_cast<unsigned*>(pCq + params.cq_off.tail);
+    m_pCqes     = pCq + params.cq_off.cqes;
+    m_cqMask    = *reinterpret_cast<unsigned*>(pCq + params.cq_off.ring_mask);
+#else
+    throw std::system_error(
+        ENOSYS, std::generic_category(), "IoUring not supported by this build"
+    );
+#endif
+}
+/**
+ * destructor
+ *    Callers must have waited for their requests; the kernel would
+ *    otherwise still be using their buffers.
+ */
+IoUring::~IoUring()
+{
+    unmap();
+    close(m_fd);
+}
+/**
+ * available
+ *    @return bool - true if an io_uring can be made.  The answer is
+ *                   worked out once.
+ */
+bool
+IoUring::available()
+{
+    static const bool result = []() {
+        try {
+            IoUring probe(1);
+            return true;
+        }
+        catch (std::exception&) {
+            return false;
+        }
+    }();
+    return result;
+}
+/**
+ * queueRead
+ *    Queue a read at an offset.  It's not started until submit or
+ *    waitCompletion.
+ * @param fd - file descriptor to read.
+ * @param pDest - where the data goes; must stay valid until completion.
+ * @param nBytes - bytes to read.
+ * @param offset - file offset of the read.
+ * @param tag    - returned with the completion.
+ * @throw std::logic_error - the submission queue is full.
+ */
+void
+IoUring::queueRead(
+    int fd, void* pDest, size_t nBytes, uint64_t offset, uint64_t tag
+)
+{
+#ifdef HAVE_IO_URING
+    queue(IORING_OP_READ, fd, pDest, nBytes, offset, tag);
+#endif
+}
+/**
+ * queueWrite
+ *    Queue a write at an offset.  Parameters are as for queueRead;
+ *    pSrc must stay valid until completion.
+ */
+void
+IoUring::queueWrite(
+    int fd, const void* pSrc, size_t nBytes, uint64_t offset, uint64_t tag
+)
+{
+#ifdef HAVE_IO_URING
+    queue(IORING_OP_WRITE, fd, pSrc, nBytes, offset, tag);
+#endif
+}
+/**
+ * submit
+ *    Start the queued requests without waiting for any to complete.
+ */
+void
+IoUring::submit()
+{
+    if (m_toSubmit) {
+        m_toSubmit -= enter(m_toSubmit, 0, 0);
+    }
+}
+/**
+ * waitCompletion
+ *    Submit what's queued and wait for a request to complete.
+ * @param[out] tag - tag of the request that completed.
+ * @return int - the request's result: bytes transferred or -errno.
+ * @note requests can complete in any order.
+ */
+int
+IoUring::waitCompletion(uint64_t& tag)
+{
+#ifdef HAVE_IO_URING
+    while (true) {
+        unsigned head = *m_pCqHead;
+        if (head != __atomic_load_n(m_pCqTail, __ATOMIC_ACQUIRE)) {
+            const io_uring_cqe& cqe =
+                static_cast<const io_uring_cqe*>(m_pCqes)[head & m_cqMask];
+            tag        = cqe.user_data;
+            int result = cqe.res;
+            __atomic_store_n(m_pCqHead, head + 1, __ATOMIC_RELEASE);
+            return result;
+        }
+        m_toSubmit -= enter(m_toSubmit, 1, IORING_ENTER_GETEVENTS);
+    }
+#else
+    return -ENOSYS;
+#endif
+}
+/**
+ * getEntries
+ *   @return unsigned - size of the submission queue.
+ */
+unsigned
+IoUring::getEntries() const
+{
+    return m_sqEntries;
+}
+////////////////////////////////////////////////////////////////////////
+// Private methods:
+
+/**
+ * queue
+ *    Fill in the next submission queue entry and make it visible to the
+ *    kernel.
+ */
+void
+IoUring::queue(
+    unsigned opcode, int fd, const void* pBuffer, size_t nBytes,
+    uint64_t offset, uint64_t tag
+)
+{
+#ifdef HAVE_IO_URING
+    unsigned tail = *m_pSqTail;
+    if (tail - __atomic_load_n(m_pSqHead, __ATOMIC_ACQUIRE) >= m_sqEntries) {
+        throw std::logic_error("IoUring submission queue is full");
+    }
+    unsigned index = tail & m_sqMask;
+    io_uring_sqe& sqe = static_cast<io_uring_sqe*>(m_pSqes)[index];
+    memset(&sqe, 0, sizeof(sqe));
+    sqe.opcode    = opcode;
+    sqe.fd        = fd;
+    sqe.addr      = reinterpret_cast<uint64_t>(pBuffer);
+    sqe.len       = nBytes;
+    sqe.off       = offset;
+    sqe.user_data = tag;
+    m_pSqArray[index] = index;
+    __atomic_store_n(m_pSqTail, tail + 1, __ATOMIC_RELEASE);
+    m_toSubmit++;
+#endif
+}
+/**
+ * enter
+ *    io_uring_enter, retrying interrupted calls.
+ * @return int - number of entries submitted.
+ * @throw std::system_error - on failure.
+ */
+int
+IoUring::enter(unsigned toSubmit, unsigned minComplete, unsigned flags)
+{
+#ifdef HAVE_IO_URING
+    int status;
+    do {
+        status = syscall(
+            __NR_io_uring_enter, m_fd, toSubmit, minComplete, flags,
+            nullptr, 0
+        );
+    } while ((status < 0) && (errno == EINTR));
+    if (status < 0) {
+        throw std::system_error(
+            errno, std::generic_category(), "IoUring entering ring"
+        );
+    }
+    return status;
+#else
+    return 0;
+#endif
+}
+/**
+ * unmap
+ *    Release whatever parts of the ring were mapped.
+ */
+void
+IoUring::unmap()
+{
+#ifdef HAVE_IO_URING
+    if (m_pSqes != MAP_FAILED) munmap(m_pSqes, m_sqesSize);
+    if ((m_pCqRing != MAP_FAILED) && (m_pCqRing != m_pSqRing)) {
+        munmap(m_pCqRing, m_cqRingSize);
+    }
+    if (m_pSqRing != MAP_FAILED) munmap(m_pSqRing, m_sqRingSize);
+#endif
+}
+
+}   // ufmt namespace.
@@ -0,0 +1,89 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef IOURING_H
+#define IOURING_H
+/** @file:  IoUring.h
+ *  @brief: Minimal wrapper around a Linux io_uring instance.
+ */
+#include <stddef.h>
+#include <stdint.h>
+
+namespace ufmt {
+
+/**
+ * IoUring
+ *    Just enough of io_uring for the io_uring data source and sink:
+ *    queue reads and writes at explicit file offsets and wait for their
+ *    completions.  The system calls are made directly so there's no
+ *    dependency on liburing.  Each request carries a caller supplied
+ *    tag that's handed back with its completion.
+ *
+ *    Not thread safe; each instance belongs to one reader or writer.
+ *
+ * @note available() says whether io_uring can be used at all: it may be
+ *       missing from the kernel, disabled, or blocked in a container.
+ */
+class IoUring
+{
+private:
+    int       m_fd;
+    void*     m_pSqRing;
+    size_t    m_sqRingSize;
+    void*     m_pCqRing;
+    size_t    m_cqRingSize;
+    void*     m_pSqes;
+    size_t    m_sqesSize;
+    unsigned* m_pSqHead;
+    unsigned* m_pSqTail;
+    unsigned* m_pSqArray;
+    unsigned  m_sqMask;
+    unsigned  m_sqEntries;
+    unsigned* m_pCqHead;
+    unsigned* m_pCqTail;
+    void*     m_pCqes;
+    unsigned  m_cqMask;
+    unsigned  m_toSubmit;          // Queued but not yet submitted.
+public:
+    IoUring(unsigned entries);
+    virtual ~IoUring();
+private:
+    IoUring(const IoUring& rhs);
+    IoUring& operator=(const IoUring& rhs);
+public:
+    static bool available();
+
+    void queueRead(
+        int fd, void* pDest, size_t nBytes, uint64_t offset, uint64_t tag
+    );
+    void queueWrite(
+        int fd, const void* pSrc, size_t nBytes, uint64_t offset, uint64_t tag
+    );
+    void submit();
+    int  waitCompletion(uint64_t& tag);
+    unsigned getEntries() const;
+private:
+    void queue(
+        unsigned opcode, int fd, const void* pBuffer, size_t nBytes,
+        uint64_t offset, uint64_t tag
+    );
+    int  enter(unsigned toSubmit, unsigned minComplete, unsigned flags);
+    void unmap();
+};
+
+}           // ufmt namespace.
+#endif
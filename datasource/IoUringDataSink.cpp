@@ -0,0 +1,266 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  IoUringDataSink.cpp
+ *  @brief: Implementation of the io_uring data sink and its writer.
+ */
+#include "IoUringDataSink.h"
+#include "IoUringDataSource.h"
+#include <unistd.h>
+#include <stdexcept>
+#include <system_error>
+
+namespace ufmt {
+/////////////////////////////////////////////////////////////////////////
+// IoUringBlockWriter
+
+/**
+ * constructor
+ * @param fd - regular file to write (not owned).
+ * @param blockSize - bytes per write.
+ * @param depth - most writes in flight.
+ * @throw std::invalid_argument - depth or block size is zero.
+ * @throw std::system_error - io_uring could not be set up.
+ */
+IoUringBlockWriter::IoUringBlockWriter(int fd, size_t blockSize, unsigned depth) :
+    CRingBlockWriter(fd, blockSize), m_ring(depth ? depth : 1), m_inFlight(0)
+{
+    if (depth == 0) {
+        throw std::invalid_argument("IoUringBlockWriter depth must be non-zero");
+    }
+    off_t here = lseek(fd, 0, SEEK_CUR);
+    m_offset = here < 0 ? 0 : here;
+    m_writes.resize(depth);
+    for (auto& w : m_writes) {
+        w.s_pBuffer = nullptr;
+        w.s_busy    = false;
+        m_freeBuffers.push_back(new uint8_t[m_blockSize]);
+    }
+}
+/**
+ * destructor
+ *    Write what's left and wait for it.  This must be done here as the
+ *    base class destructor would use its own writeBlock.  Our buffers
+ *    are deleted except the one that's current, which the base deletes.
+ */
+IoUringBlockWriter::~IoUringBlockWriter()
+{
+    try {
+        sync();
+    }
+    catch (...) {}
+    try {
+        drain();                       // In case sync threw.
+    }
+    catch (...) {}
+    for (auto p : m_freeBuffers) {
+        delete []p;
+    }
+    for (auto& w : m_writes) {
+        delete []w.s_pBuffer;
+    }
+}
+/**
+ * sync
+ *    Write the buffer and wait for all writes to complete.  On return the
+ *    file position is just past the data written.
+ * @throw int - errno from a failed write.
+ */
+void
+IoUringBlockWriter::sync()
+{
+    flush();
+    std::lock_guard<std::mutex> s(m_lock);
+    drain();
+}
+/**
+ * writeBlock
+ *    If the data is our buffer, it's swapped for a free one and written
+ *    asynchronously.  Otherwise the data is the caller's (too big to
+ *    buffer) and we wait for it to be written.  Called with m_lock held.
+ * @param pData - data to write.
+ * @param nBytes - bytes to write.
+ * @throw int - errno from this or an earlier failed write.
+ */
+void
+IoUringBlockWriter::writeBlock(const void* pData, size_t nBytes)
+{
+    size_t slot = freeSlot();
+    Write& w = m_writes[slot];
+    w.s_pData  = static_cast<const uint8_t*>(pData);
+    w.s_nBytes = nBytes;
+    w.s_offset = m_offset;
+    m_offset  += nBytes;
+    if (pData == m_pBuffer) {
+        w.s_pBuffer = m_pBuffer;
+        m_pBuffer   = m_freeBuffers.back();
+        m_freeBuffers.pop_back();
+        start(slot);
+    } else {
+        start(slot);
+        while (w.s_busy) {
+            reap();
+        }
+    }
+}
+/**
+ * freeSlot
+ *   @return size_t - index of a write slot not in use, waiting for one if
+ *                    need be.
+ */
+size_t
+IoUringBlockWriter::freeSlot()
+{
+    while (true) {
+        for (size_t i = 0; i < m_writes.size(); i++) {
+            if (!m_writes[i].s_busy) return i;
+        }
+        reap();
+    }
+}
+/**
+ * start
+ *    Queue and submit the (remaining) write for a slot.
+ */
+void
+IoUringBlockWriter::start(size_t slot)
+{
+    Write& w = m_writes[slot];
+    w.s_busy = true;
+    m_ring.queueWrite(m_fd, w.s_pData, w.s_nBytes, w.s_offset, slot);
+    m_ring.submit();
+    m_inFlight++;
+}
+/**
+ * reap
+ *    Wait for a write to complete.  Partial writes are continued; a
+ *    finished write's buffer goes back on the free list.
+ * @throw int - errno if the write failed.
+ */
+void
+IoUringBlockWriter::reap()
+{
+    uint64_t slot;
+    int result = m_ring.waitCompletion(slot);
+    m_inFlight--;
+    Write& w = m_writes[slot];
+    if (result <= 0) {
+        w.s_busy = false;
+        if (w.s_pBuffer) {
+            m_freeBuffers.push_back(w.s_pBuffer);
+            w.s_pBuffer = nullptr;
+        }
+        throw result ? -result : EIO;
+    }
+    if (size_t(result) < w.s_nBytes) {
+        w.s_pData  += result;
+        w.s_nBytes -= result;
+        w.s_offset += result;
+        start(slot);
+        return;
+    }
+    w.s_busy = false;
+    if (w.s_pBuffer) {
+        m_freeBuffers.push_back(w.s_pBuffer);
+        w.s_pBuffer = nullptr;
+    }
+}
+/**
+ * drain
+ *    Wait for all writes and leave the file position after them.
+ */
+void
+IoUringBlockWriter::drain()
+{
+    while (m_inFlight) {
+        reap();
+    }
+    lseek(m_fd, m_offset, SEEK_SET);
+}
+
+/////////////////////////////////////////////////////////////////////////
+// IoUringDataSink
+
+/**
+ * constructor
+ * @param pFactory - factory used to put items.
+ * @param fd       - file descriptor to write (not owned).
+ * @param blockSize - bytes per write.
+ * @param depth    - most writes in flight.
+ */
+IoUringDataSink::IoUringDataSink(
+    RingItemFactoryBase* pFactory, int fd, size_t blockSize, unsigned depth
+) :
+    IoUringDataSink(pFactory, makeWriter(fd, blockSize, depth))
+{}
+/**
+ * destructor
+ */
+IoUringDataSink::~IoUringDataSink()
+{}
+/**
+ * flush
+ *    Write what's buffered and wait for the writes in flight.
+ */
+void
+IoUringDataSink::flush()
+{
+    if (m_pUringWriter) {
+        m_pUringWriter->sync();
+    } else {
+        FdDataSink::flush();
+    }
+}
+/**
+ * usingIoUring
+ *   @return bool - true if writes are done with io_uring.
+ */
+bool
+IoUringDataSink::usingIoUring() const
+{
+    return m_pUringWriter != nullptr;
+}
+/**
+ * constructor (private)
+ *    Delegated to once the writer is made.
+ */
+IoUringDataSink::IoUringDataSink(
+    RingItemFactoryBase* pFactory, CRingBlockWriter* pWriter
+) :
+    FdDataSink(pFactory, pWriter),
+    m_pUringWriter(dynamic_cast<IoUringBlockWriter*>(pWriter))
+{}
+/**
+ * makeWriter
+ *   @return CRingBlockWriter* - an IoUringBlockWriter if io_uring can be
+ *                  used, otherwise a plain CRingBlockWriter.  That's also
+ *                  the case if a ring of the requested depth can't be set
+ *                  up.
+ */
+CRingBlockWriter*
+IoUringDataSink::makeWriter(int fd, size_t blockSize, unsigned depth)
+{
+    if (IoUringDataSource::canUseIoUring(fd)) {
+        try {
+            return new IoUringBlockWriter(fd, blockSize, depth);
+        }
+        catch (std::system_error&) {}
+    }
+    return new CRingBlockWriter(fd, blockSize);
+}
+
+}   // ufmt namespace.
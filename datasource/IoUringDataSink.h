@@ -0,0 +1,102 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef IOURINGDATASINK_H
+#define IOURINGDATASINK_H
+/** @file:  IoUringDataSink.h
+ *  @brief: File data sink that keeps several writes in flight with io_uring.
+ */
+#include "FdDataSink.h"
+#include "IoUring.h"
+#include <CRingBlockWriter.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace ufmt {
+
+/**
+ * IoUringBlockWriter
+ *    A CRingBlockWriter whose full blocks are written asynchronously.
+ *    When a block is written, its buffer is handed to io_uring and a free
+ *    buffer takes its place, so items can be put while up to depth
+ *    blocks are being written.  Writes are at explicit offsets starting
+ *    from the file position at construction; sync() waits for them and
+ *    leaves the file position after the data.  Only regular files can be
+ *    written this way.
+ *
+ * @note there's no flush interval.  Errors from asynchronous writes are
+ *       thrown by a later put, flush or sync.
+ */
+class IoUringBlockWriter : public CRingBlockWriter
+{
+private:
+    struct Write {
+        uint8_t*       s_pBuffer;    // Owned buffer; null if not ours.
+        const uint8_t* s_pData;      // Data left to write.
+        size_t         s_nBytes;
+        uint64_t       s_offset;
+        bool           s_busy;
+    };
+    IoUring             m_ring;
+    std::vector<Write>  m_writes;
+    std::vector<uint8_t*> m_freeBuffers;
+    uint64_t            m_offset;        // Where the next block goes.
+    unsigned            m_inFlight;
+public:
+    IoUringBlockWriter(int fd, size_t blockSize, unsigned depth);
+    virtual ~IoUringBlockWriter();
+    void sync();
+protected:
+    virtual void writeBlock(const void* pData, size_t nBytes);
+private:
+    size_t freeSlot();
+    void   start(size_t slot);
+    void   reap();
+    void   drain();
+};
+
+/**
+ * IoUringDataSink
+ *    FdDataSink that writes through an IoUringBlockWriter.  If io_uring
+ *    is not available or the descriptor isn't a regular file, this is
+ *    just an FdDataSink.  flush() waits for the writes in flight.
+ */
+class IoUringDataSink : public FdDataSink
+{
+public:
+    static const unsigned DEFAULT_DEPTH = 4;
+private:
+    IoUringBlockWriter* m_pUringWriter;    // Null if we fell back.
+public:
+    IoUringDataSink(
+        RingItemFactoryBase* pFactory, int fd,
+        size_t blockSize = CRingBlockWriter::DEFAULT_BLOCK_SIZE,
+        unsigned depth = DEFAULT_DEPTH
+    );
+    virtual ~IoUringDataSink();
+    virtual void flush();
+    bool usingIoUring() const;
+private:
+    IoUringDataSink(
+        RingItemFactoryBase* pFactory, CRingBlockWriter* pWriter
+    );
+    static CRingBlockWriter* makeWriter(int fd, size_t blockSize, unsigned depth);
+};
+
+}           // ufmt namespace.
+#endif
@@ -0,0 +1,262 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  IoUringDataSource.cpp
+ *  @brief: Implementation of the io_uring data source and its reader.
+ */
+#include "IoUringDataSource.h"
+#include <string.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <algorithm>
+#include <stdexcept>
+#include <system_error>
+
+namespace ufmt {
+/////////////////////////////////////////////////////////////////////////
+// IoUringBlockReader
+
+/**
+ * constructor
+ *    Start depth reads beginning at the current file position.
+ * @param fd - regular file to read (not owned).
+ * @param bufferSize - bytes per read.  This is also the block size.
+ * @param depth - number of reads kept in flight.
+ * @throw std::invalid_argument - depth is zero.
+ * @throw std::system_error - io_uring could not be set up.
+ */
+IoUringBlockReader::IoUringBlockReader(int fd, size_t bufferSize, unsigned depth) :
+    CRingBlockReader(fd, bufferSize), m_ring(depth ? depth : 1),
+    m_bufferSize(bufferSize), m_nextSlot(0), m_nextOffset(0), m_inFlight(0)
+{
+    if (depth == 0) {
+        throw std::invalid_argument("IoUringBlockReader depth must be non-zero");
+    }
+    off_t here = lseek(fd, 0, SEEK_CUR);
+    m_slots.resize(depth);
+    for (auto& s : m_slots) {
+        s.s_pData = new uint8_t[m_bufferSize];
+        s.s_state = idle;
+    }
+    restart(here < 0 ? 0 : here);
+}
+/**
+ * destructor
+ *    Wait for reads still in flight; the kernel is using their buffers.
+ */
+IoUringBlockReader::~IoUringBlockReader()
+{
+    try {
+        drain();
+    }
+    catch (...) {}
+    for (auto& s : m_slots) {
+        delete []s.s_pData;
+    }
+}
+/**
+ * readBlock
+ *    Take data from the oldest read.
+ * @param pDest - where to put the data.
+ * @param nBytes - most bytes to take.
+ * @return ssize_t - bytes taken, 0 on end of file.
+ * @throw int - errno if the read failed (as CRingBlockReader::readBlock).
+ */
+ssize_t
+IoUringBlockReader::readBlock(void* pDest, size_t nBytes)
+{
+    Slot& s = m_slots[m_nextSlot];
+    if (s.s_state == idle) {                // Hit the end earlier.
+        return 0;
+    }
+    while (s.s_state == inFlight) {
+        reap();
+    }
+    if (s.s_result <= 0) {
+        int result = s.s_result;
+        drain();
+        for (auto& slot : m_slots) slot.s_state = idle;
+        if (result < 0) {
+            throw -result;
+        }
+        return 0;
+    }
+    size_t n = std::min(nBytes, size_t(s.s_result) - s.s_consumed);
+    memcpy(pDest, s.s_pData + s.s_consumed, n);
+    s.s_consumed += n;
+
+    if (s.s_consumed == size_t(s.s_result)) {
+        if (size_t(s.s_result) < m_bufferSize) {
+            // Short read - normally the end of file but the reads after
+            // this one were at the wrong offsets, so start over from here
+            // (this also picks up data appended since).
+
+            restart(s.s_offset + s.s_result);
+        } else {
+            issue(m_nextSlot);
+            m_nextSlot = (m_nextSlot + 1) % m_slots.size();
+            m_ring.submit();
+        }
+    }
+    return n;
+}
+/**
+ * skipData
+ *    The reads in flight are at fixed offsets so skipped data are taken
+ *    from them and thrown away.
+ * @param nBytes - number of bytes to skip.
+ * @return uint64_t - bytes skipped, fewer than nBytes at end of file.
+ */
+uint64_t
+IoUringBlockReader::skipData(uint64_t nBytes)
+{
+    return discardData(nBytes);
+}
+/**
+ * issue
+ *    Queue the read for a slot at the next offset.
+ * @param slot - index of the slot.
+ */
+void
+IoUringBlockReader::issue(size_t slot)
+{
+    Slot& s = m_slots[slot];
+    s.s_offset   = m_nextOffset;
+    s.s_consumed = 0;
+    s.s_result   = 0;
+    s.s_state    = inFlight;
+    m_ring.queueRead(getFd(), s.s_pData, m_bufferSize, m_nextOffset, slot);
+    m_nextOffset += m_bufferSize;
+    m_inFlight++;
+}
+/**
+ * reap
+ *    Wait for a read to complete and record its result.
+ */
+void
+IoUringBlockReader::reap()
+{
+    uint64_t slot;
+    int result = m_ring.waitCompletion(slot);
+    m_slots[slot].s_result = result;
+    m_slots[slot].s_state  = complete;
+    m_inFlight--;
+}
+/**
+ * drain
+ *    Wait for all reads in flight.
+ */
+void
+IoUringBlockReader::drain()
+{
+    while (m_inFlight) {
+        reap();
+    }
+}
+/**
+ * restart
+ *    Discard the reads in flight and issue reads for all slots starting
+ *    at an offset.
+ * @param offset - file offset of the first read.
+ */
+void
+IoUringBlockReader::restart(uint64_t offset)
+{
+    drain();
+    m_nextOffset = offset;
+    m_nextSlot   = 0;
+    for (size_t i = 0; i < m_slots.size(); i++) {
+        issue(i);
+    }
+    m_ring.submit();
+}
+
+/////////////////////////////////////////////////////////////////////////
+// IoUringDataSource
+
+/**
+ * constructor
+ * @param pFactory - pointer to the factory used to get items.
+ * @param fd       - file descriptor open on the data source (not owned).
+ * @param bufferSize - bytes per read.
+ * @param depth    - number of reads kept in flight.
+ */
+IoUringDataSource::IoUringDataSource(
+    RingItemFactoryBase* pFactory, int fd, size_t bufferSize, unsigned depth
+) :
+    IoUringDataSource(pFactory, fd, makeReader(fd, bufferSize, depth))
+{}
+/**
+ * destructor
+ */
+IoUringDataSource::~IoUringDataSource()
+{}
+/**
+ * usingIoUring
+ *   @return bool - true if reads are done with io_uring, false if
+ *                  we fell back to plain block reads.
+ */
+bool
+IoUringDataSource::usingIoUring() const
+{
+    return m_usingIoUring;
+}
+/**
+ * canUseIoUring
+ *   @param fd - a file descriptor.
+ *   @return bool - true if io_uring is available and fd is a regular file.
+ */
+bool
+IoUringDataSource::canUseIoUring(int fd)
+{
+    struct stat info;
+    if (fstat(fd, &info) || !S_ISREG(info.st_mode)) {
+        return false;
+    }
+    return IoUring::available();
+}
+/**
+ * constructor (private)
+ *    Delegated to once the reader is made.
+ */
+IoUringDataSource::IoUringDataSource(
+    RingItemFactoryBase* pFactory, int fd, CRingBlockReader* pReader
+) :
+    FdDataSource(pFactory, fd, pReader),
+    m_usingIoUring(dynamic_cast<IoUringBlockReader*>(pReader) != nullptr)
+{}
+/**
+ * makeReader
+ *   @return CRingBlockReader* - an IoUringBlockReader if io_uring can be
+ *                  used, otherwise a plain CRingBlockReader.  That's also
+ *                  the case if a ring of the requested depth can't be set
+ *                  up (e.g. the depth is over the kernel's limit).
+ */
+CRingBlockReader*
+IoUringDataSource::makeReader(int fd, size_t bufferSize, unsigned depth)
+{
+    if (canUseIoUring(fd)) {
+        try {
+            return new IoUringBlockReader(fd, bufferSize, depth);
+        }
+        catch (std::system_error&) {}
+    }
+    return new CRingBlockReader(fd, bufferSize);
+}
+
+}   // ufmt namespace.
@@ -0,0 +1,101 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef IOURINGDATASOURCE_H
+#define IOURINGDATASOURCE_H
+/** @file:  IoUringDataSource.h
+ *  @brief: File data source that keeps several reads in flight with io_uring.
+ */
+#include "FdDataSource.h"
+#include "IoUring.h"
+#include <CRingBlockReader.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+namespace ufmt {
+
+/**
+ * IoUringBlockReader
+ *    A CRingBlockReader that keeps depth reads of bufferSize bytes in
+ *    flight at successive file offsets.  readBlock hands out the data of
+ *    the oldest read, waiting only if it hasn't completed, and then
+ *    reuses its buffer for the read after the newest one.  Only regular
+ *    files can be read this way as reads are at explicit offsets.
+ */
+class IoUringBlockReader : public CRingBlockReader
+{
+private:
+    enum SlotState {idle, inFlight, complete};
+    struct Slot {
+        uint8_t*  s_pData;
+        uint64_t  s_offset;
+        int       s_result;         // Bytes read or -errno.
+        size_t    s_consumed;
+        SlotState s_state;
+    };
+    IoUring           m_ring;
+    std::vector<Slot> m_slots;
+    size_t            m_bufferSize;
+    size_t            m_nextSlot;       // Slot to consume next.
+    uint64_t          m_nextOffset;     // Offset of the next read to issue.
+    unsigned          m_inFlight;
+public:
+    IoUringBlockReader(int fd, size_t bufferSize, unsigned depth);
+    virtual ~IoUringBlockReader();
+protected:
+    virtual ssize_t readBlock(void* pDest, size_t nBytes);
+    virtual uint64_t skipData(uint64_t nBytes);
+private:
+    void issue(size_t slot);
+    void reap();
+    void drain();
+    void restart(uint64_t offset);
+};
+
+/**
+ * IoUringDataSource
+ *    FdDataSource whose block reads are done by an IoUringBlockReader so
+ *    that several large reads are in flight at once.  If io_uring is not
+ *    available or the descriptor isn't a regular file, this is just a
+ *    block buffered FdDataSource.
+ */
+class IoUringDataSource : public FdDataSource
+{
+public:
+    static const unsigned DEFAULT_DEPTH = 4;
+private:
+    bool m_usingIoUring;
+public:
+    IoUringDataSource(
+        RingItemFactoryBase* pFactory, int fd,
+        size_t bufferSize = CRingBlockReader::DEFAULT_BLOCK_SIZE,
+        unsigned depth = DEFAULT_DEPTH
+    );
+    virtual ~IoUringDataSource();
+    bool usingIoUring() const;
+
+    static bool canUseIoUring(int fd);
+private:
+    IoUringDataSource(
+        RingItemFactoryBase* pFactory, int fd, CRingBlockReader* pReader
+    );
+    static CRingBlockReader* makeReader(int fd, size_t bufferSize, unsigned depth);
+};
+
+}           // ufmt namespace.
+#endif
@@ -0,0 +1,205 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  MmapDataSource.cpp
+ *  @brief: Implementation of the memory mapped file data source.
+ */
+#include "MmapDataSource.h"
+#include <RingItemFactoryBase.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <CRingItemFilter.h>
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <errno.h>
+#include <system_error>
+#include <stdexcept>
+#include <string.h>
+
+namespace ufmt {
+/**
+ * constructor
+ *    Open and map the file.  The file descriptor is closed once the
+ *    mapping is made as the mapping does not need it.
+ * @param pFactory - pointer to the factory used to make items.
+ * @param path     - path to the event file.
+ * @param startOffset - offset of the first item to give.  Offsets past the
+ *                   end of the file give an empty source.
+ * @throw std::system_error - if the file can't be opened, stat-ed or mapped.
+ */
+MmapDataSource::MmapDataSource(
+    RingItemFactoryBase* pFactory, const std::string& path, size_t startOffset
+) :
+    DataSource(pFactory), m_pData(nullptr), m_nBytes(0), m_offset(startOffset),
+    m_pFilter(nullptr)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::system_error(
+            errno, std::generic_category(), "MmapDataSource opening file"
+        );
+    }
+    struct stat info;
+    if (fstat(fd, &info)) {
+        int error = errno;
+        close(fd);
+        throw std::system_error(
+            error, std::generic_category(), "MmapDataSource stat-ing file"
+        );
+    }
+    m_nBytes = info.st_size;
+    if (m_offset > m_nBytes) {
+        m_offset = m_nBytes;
+    }
+    if (m_nBytes) {                    // Can't map an empty file.
+        void* p = mmap(
+            nullptr, m_nBytes, PROT_READ, MAP_PRIVATE, fd, 0
+        );
+        if (p == MAP_FAILED) {
+            int error = errno;
+            close(fd);
+            throw std::system_error(
+                error, std::generic_category(), "MmapDataSource mapping file"
+            );
+        }
+        m_pData = static_cast<uint8_t*>(p);
+        madvise(m_pData, m_nBytes, MADV_SEQUENTIAL);  // Just a hint.
+    }
+    close(fd);
+}
+/**
+ * destructor
+ *    Unmap the file.  Any items still around are now invalid.
+ */
+MmapDataSource::~MmapDataSource()
+{
+    if (m_pData) {
+        munmap(m_pData, m_nBytes);
+    }
+}
+
+/**
+ *  getItem
+ *     @return CRingItem* - undifferentiated ring item dynamically created
+ *                          whose storage is in the mapping.
+ *                          nullptr if there's no more.
+ *     @note a truncated item at the end of the file is treated as an
+ *           end of file just as with the other data sources.
+ *     @throw std::runtime_error - the item size is smaller than a header.
+ */
+CRingItem*
+MmapDataSource::getItem()
+{
+    pRingItem pRaw = nextItem();
+    if (!pRaw) {
+        return nullptr;
+    }
+    
+    // Let the factory give us the right item class, then point it at the
+    // mapping.
+    
+    CRingItem* pResult = m_pFactory->makeRingItem(
+        pRaw->s_header.s_type, size_t(0)
+    );
+    pResult->useExternalStorage(pRaw);
+    return pResult;
+}
+/**
+ * getItem
+ *    Point an existing item at the next item in the mapping.  Nothing
+ *    is copied or allocated.  The item's own storage is used again if
+ *    it is later refilled from some other source.
+ * @param item - the item to point at the next item.
+ * @return bool - false if there are no more items.
+ */
+bool
+MmapDataSource::getItem(CRingItem& item)
+{
+    pRingItem pRaw = nextItem();
+    if (!pRaw) {
+        return false;
+    }
+    item.useExternalStorage(pRaw);
+    return true;
+}
+/**
+ * peek
+ *    Copy data from the mapping at the next item.
+ * @param pDest - where to put the data.
+ * @param nBytes - most bytes wanted.
+ * @return size_t - bytes copied; fewer than nBytes near the end of the file.
+ */
+size_t
+MmapDataSource::peek(void* pDest, size_t nBytes)
+{
+    size_t n = m_nBytes - m_offset;
+    if (n > nBytes) n = nBytes;
+    memcpy(pDest, m_pData + m_offset, n);
+    return n;
+}
+/**
+ * setFilter
+ *    Step over the items a filter rejects.
+ * @param pFilter - the filter (nullptr for none).  The caller owns it.
+ * @return bool - true, the filter is always applied.
+ */
+bool
+MmapDataSource::setFilter(const CRingItemFilter* pFilter)
+{
+    m_pFilter = pFilter;
+    return true;
+}
+///////////////////////////////////////////////////////////////////////////////
+// Private utilities.
+
+/**
+ * nextItem
+ *   Locate the next item in the mapping (the filter accepts) and advance
+ *   past it.
+ * @return pRingItem - pointer to the item in the mapping.
+ * @retval nullptr   - no more (complete) items.
+ * @throw std::runtime_error - the item size is smaller than a header.
+ */
+pRingItem
+MmapDataSource::nextItem()
+{
+    while (true) {
+        if (m_nBytes - m_offset < sizeof(RingItemHeader)) {
+            return nullptr;
+        }
+        pRingItem pRaw = reinterpret_cast<pRingItem>(m_pData + m_offset);
+        uint32_t  size = pRaw->s_header.s_size;
+        if (size < sizeof(RingItemHeader)) {
+            throw std::runtime_error(
+                "MmapDataSource - ring item size is smaller than a ring item header"
+            );
+        }
+        if (m_nBytes - m_offset < size) {
+            return nullptr;
+        }
+        m_offset += size;
+        if (!m_pFilter || m_pFilter->accept(pRaw)) {
+            return pRaw;
+        }
+    }
+}
+
+}   // ufmt namespace.
@@ -0,0 +1,72 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+#ifndef MMAPDATASOURCE_H
+#define MMAPDATASOURCE_H
+/** @file:  MmapDataSource.h
+ *  @brief: Data source of ring items from a memory mapped file.
+ */
+#include "DataSource.h"
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+
+namespace ufmt {
+    struct _RingItem;
+    typedef _RingItem RingItem, *pRingItem;
+
+/**
+ * MmapDataSource
+ *    Maps an event file into memory and hands out ring items whose
+ *    storage is the mapping itself (see CRingItem::useExternalStorage),
+ *    so items that are only read are never copied.  The mapping is read
+ *    only; an item is copied into its own storage the first time it is
+ *    modified (see CRingItem::makeWritable), so modifying or extending
+ *    an item touches neither the file nor the items that follow it.
+ *    With a filter (setFilter), the bodies of rejected items are not
+ *    touched so their pages are not faulted in.
+ *
+ * @note Items gotten from this source that have not been modified point
+ *       into the mapping and therefore must not be used after the data
+ *       source is destroyed.  Copy an item (e.g. with the factory's
+ *       makeRingItem) if that is needed.
+ */
+class MmapDataSource : public DataSource
+{
+private:
+    uint8_t* m_pData;                 // Start of the mapping.
+    size_t   m_nBytes;                // Size of the file/mapping.
+    size_t   m_offset;                // Offset of the next item.
+    const CRingItemFilter* m_pFilter;
+public:
+    MmapDataSource(
+        RingItemFactoryBase* pFactory, const std::string& path,
+        size_t startOffset = 0
+    );
+    virtual ~MmapDataSource();
+    virtual CRingItem* getItem();
+    virtual bool getItem(CRingItem& item);
+    virtual size_t peek(void* pDest, size_t nBytes);
+    virtual bool setFilter(const CRingItemFilter* pFilter);
+private:
+    pRingItem nextItem();
+private:
+    MmapDataSource(const MmapDataSource& rhs);
+    MmapDataSource& operator=(const MmapDataSource& rhs);
+};
+
+}           // ufmt namespace.
+#endif
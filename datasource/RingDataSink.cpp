@@ -0,0 +1,62 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  RingDataSink.cpp
+ *  @brief: Implement RingDataSink class.
+ */
+
+#include "RingDataSink.h"
+#include <RingItemFactoryBase.h>
+using namespace ufmt;
+
+/**
+ * constructor
+ *    @param pFact - factory we use to put items.
+ *    @param ring  - References the ring buffer to which items go.  It must
+ *                   be attached as the producer.
+ */
+RingDataSink::RingDataSink(RingItemFactoryBase* pFact, CRingBuffer& ring) :
+    DataSink(pFact), m_ring(ring)
+    {}
+    
+/**
+ * destructor
+ */
+RingDataSink::~RingDataSink()
+{
+    
+}
+/**
+ * putItem
+ *    Put an item into the ring buffer.  Ring buffers aren't buffered
+ *    further as consumers should see items as soon as possible.
+ * @param item - the item.
+ */
+void
+RingDataSink::putItem(const CRingItem& item)
+{
+    m_pFactory->putRingItem(&item, m_ring);
+}
+/**
+ * putItems
+ * @param batch - items to put into the ring.
+ */
+void
+RingDataSink::putItems(const RingItemBatch& batch)
+{
+    m_pFactory->putRingItem(batch, m_ring);
+}
@@ -0,0 +1,42 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef RINGDATASINK_H
+#define RINGDATASINK_H
+
+/** @file:  RingDataSink.h
+ *  @brief: Put ring items into a ringbuffer.
+ */
+
+#include "DataSink.h"
+
+
+class CRingBuffer;
+namespace ufmt {
+
+class RingDataSink : public DataSink
+{
+private:
+    CRingBuffer& m_ring;
+public:
+    RingDataSink(ufmt::RingItemFactoryBase* pFact, CRingBuffer& ring);
+    virtual ~RingDataSink();
+    virtual void putItem(const CRingItem& item);
+    virtual void putItems(const RingItemBatch& batch);
+};
+}                                     // ufmt namespace.
+#endif
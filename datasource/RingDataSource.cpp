@@ -48,4 +48,28 @@ CRingItem*
 RingDataSource::getItem()
 {
     return m_pFactory->getRingItem(m_ring);
+}
+/**
+ * getItem
+ *    Refill an existing item with the next item from the ring buffer.
+ * @param item - the item to fill in.
+ * @return bool - always true as we wait forever for data.
+ */
+bool
+RingDataSource::getItem(CRingItem& item)
+{
+    return m_pFactory->getRingItem(m_ring, item);
+}
+/**
+ * getItems
+ *    Get a batch of items from the ring buffer.  We wait for the first
+ *    item but the batch ends early if no more items are already in the ring.
+ * @param items - items to refill (see DataSource::getItems).
+ * @param maxItems - most items to get.
+ * @return size_t - number of items gotten.
+ */
+size_t
+RingDataSource::getItems(std::vector<CRingItem*>& items, size_t maxItems)
+{
+    return m_pFactory->getRingItems(m_ring, items, maxItems);
 }
\ No newline at end of file
@@ -35,6 +35,8 @@ public:
     RingDataSource(ufmt::RingItemFactoryBase* pFact, CRingBuffer& ring);
     virtual ~RingDataSource();
     virtual CRingItem* getItem();
+    virtual bool getItem(CRingItem& item);
+    virtual size_t getItems(std::vector<CRingItem*>& items, size_t maxItems);
 };
 }                                     // ufmt namespace.
 #endif
\ No newline at end of file
@@ -0,0 +1,152 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+/** @file:  RunSegmentDataSource.cpp
+ *  @brief: Implementation of the run segment data source.
+ */
+#include "RunSegmentDataSource.h"
+#include <RingItemFactoryBase.h>
+#include <CRingRangeReader.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <stdexcept>
+#include <sstream>
+#include <system_error>
+
+namespace ufmt {
+
+/**
+ * constructor
+ * @param pFactory - pointer to the factory used to get items.
+ * @param index    - index of the files holding the segment.
+ * @param run      - run number of the segment.
+ * @param segment  - segment number within the run.
+ * @param blockSize - number of bytes read at a time.
+ * @throw std::invalid_argument - the index has no such segment.
+ */
+RunSegmentDataSource::RunSegmentDataSource(
+    RingItemFactoryBase* pFactory, const CRunSegmentIndex& index,
+    uint32_t run, unsigned segment, size_t blockSize
+) :
+    DataSource(pFactory), m_files(index.getFiles()), m_nextExtent(0),
+    m_blockSize(blockSize), m_fd(-1), m_pReader(nullptr), m_pFilter(nullptr)
+{
+    const CRunSegmentIndex::Segment* pSegment = index.find(run, segment);
+    if (!pSegment) {
+        std::stringstream msg;
+        msg << "RunSegmentDataSource - there's no segment " << segment
+            << " of run " << run << " in the index";
+        throw std::invalid_argument(msg.str());
+    }
+    m_extents = pSegment->s_extents;
+}
+/**
+ * destructor
+ */
+RunSegmentDataSource::~RunSegmentDataSource()
+{
+    closeExtent();
+}
+/**
+ *  getItem
+ *     @return CRingItem* - undifferentiated ring item dynamically created.
+ *                          nullptr if there's no more in the segment.
+ */
+CRingItem*
+RunSegmentDataSource::getItem()
+{
+    while (m_pReader || nextExtent()) {
+        CRingItem* pResult = m_pFactory->getRingItem(*m_pReader);
+        if (pResult) {
+            return pResult;
+        }
+        closeExtent();
+    }
+    return nullptr;
+}
+/**
+ * getItem
+ *    Refill an existing item with the next item.
+ *  @param item - item to fill in.
+ *  @return bool - false if there are no more items in the segment.
+ */
+bool
+RunSegmentDataSource::getItem(CRingItem& item)
+{
+    while (m_pReader || nextExtent()) {
+        if (m_pFactory->getRingItem(*m_pReader, item)) {
+            return true;
+        }
+        closeExtent();
+    }
+    return false;
+}
+/**
+ * setFilter
+ *    Step over the items a filter rejects without reading their bodies.
+ * @param pFilter - the filter (nullptr for none).  The caller owns it.
+ * @return bool - true, the filter is always applied.
+ */
+bool
+RunSegmentDataSource::setFilter(const CRingItemFilter* pFilter)
+{
+    m_pFilter = pFilter;
+    if (m_pReader) {
+        m_pReader->setFilter(pFilter);
+    }
+    return true;
+}
+/**
+ * nextExtent
+ *    Start reading the next extent of the segment.
+ * @return bool - false if there are no more extents.
+ * @throw std::system_error - the extent's file can't be opened.
+ */
+bool
+RunSegmentDataSource::nextExtent()
+{
+    if (m_nextExtent >= m_extents.size()) {
+        return false;
+    }
+    const CRunSegmentIndex::Extent& e = m_extents[m_nextExtent++];
+    m_fd = open(m_files.at(e.s_file).c_str(), O_RDONLY);
+    if (m_fd < 0) {
+        throw std::system_error(
+            errno, std::generic_category(),
+            "RunSegmentDataSource opening event file"
+        );
+    }
+    m_pReader = new CRingRangeReader(m_fd, e.s_begin, e.s_end, m_blockSize);
+    m_pReader->setFilter(m_pFilter);
+    return true;
+}
+/**
+ * closeExtent
+ *    Done with the current extent.
+ */
+void
+RunSegmentDataSource::closeExtent()
+{
+    delete m_pReader;
+    m_pReader = nullptr;
+    if (m_fd >= 0) {
+        close(m_fd);
+        m_fd = -1;
+    }
+}
+
+}   // ufmt namespace.
@@ -0,0 +1,69 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+#ifndef RUNSEGMENTDATASOURCE_H
+#define RUNSEGMENTDATASOURCE_H
+/** @file:  RunSegmentDataSource.h
+ *  @brief: Data source of the items in one run segment of a set of files.
+ */
+#include "DataSource.h"
+#include <CRunSegmentIndex.h>
+#include <CRingBlockReader.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace ufmt {
+/**
+ * RunSegmentDataSource
+ *    Gives the items of one run segment located by a CRunSegmentIndex.
+ *    Only the byte ranges of the files that hold the segment are read so
+ *    the segment can be processed without reading the data before it.
+ *    The items are read from each range a block at a time by a
+ *    CRingRangeReader, which steps over the items rejected by a filter
+ *    (setFilter) without reading their bodies.
+ */
+class RunSegmentDataSource : public DataSource
+{
+private:
+    std::vector<std::string>                 m_files;
+    std::vector<CRunSegmentIndex::Extent>    m_extents;
+    size_t            m_nextExtent;
+    size_t            m_blockSize;
+    int               m_fd;             // Open on the current extent's file.
+    CRingBlockReader* m_pReader;        // Reads the current extent.
+    const CRingItemFilter* m_pFilter;
+public:
+    RunSegmentDataSource(
+        RingItemFactoryBase* pFactory, const CRunSegmentIndex& index,
+        uint32_t run, unsigned segment,
+        size_t blockSize = CRingBlockReader::DEFAULT_BLOCK_SIZE
+    );
+    virtual ~RunSegmentDataSource();
+    virtual CRingItem* getItem();
+    virtual bool getItem(CRingItem& item);
+    virtual bool setFilter(const CRingItemFilter* pFilter);
+private:
+    bool nextExtent();
+    void closeExtent();
+private:
+    RunSegmentDataSource(const RunSegmentDataSource& rhs);
+    RunSegmentDataSource& operator=(const RunSegmentDataSource& rhs);
+};
+
+}           // ufmt namespace.
+#endif
@@ -2,37 +2,90 @@
 #include "DataSource.h"
 #include "StreamDataSource.h"
 #include "FdDataSource.h"
+#include "MmapDataSource.h"
+#include "IoUringDataSource.h"
+#include "AutoFormatDataSource.h"
+#include "SourceSelector.h"
 #ifdef HAVE_NSCLDAQ
 #include "RingDataSource.h"
 #include <CRemoteAccess.h>
 #include <Exception.h>
 #endif
 #include <RingItemFactoryBase.h>
+#include <CRingBlockReader.h>
 #include "URL.h"
 
 #include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <system_error>
 #include <fstream>
 
 namespace ufmt {
     /**
-     * makeDataSource
+     * makeFileSource [static]
+     *    Make the block reading source for a file descriptor.
+     * @param pFactory - pointer to the ring item factory to use.
+     * @param fd       - descriptor open on the file (positioned).
+     * @param options  - how the blocks are read.
+     * @return FdDataSource* - dynamically allocated data source.
+     */
+    static FdDataSource*
+    makeFileSource(
+        RingItemFactoryBase* pFactory, int fd, const DataSourceOptions& options
+    )
+    {
+        size_t blockSize = options.s_readAheadBufferSize ?
+            options.s_readAheadBufferSize : CRingBlockReader::DEFAULT_BLOCK_SIZE;
+        if (options.s_ioUring) {     // Falls back to block reads.
+            return new IoUringDataSource(
+                pFactory, fd, blockSize,
+                options.s_readAheadDepth ? options.s_readAheadDepth :
+                    IoUringDataSource::DEFAULT_DEPTH
+            );
+        }
+        return new FdDataSource(
+            pFactory, fd, blockSize, options.s_readAheadDepth
+        );
+    }
+    /**
+     * makeSource [static]
      *    - parse the URI of the source
      *    - Based on the parse create the underlying connection, stream, fd, ringbuffer
      *    - Create the correcte concrete instance of DataSource given all that.
      * @param pFact - pointer to the ring item factory to use.
      * @param strUrl   - String URI of the connection.
+     * @param options  - Options that modify the kind of source made.  A start
+     *                  offset (e.g. from a CRingFileIndex) must be the offset
+     *                  of an item.  Unless they are mapped, file:// and stdin
+     *                  sources are FdDataSource objects that read blocks
+     *                  through a CRingBlockReader.  A validator makes them
+     *                  resynchronize after damaged data; it must outlive
+     *                  the source.
      * @return DataSource* - dynamically allocated data source.
      * @throw std::exception derived exception on failure -- which can come from
      *          not being able to form the underlying connection
      */
-    DataSource*
-    makeDataSource(RingItemFactoryBase* pFactory, const std::string& strUrl)
+    static DataSource*
+    makeSource(
+        RingItemFactoryBase* pFactory, const std::string& strUrl,
+        const DataSourceOptions& options
+    )
     {
         // Special case the url is just "-"  then it's stdin, a file descriptor
         // data source:
         
         if (strUrl == "-") {
-            return new FdDataSource(pFactory, STDIN_FILENO);   
+            FdDataSource* pSource = new FdDataSource(
+                pFactory, STDIN_FILENO, options.s_readAheadBufferSize ?
+                    options.s_readAheadBufferSize :
+                    CRingBlockReader::DEFAULT_BLOCK_SIZE,
+                options.s_readAheadDepth
+            );
+            if (options.s_pValidator) {
+                pSource->setValidator(options.s_pValidator);
+            }
+            return pSource;
         }
         // Parse the URI:
         
@@ -56,9 +109,69 @@ namespace ufmt {
     #endif
         } else {
             std::string path = uri.getPath();
+            if (options.s_mapFiles && !options.s_pValidator && (protocol == "file")) {
+                return new MmapDataSource(pFactory, path, options.s_startOffset);
+            }
+            if (protocol == "file") {
+                // Files are read a block at a time through a CRingBlockReader
+                // (or one of its read ahead/io_uring flavors), never an item
+                // at a time.
+                
+                int fd = open(path.c_str(), O_RDONLY);  // The source closes it.
+                if (fd < 0) {
+                    throw std::system_error(
+                        errno, std::generic_category(), "Opening file"
+                    );
+                }
+                if (lseek(fd, options.s_startOffset, SEEK_SET) < 0) {
+                    int error = errno;
+                    close(fd);
+                    throw std::system_error(
+                        error, std::generic_category(), "Positioning file"
+                    );
+                }
+                FdDataSource* pSource;
+                try {
+                    pSource = makeFileSource(pFactory, fd, options);
+                }
+                catch (...) {
+                    close(fd);
+                    throw;
+                }
+                pSource->setOwnsFd(true);
+                if (options.s_pValidator) {
+                    pSource->setValidator(options.s_pValidator);
+                }
+                return pSource;
+            }
             std::ifstream& in(*(new std::ifstream(path.c_str())));  // Need it to last past block.
+            if (options.s_startOffset) {
+                in.seekg(options.s_startOffset);
+            }
             return new StreamDataSource(pFactory, in);
         }
 
     }
-}
\ No newline at end of file
+    /**
+     * makeDataSource
+     *    Make the source described by a URI (see makeSource) and, if
+     *    requested, wrap it in an AutoFormatDataSource so that the format
+     *    of the data selects the factory.
+     * @param pFactory - factory to use (the fallback if the format is detected).
+     * @param strUrl   - String URI of the connection.
+     * @param options  - Options that modify the kind of source made.
+     * @return DataSource* - dynamically allocated data source.
+     */
+    DataSource*
+    makeDataSource(
+        RingItemFactoryBase* pFactory, const std::string& strUrl,
+        const DataSourceOptions& options
+    )
+    {
+        DataSource* pSource = makeSource(pFactory, strUrl, options);
+        if (options.s_autoFormat) {
+            pSource = new AutoFormatDataSource(pSource);
+        }
+        return pSource;
+    }
+}
@@ -1,12 +1,40 @@
 #ifndef SOURCESELECTOR_H
 #define SOURCESELECTOR_H
 #include <string>
-class DataSource;
-class RingItemFactoryBase;
+#include <stddef.h>
+#include <stdint.h>
 
 namespace ufmt {
+    class DataSource;
+    class RingItemFactoryBase;
+    class CRingItemValidator;
+    
+    /**
+     * DataSourceOptions
+     *    Optional choices about how makeDataSource builds the data source.
+     *    The defaults give block read file and stdin sources.
+     */
+    struct DataSourceOptions {
+        bool     s_mapFiles;           // file:// sources are memory mapped.
+        unsigned s_readAheadDepth;     // Non zero - blocks read ahead.
+        size_t   s_readAheadBufferSize; // 0 - default block size.
+        bool     s_ioUring;            // file:// sources use io_uring if possible.
+        uint64_t s_startOffset;        // File sources start at this offset.
+        const CRingItemValidator* s_pValidator;  // Non null - file and stdin
+                                       // sources skip damaged data.
+        bool     s_autoFormat;         // Data format selects the factory.
+        DataSourceOptions() :
+            s_mapFiles(false), s_readAheadDepth(0), s_readAheadBufferSize(0),
+            s_ioUring(false), s_startOffset(0), s_pValidator(nullptr),
+            s_autoFormat(false)
+        {}
+    };
+    
     DataSource*
-    makeDataSource(RingItemFactoryBase* pFactory, const std::string& strUrl);
+    makeDataSource(
+        RingItemFactoryBase* pFactory, const std::string& strUrl,
+        const DataSourceOptions& options = DataSourceOptions()
+    );
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,68 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  StreamDataSink.cpp
+ *  @brief:  Implement the stream data sink.
+ */
+#include "StreamDataSink.h"
+#include <RingItemFactoryBase.h>
+namespace ufmt {
+
+/**
+ * constructor
+ *    @param pFactory - factory for ring items.
+ *    @param str     - references stream to which ring items are put.
+ *                     Streams do their own buffering.
+ */
+StreamDataSink::StreamDataSink(RingItemFactoryBase* pFactory, std::ostream& str) :
+    DataSink(pFactory), m_str(str)
+{}
+
+/**
+ * destructor
+ */
+StreamDataSink::~StreamDataSink() {}
+
+/**
+ * putItem
+ *  @param item - item to put to the stream.
+ */
+void
+StreamDataSink::putItem(const CRingItem& item)
+{
+    m_pFactory->putRingItem(&item, m_str);
+}
+/**
+ * putItems
+ *  @param batch - items to put to the stream.
+ */
+void
+StreamDataSink::putItems(const RingItemBatch& batch)
+{
+    m_pFactory->putRingItem(batch, m_str);
+}
+/**
+ * flush
+ *   Flush the stream.
+ */
+void
+StreamDataSink::flush()
+{
+    m_str.flush();
+}
+
+}                 // namespace ufmt
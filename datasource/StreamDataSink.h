@@ -0,0 +1,41 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+#ifndef STREAMDATASINK_H
+#define STREAMDATASINK_H
+/** @file:  StreamDataSink.h
+ *  @brief: Defines a class that puts ring items to a stream.
+ */
+#include "DataSink.h"
+#include <ostream>
+
+namespace ufmt {
+
+class StreamDataSink : public DataSink
+{
+private:
+    std::ostream& m_str;
+public:
+    StreamDataSink(RingItemFactoryBase* pFactory, std::ostream& str);
+    virtual ~StreamDataSink();
+    virtual void putItem(const CRingItem& item);
+    virtual void putItems(const RingItemBatch& batch);
+    virtual void flush();
+};
+
+}                    // namespace ufmt
+#endif
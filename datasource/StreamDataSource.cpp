@@ -46,5 +46,47 @@ StreamDataSource::getItem()
 {
     return m_pFactory->getRingItem(m_str);
 }
+/**
+ * getItem
+ *  @param item - existing item to refill with the next item from the stream.
+ *  @return bool - false if there are no more items.
+ */
+bool
+StreamDataSource::getItem(CRingItem& item)
+{
+    return m_pFactory->getRingItem(m_str, item);
+}
+/**
+ * getItems
+ *  @param items - items to refill with the next batch (see DataSource::getItems).
+ *  @param maxItems - most items to get.
+ *  @return size_t - number of items gotten.
+ */
+size_t
+StreamDataSource::getItems(std::vector<CRingItem*>& items, size_t maxItems)
+{
+    return m_pFactory->getRingItems(m_str, items, maxItems);
+}
+/**
+ * peek
+ *    Read from the stream and seek back.  This only works for seekable
+ *    streams (files, string streams).
+ *  @param pDest - where to put the data.
+ *  @param nBytes - most bytes wanted.
+ *  @return size_t - bytes copied, 0 if the stream can't seek.
+ */
+size_t
+StreamDataSource::peek(void* pDest, size_t nBytes)
+{
+    std::istream::pos_type here = m_str.tellg();
+    if (here == std::istream::pos_type(-1)) {
+        return 0;
+    }
+    m_str.read(reinterpret_cast<char*>(pDest), nBytes);
+    size_t n = m_str.gcount();
+    m_str.clear();
+    m_str.seekg(here);
+    return n;
+}
 
 }                 // namespace ufmt
\ No newline at end of file
@@ -32,6 +32,9 @@ public:
     StreamDataSource(RingItemFactoryBase* pFactory, std::istream& str);
     virtual ~StreamDataSource();
     virtual CRingItem* getItem();
+    virtual bool getItem(CRingItem& item);
+    virtual size_t getItems(std::vector<CRingItem*>& items, size_t maxItems);
+    virtual size_t peek(void* pDest, size_t nBytes);
 };
 
 }                    // namespace ufmt
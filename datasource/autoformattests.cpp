@@ -0,0 +1,164 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  autoformattests.cpp
+ *  @brief: Test the format detecting data source wrapper.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include <Asserts.h>
+#include "AutoFormatDataSource.h"
+#include "MmapDataSource.h"
+#include "FdDataSource.h"
+#include <CRingBlockReader.h>
+#include <CRingItemValidator.h>
+#include <CPhysicsEventItem.h>
+#include <CRingStateChangeItem.h>
+#include <NSCLDAQFormatFactorySelector.h>
+#include <RingItemFactoryBase.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace ufmt;
+
+class autoformattest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(autoformattest);
+    CPPUNIT_TEST(setfactory_1);
+    CPPUNIT_TEST(setfactory_2);
+    CPPUNIT_TEST(validator_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_file;
+public:
+    void setUp() {
+        char name[] = "/tmp/autoformattestXXXXXX";
+        int fd = mkstemp(name);
+        m_file = name;
+        
+        // A couple of physics items without body headers:
+        
+        std::vector<uint8_t> item(sizeof(RingItemHeader) + 2*sizeof(uint32_t), 0);
+        RingItemHeader* pH = reinterpret_cast<RingItemHeader*>(item.data());
+        pH->s_size = item.size();
+        pH->s_type = PHYSICS_EVENT;
+        item[sizeof(RingItemHeader)] = sizeof(uint32_t);
+        write(fd, item.data(), item.size());
+        write(fd, item.data(), item.size());
+        close(fd);
+    }
+    void tearDown() {
+        unlink(m_file.c_str());
+    }
+protected:
+    void setfactory_1();
+    void setfactory_2();
+    void validator_1();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(autoformattest);
+
+// Setting the factory is passed on to the wrapped source:
+
+void autoformattest::setfactory_1()
+{
+    AutoFormatDataSource source(new MmapDataSource(
+        FormatSelector::makeFactory(FormatSelector::v12), m_file
+    ));
+    RingItemFactoryBase* pFactory =
+        FormatSelector::makeFactory(FormatSelector::v10);
+    source.setFactory(pFactory);
+    EQ(pFactory, source.getFactory());
+    EQ(pFactory, source.getSource()->getFactory());
+    EQ(FormatSelector::v10, source.getVersion());
+}
+// Including when called through the base class:
+
+void autoformattest::setfactory_2()
+{
+    std::unique_ptr<DataSource> pSource(new AutoFormatDataSource(
+        new MmapDataSource(
+            FormatSelector::makeFactory(FormatSelector::v12), m_file
+        )
+    ));
+    RingItemFactoryBase* pFactory =
+        FormatSelector::makeFactory(FormatSelector::v11);
+    pSource->setFactory(pFactory);
+    EQ(pFactory, pSource->getFactory());
+    
+    std::unique_ptr<CRingItem> pItem(pSource->getItem());
+    ASSERT(pItem.get());
+    EQ(PHYSICS_EVENT, pItem->type());
+    EQ(FormatSelector::v11, pSource->getFactory()->version());
+}
+// Detecting v10 data retargets a v12 validator so v10 items, whose first
+// body word would be a bad v12 body header size, aren't skipped:
+
+void autoformattest::validator_1()
+{
+    char name[] = "/tmp/autoformattestXXXXXX";
+    int fd = mkstemp(name);
+    RingItemFactoryBase* pFact10 =
+        FormatSelector::makeFactory(FormatSelector::v10);
+    std::vector<CRingItem*> items;
+    items.push_back(pFact10->makeStateChangeItem(BEGIN_RUN, 1, 0, 0, "A title"));
+    for (int i = 0; i < 3; i++) {
+        CPhysicsEventItem* pEvent = pFact10->makePhysicsEventItem(100);
+        uint32_t* p = reinterpret_cast<uint32_t*>(pEvent->getBodyCursor());
+        *p++ = 12345;
+        pEvent->setBodyCursor(p);
+        pEvent->updateSize();
+        items.push_back(pEvent);
+    }
+    for (auto pItem : items) {
+        write(fd, pItem->getItemPointer(), pItem->size());
+        delete pItem;
+    }
+    delete pFact10;
+    lseek(fd, 0, SEEK_SET);
+    
+    CRingItemValidator validator(FormatSelector::v12);
+    FdDataSource* pFdSource = new FdDataSource(
+        FormatSelector::makeFactory(FormatSelector::v12), fd,
+        CRingBlockReader::DEFAULT_BLOCK_SIZE
+    );
+    pFdSource->setValidator(&validator);
+    AutoFormatDataSource source(pFdSource);
+    EQ(FormatSelector::v10, source.getVersion());
+    const CRingItemValidator* pValidator =
+        pFdSource->getReader()->getValidator();
+    ASSERT(pValidator != &validator);
+    EQ(FormatSelector::v10, pValidator->getVersion());
+    EQ(validator.getMaxItemSize(), pValidator->getMaxItemSize());
+    
+    size_t n = 0;
+    while (std::unique_ptr<CRingItem>(source.getItem()).get()) {
+        n++;
+    }
+    EQ(size_t(4), n);
+    EQ(uint64_t(0), pFdSource->getReader()->getSkippedBytes());
+    close(fd);
+    unlink(name);
+}
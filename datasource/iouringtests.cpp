@@ -0,0 +1,165 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  iouringtests.cpp
+ *  @brief: Test the io_uring data source and sink.
+ */
+#include <fmtconfig.h>
+#ifdef HAVE_IO_URING
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include <Asserts.h>
+#include "IoUringDataSource.h"
+#include "IoUringDataSink.h"
+#include "IoUring.h"
+#include <NSCLDAQFormatFactorySelector.h>
+#include <RingItemFactoryBase.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <memory>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace ufmt;
+
+class iouringtest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(iouringtest);
+    CPPUNIT_TEST(roundtrip_1);
+    CPPUNIT_TEST(fallback_1);
+    CPPUNIT_TEST(fallback_2);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    RingItemFactoryBase* m_pFactory;
+    char                 m_name[100];
+    int                  m_fd;
+public:
+    void setUp() {
+        m_pFactory = &FormatSelector::selectFactory(FormatSelector::v12);
+        strcpy(m_name, "/tmp/iouringtestXXXXXX");
+        m_fd = mkstemp(m_name);
+    }
+    void tearDown() {
+        close(m_fd);
+        unlink(m_name);
+    }
+protected:
+    void roundtrip_1();
+    void fallback_1();
+    void fallback_2();
+private:
+    RingItemFactoryBase* newFactory();
+    void writeItems(DataSink& sink, unsigned n);
+    void checkItems(DataSource& source, unsigned n);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(iouringtest);
+
+// Sources own their factories:
+
+RingItemFactoryBase*
+iouringtest::newFactory()
+{
+    return FormatSelector::makeFactory(FormatSelector::v12);
+}
+
+// Item i has i % 500 + 1 body words of i, so items straddle the blocks:
+
+void
+iouringtest::writeItems(DataSink& sink, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        std::unique_ptr<CRingItem> item(
+            m_pFactory->makeRingItem(PHYSICS_EVENT, size_t(2048))
+        );
+        uint32_t* p = reinterpret_cast<uint32_t*>(item->getBodyCursor());
+        for (unsigned w = 0; w < i % 500 + 1; w++) {
+            *p++ = i;
+        }
+        item->setBodyCursor(p);
+        item->updateSize();
+        sink.putItem(*item);
+    }
+    sink.flush();
+}
+void
+iouringtest::checkItems(DataSource& source, unsigned n)
+{
+    for (unsigned i = 0; i < n; i++) {
+        std::unique_ptr<CRingItem> item(source.getItem());
+        ASSERT(item.get());
+        EQ(PHYSICS_EVENT, item->type());
+        EQ(size_t((i % 500 + 1)*sizeof(uint32_t)), item->getBodySize());
+        const uint32_t* p =
+            reinterpret_cast<const uint32_t*>(item->getBodyPointer());
+        EQ(i, p[0]);
+        EQ(i, p[i % 500]);
+    }
+    std::unique_ptr<CRingItem> item(source.getItem());
+    ASSERT(!item.get());
+}
+// Items written with several writes in flight read back with several
+// reads in flight:
+
+void iouringtest::roundtrip_1()
+{
+    {
+        IoUringDataSink sink(m_pFactory, m_fd, 4096, 4);
+        EQ(IoUring::available(), sink.usingIoUring());
+        writeItems(sink, 1000);
+    }
+    lseek(m_fd, 0, SEEK_SET);
+    IoUringDataSource source(newFactory(), m_fd, 4096, 4);
+    EQ(IoUring::available(), source.usingIoUring());
+    checkItems(source, 1000);
+}
+// If a ring can't be set up (here the depth is over the kernel's limit)
+// the plain block reader and writer are used:
+
+void iouringtest::fallback_1()
+{
+    {
+        IoUringDataSink sink(m_pFactory, m_fd, 4096, 1000000);
+        ASSERT(!sink.usingIoUring());
+        writeItems(sink, 100);
+    }
+    lseek(m_fd, 0, SEEK_SET);
+    IoUringDataSource source(newFactory(), m_fd, 4096, 1000000);
+    ASSERT(!source.usingIoUring());
+    checkItems(source, 100);
+}
+// Descriptors that aren't regular files aren't read with io_uring:
+
+void iouringtest::fallback_2()
+{
+    int pipes[2];
+    ASSERT(pipe(pipes) == 0);
+    {
+        IoUringDataSink sink(m_pFactory, pipes[1], 4096, 4);
+        ASSERT(!sink.usingIoUring());
+        writeItems(sink, 10);               // Fits in the pipe.
+    }
+    close(pipes[1]);
+    IoUringDataSource source(newFactory(), pipes[0], 4096, 4);
+    ASSERT(!source.usingIoUring());
+    checkItems(source, 10);
+    close(pipes[0]);
+}
+#endif
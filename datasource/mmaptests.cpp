@@ -0,0 +1,165 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  mmaptests.cpp
+ *  @brief: Test the memory mapped file data source.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include <Asserts.h>
+#include "MmapDataSource.h"
+#include <NSCLDAQFormatFactorySelector.h>
+#include <RingItemFactoryBase.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace ufmt;
+
+class mmaptest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(mmaptest);
+    CPPUNIT_TEST(read_1);
+    CPPUNIT_TEST(grow_1);
+    CPPUNIT_TEST(grow_2);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_file;
+    std::vector<uint8_t> m_contents;      // What was written.
+public:
+    void setUp() {
+        char name[] = "/tmp/mmaptestXXXXXX";
+        int fd = mkstemp(name);
+        m_file = name;
+        m_contents.clear();
+        for (uint32_t i = 0; i < 3; i++) {
+            addItem(PHYSICS_EVENT, 4*(i+1), uint8_t(i+1));
+        }
+        write(fd, m_contents.data(), m_contents.size());
+        close(fd);
+    }
+    void tearDown() {
+        unlink(m_file.c_str());
+    }
+protected:
+    void read_1();
+    void grow_1();
+    void grow_2();
+private:
+    void addItem(uint32_t type, uint32_t bodyBytes, uint8_t fill);
+    std::vector<uint8_t> fileContents();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(mmaptest);
+
+// Add an item without a body header whose body bytes are all fill:
+
+void
+mmaptest::addItem(uint32_t type, uint32_t bodyBytes, uint8_t fill)
+{
+    std::vector<uint8_t> item(sizeof(RingItemHeader) + sizeof(uint32_t), 0);
+    item.resize(item.size() + bodyBytes, fill);
+    RingItemHeader* pH = reinterpret_cast<RingItemHeader*>(item.data());
+    pH->s_size = item.size();
+    pH->s_type = type;
+    item[sizeof(RingItemHeader)] = sizeof(uint32_t);
+    m_contents.insert(m_contents.end(), item.begin(), item.end());
+}
+// Read back the whole file:
+
+std::vector<uint8_t>
+mmaptest::fileContents()
+{
+    std::vector<uint8_t> result(m_contents.size() + 1);
+    FILE* fp = fopen(m_file.c_str(), "r");
+    result.resize(fread(result.data(), 1, result.size(), fp));
+    fclose(fp);
+    return result;
+}
+
+// Items that are only read point into the mapping:
+
+void mmaptest::read_1()
+{
+    MmapDataSource source(
+        FormatSelector::makeFactory(FormatSelector::v12), m_file
+    );
+    for (uint32_t i = 0; i < 3; i++) {
+        std::unique_ptr<const CRingItem> pItem(source.getItem());
+        ASSERT(pItem.get());
+        ASSERT(pItem->isExternalStorage());
+        EQ(uint32_t(sizeof(RingItemHeader) + sizeof(uint32_t) + 4*(i+1)), pItem->size());
+    }
+    ASSERT(!source.getItem());
+}
+// Growing an item copies it so the item that follows is still intact:
+
+void mmaptest::grow_1()
+{
+    MmapDataSource source(
+        FormatSelector::makeFactory(FormatSelector::v12), m_file
+    );
+    std::unique_ptr<CRingItem> pFirst(source.getItem());
+    uint8_t more[64];
+    memset(more, 0xaa, sizeof(more));
+    pFirst->appendBodyData(more, sizeof(more));
+    ASSERT(!pFirst->isExternalStorage());
+    EQ(uint32_t(sizeof(RingItemHeader) + sizeof(uint32_t) + 4 + sizeof(more)), pFirst->size());
+    
+    std::unique_ptr<CRingItem> pSecond(source.getItem());
+    ASSERT(pSecond.get());
+    EQ(PHYSICS_EVENT, pSecond->type());
+    EQ(uint32_t(sizeof(RingItemHeader) + sizeof(uint32_t) + 8), pSecond->size());
+    const uint8_t* p = reinterpret_cast<const uint8_t*>(
+        static_cast<const CRingItem&>(*pSecond).getItemPointer()
+    ) + sizeof(RingItemHeader) + sizeof(uint32_t);
+    for (int i = 0; i < 8; i++) {
+        EQ(uint8_t(2), p[i]);
+    }
+    ASSERT(fileContents() == m_contents);
+}
+// Same for items refilled by the source:
+
+void mmaptest::grow_2()
+{
+    MmapDataSource source(
+        FormatSelector::makeFactory(FormatSelector::v12), m_file
+    );
+    std::unique_ptr<CRingItem> pItem(
+        FormatSelector::selectFactory(FormatSelector::v12).makeRingItem(
+            PHYSICS_EVENT, size_t(100)
+        )
+    );
+    ASSERT(source.getItem(*pItem));
+    uint32_t* pCursor = static_cast<uint32_t*>(pItem->getBodyCursor());
+    *pCursor++ = 0xdeadbeef;
+    pItem->setBodyCursor(pCursor);
+    pItem->updateSize();
+    
+    ASSERT(source.getItem(*pItem));
+    ASSERT(pItem->isExternalStorage());
+    EQ(uint32_t(sizeof(RingItemHeader) + sizeof(uint32_t) + 8), pItem->size());
+    ASSERT(fileContents() == m_contents);
+}
@@ -0,0 +1,179 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  segmenttests.cpp
+ *  @brief: Test the run segment data source.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include <Asserts.h>
+#include <TestItems.h>
+#include "RunSegmentDataSource.h"
+#include <CRunSegmentIndex.h>
+#include <NSCLDAQFormatFactorySelector.h>
+#include <RingItemFactoryBase.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <v12/DataFormat.h>
+#include <v12/RingViewDecoder.h>
+#include <memory>
+#include <stdexcept>
+#include <system_error>
+#include <string>
+#include <vector>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+using namespace ufmt;
+
+class segmenttest : public CppUnit::TestFixture, public testitems::RunFiles {
+    CPPUNIT_TEST_SUITE(segmenttest);
+    CPPUNIT_TEST(boundary_1);
+    CPPUNIT_TEST(boundary_2);
+    CPPUNIT_TEST(nonzero_1);
+    CPPUNIT_TEST(missing_1);
+    CPPUNIT_TEST(missing_2);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    RingItemFactoryBase*     m_pFactory;
+    CRunSegmentIndex         m_index;
+public:
+    void setUp() {
+        m_pFactory = &FormatSelector::selectFactory(FormatSelector::v12);
+        writeRuns();
+        m_index.build(m_files, v12::RingViewDecoder());
+    }
+    void tearDown() {
+        clear();
+    }
+protected:
+    void boundary_1();
+    void boundary_2();
+    void nonzero_1();
+    void missing_1();
+    void missing_2();
+private:
+    RingItemFactoryBase* newFactory();
+    std::vector<uint32_t> readTypes(DataSource& source);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(segmenttest);
+
+// Sources own their factories:
+
+RingItemFactoryBase*
+segmenttest::newFactory()
+{
+    return FormatSelector::makeFactory(FormatSelector::v12);
+}
+
+// Types of the items left in a source.  Physics items are given as
+// PHYSICS_EVENT + their body size after checking the body contents:
+
+std::vector<uint32_t>
+segmenttest::readTypes(DataSource& source)
+{
+    std::vector<uint32_t> result;
+    std::unique_ptr<CRingItem> pItem;
+    while (pItem.reset(source.getItem()), pItem) {
+        uint32_t type = pItem->type();
+        if (type == PHYSICS_EVENT) {
+            size_t n = pItem->getBodySize();
+            const uint8_t* p =
+                reinterpret_cast<const uint8_t*>(pItem->getBodyPointer());
+            for (size_t i = 0; i < n; i++) {
+                EQ(uint8_t(n), p[i]);
+            }
+            type += n;
+        }
+        result.push_back(type);
+    }
+    return result;
+}
+
+// The resumed segment of run 7 is read across the boundary between the
+// files:
+
+void segmenttest::boundary_1()
+{
+    RunSegmentDataSource source(newFactory(), m_index, 7, 1);
+    std::vector<uint32_t> types = readTypes(source);
+    std::vector<uint32_t> expected = {
+        RESUME_RUN, PHYSICS_EVENT + 20, PHYSICS_EVENT + 21,
+        PHYSICS_EVENT + 22, PHYSICS_EVENT + 23, END_RUN
+    };
+    ASSERT(types == expected);
+}
+// Same with blocks smaller than the items, filling in one item:
+
+void segmenttest::boundary_2()
+{
+    RunSegmentDataSource source(newFactory(), m_index, 7, 1, 16);
+    std::unique_ptr<CRingItem> pItem(m_pFactory->makeRingItem(PHYSICS_EVENT, size_t(8)));
+    std::vector<uint32_t> types;
+    while (source.getItem(*pItem)) {
+        types.push_back(pItem->type());
+    }
+    std::vector<uint32_t> expected = {
+        RESUME_RUN, PHYSICS_EVENT, PHYSICS_EVENT, PHYSICS_EVENT, PHYSICS_EVENT,
+        END_RUN
+    };
+    ASSERT(types == expected);
+    ASSERT(!source.getItem(*pItem));
+}
+// Segments that don't start at the front of the data are read without
+// the items before them:
+
+void segmenttest::nonzero_1()
+{
+    RunSegmentDataSource run8(newFactory(), m_index, 8, 0);
+    std::vector<uint32_t> types = readTypes(run8);
+    std::vector<uint32_t> expected = {
+        BEGIN_RUN, PHYSICS_EVENT + 30, END_RUN
+    };
+    ASSERT(types == expected);
+
+    RunSegmentDataSource run7(newFactory(), m_index, 7, 0);
+    types = readTypes(run7);
+    expected = {
+        BEGIN_RUN, PHYSICS_EVENT + 10, PHYSICS_EVENT + 11,
+        PHYSICS_EVENT + 12, PAUSE_RUN
+    };
+    ASSERT(types == expected);
+}
+// Segments that aren't in the index:
+
+void segmenttest::missing_1()
+{
+    EXCEPTION(
+        RunSegmentDataSource(newFactory(), m_index, 7, 2), std::invalid_argument
+    );
+    EXCEPTION(
+        RunSegmentDataSource(newFactory(), m_index, 9, 0), std::invalid_argument
+    );
+}
+// Segments whose files have gone away:
+
+void segmenttest::missing_2()
+{
+    unlink(m_files.back().c_str());
+    RunSegmentDataSource source(newFactory(), m_index, 8, 0);
+    EXCEPTION(delete source.getItem(), std::system_error&);
+}
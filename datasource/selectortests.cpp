@@ -0,0 +1,160 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  selectortests.cpp
+ *  @brief: Test the kinds of sources makeDataSource makes for files.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include <Asserts.h>
+#include "SourceSelector.h"
+#include "FdDataSource.h"
+#include "MmapDataSource.h"
+#include <NSCLDAQFormatFactorySelector.h>
+#include <CRingBlockReader.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <memory>
+#include <string>
+#include <vector>
+#include <stdint.h>
+#include <stdlib.h>
+#include <dirent.h>
+#include <unistd.h>
+
+using namespace ufmt;
+
+class srcselecttest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(srcselecttest);
+    CPPUNIT_TEST(file_1);
+    CPPUNIT_TEST(file_2);
+    CPPUNIT_TEST(file_3);
+    CPPUNIT_TEST(file_4);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    std::string m_file;
+public:
+    void setUp() {
+        char name[] = "/tmp/srcselecttestXXXXXX";
+        int fd = mkstemp(name);
+        m_file = name;
+        
+        // Ten physics items without body headers:
+        
+        std::vector<uint8_t> item(sizeof(RingItemHeader) + 2*sizeof(uint32_t), 0);
+        RingItemHeader* pH = reinterpret_cast<RingItemHeader*>(item.data());
+        pH->s_size = item.size();
+        pH->s_type = PHYSICS_EVENT;
+        item[sizeof(RingItemHeader)] = sizeof(uint32_t);
+        for (int i = 0; i < 10; i++) {
+            write(fd, item.data(), item.size());
+        }
+        close(fd);
+    }
+    void tearDown() {
+        unlink(m_file.c_str());
+    }
+protected:
+    void file_1();
+    void file_2();
+    void file_3();
+    void file_4();
+private:
+    size_t countItems(DataSource& source);
+    size_t openFds();
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(srcselecttest);
+
+size_t
+srcselecttest::countItems(DataSource& source)
+{
+    size_t n = 0;
+    while (std::unique_ptr<CRingItem>(source.getItem()).get()) {
+        n++;
+    }
+    return n;
+}
+
+size_t
+srcselecttest::openFds()
+{
+    size_t n = 0;
+    DIR* pDir = opendir("/proc/self/fd");
+    while (readdir(pDir)) {
+        n++;
+    }
+    closedir(pDir);
+    return n;
+}
+
+// By default files are read by blocks:
+
+void srcselecttest::file_1()
+{
+    std::unique_ptr<DataSource> pSource(makeDataSource(
+        FormatSelector::makeFactory(FormatSelector::v12), "file://" + m_file
+    ));
+    FdDataSource* pFdSource = dynamic_cast<FdDataSource*>(pSource.get());
+    ASSERT(pFdSource);
+    ASSERT(pFdSource->getReader());
+    EQ(size_t(10), countItems(*pSource));
+}
+// The block size can be chosen and the start offset is honored:
+
+void srcselecttest::file_2()
+{
+    DataSourceOptions options;
+    options.s_readAheadBufferSize = 64;
+    options.s_startOffset = 4*(sizeof(RingItemHeader) + 2*sizeof(uint32_t));
+    std::unique_ptr<DataSource> pSource(makeDataSource(
+        FormatSelector::makeFactory(FormatSelector::v12), "file://" + m_file,
+        options
+    ));
+    FdDataSource* pFdSource = dynamic_cast<FdDataSource*>(pSource.get());
+    ASSERT(pFdSource);
+    ASSERT(pFdSource->getReader());
+    EQ(size_t(6), countItems(*pSource));
+}
+// Mapped files are still mapped:
+
+void srcselecttest::file_3()
+{
+    DataSourceOptions options;
+    options.s_mapFiles = true;
+    std::unique_ptr<DataSource> pSource(makeDataSource(
+        FormatSelector::makeFactory(FormatSelector::v12), "file://" + m_file,
+        options
+    ));
+    ASSERT(dynamic_cast<MmapDataSource*>(pSource.get()));
+    EQ(size_t(10), countItems(*pSource));
+}
+// The source closes the file it opened:
+
+void srcselecttest::file_4()
+{
+    size_t nFds = openFds();
+    {
+        std::unique_ptr<DataSource> pSource(makeDataSource(
+            FormatSelector::makeFactory(FormatSelector::v12), "file://" + m_file
+        ));
+        EQ(nFds + 1, openFds());
+    }
+    EQ(nFds, openFds());
+}
@@ -0,0 +1,171 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  sinktests.cpp
+ *  @brief: Test the file descriptor and stream data sinks.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include <Asserts.h>
+#include "FdDataSink.h"
+#include "StreamDataSink.h"
+#include <NSCLDAQFormatFactorySelector.h>
+#include <RingItemFactoryBase.h>
+#include <RingItemBatch.h>
+#include <CRingItem.h>
+#include <DataFormat.h>
+#include <chrono>
+#include <memory>
+#include <sstream>
+#include <thread>
+#include <vector>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+using namespace ufmt;
+
+class sinktest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(sinktest);
+    CPPUNIT_TEST(fd_1);
+    CPPUNIT_TEST(fd_2);
+    CPPUNIT_TEST(stream_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    RingItemFactoryBase*    m_pFactory;      // Sinks don't own factories.
+    std::vector<CRingItem*> m_items;
+public:
+    void setUp() {
+        m_pFactory = FormatSelector::makeFactory(FormatSelector::v12);
+        for (int i = 0; i < 4; i++) {
+            CRingItem* pItem = m_pFactory->makeRingItem(PHYSICS_EVENT, size_t(100));
+            uint32_t* p = static_cast<uint32_t*>(pItem->getBodyCursor());
+            for (int w = 0; w < 5; w++) {
+                *p++ = i*5 + w;
+            }
+            pItem->setBodyCursor(p);
+            pItem->updateSize();
+            m_items.push_back(pItem);
+        }
+    }
+    void tearDown() {
+        for (auto p : m_items) {
+            delete p;
+        }
+        m_items.clear();
+        delete m_pFactory;
+    }
+protected:
+    void fd_1();
+    void fd_2();
+    void stream_1();
+private:
+    static off_t fileSize(int fd);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(sinktest);
+
+off_t
+sinktest::fileSize(int fd)
+{
+    struct stat info;
+    fstat(fd, &info);
+    return info.st_size;
+}
+
+// Without a flush interval items stay buffered until flush/destruction:
+
+void sinktest::fd_1()
+{
+    int fd = memfd_create("sinktest", 0);
+    {
+        FdDataSink sink(m_pFactory, fd);
+        sink.putItem(*m_items[0]);
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        EQ(off_t(0), fileSize(fd));
+        sink.flush();
+        EQ(off_t(m_items[0]->size()), fileSize(fd));
+        sink.putItem(*m_items[1]);
+    }
+    EQ(off_t(m_items[0]->size() + m_items[1]->size()), fileSize(fd));
+    close(fd);
+}
+// With a flush interval buffered items are written without a flush and
+// read back unchanged:
+
+void sinktest::fd_2()
+{
+    int fd = memfd_create("sinktest", 0);
+    FdDataSink sink(m_pFactory, fd, 1024*1024, 10);
+    sink.putItem(*m_items[0]);
+    RingItemBatch batch;
+    for (int i = 1; i < 4; i++) {
+        batch.append(*m_items[i]);
+    }
+    sink.putItems(batch);
+    
+    off_t total = m_items[0]->size() + batch.bytes();
+    for (int i = 0; (i < 200) && (fileSize(fd) < total); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EQ(total, fileSize(fd));
+    
+    lseek(fd, 0, SEEK_SET);
+    std::vector<CRingItem*> gotten;
+    EQ(size_t(4), m_pFactory->getRingItems(fd, gotten, 10));
+    for (int i = 0; i < 4; i++) {
+        EQ(m_items[i]->size(), gotten[i]->size());
+        EQ(0, memcmp(
+            static_cast<const CRingItem*>(m_items[i])->getItemPointer(),
+            static_cast<const CRingItem*>(gotten[i])->getItemPointer(),
+            m_items[i]->size()
+        ));
+        delete gotten[i];
+    }
+    close(fd);
+}
+// Items and batches put to a stream read back unchanged:
+
+void sinktest::stream_1()
+{
+    std::stringstream s;
+    {
+        StreamDataSink sink(m_pFactory, s);
+        sink.putItem(*m_items[0]);
+        RingItemBatch batch;
+        for (int i = 1; i < 4; i++) {
+            batch.append(*m_items[i]);
+        }
+        sink.putItems(batch);
+        sink.flush();
+    }
+    for (int i = 0; i < 4; i++) {
+        std::unique_ptr<CRingItem> pItem(m_pFactory->getRingItem(s));
+        ASSERT(pItem.get());
+        EQ(m_items[i]->size(), pItem->size());
+        EQ(0, memcmp(
+            static_cast<const CRingItem*>(m_items[i])->getItemPointer(),
+            static_cast<const CRingItem*>(pItem.get())->getItemPointer(),
+            m_items[i]->size()
+        ));
+    }
+    ASSERT(!std::unique_ptr<CRingItem>(m_pFactory->getRingItem(s)).get());
+}
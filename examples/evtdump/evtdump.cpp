@@ -30,6 +30,7 @@
 
 #include <DataSource.h>
 #include <FdDataSource.h>
+#include <AutoFormatDataSource.h>
 #include <StreamDataSource.h>
 #include <SourceSelector.h>
 #ifdef HAVE_NSCLDAQ
@@ -48,6 +49,11 @@
 #include <DataFormat.h>
 #include <algorithm>
 #include <RingItemFactoryBase.h>
+#include <CRingFileIndex.h>
+#include <CRingBlockReader.h>
+#include <CRingItemValidator.h>
+#include <CRingItemFilter.h>
+#include <fcntl.h>
 
 // These are headers for the abstrct ring items we can get back from the factory.
 // As new ring items are added this set of #include's must be updated as well
@@ -282,6 +288,101 @@ mapVersion(enum_format fmtIn)
             throw std::invalid_argument("Invalid DAQ format version specifier");
     }
 }
+/**
+ * indexedSkip
+ *    If the data source is a file with a current sidecar index (or we're
+ *    allowed to build one), find the offset of the item after the skipped
+ *    ones so the data source can start there without reading them.
+ * @param source - data source URI.
+ * @param skipCount - number of items to skip.
+ * @param version - format of the data.
+ * @param build   - if true build (and try to save) a missing or stale index.
+ * @param[out] offset - offset of the first item to dump.  If there are no
+ *                more than skipCount items this is the end of the file.
+ * @return bool - true if the index was used to compute offset.
+ */
+static bool
+indexedSkip(
+    const std::string& source, int skipCount,
+    FormatSelector::SupportedVersions version, bool build, uint64_t& offset
+)
+{
+    if (source == "-") return false;
+    URL uri(source);
+    if (uri.getProto() != "file") return false;
+    std::string path      = uri.getPath();
+    std::string indexPath = CRingFileIndex::indexPath(path);
+
+    CRingFileIndex index;
+    bool haveIndex = false;
+    try {
+        index.read(indexPath);
+        haveIndex = index.isCurrent(path) && (index.getVersion() == version);
+    }
+    catch (std::exception&) {}                 // No usable index.
+    if (!haveIndex) {
+        if (!build) return false;
+        index.build(path, version);
+        haveIndex = true;
+        try {
+            index.write(indexPath);
+        }
+        catch (std::exception& e) {
+            std::cerr << "Unable to save the index: " << e.what() << std::endl;
+        }
+    }
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) return false;                   // makeDataSource will report it.
+    if (!index.findItem(fd, skipCount, offset)) {
+        offset = lseek(fd, 0, SEEK_END);
+    }
+    close(fd);
+    return true;
+}
+/**
+ * reportSkipped
+ *    Report the byte ranges a resynchronizing source has skipped since the
+ *    last report.
+ * @param pSource - the data source.
+ * @param base - file offset at which the source started reading.
+ */
+static void
+reportSkipped(DataSource* pSource, uint64_t base)
+{
+    AutoFormatDataSource* pAuto = dynamic_cast<AutoFormatDataSource*>(pSource);
+    if (pAuto) {
+        pSource = pAuto->getSource();
+    }
+    FdDataSource* pFdSource = dynamic_cast<FdDataSource*>(pSource);
+    CRingBlockReader* pReader = pFdSource ? pFdSource->getReader() : nullptr;
+    if (!pReader) return;
+    for (auto& r : pReader->getSkipped()) {
+        std::cerr << "Skipped " << r.s_nBytes << " bytes at offset "
+            << base + r.s_offset << ": "
+            << CRingItemValidator::problemString(r.s_problem) << std::endl;
+    }
+    pReader->clearSkipped();
+}
+/**
+ * checkFactory
+ *    An auto format source changes factories when the format changes.
+ *    When it does, remake the item we refill so that it's the class
+ *    of the new format.
+ * @param pSource - the data source.
+ * @param[inout] pFactory - factory the item was made with.
+ * @param[inout] pItem  - the item just read.
+ */
+static void
+checkFactory(
+    DataSource* pSource, RingItemFactoryBase*& pFactory,
+    std::unique_ptr<CRingItem>& pItem
+)
+{
+    if (pSource->getFactory() != pFactory) {
+        pFactory = pSource->getFactory();
+        pItem.reset(pFactory->makeRingItem(*pItem));
+    }
+}
 /**
  * makeSourceString
  *   Given a source string URI creates the actual one.  In this case it's a
@@ -323,7 +424,26 @@ int main(int argc, char** argv)
         // Now we need to take the URI and the factory and create a data source:
         
         
-        std::unique_ptr<ufmt::DataSource> pSource(ufmt::makeDataSource(&fact, dataSource));
+        ufmt::DataSourceOptions sourceOptions;
+        sourceOptions.s_mapFiles = args.mmap_flag;
+        sourceOptions.s_readAheadDepth = args.read_ahead_arg;
+        sourceOptions.s_readAheadBufferSize = args.read_ahead_size_arg;
+        sourceOptions.s_ioUring = args.io_uring_flag;
+        sourceOptions.s_autoFormat = args.auto_format_flag;
+        std::unique_ptr<CRingItemValidator> pValidator;
+        if (args.resync_flag) {
+            pValidator.reset(new CRingItemValidator(defaultVersion));
+            sourceOptions.s_pValidator = pValidator.get();
+        }
+        if ((skipCount > 0) && indexedSkip(
+                dataSource, skipCount, defaultVersion, args.index_flag,
+                sourceOptions.s_startOffset
+            )) {
+            skipCount = 0;                           // Source starts past them.
+        }
+        std::unique_ptr<ufmt::DataSource> pSource(
+            ufmt::makeDataSource(&fact, dataSource, sourceOptions)
+        );
         
         // Proces the scalerBits value into a ::CRingScalerItem::m_ScalerFormatMask
         
@@ -332,33 +452,57 @@ int main(int argc, char** argv)
         sbits--;
         ::CRingScalerItem::m_ScalerFormatMask = sbits;
         
+        // A single item is refilled by each read so reading does not
+        // allocate an item per read:
+        
+        // The source owns the factory and, with --auto-format, may replace it.
+        
+        RingItemFactoryBase* pFactory = pSource->getFactory();
+        std::unique_ptr<CRingItem> pItem(pFactory->makeRingItem(PHYSICS_EVENT, size_t(0)));
+        
         // If there's a skip count skip exactly that many items:
         
         if (skipCount > 0) {
             for (int i =0; i < skipCount; i++) {
-                std::unique_ptr<CRingItem> p(pSource->getItem());
-                if (!p.get()) {
+                bool gotItem = pSource->getItem(*pItem);
+                if (args.resync_flag) {
+                    reportSkipped(pSource.get(), sourceOptions.s_startOffset);
+                }
+                if (!gotItem) {
                     // end of data source
                     exit(EXIT_SUCCESS);
                 }
+                checkFactory(pSource.get(), pFactory, pItem);
             }
         }
+        // Sources that can step over the excluded items without reading
+        // them are asked to; otherwise each item is checked here.  This is
+        // done after the skip as excluded items count as skipped.
+
+        CRingItemFilter filter(defaultVersion);
+        bool sourceFilters = false;
+        if (!exclusionList.empty()) {
+            filter.excludeTypes(exclusionList);
+            sourceFilters = pSource->setFilter(&filter);
+        }
         // Now dump the items that are not excluded and if there's a dumpCount
         // only dump that many items -- or until the end of the data source:
         
         int remaining = dumpCount;
         while(1) {
-            std::unique_ptr<CRingItem> pItem(pSource->getItem());
-            if (!pItem.get()) {
+            bool gotItem = pSource->getItem(*pItem);
+            if (args.resync_flag) {
+                reportSkipped(pSource.get(), sourceOptions.s_startOffset);
+            }
+            if (!gotItem) {
                 exit(EXIT_SUCCESS);                          // End of source.
             }
+            checkFactory(pSource.get(), pFactory, pItem);
             
-            if (std::find(
-                    exclusionList.begin(), exclusionList.end(), pItem->type()
-                ) == exclusionList.end()) {
+            if (sourceFilters || filter.acceptType(pItem->type())) {
                 // Dumpable:
                     
-                dumpItem(pItem.get(), fact);
+                dumpItem(pItem.get(), *pFactory);
                 
                 // Apply any limit to the count:
                 
@@ -26,8 +26,15 @@
 #include <abstract/CDataFormatItem.h>
 #include <v11/RingItemFactory.h>
 #include <v12/RingItemFactory.h>
+#include <abstract/CRingItem.h>
+#include <abstract/CPhysicsEventItem.h>
+#include <abstract/CRingStateChangeItem.h>
+#include <abstract/DataFormat.h>
 
 #include <memory>
+#include <thread>
+#include <vector>
+#include <string.h>
 
 using namespace ufmt;
 
@@ -47,6 +54,19 @@ class seltest : public CppUnit::TestFixture {
     CPPUNIT_TEST(destructor_1);
     CPPUNIT_TEST(destructor_2);
     CPPUNIT_TEST(destructor_3);
+
+    CPPUNIT_TEST(make_1);
+    
+    CPPUNIT_TEST(detect_1);
+    CPPUNIT_TEST(detect_2);
+    CPPUNIT_TEST(detect_3);
+    CPPUNIT_TEST(detect_4);
+    CPPUNIT_TEST(detect_5);
+    CPPUNIT_TEST(detect_6);
+    CPPUNIT_TEST(detect_7);
+
+    CPPUNIT_TEST(thread_1);
+    CPPUNIT_TEST(thread_2);
     CPPUNIT_TEST_SUITE_END();
     
 private:
@@ -73,6 +93,22 @@ protected:
     void destructor_2();
     void destructor_3();
 
+    void make_1();
+    
+    void detect_1();
+    void detect_2();
+    void detect_3();
+    void detect_4();
+    void detect_5();
+    void detect_6();
+    void detect_7();
+
+    void thread_1();
+    void thread_2();
+private:
+    std::vector<uint8_t> someItems(
+        RingItemFactoryBase& fact, bool formatItem
+    );
 };
 
 CPPUNIT_TEST_SUITE_REGISTRATION(seltest);
@@ -193,4 +229,194 @@ void seltest::destructor_3() {
     ASSERT(pSel1 != &sel2);
     delete &sel2;
     delete &dummy;
-}
\ No newline at end of file
+}
+// makeFactory factories are new and not cached:
+
+void seltest::make_1()
+{
+    RingItemFactoryBase* pFact = FormatSelector::makeFactory(FormatSelector::v12);
+    auto& cached = FormatSelector::selectFactory(FormatSelector::v12);
+    ASSERT(pFact != &cached);
+    std::unique_ptr<::CDataFormatItem> item(pFact->makeDataFormatItem());
+    EQ(uint16_t(12), item->getMajor());
+    delete pFact;
+    
+    EQ(&cached, &FormatSelector::selectFactory(FormatSelector::v12));
+    delete &cached;
+}
+// Serialize a format item (if the factory can and we want one),
+// a begin run and a few physics events:
+
+std::vector<uint8_t>
+seltest::someItems(RingItemFactoryBase& fact, bool formatItem)
+{
+    std::vector<uint8_t> result;
+    std::vector<CRingItem*> items;
+    if (formatItem) {
+        items.push_back(fact.makeDataFormatItem());
+    }
+    items.push_back(fact.makeStateChangeItem(BEGIN_RUN, 1, 0, 0, "A title"));
+    for (int i = 0; i < 3; i++) {
+        CPhysicsEventItem* pEvent = fact.makePhysicsEventItem(100);
+        uint16_t* p = reinterpret_cast<uint16_t*>(pEvent->getBodyCursor());
+        for (int w = 0; w < 10; w++) {
+            *p++ = w;
+        }
+        pEvent->setBodyCursor(p);
+        pEvent->updateSize();
+        items.push_back(pEvent);
+    }
+    for (auto pItem : items) {
+        const uint8_t* p =
+            reinterpret_cast<const uint8_t*>(pItem->getItemPointer());
+        result.insert(result.end(), p, p + pItem->size());
+        delete pItem;
+    }
+    return result;
+}
+// A format item decides:
+
+void seltest::detect_1()
+{
+    v11::RingItemFactory fact11;
+    auto data = someItems(fact11, true);
+    FormatSelector::SupportedVersions v = FormatSelector::v10;
+    ASSERT(FormatSelector::getFormatVersion(data.data(), v));
+    EQ(FormatSelector::v11, v);
+    
+    v12::RingItemFactory fact12;
+    data = someItems(fact12, true);
+    ASSERT(FormatSelector::detectVersion(data.data(), data.size(), v));
+    EQ(FormatSelector::v12, v);
+}
+// v10 has no format item but its state change items give it away:
+
+void seltest::detect_2()
+{
+    auto& fact = FormatSelector::selectFactory(FormatSelector::v10);
+    auto data = someItems(fact, false);
+    FormatSelector::SupportedVersions v = FormatSelector::v12;
+    ASSERT(!FormatSelector::getFormatVersion(data.data(), v));
+    ASSERT(FormatSelector::detectVersion(data.data(), data.size(), v));
+    EQ(FormatSelector::v10, v);
+    delete &fact;
+}
+// Without format items, v11 and v12 differ in the body header size word:
+
+void seltest::detect_3()
+{
+    v11::RingItemFactory fact11;
+    auto data = someItems(fact11, false);
+    FormatSelector::SupportedVersions v = FormatSelector::v10;
+    ASSERT(FormatSelector::detectVersion(data.data(), data.size(), v));
+    EQ(FormatSelector::v11, v);
+    
+    v12::RingItemFactory fact12;
+    data = someItems(fact12, false);
+    ASSERT(FormatSelector::detectVersion(data.data(), data.size(), v));
+    EQ(FormatSelector::v12, v);
+}
+// Items cut off by the end of the data are ignored:
+
+void seltest::detect_4()
+{
+    v12::RingItemFactory fact;
+    auto data = someItems(fact, true);
+    FormatSelector::SupportedVersions v = FormatSelector::v10;
+    ASSERT(!FormatSelector::detectVersion(data.data(), sizeof(DataFormat) - 1, v));
+    EQ(FormatSelector::v10, v);
+    ASSERT(FormatSelector::detectVersion(data.data(), sizeof(DataFormat), v));
+    EQ(FormatSelector::v12, v);
+}
+// Garbage and empty data don't decide anything:
+
+void seltest::detect_5()
+{
+    FormatSelector::SupportedVersions v = FormatSelector::v11;
+    uint8_t garbage[256];
+    memset(garbage, 0xa5, sizeof(garbage));
+    ASSERT(!FormatSelector::detectVersion(garbage, sizeof(garbage), v));
+    ASSERT(!FormatSelector::detectVersion(garbage, 0, v));
+    EQ(FormatSelector::v11, v);
+}
+// A format item with an unsupported major version is not a decision:
+
+void seltest::detect_6()
+{
+    v12::RingItemFactory fact;
+    auto data = someItems(fact, true);
+    reinterpret_cast<DataFormat*>(data.data())->s_majorVersion = 99;
+    FormatSelector::SupportedVersions v = FormatSelector::v10;
+    ASSERT(!FormatSelector::getFormatVersion(data.data(), v));
+    
+    // The remaining items still look like v12:
+    
+    ASSERT(FormatSelector::detectVersion(data.data(), data.size(), v));
+    EQ(FormatSelector::v12, v);
+}
+// Items that all have body headers are v11 or v12; the caller's
+// choice between them stands:
+
+void seltest::detect_7()
+{
+    v12::RingItemFactory fact;
+    std::vector<uint8_t> data;
+    for (int i = 0; i < 3; i++) {
+        std::unique_ptr<CPhysicsEventItem> pEvent(
+            fact.makePhysicsEventItem(0x1000 + i, 1, 0, 100)
+        );
+        uint32_t* pBody = reinterpret_cast<uint32_t*>(pEvent->getBodyCursor());
+        *pBody++ = i;
+        pEvent->setBodyCursor(pBody);
+        pEvent->updateSize();
+        const uint8_t* p =
+            reinterpret_cast<const uint8_t*>(pEvent->getItemPointer());
+        data.insert(data.end(), p, p + pEvent->size());
+    }
+    FormatSelector::SupportedVersions v = FormatSelector::v11;
+    ASSERT(FormatSelector::detectVersion(data.data(), data.size(), v));
+    EQ(FormatSelector::v11, v);
+    v = FormatSelector::v10;
+    ASSERT(FormatSelector::detectVersion(data.data(), data.size(), v));
+    EQ(FormatSelector::v12, v);
+}
+// Threads racing to make the first factory all get the same one:
+
+void seltest::thread_1()
+{
+    const int nThreads = 8;
+    RingItemFactoryBase* factories[nThreads];
+    std::vector<std::thread> threads;
+    for (int i = 0; i < nThreads; i++) {
+        threads.emplace_back([&factories, i]() {
+            factories[i] = &FormatSelector::selectFactory(FormatSelector::v11);
+        });
+    }
+    for (auto& t : threads) {
+        t.join();
+    }
+    for (int i = 1; i < nThreads; i++) {
+        EQ(factories[0], factories[i]);
+    }
+    EQ(factories[0], &FormatSelector::selectFactory(FormatSelector::v11));
+    delete factories[0];
+}
+// Thread factories are per thread and not the shared one:
+
+void seltest::thread_2()
+{
+    auto& mine = FormatSelector::selectThreadFactory(FormatSelector::v12);
+    EQ(&mine, &FormatSelector::selectThreadFactory(FormatSelector::v12));
+    EQ(FormatSelector::v12, mine.version());
+    
+    auto& shared = FormatSelector::selectFactory(FormatSelector::v12);
+    ASSERT(&mine != &shared);
+    
+    RingItemFactoryBase* pOther(nullptr);
+    std::thread t([&pOther]() {
+        pOther = &FormatSelector::selectThreadFactory(FormatSelector::v12);
+    });
+    t.join();
+    ASSERT(pOther != &mine);
+    delete &shared;
+}
@@ -35,7 +35,7 @@ namespace ufmt {
   class CPhysicsEventItem : public ::ufmt::CPhysicsEventItem
   {
   public:
-    CPhysicsEventItem(size_t maxBody=8192);
+    CPhysicsEventItem(size_t maxBody=CRingItemStaticBufferSize - 10);
     virtual ~CPhysicsEventItem();
 
   private:
@@ -16,6 +16,7 @@
 
 
 #include "CRingItem.h"
+#include <utility>
 #include "DataFormat.h"
 
 
@@ -60,6 +61,26 @@ namespace ufmt {
   {
     deleteIfNecessary();
   }
+  /**
+   * move constructor
+   *   Takes over the storage of rhs (see ::ufmt::CRingItem::moveIn).
+   * @param rhs - item we take over.  It's left empty.
+   */
+  CRingItem::CRingItem(CRingItem&& rhs) :
+    ::ufmt::CRingItem(std::move(rhs))
+  {
+  }
+  /**
+   * move assignment
+   * @param rhs - item we take over.  It's left empty.
+   * @return CRingItem& - *this
+   */
+  CRingItem&
+  CRingItem::operator=(CRingItem&& rhs)
+  {
+    ::ufmt::CRingItem::operator=(std::move(rhs));
+    return *this;
+  }
 
 
   //////////////////////////////////////////////////////////////////////////////////////////
@@ -87,6 +108,7 @@ namespace ufmt {
   void*
   CRingItem::getBodyPointer() 
   {
+    makeWritable();
     v10::pRingItemHeader ph = reinterpret_cast<v10::pRingItemHeader>(m_pItem);
     return ph+1;
   }
@@ -52,9 +52,12 @@ namespace ufmt {
     // Constructors and canonicals.
 
   public:
-    CRingItem(uint16_t type, size_t maxBody = 8192);
+    CRingItem(uint16_t type, size_t maxBody = CRingItemStaticBufferSize - 10);
 
     virtual ~CRingItem();
+
+    CRingItem(CRingItem&& rhs);
+    CRingItem& operator=(CRingItem&& rhs);
   private:
     CRingItem(const CRingItem& rhs);
     CRingItem& operator=(const CRingItem& rhs);
@@ -32,6 +32,8 @@
 #include <CRingBuffer.h>
 #endif
 #include <io.h>
+#include <CRingBlockReader.h>
+#include <CRingBlockWriter.h>
 
 #include <string.h>
 #include <stdint.h>
@@ -66,7 +68,7 @@ namespace ufmt {
     ::ufmt::CRingItem*
     RingItemFactory::makeRingItem(uint16_t type, size_t maxBody)
     {
-        return new v10::CRingItem(type, maxBody);
+        return newItem<v10::CRingItem>(type, maxBody);
     }
     
     //  from event building parameters
@@ -77,7 +79,7 @@ namespace ufmt {
         size_t maxBody, uint32_t barrierType 
     )
     {
-        return new v10::CRingItem(type, maxBody);
+        return newItem<v10::CRingItem>(type, maxBody);
     }
     
     // From an existing item -
@@ -208,6 +210,158 @@ namespace ufmt {
         return result;
         
     }
+    /**
+     * getRingItem (from block reader)
+     *    Gets the next item from a block buffered file descriptor reader.
+     *    This avoids the two read(2) calls per item the fd overload needs.
+     *  @param reader - the block reader.
+     *  @return ::ufmt::CRingItem* - pointer to a new ring item that must be
+     *              destroyed via delete.
+     *  @retval nullptr - end of file.
+     */
+    ::ufmt::CRingItem*
+    RingItemFactory::getRingItem(::ufmt::CRingBlockReader& reader)
+    {
+        const ::ufmt::RingItem* pRaw = reader.nextItem();
+        if (!pRaw) {
+            return nullptr;                // EOF.
+        }
+        return makeRingItem(pRaw);
+    }
+    #ifdef HAVE_NSCLDAQ
+    /**
+     * getRingItem (refill from ring buffer)
+     *    Get the next ring item from a ring buffer into an existing item.
+     *    The item's storage is only reallocated if it's too small.
+     * @param ringbuf - ring buffer from which the item is gotten.
+     * @param item    - item to fill in.
+     * @param timeout - seconds to wait for the header.
+     * @return bool   - false if the header could not be gotten in time.
+     */
+    bool
+    RingItemFactory::getRingItem(
+        ::CRingBuffer& ringbuf, ::ufmt::CRingItem& item, unsigned long timeout
+    )
+    {
+        v10::RingItemHeader hdr;
+        if (!ringbuf.get(&hdr, sizeof(hdr), sizeof(hdr), timeout)) {
+            return false;
+        }
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        uint32_t remaining = hdr.s_size - sizeof(hdr);
+        if (remaining) {
+            ringbuf.get(p, remaining, remaining);
+            p += remaining;
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        return true;
+    }
+    #endif
+    /**
+     * getRingItem (refill from file descriptor)
+     *    Read the next ring item from a file descriptor into an existing
+     *    item.  The item's storage is only reallocated if it's too small.
+     * @param fd   - file descriptor open on the ring item source.
+     * @param item - item to fill in.
+     * @return bool - false on end of file.  If the end of file is in the
+     *                middle of an item the contents of item are undefined.
+     */
+    bool
+    RingItemFactory::getRingItem(int fd, ::ufmt::CRingItem& item)
+    {
+        v10::RingItemHeader hdr;
+        if (fmtio::readData(fd, &hdr, sizeof(hdr)) < sizeof(hdr)) {
+            return false;
+        }
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        uint32_t remaining = hdr.s_size - sizeof(hdr);
+        if (remaining) {
+            if (fmtio::readData(fd, p, remaining) < remaining) {
+                return false;
+            }
+            p += remaining;
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        return true;
+    }
+    /**
+     * getRingItem (refill from std::istream)
+     * @param in   - stream open on the ring item source.
+     * @param item - item to fill in.
+     * @return bool - false if the item could not be read; the stream has
+     *                the reason.
+     */
+    bool
+    RingItemFactory::getRingItem(std::istream& in, ::ufmt::CRingItem& item)
+    {
+        v10::RingItemHeader hdr;
+        in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+        if (!in) {
+            return false;
+        }
+        char* p = reinterpret_cast<char*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        size_t remaining = hdr.s_size - sizeof(hdr);
+        in.read(p, remaining);
+        if (!in) {
+            return false;
+        }
+        item.setBodyCursor(p + remaining);
+        item.updateSize();
+        return true;
+    }
+    /**
+     * getRingItem (refill from block reader)
+     * @param reader - block buffered reader on the ring item source.
+     * @param item   - item to fill in.
+     * @return bool  - false on end of file.
+     */
+    bool
+    RingItemFactory::getRingItem(
+        ::ufmt::CRingBlockReader& reader, ::ufmt::CRingItem& item
+    )
+    {
+        const ::ufmt::RingItem* pRaw = reader.nextItem();
+        if (!pRaw) {
+            return false;
+        }
+        refillItem(item, pRaw);
+        return true;
+    }
+    /**
+     * getRingItems
+     *    Refill a batch of items from a block reader.  The reader is looped
+     *    over here rather than through a getRingItem call per item.
+     * @param reader - the block reader.
+     * @param items  - the batch; lengthened as needed.
+     * @param maxItems - most items to get.
+     * @return size_t - number of items gotten; fewer than maxItems only at
+     *                the end of the data.
+     */
+    size_t
+    RingItemFactory::getRingItems(
+        ::ufmt::CRingBlockReader& reader,
+        std::vector<::ufmt::CRingItem*>& items, size_t maxItems
+    )
+    {
+        size_t n = 0;
+        while (n < maxItems) {
+            const ::ufmt::RingItem* pRaw = reader.nextItem();
+            if (!pRaw) {
+                break;
+            }
+            refillItem(*batchItem(items, n), pRaw);
+            n++;
+        }
+        return n;
+    }
     // Put ring items to various data sinks.
     
     /**
@@ -243,6 +397,21 @@ namespace ufmt {
         fmtio::writeData(fd, hdr, hdr->s_size);
         
     }
+    /**
+     * putRingItem
+     *    Put a ring item through a block writer, which coalesces items
+     *    into large writes.
+     * @param pItem - pointer to the item to put.
+     * @param writer - the writer.
+     * @throw errors from fmtio::writeData are thrown as exceptions.
+     */
+    void
+    RingItemFactory::putRingItem(
+        const ::ufmt::CRingItem* pItem, ::ufmt::CRingBlockWriter& writer
+    )
+    {
+        writer.put(pItem->getItemPointer(), pItem->size());
+    }
     /**
      * putRingItem (to ring).
      *   @param pItem - pointer to he item.
@@ -322,7 +491,7 @@ namespace ufmt {
     ::ufmt::CPhysicsEventItem*
     RingItemFactory::makePhysicsEventItem(size_t maxBody)
     {
-    return new v10::CPhysicsEventItem(maxBody);
+    return newItem<v10::CPhysicsEventItem>(maxBody);
     }
     
     ::ufmt::CPhysicsEventItem*
@@ -362,7 +531,7 @@ namespace ufmt {
                 const void* payload, uint32_t barrier
     )
     {
-        return new v10::CRingFragmentItem(
+        return newItem<v10::CRingFragmentItem>(
         timestamp, source, payloadSize, payload, barrier
         );
     }
@@ -373,7 +542,7 @@ namespace ufmt {
         if (rhs.type() == v10::EVB_FRAGMENT || rhs.type() == v10::EVB_UNKNOWN_PAYLOAD) {
         const v10::EventBuilderFragment* pSrc =
         reinterpret_cast<const v10::EventBuilderFragment*>(rhs.getItemPointer());
-        auto result =  new v10::CRingFragmentItem(
+        auto result =  newItem<v10::CRingFragmentItem>(
             pSrc->s_timestamp, pSrc->s_sourceId,
             pSrc->s_payloadSize, pSrc->s_body,
             pSrc->s_barrierType 
@@ -408,7 +577,7 @@ namespace ufmt {
         int divisor
     )
     {
-        return new v10::CRingPhysicsEventCountItem(count, timeoffset, stamp);
+        return newItem<v10::CRingPhysicsEventCountItem>(count, timeoffset, stamp);
     }
     /**
      * makePhysicsEventCountItem
@@ -458,7 +627,7 @@ namespace ufmt {
     ::ufmt::CRingScalerItem*
     RingItemFactory::makeScalerItem(size_t numScalers)
     {
-        return new v10::CRingScalerItem(numScalers);
+        return newItem<v10::CRingScalerItem>(numScalers);
     }
     
     ::ufmt::CRingScalerItem*
@@ -472,7 +641,7 @@ namespace ufmt {
                 uint32_t              timeOffsetDivisor
     )
     {
-        return new v10::CRingScalerItem(
+        return newItem<v10::CRingScalerItem>(
             startTime, stopTime, timestamp, scalers, isIncremental,
             sid, timeOffsetDivisor
         );
@@ -559,7 +728,7 @@ namespace ufmt {
         {
             if (!isValidTextItemType(type)) throw std::bad_cast();
             
-            return new CRingTextItem(type, theStrings);
+            return newItem<CRingTextItem>(type, theStrings);
         }
         
         
@@ -573,7 +742,7 @@ namespace ufmt {
         {
             if (!isValidTextItemType(type)) throw std::bad_cast();
             
-            return new CRingTextItem(
+            return newItem<CRingTextItem>(
                 type, theStrings, offsetTime, timestamp, divisor
             );
         }
@@ -651,7 +820,7 @@ namespace ufmt {
         )
         {
             if(!isValidStateChangeType(itemType)) throw std::bad_cast();
-            return new CRingStateChangeItem(
+            return newItem<CRingStateChangeItem>(
                 itemType, runNumber, timeOffset, timestamp, title 
             );
         }
@@ -671,6 +840,83 @@ namespace ufmt {
                 pItem->s_Timestamp, std::string(pItem->s_title)
             );
         }
+        ///////////////////////////////////////////////////////////
+        // Conversions that take over the storage of an rvalue item.
+        // The checks are the same as for the copying conversions above;
+        // the items are then given rhs's storage (see adoptItem).  rhs is
+        // left empty.
+        
+        ::ufmt::CRingItem*
+        RingItemFactory::makeRingItem(::ufmt::CRingItem&& rhs)
+        {
+            return adoptItem<v10::CRingItem>(std::move(rhs), rhs.type(), 0);
+        }
+        
+        ::ufmt::CPhysicsEventItem*
+        RingItemFactory::makePhysicsEventItem(::ufmt::CRingItem&& rhs)
+        {
+            if (rhs.type() != v10::PHYSICS_EVENT) {
+                throw std::bad_cast();
+            }
+            return adoptItem<v10::CPhysicsEventItem>(std::move(rhs), size_t(0));
+        }
+        // Note that the type of rhs is kept as with the copying conversion.
+        
+        ::ufmt::CRingFragmentItem*
+        RingItemFactory::makeRingFragmentItem(::ufmt::CRingItem&& rhs)
+        {
+            if (rhs.type() != v10::EVB_FRAGMENT && rhs.type() != v10::EVB_UNKNOWN_PAYLOAD) {
+                throw std::bad_cast();
+            }
+            return adoptItem<v10::CRingFragmentItem>(
+                std::move(rhs), 0, 0, 0, nullptr, 0
+            );
+        }
+        
+        ::ufmt::CRingScalerItem*
+        RingItemFactory::makeScalerItem(::ufmt::CRingItem&& rhs)
+        {
+            size_t expectedSize;
+            if (rhs.type() == v10::INCREMENTAL_SCALERS) {
+                const v10::ScalerItem* pItem =
+                    reinterpret_cast<const v10::ScalerItem*>(rhs.getItemPointer());
+                expectedSize =
+                    (pItem->s_scalerCount - 1) *sizeof(uint32_t) + sizeof(v10::ScalerItem);
+            } else if (rhs.type() == v10::TIMESTAMPED_NONINCR_SCALERS) {
+                const v10::NonIncrTimestampedScaler* pItem =
+                    reinterpret_cast<const v10::NonIncrTimestampedScaler*>(
+                        rhs.getItemPointer()
+                    );
+                expectedSize =
+                    sizeof(v10::NonIncrTimestampedScaler) +
+                    (pItem->s_scalerCount-1)*sizeof(uint32_t);
+            } else {
+                throw std::bad_cast();
+            }
+            if (rhs.size() != expectedSize) {
+                throw std::bad_cast();
+            }
+            return adoptItem<v10::CRingScalerItem>(std::move(rhs), size_t(0));
+        }
+        
+        ::ufmt::CRingTextItem*
+        RingItemFactory::makeTextItem(::ufmt::CRingItem&& rhs)
+        {
+            if (!isValidTextItemType(rhs.type())) throw std::bad_cast();
+            return adoptItem<v10::CRingTextItem>(
+                std::move(rhs), rhs.type(), std::vector<std::string>()
+            );
+        }
+        
+        ::ufmt::CRingStateChangeItem*
+        RingItemFactory::makeStateChangeItem(::ufmt::CRingItem&& rhs)
+        {
+            if (!isValidStateChangeType(rhs.type())) throw std::bad_cast();
+            if (rhs.size() != sizeof(v10::StateChangeItem)) {
+                throw std::bad_cast();
+            }
+            return adoptItem<v10::CRingStateChangeItem>(std::move(rhs), rhs.type());
+        }
         /** Return the factory format version */
 
         ufmt::FormatSelector::SupportedVersions  
@@ -741,6 +987,22 @@ namespace ufmt {
             return validStateChangeType.count(reason) > 0;
         }
         
+        /**
+         * refillItem
+         *    Copy a raw item into an existing item, whose storage is only
+         *    reallocated if it's too small.
+         * @param item - item to fill in.
+         * @param pRaw - the raw item.
+         */
+        void
+        RingItemFactory::refillItem(::ufmt::CRingItem& item, const ::ufmt::RingItem* pRaw)
+        {
+            uint32_t size = pRaw->s_header.s_size;
+            uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(size));
+            memcpy(p, pRaw, size);
+            item.setBodyCursor(p + size);
+            item.updateSize();
+        }
     }                          // v10 namespace.
 }
 
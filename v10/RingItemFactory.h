@@ -42,18 +42,38 @@ namespace ufmt {
             ::ufmt::CRingItem* makeRingItem(uint16_t type, uint64_t timestamp, uint32_t sourceId,
                     size_t maxBody, uint32_t barrierType = 0 );
             ::ufmt::CRingItem* makeRingItem(const ::ufmt::CRingItem& rhs);
+            virtual ::ufmt::CRingItem* makeRingItem(::ufmt::CRingItem&& rhs);
             ::ufmt::CRingItem* makeRingItem(const ::ufmt::RingItem* pRawRing);
     #ifdef HAVE_NSCLDAQ  
             virtual ::ufmt::CRingItem* getRingItem(::CRingBuffer& ringbuf, unsigned long timeout=ULONG_MAX) ;
     #endif
             virtual ::ufmt::CRingItem* getRingItem(int fd) ;
             virtual ::ufmt::CRingItem* getRingItem(::std::istream& in);
+            virtual ::ufmt::CRingItem* getRingItem(::ufmt::CRingBlockReader& reader) ;
+    #ifdef HAVE_NSCLDAQ
+            virtual bool getRingItem(
+                ::CRingBuffer& ringbuf, ::ufmt::CRingItem& item,
+                unsigned long timeout=ULONG_MAX
+            ) ;
+    #endif
+            virtual bool getRingItem(int fd, ::ufmt::CRingItem& item) ;
+            virtual bool getRingItem(::std::istream& in, ::ufmt::CRingItem& item) ;
+            virtual bool getRingItem(
+                ::ufmt::CRingBlockReader& reader, ::ufmt::CRingItem& item
+            ) ;
+            virtual size_t getRingItems(
+                ::ufmt::CRingBlockReader& reader,
+                ::std::vector<::ufmt::CRingItem*>& items, size_t maxItems
+            ) ;
+            using ::ufmt::RingItemFactoryBase::getRingItems;
             
             virtual ::std::ostream& putRingItem(const ::ufmt::CRingItem* pItem, ::std::ostream& out) ;
             virtual void putRingItem(const ::ufmt::CRingItem* pItem, int fd) ;
+            virtual void putRingItem(const ::ufmt::CRingItem* pItem, ::ufmt::CRingBlockWriter& writer) ;
     #ifdef HAVE_NSCLDAQ  
             virtual void putRingItem(const ::ufmt::CRingItem* pItem, ::CRingBuffer& ringbuf) ;
     #endif
+            using ::ufmt::RingItemFactoryBase::putRingItem;    // Batches.
             // abnormal end items for 10.x:
             
             virtual ::ufmt::CAbnormalEndItem* makeAbnormalEndItem() ;
@@ -79,6 +99,7 @@ namespace ufmt {
                 size_t maxBody
             ) ;
             virtual ::ufmt::CPhysicsEventItem* makePhysicsEventItem(const ::ufmt::CRingItem& rhs) ;
+            virtual ::ufmt::CPhysicsEventItem* makePhysicsEventItem(::ufmt::CRingItem&& rhs) ;
             
             // RingFragment items (not supported in v10):
             
@@ -87,6 +108,7 @@ namespace ufmt {
                 const void* payload, uint32_t barrier=0
             ) ;
             virtual ::ufmt::CRingFragmentItem* makeRingFragmentItem(const ::ufmt::CRingItem& rhs) ;
+            virtual ::ufmt::CRingFragmentItem* makeRingFragmentItem(::ufmt::CRingItem&& rhs) ;
         
             // Event count items.
             
@@ -109,6 +131,7 @@ namespace ufmt {
                 uint32_t              timeOffsetDivisor = 1
             );
             virtual ::ufmt::CRingScalerItem* makeScalerItem(const ::ufmt::CRingItem& rhs);
+            virtual ::ufmt::CRingScalerItem* makeScalerItem(::ufmt::CRingItem&& rhs);
             
             // Text items:
             
@@ -125,6 +148,7 @@ namespace ufmt {
                 time_t                   timestamp, uint32_t divisor=1
             );
             virtual ::ufmt::CRingTextItem* makeTextItem(const ::ufmt::CRingItem& rhs);
+            virtual ::ufmt::CRingTextItem* makeTextItem(::ufmt::CRingItem&& rhs);
             
             // unknown fragments.
             
@@ -143,11 +167,15 @@ namespace ufmt {
                 ::std::string title
             );
             virtual ::ufmt::CRingStateChangeItem* makeStateChangeItem(const ::ufmt::CRingItem& rhs);
+            virtual ::ufmt::CRingStateChangeItem* makeStateChangeItem(::ufmt::CRingItem&& rhs);
         
 
             virtual ufmt::FormatSelector::SupportedVersions version();
             
         private:
+            static void refillItem(
+                ::ufmt::CRingItem& item, const ::ufmt::RingItem* pRaw
+            );
             static bool isValidTextItemType(uint32_t itemType);
             static ::std::vector<::std::string> stringsToVector(
                 uint32_t nStrings, const char* pStrings
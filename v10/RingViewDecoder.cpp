@@ -0,0 +1,186 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  RingViewDecoder.cpp (v10)
+ *  @brief: Implement the v10 decoder for the typed ring item views.
+ */
+#include "RingViewDecoder.h"
+#include "DataFormat.h"
+#include <CRingItemView.h>
+#include <stddef.h>
+
+namespace ufmt {
+    namespace v10 {
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - v10.
+     */
+    ::ufmt::FormatSelector::SupportedVersions
+    RingViewDecoder::getVersion() const
+    {
+        return ::ufmt::FormatSelector::v10;
+    }
+    /**
+     * decodeScaler
+     *    v10 has incremental and non incremental scaler items with
+     *    different layouts.  Incremental scaler times are in seconds.
+     *    v10 items have no original source id.
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v10 scaler item.
+     */
+    bool
+    RingViewDecoder::decodeScaler(
+        const ::ufmt::CRingItemView& item, ScalerInfo& info
+    ) const
+    {
+        if (item.getVersion() != ::ufmt::FormatSelector::v10) {
+            return false;
+        }
+        if (item.type() == v10::INCREMENTAL_SCALERS) {
+            const v10::ScalerItem* p =
+                reinterpret_cast<const v10::ScalerItem*>(item.getItemPointer());
+            info.s_startTime     = p->s_intervalStartOffset;
+            info.s_endTime       = p->s_intervalEndOffset;
+            info.s_divisor       = 1;
+            info.s_timestamp     = p->s_timestamp;
+            info.s_isIncremental = true;
+            info.s_scalerCount   = p->s_scalerCount;
+        } else if (item.type() == v10::TIMESTAMPED_NONINCR_SCALERS) {
+            const v10::NonIncrTimestampedScaler* p =
+                reinterpret_cast<const v10::NonIncrTimestampedScaler*>(
+                    item.getItemPointer()
+                );
+            info.s_startTime     = p->s_intervalStartOffset;
+            info.s_endTime       = p->s_intervalEndOffset;
+            info.s_divisor       = p->s_intervalDivisor;
+            info.s_timestamp     = p->s_clockTimestamp;
+            info.s_isIncremental = false;
+            info.s_scalerCount   = p->s_scalerCount;
+        } else {
+            return false;
+        }
+        info.s_originalSid = 0;
+        return true;
+    }
+    /**
+     * getScaler
+     *   @param item - view of a v10 scaler item.
+     *   @param channel - scaler channel; the caller checks it's in range.
+     *   @return uint32_t - the value of that scaler.
+     */
+    uint32_t
+    RingViewDecoder::getScaler(
+        const ::ufmt::CRingItemView& item, uint32_t channel
+    ) const
+    {
+        if (item.type() == v10::INCREMENTAL_SCALERS) {
+            return reinterpret_cast<const v10::ScalerItem*>(
+                item.getItemPointer())->s_scalers[channel];
+        }
+        return reinterpret_cast<const v10::NonIncrTimestampedScaler*>(
+            item.getItemPointer())->s_scalers[channel];
+    }
+    /**
+     * decodeText
+     *    v10 time offsets are in seconds.
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v10 text item.
+     */
+    bool
+    RingViewDecoder::decodeText(
+        const ::ufmt::CRingItemView& item, TextInfo& info
+    ) const
+    {
+        uint32_t t = item.type();
+        if ((item.getVersion() != ::ufmt::FormatSelector::v10) ||
+            ((t != v10::PACKET_TYPES) && (t != v10::MONITORED_VARIABLES))) {
+            return false;
+        }
+        const v10::TextItem* p =
+            reinterpret_cast<const v10::TextItem*>(item.getItemPointer());
+        info.s_stringCount = p->s_stringCount;
+        info.s_pStrings    = p->s_strings;
+        info.s_timeOffset  = p->s_timeOffset;
+        info.s_divisor     = 1;
+        info.s_timestamp   = p->s_timestamp;
+        info.s_originalSid = 0;
+        return true;
+    }
+    /**
+     * decodeStateChange
+     *    v10 time offsets are in seconds.
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v10 state change item.
+     */
+    bool
+    RingViewDecoder::decodeStateChange(
+        const ::ufmt::CRingItemView& item, StateChangeInfo& info
+    ) const
+    {
+        uint32_t t = item.type();
+        if ((item.getVersion() != ::ufmt::FormatSelector::v10) ||
+            ((t != v10::BEGIN_RUN) && (t != v10::END_RUN) &&
+             (t != v10::PAUSE_RUN) && (t != v10::RESUME_RUN))) {
+            return false;
+        }
+        const v10::StateChangeItem* p =
+            reinterpret_cast<const v10::StateChangeItem*>(item.getItemPointer());
+        info.s_runNumber   = p->s_runNumber;
+        info.s_timeOffset  = p->s_timeOffset;
+        info.s_divisor     = 1;
+        info.s_pTitle      = p->s_title;
+        info.s_timestamp   = p->s_Timestamp;
+        info.s_originalSid = 0;
+        return true;
+    }
+    /**
+     * decodeFragment
+     *    In v10 the fragment header is the start of the item body.
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v10 fragment with a
+     *                  complete fragment header.
+     */
+    bool
+    RingViewDecoder::decodeFragment(
+        const ::ufmt::CRingItemView& item, FragmentInfo& info
+    ) const
+    {
+        uint32_t t = item.type();
+        if ((item.getVersion() != ::ufmt::FormatSelector::v10) ||
+            ((t != v10::EVB_FRAGMENT) && (t != v10::EVB_UNKNOWN_PAYLOAD)) ||
+            (item.size() < offsetof(v10::EventBuilderFragment, s_body))) {
+            return false;
+        }
+        const v10::EventBuilderFragment* p =
+            reinterpret_cast<const v10::EventBuilderFragment*>(
+                item.getItemPointer()
+            );
+        info.s_timestamp   = p->s_timestamp;
+        info.s_sourceId    = p->s_sourceId;
+        info.s_barrier     = p->s_barrierType;
+        info.s_payloadSize = p->s_payloadSize;
+        info.s_pPayload    = p->s_body;
+        return true;
+    }
+
+    }                // v10
+}                    // ufmt
@@ -0,0 +1,53 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  RingViewDecoder.h (v10)
+ *  @brief: Decodes v10 items for the typed ring item views.
+ */
+#ifndef V10_RINGVIEWDECODER_H
+#define V10_RINGVIEWDECODER_H
+#include <RingViewDecoderBase.h>
+
+namespace ufmt {
+    namespace v10 {
+
+    class RingViewDecoder : public ::ufmt::RingViewDecoderBase
+    {
+    public:
+        virtual ::ufmt::FormatSelector::SupportedVersions getVersion() const;
+
+        virtual bool decodeScaler(
+            const ::ufmt::CRingItemView& item, ScalerInfo& info
+        ) const;
+        virtual uint32_t getScaler(
+            const ::ufmt::CRingItemView& item, uint32_t channel
+        ) const;
+        virtual bool decodeText(
+            const ::ufmt::CRingItemView& item, TextInfo& info
+        ) const;
+        virtual bool decodeStateChange(
+            const ::ufmt::CRingItemView& item, StateChangeInfo& info
+        ) const;
+        virtual bool decodeFragment(
+            const ::ufmt::CRingItemView& item, FragmentInfo& info
+        ) const;
+    };
+
+    }                // v10
+}                    // ufmt
+#endif
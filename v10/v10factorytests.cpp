@@ -35,6 +35,7 @@
 #include <sys/mman.h>
 #include <stdlib.h>
 #include <fstream>
+#include <sstream>
 #include <stdexcept>
 #include <ios>
 #include <typeinfo>
@@ -47,6 +48,10 @@
 #include "CRingStateChangeItem.h"
 #include "CRingFragmentItem.h"
 #include <CUnknownFragment.h>
+#include <CRingBlockReader.h>
+#include <CRingBlockWriter.h>
+#include <RingItemBatch.h>
+#include <vector>
 #include <memory>
 #pragma GCC diagnostic ignored "-Waddress-of-packed-member"
 #pragma GCC diagnostic ignored "-Wunused-result"
@@ -85,6 +90,9 @@ class v10factorytest : public CppUnit::TestFixture {
     CPPUNIT_TEST(ring_8);
     CPPUNIT_TEST(ring_9);
     CPPUNIT_TEST(ring_10);
+    CPPUNIT_TEST(ring_11);
+    CPPUNIT_TEST(ring_12);
+    CPPUNIT_TEST(ring_13);
     
     CPPUNIT_TEST(abend_1);
     CPPUNIT_TEST(abend_2);
@@ -153,6 +161,9 @@ protected:
     void ring_8();
     void ring_9();
     void ring_10();
+    void ring_11();
+    void ring_12();
+    void ring_13();
     
     void abend_1();
     void abend_2();
@@ -598,6 +609,84 @@ v10factorytest::ring_10()
     delete pReadItem;
 #endif
 }
+// get ring items from an fd via a block reader with a block size that
+// splits the second item across reads.
+void
+v10factorytest::ring_11()
+{
+#pragma packed(push, 1)
+    struct {
+        v10::RingItemHeader s_header;
+        uint16_t             s_body[100];
+    } rawItem;
+#pragma packed(pop)
+    rawItem.s_header.s_type = PHYSICS_EVENT;
+    rawItem.s_header.s_size = sizeof(rawItem);
+    for (int i =0; i < 100; i++) {
+        rawItem.s_body[i] = i;
+    }
+    
+    int fd = memfd_create("TestFile", 0);
+    write(fd, &rawItem, sizeof(rawItem));
+    write(fd, &rawItem, sizeof(rawItem));
+    lseek(fd, 0, SEEK_SET);            // Rewind:
+    
+    ::CRingItem* pItem(0);
+    try {
+        CRingBlockReader reader(fd, sizeof(rawItem) + 10);
+        for (int i = 0; i < 2; i++) {
+            pItem = m_pFactory->getRingItem(reader);
+            ASSERT(pItem);
+            EQ(rawItem.s_header.s_size, pItem->size());
+            EQ(0, memcmp(&rawItem, pItem->getItemPointer(), sizeof(rawItem)));
+            delete pItem;
+            pItem = nullptr;
+        }
+        pItem = m_pFactory->getRingItem(reader);
+        ASSERT(!pItem);
+    }
+    catch (...) {
+        close(fd);
+        delete pItem;
+        throw;
+    }
+    
+    close(fd);
+}
+// Refill an existing item from an fd and a stream.
+void
+v10factorytest::ring_12()
+{
+#pragma packed(push, 1)
+    struct {
+        v10::RingItemHeader s_header;
+        uint16_t             s_body[100];
+    } rawItem;
+#pragma packed(pop)
+    rawItem.s_header.s_type = PHYSICS_EVENT;
+    rawItem.s_header.s_size = sizeof(rawItem);
+    for (int i =0; i < 100; i++) {
+        rawItem.s_body[i] = i;
+    }
+    
+    int fd = memfd_create("TestFile", 0);
+    write(fd, &rawItem, sizeof(rawItem));
+    lseek(fd, 0, SEEK_SET);            // Rewind:
+    
+    std::unique_ptr<::CRingItem> pItem(m_pFactory->makeRingItem(BEGIN_RUN, 10));
+    ASSERT(m_pFactory->getRingItem(fd, *pItem));
+    EQ(rawItem.s_header.s_size, pItem->size());
+    EQ(0, memcmp(&rawItem, pItem->getItemPointer(), sizeof(rawItem)));
+    EQ(sizeof(rawItem.s_body), pItem->getBodySize());
+    ASSERT(!m_pFactory->getRingItem(fd, *pItem));
+    close(fd);
+    
+    std::stringstream s;
+    s.write(reinterpret_cast<const char*>(&rawItem), sizeof(rawItem));
+    std::unique_ptr<::CRingItem> pItem2(m_pFactory->makeRingItem(BEGIN_RUN, 10));
+    ASSERT(m_pFactory->getRingItem(s, *pItem2));
+    EQ(0, memcmp(&rawItem, pItem2->getItemPointer(), sizeof(rawItem)));
+}
 // Can't create an abnormal end item:
 
 void
@@ -1589,4 +1678,48 @@ void v10factorytest::state_8()
 
 void v10factorytest::version_1() {
     EQ(ufmt::FormatSelector::SupportedVersions::v10, m_pFactory->version());
-}
\ No newline at end of file
+}
+// Items put through a block writer, one at a time and as a batch, read
+// back unchanged.  Small blocks make the writer write several times:
+
+void v10factorytest::ring_13()
+{
+    std::vector<::CRingItem*> items;
+    RingItemBatch batch;
+    for (int i = 0; i < 6; i++) {
+        ::CRingItem* pItem = m_pFactory->makeRingItem(v10::PHYSICS_EVENT, 100);
+        uint16_t* p = reinterpret_cast<uint16_t*>(pItem->getBodyCursor());
+        for (int w = 0; w < 10; w++) {
+            *p++ = i*10 + w;
+        }
+        pItem->setBodyCursor(p);
+        pItem->updateSize();
+        items.push_back(pItem);
+        if (i >= 3) {
+            batch.append(*pItem);
+        }
+    }
+    int fd = memfd_create("TestFile", 0);
+    {
+        CRingBlockWriter writer(fd, 64);
+        for (int i = 0; i < 3; i++) {
+            m_pFactory->putRingItem(items[i], writer);
+        }
+        m_pFactory->putRingItem(batch, writer);
+        writer.flush();
+    }
+    lseek(fd, 0, SEEK_SET);
+    
+    std::vector<::CRingItem*> gotten;
+    EQ(size_t(6), m_pFactory->getRingItems(fd, gotten, 10));
+    close(fd);
+    for (int i = 0; i < 6; i++) {
+        EQ(items[i]->size(), gotten[i]->size());
+        EQ(0, memcmp(
+            items[i]->getItemPointer(), gotten[i]->getItemPointer(),
+            items[i]->size()
+        ));
+        delete items[i];
+        delete gotten[i];
+    }
+}
@@ -33,10 +33,10 @@ namespace ufmt {
   class CPhysicsEventItem : public ::ufmt::CPhysicsEventItem
   {
   public:
-    CPhysicsEventItem(size_t maxBody=8192);
+    CPhysicsEventItem(size_t maxBody=CRingItemStaticBufferSize - 10);
     CPhysicsEventItem(                                 // Our factory can use this.
         uint64_t timestamp, uint32_t source, uint32_t barrier,
-        size_t maxBody=8192
+        size_t maxBody=CRingItemStaticBufferSize - 10
     );
 
     virtual ~CPhysicsEventItem();
@@ -15,6 +15,7 @@
 */
 
 #include "CRingItem.h"
+#include <utility>
 #include "DataFormat.h"
 
 #include <string.h>
@@ -92,6 +93,26 @@ namespace ufmt {
   {
     
   }
+  /**
+   * move constructor
+   *   Takes over the storage of rhs (see ::ufmt::CRingItem::moveIn).
+   * @param rhs - item we take over.  It's left empty.
+   */
+  CRingItem::CRingItem(CRingItem&& rhs) :
+    ::ufmt::CRingItem(std::move(rhs))
+  {
+  }
+  /**
+   * move assignment
+   * @param rhs - item we take over.  It's left empty.
+   * @return CRingItem& - *this
+   */
+  CRingItem&
+  CRingItem::operator=(CRingItem&& rhs)
+  {
+    ::ufmt::CRingItem::operator=(std::move(rhs));
+    return *this;
+  }
 
   //////////////////////////////////////////////////////////////////////////////////////////
   //
@@ -154,6 +175,7 @@ namespace ufmt {
   void*
   CRingItem::getBodyPointer()
   {
+      makeWritable();
       const CRingItem* cP = const_cast<const CRingItem*>(this); // force const call?
       const void* pResult = cP->getBodyPointer();
       return const_cast<void*>(pResult);                        // throw away the const.
@@ -45,6 +45,9 @@ namespace ufmt {
     CRingItem(uint16_t type, uint64_t timestamp, uint32_t sourceId,
               uint32_t barrierType, size_t maxBody );
     virtual ~CRingItem();
+
+    CRingItem(CRingItem&& rhs);
+    CRingItem& operator=(CRingItem&& rhs);
   private:  
     CRingItem(const CRingItem& rhs);
     
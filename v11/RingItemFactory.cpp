@@ -44,6 +44,8 @@
 #include <CRingBuffer.h>
 #endif
 #include <io.h>
+#include <CRingBlockReader.h>
+#include <CRingBlockWriter.h>
 #include <stdexcept>
 #include <typeinfo>
 #include <time.h>
@@ -61,7 +63,7 @@ namespace ufmt {
     ::ufmt::CRingItem*
     RingItemFactory::makeRingItem(uint16_t type, size_t maxBody)
     {
-        return new v11::CRingItem(type, maxBody);
+        return newItem<v11::CRingItem>(type, maxBody);
     }
     /**
      * makeRingItem
@@ -78,7 +80,7 @@ namespace ufmt {
         size_t maxBody, uint32_t barrierType
     )
     {
-        return new v11::CRingItem(type, timestamp, sourceId, barrierType, maxBody);
+        return newItem<v11::CRingItem>(type, timestamp, sourceId, barrierType, maxBody);
     }
     /**
      * makeRingItem
@@ -93,7 +95,7 @@ namespace ufmt {
     ::ufmt::CRingItem*
     RingItemFactory::makeRingItem(const ::ufmt::CRingItem& rhs)
     {
-        v11::CRingItem* pItem =  new v11::CRingItem(rhs.type(), rhs.size());
+        v11::CRingItem* pItem =  newItem<v11::CRingItem>(rhs.type(), rhs.size());
         memcpy(pItem->getItemPointer(), rhs.getItemPointer(), rhs.size());
         uint8_t* pCursor = reinterpret_cast<uint8_t*>(pItem->getItemPointer());
         pCursor += rhs.size();
@@ -109,7 +111,7 @@ namespace ufmt {
     ::ufmt::CRingItem*
     RingItemFactory::makeRingItem(const ::ufmt::RingItem* pRawRing)
     {
-        v11::CRingItem* pItem = new v11::CRingItem(
+        v11::CRingItem* pItem = newItem<v11::CRingItem>(
             pRawRing->s_header.s_type, pRawRing->s_header.s_size
         );
         memcpy(pItem->getItemPointer(), pRawRing, pRawRing->s_header.s_size);
@@ -136,7 +138,7 @@ namespace ufmt {
         if (!ringbuf.get(&hdr, sizeof(hdr), sizeof(hdr), timeout)) {
 	    return nullptr;
 	}
-        v11::CRingItem* pItem = new v11::CRingItem(hdr.s_type, hdr.s_size);
+        v11::CRingItem* pItem = newItem<v11::CRingItem>(hdr.s_type, hdr.s_size);
         size_t remaining = hdr.s_size - sizeof(v11::RingItemHeader);
         v11::pRingItem pItemStorage =
             reinterpret_cast<v11::pRingItem>(pItem->getItemPointer());
@@ -161,7 +163,7 @@ namespace ufmt {
         if (fmtio::readData(fd, &hdr, sizeof(hdr)) < sizeof(hdr)) {
             return nullptr;
         }
-        v11::CRingItem* pResult = new v11::CRingItem(hdr.s_type, hdr.s_size);
+        v11::CRingItem* pResult = newItem<v11::CRingItem>(hdr.s_type, hdr.s_size);
         
         v11::pRingItem pRawItem =
             reinterpret_cast<v11::pRingItem>(pResult->getItemPointer());
@@ -191,7 +193,7 @@ namespace ufmt {
         if (!in) {
             return nullptr;            
         }
-        v11::CRingItem* pResult = new v11::CRingItem(hdr.s_type, hdr.s_size);
+        v11::CRingItem* pResult = newItem<v11::CRingItem>(hdr.s_type, hdr.s_size);
         size_t remaining = hdr.s_size - sizeof(v11::RingItemHeader);
         v11::pRingItem pRawItem =
             reinterpret_cast<v11::pRingItem>(pResult->getItemPointer());
@@ -207,6 +209,155 @@ namespace ufmt {
         return pResult;
         
     }
+    /**
+     * getRingItem
+     *   @param reader - block buffered reader open on the ring item source.
+     *   @return ::CRingItem* points to a dynamically allocated v11 ring item.
+     *   @retval nullptr - eof.
+     */
+    ::ufmt::CRingItem*
+    RingItemFactory::getRingItem(::ufmt::CRingBlockReader& reader)
+    {
+        const ::ufmt::RingItem* pRaw = reader.nextItem();
+        if (!pRaw) {
+            return nullptr;
+        }
+        return makeRingItem(pRaw);
+    }
+    #ifdef HAVE_NSCLDAQ
+    /**
+     * getRingItem (refill from ring buffer)
+     *    Get the next ring item from a ring buffer into an existing item.
+     *    The item's storage is only reallocated if it's too small.
+     * @param ringbuf - ring buffer from which the item is gotten.
+     * @param item    - item to fill in.
+     * @param timeout - seconds to wait for the header.
+     * @return bool   - false if the header could not be gotten in time.
+     */
+    bool
+    RingItemFactory::getRingItem(
+        ::CRingBuffer& ringbuf, ::ufmt::CRingItem& item, unsigned long timeout
+    )
+    {
+        v11::RingItemHeader hdr;
+        if (!ringbuf.get(&hdr, sizeof(hdr), sizeof(hdr), timeout)) {
+            return false;
+        }
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        uint32_t remaining = hdr.s_size - sizeof(hdr);
+        if (remaining) {
+            ringbuf.get(p, remaining, remaining);
+            p += remaining;
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        return true;
+    }
+    #endif
+    /**
+     * getRingItem (refill from file descriptor)
+     *    Read the next ring item from a file descriptor into an existing
+     *    item.  The item's storage is only reallocated if it's too small.
+     * @param fd   - file descriptor open on the ring item source.
+     * @param item - item to fill in.
+     * @return bool - false on end of file.  If the end of file is in the
+     *                middle of an item the contents of item are undefined.
+     */
+    bool
+    RingItemFactory::getRingItem(int fd, ::ufmt::CRingItem& item)
+    {
+        v11::RingItemHeader hdr;
+        if (fmtio::readData(fd, &hdr, sizeof(hdr)) < sizeof(hdr)) {
+            return false;
+        }
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        uint32_t remaining = hdr.s_size - sizeof(hdr);
+        if (remaining) {
+            if (fmtio::readData(fd, p, remaining) < remaining) {
+                return false;
+            }
+            p += remaining;
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        return true;
+    }
+    /**
+     * getRingItem (refill from std::istream)
+     * @param in   - stream open on the ring item source.
+     * @param item - item to fill in.
+     * @return bool - false if the item could not be read; the stream has
+     *                the reason.
+     */
+    bool
+    RingItemFactory::getRingItem(std::istream& in, ::ufmt::CRingItem& item)
+    {
+        v11::RingItemHeader hdr;
+        in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+        if (!in) {
+            return false;
+        }
+        char* p = reinterpret_cast<char*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        size_t remaining = hdr.s_size - sizeof(hdr);
+        in.read(p, remaining);
+        if (!in) {
+            return false;
+        }
+        item.setBodyCursor(p + remaining);
+        item.updateSize();
+        return true;
+    }
+    /**
+     * getRingItem (refill from block reader)
+     * @param reader - block buffered reader on the ring item source.
+     * @param item   - item to fill in.
+     * @return bool  - false on end of file.
+     */
+    bool
+    RingItemFactory::getRingItem(
+        ::ufmt::CRingBlockReader& reader, ::ufmt::CRingItem& item
+    )
+    {
+        const ::ufmt::RingItem* pRaw = reader.nextItem();
+        if (!pRaw) {
+            return false;
+        }
+        refillItem(item, pRaw);
+        return true;
+    }
+    /**
+     * getRingItems
+     *    Refill a batch of items from a block reader.  The reader is looped
+     *    over here rather than through a getRingItem call per item.
+     * @param reader - the block reader.
+     * @param items  - the batch; lengthened as needed.
+     * @param maxItems - most items to get.
+     * @return size_t - number of items gotten; fewer than maxItems only at
+     *                the end of the data.
+     */
+    size_t
+    RingItemFactory::getRingItems(
+        ::ufmt::CRingBlockReader& reader,
+        std::vector<::ufmt::CRingItem*>& items, size_t maxItems
+    )
+    {
+        size_t n = 0;
+        while (n < maxItems) {
+            const ::ufmt::RingItem* pRaw = reader.nextItem();
+            if (!pRaw) {
+                break;
+            }
+            refillItem(*batchItem(items, n), pRaw);
+            n++;
+        }
+        return n;
+    }
     /**
      * putRingItem
      *     Put a ring item into a stream.  This blocks, if necessary
@@ -239,6 +390,21 @@ namespace ufmt {
         size_t bytes      = pItem->size();
         fmtio::writeData(fd, pData, bytes);
     }
+    /**
+     * putRingItem
+     *    Put a ring item through a block writer, which coalesces items
+     *    into large writes.
+     * @param pItem - pointer to the item to put.
+     * @param writer - the writer.
+     * @throw errors from fmtio::writeData are thrown as exceptions.
+     */
+    void
+    RingItemFactory::putRingItem(
+        const ::ufmt::CRingItem* pItem, ::ufmt::CRingBlockWriter& writer
+    )
+    {
+        writer.put(pItem->getItemPointer(), pItem->size());
+    }
     #ifdef HAVE_NSCLDAQ    
     /**
      * putRingItem
@@ -262,7 +428,7 @@ namespace ufmt {
     ::ufmt::CAbnormalEndItem*
     RingItemFactory::makeAbnormalEndItem()
     {
-        return new v11::CAbnormalEndItem;
+        return newItem<v11::CAbnormalEndItem>();
     }
     /**
      * makeAbnormalEndITem
@@ -279,7 +445,7 @@ namespace ufmt {
         if (rhs.type() == v11::ABNORMAL_ENDRUN) {
             // there are no contents to speak of so:
             
-            return new v11::CAbnormalEndItem;
+            return newItem<v11::CAbnormalEndItem>();
         } else {
             throw std::bad_cast();
         }
@@ -291,7 +457,7 @@ namespace ufmt {
     ::ufmt::CDataFormatItem*
     RingItemFactory::makeDataFormatItem()
     {
-        return new CDataFormatItem;           // Has right versions.
+        return newItem<CDataFormatItem>();           // Has right versions.
     }
     /**
      * makeDataFormatItem.
@@ -310,7 +476,7 @@ namespace ufmt {
             if (p->s_majorVersion != v11::FORMAT_MAJOR) {
                 throw std::bad_cast();
             } else {
-                return new v11::CDataFormatItem;
+                return newItem<v11::CDataFormatItem>();
             }
         } else {
             throw std::bad_cast();
@@ -333,7 +499,7 @@ namespace ufmt {
     {
         ::ufmt::CGlomParameters::TimestampPolicy ePolicy =
             static_cast<::ufmt::CGlomParameters::TimestampPolicy>(policy);
-        return new CGlomParameters(interval, isBuilding, ePolicy);
+        return newItem<CGlomParameters>(interval, isBuilding, ePolicy);
     }
     /**
      * makeGlomParameters
@@ -349,7 +515,7 @@ namespace ufmt {
         if (rhs.type() == v11::EVB_GLOM_INFO) {
             const v11::GlomParameters* pGlom =
                 reinterpret_cast<const v11::GlomParameters*>(rhs.getItemPointer());
-            return new v11::CGlomParameters(
+            return newItem<v11::CGlomParameters>(
                 pGlom->s_coincidenceTicks, pGlom->s_isBuilding,
                 static_cast<::ufmt::CGlomParameters::TimestampPolicy>(pGlom->s_timestampPolicy)
             );
@@ -368,7 +534,7 @@ namespace ufmt {
     ::ufmt::CPhysicsEventItem*
     RingItemFactory::makePhysicsEventItem(size_t maxbody)
     {
-        return new v11::CPhysicsEventItem(maxbody);
+        return newItem<v11::CPhysicsEventItem>(maxbody);
     }
     /**
      * makePhysicsEventItem
@@ -385,7 +551,7 @@ namespace ufmt {
         uint64_t timestamp, uint32_t source, uint32_t barrier, size_t maxsize
     )
     {
-        return new v11::CPhysicsEventItem(
+        return newItem<v11::CPhysicsEventItem>(
             timestamp, source, barrier, maxsize
         );
     }
@@ -406,7 +572,7 @@ namespace ufmt {
     RingItemFactory::makePhysicsEventItem(const ::ufmt::CRingItem& rhs)
     {
         if (rhs.type() == v11::PHYSICS_EVENT) {
-            v11::CPhysicsEventItem* pResult = new v11::CPhysicsEventItem(rhs.size());
+            v11::CPhysicsEventItem* pResult = newItem<v11::CPhysicsEventItem>(rhs.size());
             
             if (rhs.hasBodyHeader()) {
                 const v11::BodyHeader* pBh =
@@ -451,7 +617,7 @@ namespace ufmt {
         uint32_t payloadSize, const void* payload, uint32_t barrier
     )
     {
-        return new v11::CRingFragmentItem(
+        return newItem<v11::CRingFragmentItem>(
             timestamp, source, payloadSize, payload, barrier
         );
     }
@@ -492,7 +658,7 @@ namespace ufmt {
         uint64_t count, uint32_t timeoffset, time_t stamp, int divisor
     )
     {
-        return new v11::CRingPhysicsEventCountItem(
+        return newItem<v11::CRingPhysicsEventCountItem>(
             count, timeoffset, stamp, divisor
         );
     }
@@ -515,7 +681,7 @@ namespace ufmt {
             } else {
                 pBody = &(pItem->s_body.u_noBodyHeader.s_body);
             }
-            return new v11::CRingPhysicsEventCountItem(
+            return newItem<v11::CRingPhysicsEventCountItem>(
                 pBody->s_eventCount, pBody->s_timeOffset, pBody->s_timestamp,
                 pBody->s_offsetDivisor
             );
@@ -534,7 +700,7 @@ namespace ufmt {
     ::ufmt::CRingScalerItem*
     RingItemFactory::makeScalerItem(size_t numScalers)
     {
-        return new v11::CRingScalerItem(numScalers);
+        return newItem<v11::CRingScalerItem>(numScalers);
     }
     /**
      * makeScaleritem
@@ -557,7 +723,7 @@ namespace ufmt {
         uint32_t sid, uint32_t timeOffsetDivisor
     )
     {
-        return new v11::CRingScalerItem(
+        return newItem<v11::CRingScalerItem>(
             startTime, stopTime, timestamp, scalers, isIncremental,
             sid, timeOffsetDivisor
         );
@@ -587,7 +753,7 @@ namespace ufmt {
                 source = pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_sourceId;
                 pBody  = &(pItem->s_body.u_hasBodyHeader.s_body);
                 std::vector<uint32_t> scalers(pBody->s_scalers, pBody->s_scalers + pBody->s_scalerCount);
-                return new v11::CRingScalerItem(
+                return newItem<v11::CRingScalerItem>(
                     pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_timestamp,
                     pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_sourceId,
                     pItem->s_body.u_hasBodyHeader.s_bodyHeader.s_barrier,
@@ -596,7 +762,7 @@ namespace ufmt {
                 );
             } else {
                 pBody = &(pItem->s_body.u_noBodyHeader.s_body);
-                auto pResult = new v11::CRingScalerItem(pBody->s_scalerCount);
+                auto pResult = newItem<v11::CRingScalerItem>(pBody->s_scalerCount);
                 memcpy(pResult->getItemPointer(), pItem, pItem->s_header.s_size);
                 return pResult;
             }
@@ -630,7 +796,7 @@ namespace ufmt {
         uint16_t type, std::vector<std::string> theStrings
     )
     {
-        return new v11::CRingTextItem(type, theStrings, 0, time(nullptr));
+        return newItem<v11::CRingTextItem>(type, theStrings, 0, time(nullptr));
     }
     /**
      * makeTextItem
@@ -657,7 +823,7 @@ namespace ufmt {
         time_t                   timestamp, uint32_t divisor
     ) 
     {
-        return new v11::CRingTextItem(
+        return newItem<v11::CRingTextItem>(
             type, theStrings, offsetTime, timestamp, divisor
         );
     }
@@ -718,7 +884,7 @@ namespace ufmt {
         uint32_t size, void* pPayload
     )
     {
-        return new v11::CUnknownFragment(
+        return newItem<v11::CUnknownFragment>(
             timestamp, sourceid, barrier, size, pPayload
         );
     }
@@ -766,7 +932,7 @@ namespace ufmt {
         std::string title
     )
     {
-        return new v11::CRingStateChangeItem(
+        return newItem<v11::CRingStateChangeItem>(
             itemType, runNumber, timeOffset, timestamp, title
         );
     }
@@ -804,13 +970,13 @@ namespace ufmt {
             reinterpret_cast<const v11::StateChangeItemBody*>(rhs.getBodyPointer());
         if (rhs.hasBodyHeader()) {
             const v11::BodyHeader *pb = reinterpret_cast<const v11::BodyHeader*>(rhs.getBodyHeader());
-            return new v11::CRingStateChangeItem(
+            return newItem<v11::CRingStateChangeItem>(
                 pb->s_timestamp, pb->s_sourceId, pb->s_barrier,
                 rhs.type(), pBody->s_runNumber, pBody->s_timeOffset,
                 pBody->s_Timestamp, pBody->s_title, pBody->s_offsetDivisor
             );
         } else {
-            return new v11::CRingStateChangeItem(
+            return newItem<v11::CRingStateChangeItem>(
                 rhs.type(), pBody->s_runNumber, pBody->s_timeOffset,
                 pBody->s_Timestamp,
                 pBody->s_title, pBody->s_offsetDivisor
@@ -822,6 +988,114 @@ namespace ufmt {
 
     
 
+    ///////////////////////////////////////////////////////////////
+    // Conversions that take over the storage of an rvalue item.
+    // The checks are the same as for the copying conversions above;
+    // the items are then given rhs's storage (see adoptItem).  rhs is
+    // left empty.
+    
+    /**
+     * makeRingItem
+     *    Like a move constructor.
+     * @param rhs - ring item whose storage we take.
+     * @return ::ufmt::CRingItem*
+     */
+    ::ufmt::CRingItem*
+    RingItemFactory::makeRingItem(::ufmt::CRingItem&& rhs)
+    {
+        return adoptItem<v11::CRingItem>(std::move(rhs), rhs.type(), size_t(0));
+    }
+    /**
+     * makePhysicsEventItem
+     * @param rhs - item whose storage we take; must be a v11::PHYSICS_EVENT.
+     * @return ::ufmt::CPhysicsEventItem*
+     * @throw std::bad_cast if the source item is not a physics item.
+     */
+    ::ufmt::CPhysicsEventItem*
+    RingItemFactory::makePhysicsEventItem(::ufmt::CRingItem&& rhs)
+    {
+        if (rhs.type() != v11::PHYSICS_EVENT) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v11::CPhysicsEventItem>(std::move(rhs), size_t(0));
+    }
+    /**
+     * makeRingFragmentItem
+     *    Only v11::EVB_FRAGMENT items are adopted.  Unknown payload items
+     *    are made as unknown fragments by the copying conversion.
+     * @param rhs - item whose storage we take.
+     * @return ::ufmt::CRingFragmentItem*
+     * @throw std::bad_cast if rhs is not a fragment.
+     */
+    ::ufmt::CRingFragmentItem*
+    RingItemFactory::makeRingFragmentItem(::ufmt::CRingItem&& rhs)
+    {
+        if (rhs.type() == v11::EVB_UNKNOWN_PAYLOAD) {
+            const ::ufmt::CRingItem& r(rhs);
+            return makeRingFragmentItem(r);
+        }
+        if (rhs.type() != v11::EVB_FRAGMENT) {
+            throw std::bad_cast();
+        }
+        if (rhs.size() < sizeof(v11::RingItemHeader) + sizeof(v11::BodyHeader)) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v11::CRingFragmentItem>(
+            std::move(rhs), 0, 0, 0, nullptr, 0
+        );
+    }
+    /**
+     * makeScalerItem
+     * @param rhs - item whose storage we take; must be v11::PERIODIC_SCALERS.
+     * @return ::ufmt::CRingScalerItem*
+     * @throw std::bad_cast if rhs is not a scaler item.
+     */
+    ::ufmt::CRingScalerItem*
+    RingItemFactory::makeScalerItem(::ufmt::CRingItem&& rhs)
+    {
+        if (rhs.type() != v11::PERIODIC_SCALERS) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v11::CRingScalerItem>(std::move(rhs), size_t(0));
+    }
+    /**
+     * makeTextItem
+     * @param rhs - item whose storage we take.
+     * @return ::ufmt::CRingTextItem*
+     * @throws std::invalid_argument - rhs is not a text item type (as the
+     *        copying conversion).
+     */
+    ::ufmt::CRingTextItem*
+    RingItemFactory::makeTextItem(::ufmt::CRingItem&& rhs)
+    {
+        return adoptItem<v11::CRingTextItem>(
+            std::move(rhs), rhs.type(), std::vector<std::string>(), 0, time_t(0)
+        );
+    }
+    /**
+     * makeStateChangeItem
+     * @param rhs - item whose storage we take; must be a valid state change
+     *        item.
+     * @return ::ufmt::CRingStateChangeItem*
+     * @throw std::bad_cast if rhs is not a state change item or is the wrong
+     *        size.
+     */
+    ::ufmt::CRingStateChangeItem*
+    RingItemFactory::makeStateChangeItem(::ufmt::CRingItem&& rhs)
+    {
+        if (!CRingStateChangeItem::isStateChange(rhs.type())) {
+            throw std::bad_cast();
+        }
+        size_t nobheaderSize = sizeof(v11::RingItemHeader) + sizeof(uint32_t) +
+            sizeof(v11::StateChangeItemBody);
+        size_t bodyHeaderSize = sizeof(v11::RingItemHeader) + sizeof(v11::BodyHeader) +
+            sizeof(v11::StateChangeItemBody);
+        if ((rhs.size() != nobheaderSize) && (rhs.size() != bodyHeaderSize)) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v11::CRingStateChangeItem>(std::move(rhs), rhs.type());
+    }
+
     ufmt::FormatSelector::SupportedVersions  RingItemFactory::version() {
             return ufmt::FormatSelector::SupportedVersions::v11;
         }
@@ -850,5 +1124,21 @@ namespace ufmt {
     }
 
 
+    /**
+     * refillItem
+     *    Copy a raw item into an existing item, whose storage is only
+     *    reallocated if it's too small.
+     * @param item - item to fill in.
+     * @param pRaw - the raw item.
+     */
+    void
+    RingItemFactory::refillItem(::ufmt::CRingItem& item, const ::ufmt::RingItem* pRaw)
+    {
+        uint32_t size = pRaw->s_header.s_size;
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(size));
+        memcpy(p, pRaw, size);
+        item.setBodyCursor(p + size);
+        item.updateSize();
+    }
     }                             // v11
 }
\ No newline at end of file
@@ -0,0 +1,175 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+
+/** @file:  RingViewDecoder.cpp (v11)
+ *  @brief: Implement the v11 decoder for the typed ring item views.
+ */
+#include "RingViewDecoder.h"
+#include "DataFormat.h"
+#include <CRingItemView.h>
+
+namespace ufmt {
+    namespace v11 {
+    /**
+     * originalSid
+     *    v11 items don't carry their original source id; the body header
+     *    source id is used if there is one.
+     */
+    static uint32_t
+    originalSid(const ::ufmt::CRingItemView& item)
+    {
+        return item.hasBodyHeader() ? item.getSourceId() : 0;
+    }
+    /**
+     * getVersion
+     *   @return FormatSelector::SupportedVersions - v11.
+     */
+    ::ufmt::FormatSelector::SupportedVersions
+    RingViewDecoder::getVersion() const
+    {
+        return ::ufmt::FormatSelector::v11;
+    }
+    /**
+     * decodeScaler
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v11 PERIODIC_SCALERS item.
+     */
+    bool
+    RingViewDecoder::decodeScaler(
+        const ::ufmt::CRingItemView& item, ScalerInfo& info
+    ) const
+    {
+        if ((item.getVersion() != ::ufmt::FormatSelector::v11) ||
+            (item.type() != v11::PERIODIC_SCALERS)) {
+            return false;
+        }
+        const v11::ScalerItemBody* pBody =
+            reinterpret_cast<const v11::ScalerItemBody*>(item.getBodyPointer());
+        info.s_startTime     = pBody->s_intervalStartOffset;
+        info.s_endTime       = pBody->s_intervalEndOffset;
+        info.s_divisor       = pBody->s_intervalDivisor;
+        info.s_timestamp     = pBody->s_timestamp;
+        info.s_isIncremental = pBody->s_isIncremental != 0;
+        info.s_scalerCount   = pBody->s_scalerCount;
+        info.s_originalSid   = originalSid(item);
+        return true;
+    }
+    /**
+     * getScaler
+     *   @param item - view of a v11 scaler item.
+     *   @param channel - scaler channel; the caller checks it's in range.
+     *   @return uint32_t - the value of that scaler.
+     */
+    uint32_t
+    RingViewDecoder::getScaler(
+        const ::ufmt::CRingItemView& item, uint32_t channel
+    ) const
+    {
+        const v11::ScalerItemBody* pBody =
+            reinterpret_cast<const v11::ScalerItemBody*>(item.getBodyPointer());
+        return pBody->s_scalers[channel];
+    }
+    /**
+     * decodeText
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v11 text item.
+     */
+    bool
+    RingViewDecoder::decodeText(
+        const ::ufmt::CRingItemView& item, TextInfo& info
+    ) const
+    {
+        uint32_t t = item.type();
+        if ((item.getVersion() != ::ufmt::FormatSelector::v11) ||
+            ((t != v11::PACKET_TYPES) && (t != v11::MONITORED_VARIABLES))) {
+            return false;
+        }
+        const v11::TextItemBody* pBody =
+            reinterpret_cast<const v11::TextItemBody*>(item.getBodyPointer());
+        info.s_stringCount = pBody->s_stringCount;
+        info.s_pStrings    = pBody->s_strings;
+        info.s_timeOffset  = pBody->s_timeOffset;
+        info.s_divisor     = pBody->s_offsetDivisor;
+        info.s_timestamp   = pBody->s_timestamp;
+        info.s_originalSid = originalSid(item);
+        return true;
+    }
+    /**
+     * decodeStateChange
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v11 state change item.
+     */
+    bool
+    RingViewDecoder::decodeStateChange(
+        const ::ufmt::CRingItemView& item, StateChangeInfo& info
+    ) const
+    {
+        uint32_t t = item.type();
+        if ((item.getVersion() != ::ufmt::FormatSelector::v11) ||
+            ((t != v11::BEGIN_RUN) && (t != v11::END_RUN) &&
+             (t != v11::PAUSE_RUN) && (t != v11::RESUME_RUN))) {
+            return false;
+        }
+        const v11::StateChangeItemBody* pBody =
+            reinterpret_cast<const v11::StateChangeItemBody*>(
+                item.getBodyPointer()
+            );
+        info.s_runNumber   = pBody->s_runNumber;
+        info.s_timeOffset  = pBody->s_timeOffset;
+        info.s_divisor     = pBody->s_offsetDivisor;
+        info.s_pTitle      = pBody->s_title;
+        info.s_timestamp   = pBody->s_Timestamp;
+        info.s_originalSid = originalSid(item);
+        return true;
+    }
+    /**
+     * decodeFragment
+     *    In v11 the fragment header is the body header.
+     *   @param item - view of a ring item.
+     *   @param info - filled in from the item.
+     *   @return bool - false if the item is not a v11 fragment with a
+     *                  complete body header.
+     */
+    bool
+    RingViewDecoder::decodeFragment(
+        const ::ufmt::CRingItemView& item, FragmentInfo& info
+    ) const
+    {
+        uint32_t t = item.type();
+        if ((item.getVersion() != ::ufmt::FormatSelector::v11) ||
+            ((t != v11::EVB_FRAGMENT) && (t != v11::EVB_UNKNOWN_PAYLOAD)) ||
+            (item.size() < sizeof(v11::EventBuilderFragment))) {
+            return false;
+        }
+        const v11::EventBuilderFragment* pItem =
+            reinterpret_cast<const v11::EventBuilderFragment*>(
+                item.getItemPointer()
+            );
+        info.s_timestamp   = pItem->s_bodyHeader.s_timestamp;
+        info.s_sourceId    = pItem->s_bodyHeader.s_sourceId;
+        info.s_barrier     = pItem->s_bodyHeader.s_barrier;
+        info.s_payloadSize = item.size() - sizeof(v11::EventBuilderFragment);
+        info.s_pPayload    = pItem->s_body;
+        return true;
+    }
+
+    }                // v11
+}                    // ufmt
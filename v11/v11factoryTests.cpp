@@ -26,6 +26,10 @@
 #include "DataFormat.h"
 
 #include <CRingItem.h>
+#include <CRingBlockReader.h>
+#include <CRingBlockWriter.h>
+#include <RingItemBatch.h>
+#include <vector>
 #include "CRingItem.h"  // v11
 #include <CAbnormalEndItem.h>
 #include <CDataFormatItem.h>
@@ -80,10 +84,13 @@ class v11facttest : public CppUnit::TestFixture {
     CPPUNIT_TEST(get_1);
     CPPUNIT_TEST(get_2);
     CPPUNIT_TEST(get_3);
+    CPPUNIT_TEST(get_4);
+    CPPUNIT_TEST(get_5);
     
     CPPUNIT_TEST(put_1);
     CPPUNIT_TEST(put_2);
     CPPUNIT_TEST(put_3);
+    CPPUNIT_TEST(put_4);
     
     CPPUNIT_TEST(abnormal_1);
     CPPUNIT_TEST(abnormal_2);
@@ -155,10 +162,13 @@ protected:
     void get_1();
     void get_2();
     void get_3();
+    void get_4();
+    void get_5();
     
     void put_1();
     void put_2();
     void put_3();
+    void put_4();
     
     void abnormal_1();
     void abnormal_2();
@@ -477,6 +487,85 @@ void v11facttest::get_3()
     }
     delete pGotten;
 }
+/* get from a block reader on a file descriptor. */
+void v11facttest::get_4()
+{
+    int fd = memfd_create("factory-test", 0);
+    ::CRingItem* pGotten(0);
+    
+    try {
+        v11::CRingItem  item(v11::PHYSICS_EVENT, 200);
+        uint16_t* p = reinterpret_cast<uint16_t*>(item.getBodyCursor());
+        for (int i =0; i < 20; i++) {
+            *p++ = i;            
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        write(fd, item.getItemPointer(), item.size());
+        lseek(fd, 0, SEEK_SET);   // rewind the memory file.
+        
+        CRingBlockReader reader(fd);
+        pGotten = m_pFactory->getRingItem(reader);
+        ASSERT(pGotten != nullptr);
+        EQ(item.size(), pGotten->size());
+        EQ(0, memcmp(item.getItemPointer(), pGotten->getItemPointer(), item.size()));
+        
+        // Check pGotten's cursor.
+        
+        const uint8_t* pBeg = reinterpret_cast<const uint8_t*>(pGotten->getItemPointer());
+        const uint8_t* pEnd = reinterpret_cast<const uint8_t*>(pGotten->getBodyCursor());
+        EQ(ptrdiff_t(pGotten->size()), pEnd - pBeg);
+        
+        delete pGotten;
+        pGotten = m_pFactory->getRingItem(reader);
+        ASSERT(pGotten == nullptr);     // EOF.
+    }
+    catch (...) {
+        close(fd);
+        delete pGotten;
+        throw;
+    }
+    close(fd);
+}
+/* refill an existing item from a file descriptor. */
+void v11facttest::get_5()
+{
+    int fd = memfd_create("factory-test", 0);
+    ::CRingItem* pGotten(0);
+    
+    try {
+        v11::CRingItem  item(v11::PHYSICS_EVENT, 200);
+        uint16_t* p = reinterpret_cast<uint16_t*>(item.getBodyCursor());
+        for (int i =0; i < 20; i++) {
+            *p++ = i;            
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        write(fd, item.getItemPointer(), item.size());
+        write(fd, item.getItemPointer(), item.size());
+        lseek(fd, 0, SEEK_SET);   // rewind the memory file.
+        
+        pGotten = m_pFactory->makeRingItem(v11::BEGIN_RUN, 100);
+        ASSERT(m_pFactory->getRingItem(fd, *pGotten));
+        EQ(item.size(), pGotten->size());
+        EQ(0, memcmp(item.getItemPointer(), pGotten->getItemPointer(), item.size()));
+        const uint8_t* pBeg = reinterpret_cast<const uint8_t*>(pGotten->getItemPointer());
+        const uint8_t* pEnd = reinterpret_cast<const uint8_t*>(pGotten->getBodyCursor());
+        EQ(ptrdiff_t(pGotten->size()), pEnd - pBeg);
+        
+        CRingBlockReader reader(fd);
+        ASSERT(m_pFactory->getRingItem(reader, *pGotten));
+        EQ(0, memcmp(item.getItemPointer(), pGotten->getItemPointer(), item.size()));
+        ASSERT(!m_pFactory->getRingItem(reader, *pGotten));
+    }
+    catch (...) {
+        close(fd);
+        delete pGotten;
+        throw;
+    }
+    close(fd);
+    delete pGotten;
+}
 // put to std::ostream:
 
 void v11facttest::put_1()
@@ -1625,4 +1714,48 @@ void v11facttest::state_5() {
 
 void v11facttest::version_1() {
     EQ(ufmt::FormatSelector::SupportedVersions::v11, m_pFactory->version());
-}
\ No newline at end of file
+}
+// Items put through a block writer, one at a time and as a batch, read
+// back unchanged.  Small blocks make the writer write several times:
+
+void v11facttest::put_4()
+{
+    std::vector<::CRingItem*> items;
+    RingItemBatch batch;
+    for (int i = 0; i < 6; i++) {
+        ::CRingItem* pItem = m_pFactory->makeRingItem(v11::PHYSICS_EVENT, 100);
+        uint16_t* p = reinterpret_cast<uint16_t*>(pItem->getBodyCursor());
+        for (int w = 0; w < 10; w++) {
+            *p++ = i*10 + w;
+        }
+        pItem->setBodyCursor(p);
+        pItem->updateSize();
+        items.push_back(pItem);
+        if (i >= 3) {
+            batch.append(*pItem);
+        }
+    }
+    int fd = memfd_create("factory-test", 0);
+    {
+        CRingBlockWriter writer(fd, 64);
+        for (int i = 0; i < 3; i++) {
+            m_pFactory->putRingItem(items[i], writer);
+        }
+        m_pFactory->putRingItem(batch, writer);
+        writer.flush();
+    }
+    lseek(fd, 0, SEEK_SET);
+    
+    std::vector<::CRingItem*> gotten;
+    EQ(size_t(6), m_pFactory->getRingItems(fd, gotten, 10));
+    close(fd);
+    for (int i = 0; i < 6; i++) {
+        EQ(items[i]->size(), gotten[i]->size());
+        EQ(0, memcmp(
+            items[i]->getItemPointer(), gotten[i]->getItemPointer(),
+            items[i]->size()
+        ));
+        delete items[i];
+        delete gotten[i];
+    }
+}
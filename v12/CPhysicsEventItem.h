@@ -35,8 +35,8 @@ namespace ufmt {
     class CPhysicsEventItem : public ::ufmt::CPhysicsEventItem
     {
     public:
-        CPhysicsEventItem(size_t maxBody=8192);
-        CPhysicsEventItem(uint64_t ts, uint32_t sid, uint32_t barrierType, size_t maxBody=8192);
+        CPhysicsEventItem(size_t maxBody=CRingItemStaticBufferSize - 10);
+        CPhysicsEventItem(uint64_t ts, uint32_t sid, uint32_t barrierType, size_t maxBody=CRingItemStaticBufferSize - 10);
         virtual ~CPhysicsEventItem();
         
     private:
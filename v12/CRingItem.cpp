@@ -18,6 +18,7 @@
 
 
 #include "CRingItem.h"
+#include <utility>
 #include "DataFormat.h"
 
 #include <string.h>
@@ -97,6 +98,26 @@ namespace ufmt {
   {
     deleteIfNecessary();
   }
+  /**
+   * move constructor
+   *   Takes over the storage of rhs (see ::ufmt::CRingItem::moveIn).
+   * @param rhs - item we take over.  It's left empty.
+   */
+  CRingItem::CRingItem(CRingItem&& rhs) :
+    ::ufmt::CRingItem(std::move(rhs))
+  {
+  }
+  /**
+   * move assignment
+   * @param rhs - item we take over.  It's left empty.
+   * @return CRingItem& - *this
+   */
+  CRingItem&
+  CRingItem::operator=(CRingItem&& rhs)
+  {
+    ::ufmt::CRingItem::operator=(std::move(rhs));
+    return *this;
+  }
 
   //////////////////////////////////////////////////////////////////////////////////////////
   //
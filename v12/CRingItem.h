@@ -50,6 +50,9 @@ namespace ufmt {
               uint32_t barrierType = 0, size_t maxBody = CRingItemStaticBufferSize - 10);
     virtual ~CRingItem();
 
+    CRingItem(CRingItem&& rhs);
+    CRingItem& operator=(CRingItem&& rhs);
+
   private:
     CRingItem(const CRingItem& rhs);
     
@@ -39,6 +39,8 @@
 #include <CRingBuffer.h>
 #endif
 #include <io.h>
+#include <CRingBlockReader.h>
+#include <CRingBlockWriter.h>
 #include <stdexcept>
 #include <set>
 #pragma GCC diagnostic ignored "-Waddress-of-packed-member"
@@ -60,7 +62,7 @@ namespace ufmt {
     ::ufmt::CRingItem*
     RingItemFactory::makeRingItem(uint16_t type, size_t maxbody)
     {
-        return new v12::CRingItem(type, maxbody);
+        return newItem<v12::CRingItem>(type, maxbody);
     }
     /**
      * makeRingItem
@@ -78,7 +80,7 @@ namespace ufmt {
         size_t maxBody, uint32_t barrierType
     )
     {
-        return new v12::CRingItem(type, timestamp, sourceId, barrierType, maxBody);    
+        return newItem<v12::CRingItem>(type, timestamp, sourceId, barrierType, maxBody);    
     }
     /**
      * makeRingItem
@@ -91,7 +93,7 @@ namespace ufmt {
         const ::ufmt::CRingItem& rhs
     )
     {
-        v12::CRingItem* pResult = new v12::CRingItem(rhs.type(), rhs.size());
+        v12::CRingItem* pResult = newItem<v12::CRingItem>(rhs.type(), rhs.size());
         memcpy(pResult->getItemPointer(), rhs.getItemPointer(), rhs.size());
 
         // Figure out where the cursor should be:
@@ -112,7 +114,7 @@ namespace ufmt {
         const ::ufmt::RingItem* rhs
     )
     {
-        v12::CRingItem* pResult = new v12::CRingItem(
+        v12::CRingItem* pResult = newItem<v12::CRingItem>(
             rhs->s_header.s_type, rhs->s_header.s_size
         );
 
@@ -140,7 +142,7 @@ namespace ufmt {
         if (!ringbuf.get(&hdr, sizeof(hdr), sizeof(hdr), timeout)) {
 	    return nullptr;
 	}
-        v12::CRingItem* pResult = new CRingItem(hdr.s_type, hdr.s_size);
+        v12::CRingItem* pResult = newItem<CRingItem>(hdr.s_type, hdr.s_size);
         
         // Read the remainder of the item:
         
@@ -172,7 +174,7 @@ namespace ufmt {
             return nullptr;
         }
         
-        v12::CRingItem* pResult = new v12::CRingItem(hdr.s_type, hdr.s_size);
+        v12::CRingItem* pResult = newItem<v12::CRingItem>(hdr.s_type, hdr.s_size);
         
         uint8_t* p = reinterpret_cast<uint8_t*>(pResult->getItemPointer());
         p += sizeof(hdr);
@@ -204,7 +206,7 @@ namespace ufmt {
         if (!in) {
             return nullptr;            
         }
-        v12::CRingItem* pResult = new v12::CRingItem(hdr.s_type, hdr.s_size);
+        v12::CRingItem* pResult = newItem<v12::CRingItem>(hdr.s_type, hdr.s_size);
         size_t remaining = hdr.s_size - sizeof(v12::RingItemHeader);
         v12::pRingItem pRawItem =
             reinterpret_cast<v12::pRingItem>(pResult->getItemPointer());
@@ -219,6 +221,157 @@ namespace ufmt {
         
         return pResult;
     }
+    /**
+     * getRingItem
+     *    Get a ring item from a block buffered reader.  The item is
+     *    copied out of the reader's buffer.
+     *  @param reader - the reader open on the data source.
+     *  @return ::ufmt::CRingItem* - pointer to the new ring item.
+     *  @retval nullptr - eof.
+     */
+    ::ufmt::CRingItem*
+    RingItemFactory::getRingItem(::ufmt::CRingBlockReader& reader)
+    {
+        const ::ufmt::RingItem* pRaw = reader.nextItem();
+        if (!pRaw) {
+            return nullptr;
+        }
+        return makeRingItem(pRaw);
+    }
+    #ifdef HAVE_NSCLDAQ
+    /**
+     * getRingItem (refill from ring buffer)
+     *    Get the next ring item from a ring buffer into an existing item.
+     *    The item's storage is only reallocated if it's too small.
+     * @param ringbuf - ring buffer from which the item is gotten.
+     * @param item    - item to fill in.
+     * @param timeout - seconds to wait for the header.
+     * @return bool   - false if the header could not be gotten in time.
+     */
+    bool
+    RingItemFactory::getRingItem(
+        CRingBuffer& ringbuf, ::ufmt::CRingItem& item, unsigned long timeout
+    )
+    {
+        v12::RingItemHeader hdr;
+        if (!ringbuf.get(&hdr, sizeof(hdr), sizeof(hdr), timeout)) {
+            return false;
+        }
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        uint32_t remaining = hdr.s_size - sizeof(hdr);
+        if (remaining) {
+            ringbuf.get(p, remaining, remaining);
+            p += remaining;
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        return true;
+    }
+    #endif
+    /**
+     * getRingItem (refill from file descriptor)
+     *    Read the next ring item from a file descriptor into an existing
+     *    item.  The item's storage is only reallocated if it's too small.
+     * @param fd   - file descriptor open on the ring item source.
+     * @param item - item to fill in.
+     * @return bool - false on end of file.  If the end of file is in the
+     *                middle of an item the contents of item are undefined.
+     */
+    bool
+    RingItemFactory::getRingItem(int fd, ::ufmt::CRingItem& item)
+    {
+        v12::RingItemHeader hdr;
+        if (fmtio::readData(fd, &hdr, sizeof(hdr)) < sizeof(hdr)) {
+            return false;
+        }
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        uint32_t remaining = hdr.s_size - sizeof(hdr);
+        if (remaining) {
+            if (fmtio::readData(fd, p, remaining) < remaining) {
+                return false;
+            }
+            p += remaining;
+        }
+        item.setBodyCursor(p);
+        item.updateSize();
+        return true;
+    }
+    /**
+     * getRingItem (refill from std::istream)
+     * @param in   - stream open on the ring item source.
+     * @param item - item to fill in.
+     * @return bool - false if the item could not be read; the stream has
+     *                the reason.
+     */
+    bool
+    RingItemFactory::getRingItem(std::istream& in, ::ufmt::CRingItem& item)
+    {
+        v12::RingItemHeader hdr;
+        in.read(reinterpret_cast<char*>(&hdr), sizeof(hdr));
+        if (!in) {
+            return false;
+        }
+        char* p = reinterpret_cast<char*>(item.prepareForRefill(hdr.s_size));
+        memcpy(p, &hdr, sizeof(hdr));
+        p += sizeof(hdr);
+        size_t remaining = hdr.s_size - sizeof(hdr);
+        in.read(p, remaining);
+        if (!in) {
+            return false;
+        }
+        item.setBodyCursor(p + remaining);
+        item.updateSize();
+        return true;
+    }
+    /**
+     * getRingItem (refill from block reader)
+     * @param reader - block buffered reader on the ring item source.
+     * @param item   - item to fill in.
+     * @return bool  - false on end of file.
+     */
+    bool
+    RingItemFactory::getRingItem(
+        ::ufmt::CRingBlockReader& reader, ::ufmt::CRingItem& item
+    )
+    {
+        const ::ufmt::RingItem* pRaw = reader.nextItem();
+        if (!pRaw) {
+            return false;
+        }
+        refillItem(item, pRaw);
+        return true;
+    }
+    /**
+     * getRingItems
+     *    Refill a batch of items from a block reader.  The reader is looped
+     *    over here rather than through a getRingItem call per item.
+     * @param reader - the block reader.
+     * @param items  - the batch; lengthened as needed.
+     * @param maxItems - most items to get.
+     * @return size_t - number of items gotten; fewer than maxItems only at
+     *                the end of the data.
+     */
+    size_t
+    RingItemFactory::getRingItems(
+        ::ufmt::CRingBlockReader& reader,
+        std::vector<::ufmt::CRingItem*>& items, size_t maxItems
+    )
+    {
+        size_t n = 0;
+        while (n < maxItems) {
+            const ::ufmt::RingItem* pRaw = reader.nextItem();
+            if (!pRaw) {
+                break;
+            }
+            refillItem(*batchItem(items, n), pRaw);
+            n++;
+        }
+        return n;
+    }
     /**
      * putRingItem
      *    Put a ring item to an std::ostream.
@@ -250,6 +403,21 @@ namespace ufmt {
         const void* p = pItem->getItemPointer();
         fmtio::writeData(fd, p, n);
     }
+    /**
+     * putRingItem
+     *    Put a ring item through a block writer, which coalesces items
+     *    into large writes.
+     * @param pItem - pointer to the item to put.
+     * @param writer - the writer.
+     * @throw errors from fmtio::writeData are thrown as exceptions.
+     */
+    void
+    RingItemFactory::putRingItem(
+        const ::ufmt::CRingItem* pItem, ::ufmt::CRingBlockWriter& writer
+    )
+    {
+        writer.put(pItem->getItemPointer(), pItem->size());
+    }
     #ifdef HAVE_NSCLDAQ    
     /**
      * putRingItem
@@ -275,7 +443,7 @@ namespace ufmt {
     ::ufmt::CAbnormalEndItem*
     RingItemFactory::makeAbnormalEndItem()
     {
-        return new v12::CAbnormalEndItem();
+        return newItem<v12::CAbnormalEndItem>();
     }
     /**
      * makeAbnormalEndItem
@@ -295,7 +463,7 @@ namespace ufmt {
         if (rhs.size() != sizeof(v12::AbnormalEndItem)) {
             throw std::bad_cast();
         }
-        return new v12::CAbnormalEndItem();   // All look the same.
+        return newItem<v12::CAbnormalEndItem>();   // All look the same.
     }
     /**
      * makeDataFormatItem.
@@ -305,7 +473,7 @@ namespace ufmt {
     ::ufmt::CDataFormatItem*
     RingItemFactory::makeDataFormatItem()
     {
-        return new v12::CDataFormatItem();
+        return newItem<v12::CDataFormatItem>();
     }
     /**
      * makeDataFormatItem
@@ -331,7 +499,7 @@ namespace ufmt {
         if (pItem->s_majorVersion != v12::FORMAT_MAJOR) {
             throw std::bad_cast();
         }
-        return new v12::CDataFormatItem();        // No actual differentiation.
+        return newItem<v12::CDataFormatItem>();        // No actual differentiation.
     }
     /**
      * makeGlomParameters
@@ -365,7 +533,7 @@ namespace ufmt {
             default:
                 throw std::invalid_argument("Invalid timestamp policy value");
         }
-        return new v12::CGlomParameters(interval, isBuilding, policySelector);
+        return newItem<v12::CGlomParameters>(interval, isBuilding, policySelector);
     }
     /**
      * makeGlomParameters
@@ -390,7 +558,7 @@ namespace ufmt {
         
         // Make the new item:
         
-        return new v12::CGlomParameters(
+        return newItem<v12::CGlomParameters>(
             pItem->s_coincidenceTicks, pItem->s_isBuilding,
             static_cast<::ufmt::CGlomParameters::TimestampPolicy>(pItem->s_timestampPolicy)
         );
@@ -407,7 +575,7 @@ namespace ufmt {
     ::ufmt::CPhysicsEventItem*
     RingItemFactory::makePhysicsEventItem(size_t maxBody)
     {
-        return new v12::CPhysicsEventItem(maxBody);
+        return newItem<v12::CPhysicsEventItem>(maxBody);
     }
     /**
      * makePhysicsEventITem
@@ -424,7 +592,7 @@ namespace ufmt {
         uint64_t timestamp, uint32_t source, uint32_t barrier, size_t maxBody
     )
     {
-        return new v12::CPhysicsEventItem(
+        return newItem<v12::CPhysicsEventItem>(
             timestamp, source, barrier, maxBody
         );
     }
@@ -442,7 +610,7 @@ namespace ufmt {
         if (rhs.type() != v12::PHYSICS_EVENT) {
             throw std::bad_cast();
         }
-        v12::CPhysicsEventItem* pResult = new v12::CPhysicsEventItem(rhs.size());
+        v12::CPhysicsEventItem* pResult = newItem<v12::CPhysicsEventItem>(rhs.size());
         
         uint8_t* pDest = reinterpret_cast<uint8_t*>(pResult->getItemPointer());
         
@@ -470,7 +638,7 @@ namespace ufmt {
         const void* payload, uint32_t barrier
     )
     {
-        return new v12::CRingFragmentItem(timestamp, source, payloadSize, payload, barrier);
+        return newItem<v12::CRingFragmentItem>(timestamp, source, payloadSize, payload, barrier);
     }
     /**
      * makeRingFragmentItem
@@ -509,7 +677,7 @@ namespace ufmt {
         uint64_t count, uint32_t timeoffset, time_t stamp, int divisor
     )
     {
-        return new v12::CRingPhysicsEventCountItem(count, timeoffset, stamp, 0, divisor);
+        return newItem<v12::CRingPhysicsEventCountItem>(count, timeoffset, stamp, 0, divisor);
     }
     /**
      * makePhysicsEventCountItem
@@ -569,7 +737,7 @@ namespace ufmt {
     ::ufmt::CRingScalerItem*
     RingItemFactory::makeScalerItem(size_t numScalers)
     {
-        return new v12::CRingScalerItem(numScalers);
+        return newItem<v12::CRingScalerItem>(numScalers);
     }
     /**
      * makeScalrItem
@@ -596,7 +764,7 @@ namespace ufmt {
         uint32_t              timeOffsetDivisor
     )
     {
-        return new v12::CRingScalerItem(
+        return newItem<v12::CRingScalerItem>(
             0xffffffffffffffff, sid, 0,
             startTime,stopTime, timestamp, scalers, timeOffsetDivisor, isIncremental
         );
@@ -661,7 +829,7 @@ namespace ufmt {
         if (validTextItemTypes.count(type) == 0) {
             throw std::invalid_argument("Invalid text item type (v12)");
         }
-        return new v12::CRingTextItem(type, theStrings);
+        return newItem<v12::CRingTextItem>(type, theStrings);
     }
     /**
      *  makeTextItem
@@ -684,7 +852,7 @@ namespace ufmt {
         if (validTextItemTypes.count(type) == 0) {
             throw std::invalid_argument("Invalid text time type (v12)");
         }
-        return new v12::CRingTextItem(
+        return newItem<v12::CRingTextItem>(
             type, theStrings, offsetTime, timestamp, divisor
         );
     }
@@ -753,8 +921,9 @@ namespace ufmt {
             uint32_t size, void* pPayload
     )
     {
-        return reinterpret_cast<::ufmt::CUnknownFragment*> (new 
-            v12::CUnknownFragment(timestamp, sourceid, barrier, size, pPayload));
+        return reinterpret_cast<::ufmt::CUnknownFragment*> (
+            newItem<v12::CUnknownFragment>(timestamp, sourceid, barrier, size, pPayload)
+        );
     }
     /**
      * makeUnknownFragment
@@ -806,7 +975,7 @@ namespace ufmt {
         std::string title
     )
     {
-        return new v12::CRingStateChangeItem(
+        return newItem<v12::CRingStateChangeItem>(
             itemType, runNumber, timeOffset, timestamp, title
         );
     }
@@ -842,13 +1011,13 @@ namespace ufmt {
         
             v12::CRingStateChangeItem* pResult;
         if (rhs.hasBodyHeader()) {
-            pResult =  new v12::CRingStateChangeItem(
+            pResult =  newItem<v12::CRingStateChangeItem>(
                 rhs.getEventTimestamp(), rhs.getSourceId(), rhs.getBarrierType(),
                 rhs.type(), pBody->s_runNumber, pBody->s_timeOffset,
                 pBody->s_Timestamp, pBody->s_title, pBody->s_offsetDivisor
             );
         } else {
-            pResult =  new v12::CRingStateChangeItem(
+            pResult =  newItem<v12::CRingStateChangeItem>(
                 rhs.type(), pBody->s_runNumber, pBody->s_timeOffset,
                 pBody->s_Timestamp,
                 pBody->s_title, pBody->s_offsetDivisor
@@ -863,6 +1032,108 @@ namespace ufmt {
         return pResult;
         
     }
+    ///////////////////////////////////////////////////////////////
+    // Conversions that take over the storage of an rvalue item.
+    // The checks are the same as for the copying conversions above;
+    // the items are then given rhs's storage (see adoptItem).  rhs is
+    // left empty.
+    
+    /**
+     * makeRingItem
+     *    Like a move constructor.
+     * @param rhs - ring item whose storage we take.
+     * @return ::ufmt::CRingItem*
+     */
+    ::ufmt::CRingItem*
+    RingItemFactory::makeRingItem(::ufmt::CRingItem&& rhs)
+    {
+        return adoptItem<v12::CRingItem>(std::move(rhs), rhs.type(), size_t(0));
+    }
+    /**
+     * makePhysicsEventItem
+     * @param rhs - item whose storage we take; must be a v12::PHYSICS_EVENT.
+     * @return ::ufmt::CPhysicsEventItem*
+     * @throw std::bad_cast if the source item is not a physics item.
+     */
+    ::ufmt::CPhysicsEventItem*
+    RingItemFactory::makePhysicsEventItem(::ufmt::CRingItem&& rhs)
+    {
+        if (rhs.type() != v12::PHYSICS_EVENT) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v12::CPhysicsEventItem>(std::move(rhs), size_t(0));
+    }
+    /**
+     * makeRingFragmentItem
+     * @param rhs - item whose storage we take; must be a fragment.
+     * @return ::ufmt::CRingFragmentItem*
+     * @throw std::bad_cast if rhs is not a fragment.
+     * @note unlike the copying conversion the item type of rhs is kept.
+     */
+    ::ufmt::CRingFragmentItem*
+    RingItemFactory::makeRingFragmentItem(::ufmt::CRingItem&& rhs)
+    {
+        if ((rhs.type() != v12::EVB_FRAGMENT) && (rhs.type() != v12::EVB_UNKNOWN_PAYLOAD)) {
+            throw std::bad_cast();
+        }
+        if (rhs.size() < sizeof(v12::EventBuilderFragment)) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v12::CRingFragmentItem>(
+            std::move(rhs), 0, 0, 0, nullptr, 0
+        );
+    }
+    /**
+     * makeScalerItem
+     * @param rhs - item whose storage we take; must be v12::PERIODIC_SCALERS.
+     * @return ::ufmt::CRingScalerItem*
+     * @throw std::bad_cast if rhs is not a scaler item.
+     */
+    ::ufmt::CRingScalerItem*
+    RingItemFactory::makeScalerItem(::ufmt::CRingItem&& rhs)
+    {
+        if (rhs.type() != v12::PERIODIC_SCALERS) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v12::CRingScalerItem>(std::move(rhs), size_t(0));
+    }
+    /**
+     * makeTextItem
+     * @param rhs - item whose storage we take; must be a text item type.
+     * @return ::ufmt::CRingTextItem*
+     * @throw std::bad_cast if rhs is not a text item.
+     */
+    ::ufmt::CRingTextItem*
+    RingItemFactory::makeTextItem(::ufmt::CRingItem&& rhs)
+    {
+        if (validTextItemTypes.count(rhs.type()) == 0) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v12::CRingTextItem>(std::move(rhs), rhs.type(), size_t(0));
+    }
+    /**
+     * makeStateChangeItem
+     * @param rhs - item whose storage we take; must be a valid state change
+     *        item.
+     * @return ::ufmt::CRingStateChangeItem*
+     * @throw std::bad_cast if rhs is not a state change item or is the wrong
+     *        size.
+     */
+    ::ufmt::CRingStateChangeItem*
+    RingItemFactory::makeStateChangeItem(::ufmt::CRingItem&& rhs)
+    {
+        if (!CRingStateChangeItem::isStateChange(rhs.type())) {
+            throw std::bad_cast();
+        }
+        size_t nobheaderSize = sizeof(v12::RingItemHeader) + sizeof(uint32_t) +
+            sizeof(v12::StateChangeItemBody);
+        size_t bodyHeaderSize = sizeof(v12::RingItemHeader) + sizeof(v12::BodyHeader) +
+            sizeof(v12::StateChangeItemBody);
+        if ((rhs.size() != nobheaderSize) && (rhs.size() != bodyHeaderSize)) {
+            throw std::bad_cast();
+        }
+        return adoptItem<v12::CRingStateChangeItem>(std::move(rhs), rhs.type());
+    }
     /** Return format version: */
     ufmt::FormatSelector::SupportedVersions 
     RingItemFactory::version() {
@@ -883,6 +1154,22 @@ namespace ufmt {
         }
         return result;
     }
+    /**
+     * refillItem
+     *    Copy a raw item into an existing item, whose storage is only
+     *    reallocated if it's too small.
+     * @param item - item to fill in.
+     * @param pRaw - the raw item.
+     */
+    void
+    RingItemFactory::refillItem(::ufmt::CRingItem& item, const ::ufmt::RingItem* pRaw)
+    {
+        uint32_t size = pRaw->s_header.s_size;
+        uint8_t* p = reinterpret_cast<uint8_t*>(item.prepareForRefill(size));
+        memcpy(p, pRaw, size);
+        item.setBodyCursor(p + size);
+        item.updateSize();
+    }
     //// end of v12 namespace
     }
 }
@@ -34,6 +34,7 @@ namespace ufmt {
         virtual ::ufmt::CRingItem* makeRingItem(uint16_t type, uint64_t timestamp, uint32_t sourceId,
                 size_t maxBody, uint32_t barrierType = 0 ) ;
         virtual ::ufmt::CRingItem* makeRingItem(const ::ufmt::CRingItem& rhs) ;
+        virtual ::ufmt::CRingItem* makeRingItem(::ufmt::CRingItem&& rhs) ;
         virtual ::ufmt::CRingItem* makeRingItem(const ::ufmt::RingItem* pRawRing) ;
 
     #ifdef HAVE_NSCLDAQ    
@@ -41,12 +42,31 @@ namespace ufmt {
     #endif
         virtual ::ufmt::CRingItem* getRingItem(int fd) ;
         virtual ::ufmt::CRingItem* getRingItem(::std::istream& in) ;
+        virtual ::ufmt::CRingItem* getRingItem(::ufmt::CRingBlockReader& reader) ;
+    #ifdef HAVE_NSCLDAQ
+        virtual bool getRingItem(
+            CRingBuffer& ringbuf, ::ufmt::CRingItem& item,
+            unsigned long timeout=ULONG_MAX
+        ) ;
+    #endif
+        virtual bool getRingItem(int fd, ::ufmt::CRingItem& item) ;
+        virtual bool getRingItem(::std::istream& in, ::ufmt::CRingItem& item) ;
+        virtual bool getRingItem(
+            ::ufmt::CRingBlockReader& reader, ::ufmt::CRingItem& item
+        ) ;
+        virtual size_t getRingItems(
+            ::ufmt::CRingBlockReader& reader,
+            ::std::vector<::ufmt::CRingItem*>& items, size_t maxItems
+        ) ;
+        using ::ufmt::RingItemFactoryBase::getRingItems;
 
         virtual ::std::ostream& putRingItem(const ::ufmt::CRingItem* pItem, ::std::ostream& out) ;
         virtual void putRingItem(const ::ufmt::CRingItem* pItem, int fd) ;
+        virtual void putRingItem(const ::ufmt::CRingItem* pItem, ::ufmt::CRingBlockWriter& writer) ;
     #ifdef HAVE_NSCLDAQ    
         virtual void putRingItem(const ::ufmt::CRingItem* pItem, ::CRingBuffer& ringbuf) ;
     #endif
+        using ::ufmt::RingItemFactoryBase::putRingItem;    // Batches.
 
         virtual ::ufmt::CAbnormalEndItem* makeAbnormalEndItem() ;
         virtual ::ufmt::CAbnormalEndItem* makeAbnormalEndItem(const ::ufmt::CRingItem& rhs) ;
@@ -64,12 +84,14 @@ namespace ufmt {
             uint64_t timestamp, uint32_t source, uint32_t barrier, size_t maxBody
         ) ;
         virtual ::ufmt::CPhysicsEventItem* makePhysicsEventItem(const ::ufmt::CRingItem& rhs) ;
+        virtual ::ufmt::CPhysicsEventItem* makePhysicsEventItem(::ufmt::CRingItem&& rhs) ;
 
         virtual ::ufmt::CRingFragmentItem* makeRingFragmentItem(
             uint64_t timestamp, uint32_t source, uint32_t payloadSize,
             const void* payload, uint32_t barrier=0
         ) ;
         virtual ::ufmt::CRingFragmentItem* makeRingFragmentItem(const ::ufmt::CRingItem& rhs) ;
+        virtual ::ufmt::CRingFragmentItem* makeRingFragmentItem(::ufmt::CRingItem&& rhs) ;
 
 
         virtual ::ufmt::CRingPhysicsEventCountItem* makePhysicsEventCountItem(
@@ -91,6 +113,7 @@ namespace ufmt {
             uint32_t              timeOffsetDivisor = 1
         ) ;
         virtual ::ufmt::CRingScalerItem* makeScalerItem(const ::ufmt::CRingItem& rhs) ;
+        virtual ::ufmt::CRingScalerItem* makeScalerItem(::ufmt::CRingItem&& rhs) ;
 
         virtual ::ufmt::CRingTextItem* makeTextItem(
             uint16_t type,
@@ -104,6 +127,7 @@ namespace ufmt {
             uint32_t divisor 
         ) ;
         virtual ::ufmt::CRingTextItem* makeTextItem(const ::ufmt::CRingItem& rhs) ;
+        virtual ::ufmt::CRingTextItem* makeTextItem(::ufmt::CRingItem&& rhs) ;
 
         virtual ::ufmt::CUnknownFragment* makeUnknownFragment(
             uint64_t timestamp, uint32_t sourceid, uint32_t barrier,
@@ -118,8 +142,12 @@ namespace ufmt {
             ::std::string title
         ) ;
         virtual ::ufmt::CRingStateChangeItem* makeStateChangeItem(const ::ufmt::CRingItem& rhs) ;
+        virtual ::ufmt::CRingStateChangeItem* makeStateChangeItem(::ufmt::CRingItem&& rhs) ;
         virtual ufmt::FormatSelector::SupportedVersions version();
     private:
+        static void refillItem(
+            ::ufmt::CRingItem& item, const ::ufmt::RingItem* pRaw
+        );
         ::std::vector<::std::string> marshallStrings(const void* p);
     };
         
@@ -30,6 +30,14 @@
 #include <CRingBuffer.h>
 #endif
 #include <CAbnormalEndItem.h>
+#include <CRingBlockReader.h>
+#include <CRingBlockWriter.h>
+#include <vector>
+#include <CRingItemPool.h>
+#include <RingItemBatch.h>
+#include <CRingScalerView.h>
+#include <CRingStateChangeView.h>
+#include "RingViewDecoder.h"
 #include "CDataFormatItem.h"   // need the v12
 #include "CGlomParameters.h"
 #include "CPhysicsEventItem.h"
@@ -82,6 +90,16 @@ class v12facttest : public CppUnit::TestFixture {
     CPPUNIT_TEST(get_4);
     CPPUNIT_TEST(get_5);
     CPPUNIT_TEST(get_6);
+    CPPUNIT_TEST(get_7);
+    CPPUNIT_TEST(get_8);
+    CPPUNIT_TEST(get_9);
+    CPPUNIT_TEST(pool_1);
+    CPPUNIT_TEST(move_1);
+    CPPUNIT_TEST(move_2);
+    CPPUNIT_TEST(batch_1);
+    CPPUNIT_TEST(batch_2);
+    CPPUNIT_TEST(batch_3);
+    CPPUNIT_TEST(view_1);
     
     CPPUNIT_TEST(put_1);
     CPPUNIT_TEST(put_2);
@@ -89,6 +107,7 @@ class v12facttest : public CppUnit::TestFixture {
     CPPUNIT_TEST(put_4);
     CPPUNIT_TEST(put_5);
     CPPUNIT_TEST(put_6);
+    CPPUNIT_TEST(put_7);
     
     CPPUNIT_TEST(abend_1);
     CPPUNIT_TEST(abend_2);
@@ -186,6 +205,16 @@ protected:
     void get_4();
     void get_5();
     void get_6();
+    void get_7();
+    void get_8();
+    void get_9();
+    void pool_1();
+    void move_1();
+    void move_2();
+    void batch_1();
+    void batch_2();
+    void batch_3();
+    void view_1();
     
     void put_1();
     void put_2();
@@ -193,6 +222,7 @@ protected:
     void put_4();
     void put_5();
     void put_6();
+    void put_7();
     
     void abend_1();
     void abend_2();
@@ -608,6 +638,314 @@ void v12facttest::get_6()
     EQ(0, memcmp(src->getItemPointer(), cpy->getItemPointer(), src->size()));
     
 }
+// Get body header item from fd via a block reader.
+void v12facttest::get_7()
+{
+    std::unique_ptr<::CRingItem> src(
+        m_pFactory->makeRingItem(v12::PHYSICS_EVENT, 0x1234567890, 1, 100, 2)
+    );
+    uint8_t* p = reinterpret_cast<uint8_t*>(src->getBodyPointer());
+    for (int i = 0; i < 10; i++) {
+        *p++ = i;
+    }
+    src->setBodyCursor(p);
+    src->updateSize();
+    
+    int fd = memfd_create("testing", 0);
+    write(fd, src->getItemPointer(), src->size());
+    lseek(fd, 0, SEEK_SET);
+    
+    CRingBlockReader reader(fd);
+    std::unique_ptr<::CRingItem> cpy(m_pFactory->getRingItem(reader));
+    std::unique_ptr<::CRingItem> eof(m_pFactory->getRingItem(reader));
+    close(fd);
+    ASSERT(cpy.get());
+    EQ(src->size(), cpy->size());
+    EQ(0, memcmp(src->getItemPointer(), cpy->getItemPointer(), src->size()));
+    ASSERT(!eof.get());
+}
+// Refill an existing item from an fd - the item storage is reused.
+void v12facttest::get_8()
+{
+    std::unique_ptr<::CRingItem> src1(
+        m_pFactory->makeRingItem(v12::PHYSICS_EVENT, 0x1234567890, 1, 100, 2)
+    );
+    uint8_t* p = reinterpret_cast<uint8_t*>(src1->getBodyPointer());
+    for (int i = 0; i < 10; i++) {
+        *p++ = i;
+    }
+    src1->setBodyCursor(p);
+    src1->updateSize();
+    std::unique_ptr<::CRingItem> src2(
+        m_pFactory->makeRingItem(v12::BEGIN_RUN, 100)
+    );
+    
+    int fd = memfd_create("testing", 0);
+    write(fd, src1->getItemPointer(), src1->size());
+    write(fd, src2->getItemPointer(), src2->size());
+    lseek(fd, 0, SEEK_SET);
+    
+    std::unique_ptr<::CRingItem> item(m_pFactory->makeRingItem(v12::PHYSICS_EVENT, 100));
+    const void* pStorage = item->getItemPointer();
+    
+    ASSERT(m_pFactory->getRingItem(fd, *item));
+    EQ(pStorage, (const void*)item->getItemPointer());
+    EQ(src1->size(), item->size());
+    EQ(0, memcmp(src1->getItemPointer(), item->getItemPointer(), src1->size()));
+    EQ(src1->getBodySize(), item->getBodySize());
+    EQ(uint64_t(0x1234567890), item->getEventTimestamp());
+    
+    ASSERT(m_pFactory->getRingItem(fd, *item));
+    EQ(pStorage, (const void*)item->getItemPointer());
+    EQ(0, memcmp(src2->getItemPointer(), item->getItemPointer(), src2->size()));
+    ASSERT(!item->hasBodyHeader());
+    
+    ASSERT(!m_pFactory->getRingItem(fd, *item));
+    close(fd);
+}
+// Refill an existing item from an istream and a block reader.
+void v12facttest::get_9()
+{
+    std::unique_ptr<::CRingItem> src(
+        m_pFactory->makeRingItem(v12::PHYSICS_EVENT, 0x1234567890, 1, 100, 2)
+    );
+    uint8_t* p = reinterpret_cast<uint8_t*>(src->getBodyPointer());
+    for (int i = 0; i < 10; i++) {
+        *p++ = i;
+    }
+    src->setBodyCursor(p);
+    src->updateSize();
+    std::unique_ptr<::CRingItem> item(m_pFactory->makeRingItem(v12::BEGIN_RUN, 100));
+    
+    std::stringstream s;
+    s.write(reinterpret_cast<char*>(src->getItemPointer()), src->size());
+    s.seekp(0);
+    ASSERT(m_pFactory->getRingItem(s, *item));
+    EQ(0, memcmp(src->getItemPointer(), item->getItemPointer(), src->size()));
+    ASSERT(!m_pFactory->getRingItem(s, *item));
+    
+    int fd = memfd_create("testing", 0);
+    write(fd, src->getItemPointer(), src->size());
+    lseek(fd, 0, SEEK_SET);
+    CRingBlockReader reader(fd);
+    std::unique_ptr<::CRingItem> item2(m_pFactory->makeRingItem(v12::BEGIN_RUN, 100));
+    ASSERT(m_pFactory->getRingItem(reader, *item2));
+    EQ(0, memcmp(src->getItemPointer(), item2->getItemPointer(), src->size()));
+    EQ(src->getBodySize(), item2->getBodySize());
+    ASSERT(!m_pFactory->getRingItem(reader, *item2));
+    close(fd);
+}
+// Items made by a factory with a pool are recycled through that pool.
+void v12facttest::pool_1()
+{
+    CRingItemPool pool;
+    m_pFactory->setItemPool(&pool);
+    EQ(&pool, m_pFactory->getItemPool());
+    
+    // Few enough scalers to fit in the smallest allowed inline storage
+    // (128 bytes) so the scaler items need no dynamic storage:
+    
+    std::vector<uint32_t> scalers(4, 1);
+    ::CRingItem* p1 = m_pFactory->makeScalerItem(0, 10, time(nullptr), scalers);
+    delete p1;
+    ::CRingItem* p2 = m_pFactory->makeScalerItem(10, 20, time(nullptr), scalers);
+    EQ((void*)p1, (void*)p2);
+    delete p2;
+    
+    // Big items recycle their storage too:
+    
+    ::CRingItem* p3 = m_pFactory->makeRingItem(v12::PHYSICS_EVENT, CRingItemStaticBufferSize*2);
+    void* pStorage = p3->getItemPointer();
+    delete p3;
+    p3 = m_pFactory->makeRingItem(v12::PHYSICS_EVENT, CRingItemStaticBufferSize*2);
+    EQ(pStorage, (void*)p3->getItemPointer());
+    delete p3;
+    
+    // The item objects are all in the same size class so only the first
+    // object and the first big storage block miss:
+    
+    auto stats = pool.getStatistics();
+    EQ(uint64_t(2), stats.s_misses);
+    EQ(uint64_t(4), stats.s_hits);
+    EQ(uint64_t(6), stats.s_frees);
+    m_pFactory->setItemPool(nullptr);
+}
+// Typed conversion of an rvalue item takes its storage:
+
+void v12facttest::move_1()
+{
+    std::vector<uint32_t> scalers;
+    for (uint32_t i = 0; i < CRingItemStaticBufferSize; i++) {   // Dynamic storage.
+        scalers.push_back(i);
+    }
+    std::unique_ptr<::CRingItem> scaler(
+        m_pFactory->makeScalerItem(0, 10, time(nullptr), scalers, true, 12)
+    );
+    std::unique_ptr<::CRingItem> generic(m_pFactory->makeRingItem(*scaler));
+    void* pStorage = generic->getItemPointer();
+    
+    std::unique_ptr<::CRingScalerItem> typed(
+        m_pFactory->makeScalerItem(std::move(*generic))
+    );
+    EQ(pStorage, (void*)typed->getItemPointer());
+    EQ(scaler->size(), typed->size());
+    EQ(uint32_t(10), typed->getEndTime());
+    EQ(uint32_t(12), typed->getOriginalSourceId());
+    EQ(scalers.size(), typed->getScalers().size());
+    EQ(uint32_t(100), typed->getScaler(100));
+    
+    EQ(v12::PERIODIC_SCALERS, generic->type());
+    EQ(uint32_t(sizeof(v12::RingItemHeader)), generic->size());
+}
+// Batch reads from a block reader - items in the vector are reused:
+
+void v12facttest::batch_1()
+{
+    int fd = memfd_create("testing", 0);
+    for (uint32_t i = 0; i < 10; i++) {
+        std::unique_ptr<::CRingItem> item(
+            m_pFactory->makeRingItem(v12::PHYSICS_EVENT, 100)
+        );
+        uint32_t* p = static_cast<uint32_t*>(item->getBodyCursor());
+        *p++ = i;
+        item->setBodyCursor(p);
+        item->updateSize();
+        write(fd, item->getItemPointer(), item->size());
+    }
+    lseek(fd, 0, SEEK_SET);
+    
+    CRingBlockReader reader(fd, 64);
+    std::vector<::CRingItem*> items;
+    EQ(size_t(4), m_pFactory->getRingItems(reader, items, 4));
+    EQ(size_t(4), items.size());
+    std::vector<::CRingItem*> first(items);
+    
+    EQ(size_t(4), m_pFactory->getRingItems(reader, items, 4));
+    ASSERT(first == items);
+    EQ(size_t(2), m_pFactory->getRingItems(reader, items, 4));
+    for (uint32_t i = 0; i < 2; i++) {
+        EQ(v12::PHYSICS_EVENT, items[i]->type());
+        EQ(
+            i + 8,
+            *static_cast<const uint32_t*>(
+                const_cast<const ::CRingItem*>(items[i])->getBodyPointer()
+            )
+        );
+    }
+    EQ(size_t(0), m_pFactory->getRingItems(reader, items, 4));
+    close(fd);
+    for (auto p : items) {
+        delete p;
+    }
+}
+// Batch reads from a stream:
+
+void v12facttest::batch_2()
+{
+    std::stringstream s;
+    std::vector<uint32_t> scalers(10, 1);
+    for (int i =0; i < 3; i++) {
+        std::unique_ptr<::CRingItem> item(
+            m_pFactory->makeScalerItem(i, i+1, time(nullptr), scalers)
+        );
+        m_pFactory->putRingItem(item.get(), s);
+    }
+    std::vector<::CRingItem*> items;
+    EQ(size_t(3), m_pFactory->getRingItems(s, items, 10));
+    for (int i =0; i < 3; i++) {
+        EQ(v12::PERIODIC_SCALERS, items[i]->type());
+    }
+    for (auto p : items) {                   // There may be extra items.
+        delete p;
+    }
+}
+// A batch is put with one write and reads back as the same items:
+
+void v12facttest::batch_3()
+{
+    RingItemBatch batch;
+    std::vector<uint32_t> scalers(10, 1);
+    for (int i =0; i < 5; i++) {
+        std::unique_ptr<::CRingItem> item(
+            m_pFactory->makeScalerItem(i, i+1, time(nullptr), scalers)
+        );
+        batch.append(*item);
+    }
+    int fd = memfd_create("testing", 0);
+    m_pFactory->putRingItem(batch, fd);
+    EQ(off_t(batch.bytes()), lseek(fd, 0, SEEK_CUR));
+    lseek(fd, 0, SEEK_SET);
+    
+    std::vector<::CRingItem*> items;
+    EQ(size_t(5), m_pFactory->getRingItems(fd, items, 10));
+    close(fd);
+    int i = 0;
+    for (auto v : batch) {
+        EQ(v.size(), items[i]->size());
+        EQ(0, memcmp(v.getItemPointer(), items[i]->getItemPointer(), v.size()));
+        i++;
+    }
+    for (auto p : items) {
+        delete p;
+    }
+    
+    std::stringstream s;
+    m_pFactory->putRingItem(batch, s);
+    EQ(batch.bytes(), s.str().size());
+}
+// Bad conversions throw without touching the item; small items are
+// copied out of the static buffer:
+
+void v12facttest::move_2()
+{
+    std::unique_ptr<::CRingItem> generic(
+        m_pFactory->makeRingItem(v12::PHYSICS_EVENT, 1234, 1, 100)
+    );
+    uint32_t size = generic->size();
+    CPPUNIT_ASSERT_THROW(
+        m_pFactory->makeStateChangeItem(std::move(*generic)), std::bad_cast
+    );
+    EQ(size, generic->size());
+    
+    std::unique_ptr<::CPhysicsEventItem> event(
+        m_pFactory->makePhysicsEventItem(std::move(*generic))
+    );
+    EQ(v12::PHYSICS_EVENT, event->type());
+    EQ(size, event->size());
+    ASSERT(event->hasBodyHeader());
+    EQ(uint64_t(1234), event->getEventTimestamp());
+    EQ(uint32_t(1), event->getSourceId());
+    EQ(uint32_t(sizeof(v12::RingItemHeader)), generic->size());
+}
+// Typed views of generic items agree with the items the factory makes.
+void v12facttest::view_1()
+{
+    v12::RingViewDecoder decoder;
+    std::vector<uint32_t> scalers = {1, 2, 3};
+    std::unique_ptr<::CRingScalerItem> sc(
+        m_pFactory->makeScalerItem(10, 20, 1234, scalers, false, 5, 2)
+    );
+    std::unique_ptr<::CRingItem> generic(m_pFactory->makeRingItem(*sc));
+    CRingScalerView sv(CRingItemView(*generic, FormatSelector::v12), decoder);
+    EQ(sc->getStartTime(), sv.getStartTime());
+    EQ(sc->getEndTime(), sv.getEndTime());
+    EQ(sc->getTimeDivisor(), sv.getTimeDivisor());
+    EQ(sc->getTimestamp(), sv.getTimestamp());
+    EQ(sc->isIncremental(), sv.isIncremental());
+    EQ(sc->getOriginalSourceId(), sv.getOriginalSourceId());
+    ASSERT(sc->getScalers() == sv.getScalers());
+    
+    std::unique_ptr<::CRingStateChangeItem> st(
+        m_pFactory->makeStateChangeItem(v12::BEGIN_RUN, 12, 0, 5678, "Title")
+    );
+    CRingStateChangeView stv(CRingItemView(*st, FormatSelector::v12), decoder);
+    EQ(st->getRunNumber(), stv.getRunNumber());
+    EQ(st->getTitle(), stv.getTitle());
+    EQ(st->getTimestamp(), stv.getTimestamp());
+    CPPUNIT_ASSERT_THROW(
+        CRingScalerView(CRingItemView(*st, FormatSelector::v12), decoder), std::bad_cast
+    );
+}
 // Put non body header item into ringbuffer:
 
 void v12facttest::put_1()
@@ -1572,4 +1910,48 @@ void v12facttest::state_7() {
 
 void v12facttest::version_1() {
     EQ(ufmt::FormatSelector::SupportedVersions::v12, m_pFactory->version());
-}
\ No newline at end of file
+}
+// Items put through a block writer, one at a time and as a batch, read
+// back unchanged.  Small blocks make the writer write several times:
+
+void v12facttest::put_7()
+{
+    std::vector<::CRingItem*> items;
+    RingItemBatch batch;
+    for (int i = 0; i < 6; i++) {
+        ::CRingItem* pItem = m_pFactory->makeRingItem(v12::PHYSICS_EVENT, 100);
+        uint16_t* p = reinterpret_cast<uint16_t*>(pItem->getBodyCursor());
+        for (int w = 0; w < 10; w++) {
+            *p++ = i*10 + w;
+        }
+        pItem->setBodyCursor(p);
+        pItem->updateSize();
+        items.push_back(pItem);
+        if (i >= 3) {
+            batch.append(*pItem);
+        }
+    }
+    int fd = memfd_create("testing", 0);
+    {
+        CRingBlockWriter writer(fd, 64);
+        for (int i = 0; i < 3; i++) {
+            m_pFactory->putRingItem(items[i], writer);
+        }
+        m_pFactory->putRingItem(batch, writer);
+        writer.flush();
+    }
+    lseek(fd, 0, SEEK_SET);
+    
+    std::vector<::CRingItem*> gotten;
+    EQ(size_t(6), m_pFactory->getRingItems(fd, gotten, 10));
+    close(fd);
+    for (int i = 0; i < 6; i++) {
+        EQ(items[i]->size(), gotten[i]->size());
+        EQ(0, memcmp(
+            items[i]->getItemPointer(), gotten[i]->getItemPointer(),
+            items[i]->size()
+        ));
+        delete items[i];
+        delete gotten[i];
+    }
+}
@@ -0,0 +1,236 @@
+/*
+    This software is Copyright by the Board of Trustees of Michigan
+    State University (c) Copyright 2017.
+
+    You may use this software under the terms of the GNU public license
+    (GPL).  The terms of this license are described at:
+
+     http://www.gnu.org/licenses/gpl.txt
+
+     Authors:
+             Ron Fox
+             Giordano Cerriza
+	     FRIB
+	     Michigan State University
+	     East Lansing, MI 48824-1321
+*/
+
+/** @file:  v12scantests.cpp
+ *  @brief: Test the parallel file scanner with the v12 factory.
+ */
+#include <cppunit/extensions/HelperMacros.h>
+#include <cppunit/Asserter.h>
+#include "Asserts.h"
+#include "DataFormat.h"
+#include "RingItemFactory.h"
+#include <CRingItem.h>
+#include <CRingParallelScanner.h>
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include <unistd.h>
+#include <string.h>
+#include <sys/mman.h>
+#pragma GCC diagnostic ignored "-Wunused-result"
+
+using namespace ufmt;
+
+// Records the items it's given:
+
+class RecordingWorker : public CRingParallelScanner::Worker
+{
+public:
+    std::vector<uint64_t> m_offsets;
+    std::vector<uint32_t> m_types;
+    bool                  m_done;
+    RecordingWorker() : m_done(false) {}
+    virtual void process(CRingItem& item, uint64_t offset) {
+        m_offsets.push_back(offset);
+        m_types.push_back(item.type());
+    }
+    virtual void done() { m_done = true; }
+};
+class RecordingFactory : public CRingParallelScanner::WorkerFactory
+{
+public:
+    unsigned m_factories;
+    RecordingFactory() : m_factories(0) {}
+    virtual RingItemFactoryBase* makeFactory() {
+        m_factories++;
+        return new v12::RingItemFactory;
+    }
+    virtual CRingParallelScanner::Worker* makeWorker(
+        const CRingParallelScanner::Chunk& chunk
+    ) {
+        return new RecordingWorker;
+    }
+};
+
+class v12scantest : public CppUnit::TestFixture {
+    CPPUNIT_TEST_SUITE(v12scantest);
+    CPPUNIT_TEST(chunks_1);
+    CPPUNIT_TEST(chunks_2);
+    CPPUNIT_TEST(scan_1);
+    CPPUNIT_TEST(scan_2);
+    CPPUNIT_TEST(empty_1);
+    CPPUNIT_TEST_SUITE_END();
+
+private:
+    int m_fd;
+    std::vector<uint64_t> m_offsets;
+    std::vector<uint32_t> m_types;
+public:
+    void setUp() {
+        m_fd = memfd_create("v12scantest", 0);
+        m_offsets.clear();
+        m_types.clear();
+    }
+    void tearDown() {
+        close(m_fd);
+    }
+protected:
+    void chunks_1();
+    void chunks_2();
+    void scan_1();
+    void scan_2();
+    void empty_1();
+private:
+    void writeItem(uint32_t type, uint32_t bodyBytes);
+    void writeRun(unsigned nEvents);
+};
+
+CPPUNIT_TEST_SUITE_REGISTRATION(v12scantest);
+
+// Write an item without a body header.  The body's size words look like
+// item sizes so boundaries can't be found from sizes alone.
+
+void
+v12scantest::writeItem(uint32_t type, uint32_t bodyBytes)
+{
+    std::vector<uint8_t> item(sizeof(v12::RingItemHeader) + sizeof(uint32_t));
+    for (uint32_t i = 0; i < bodyBytes; i++) {
+        item.push_back((i % 4) ? 0 : 16);
+    }
+    v12::RingItemHeader* pH = reinterpret_cast<v12::RingItemHeader*>(item.data());
+    pH->s_size = item.size();
+    pH->s_type = type;
+    uint32_t empty = sizeof(uint32_t);
+    memcpy(item.data() + sizeof(v12::RingItemHeader), &empty, sizeof(empty));
+
+    m_offsets.push_back(lseek(m_fd, 0, SEEK_CUR));
+    m_types.push_back(type);
+    write(m_fd, item.data(), item.size());
+}
+void
+v12scantest::writeRun(unsigned nEvents)
+{
+    writeItem(v12::BEGIN_RUN, 100);
+    for (unsigned i = 0; i < nEvents; i++) {
+        writeItem(v12::PHYSICS_EVENT, (i * 37) % 500);
+        if ((i % 100) == 99) {
+            writeItem(v12::PERIODIC_SCALERS, 64);
+        }
+    }
+    writeItem(v12::END_RUN, 100);
+}
+
+// Chunks cover the file and start on item boundaries:
+
+void v12scantest::chunks_1()
+{
+    writeRun(2000);
+    CRingParallelScanner scanner(m_fd, FormatSelector::v12, 3, 7);
+    EQ(unsigned(3), scanner.getThreadCount());
+    EQ(uint64_t(lseek(m_fd, 0, SEEK_END)), scanner.getFileSize());
+
+    auto& chunks = scanner.getChunks();
+    EQ(size_t(7), chunks.size());
+    EQ(uint64_t(0), chunks[0].s_begin);
+    EQ(scanner.getFileSize(), chunks.back().s_end);
+    std::set<uint64_t> offsets(m_offsets.begin(), m_offsets.end());
+    for (unsigned i = 0; i < chunks.size(); i++) {
+        EQ(i, chunks[i].s_index);
+        ASSERT(offsets.count(chunks[i].s_begin));
+        if (i > 0) {
+            EQ(chunks[i-1].s_end, chunks[i].s_begin);
+        }
+    }
+}
+// More chunks than items gives at most one chunk per item:
+
+void v12scantest::chunks_2()
+{
+    writeItem(v12::BEGIN_RUN, 1000);
+    writeItem(v12::END_RUN, 1000);
+    CRingParallelScanner scanner(m_fd, FormatSelector::v12, 2, 50);
+    auto& chunks = scanner.getChunks();
+    EQ(size_t(2), chunks.size());
+    EQ(m_offsets[1], chunks[0].s_end);
+}
+// Merging the workers in order gives the items in file order:
+
+void v12scantest::scan_1()
+{
+    writeRun(5000);
+    CRingParallelScanner scanner(m_fd, FormatSelector::v12, 4, 16, 4096);
+    RecordingFactory factory;
+    auto workers = scanner.scan(factory);
+    EQ(unsigned(4), factory.m_factories);
+    EQ(scanner.getChunks().size(), workers.size());
+
+    std::vector<uint64_t> offsets;
+    std::vector<uint32_t> types;
+    uint64_t total = 0;
+    for (unsigned i = 0; i < workers.size(); i++) {
+        RecordingWorker* w = dynamic_cast<RecordingWorker*>(workers[i]);
+        ASSERT(w->m_done);
+        EQ(uint64_t(w->m_offsets.size()), scanner.getChunks()[i].s_itemCount);
+        offsets.insert(offsets.end(), w->m_offsets.begin(), w->m_offsets.end());
+        types.insert(types.end(), w->m_types.begin(), w->m_types.end());
+        total += scanner.getChunks()[i].s_itemCount;
+        delete w;
+    }
+    EQ(uint64_t(m_offsets.size()), total);
+    ASSERT(offsets == m_offsets);
+    ASSERT(types == m_types);
+}
+// Worker errors stop the scan and are rethrown:
+
+class ThrowingWorker : public CRingParallelScanner::Worker
+{
+public:
+    virtual void process(CRingItem& item, uint64_t offset) {
+        if (item.type() == v12::END_RUN) {
+            throw std::logic_error("end run");
+        }
+    }
+};
+class ThrowingFactory : public RecordingFactory
+{
+public:
+    virtual CRingParallelScanner::Worker* makeWorker(
+        const CRingParallelScanner::Chunk& chunk
+    ) {
+        return new ThrowingWorker;
+    }
+};
+
+void v12scantest::scan_2()
+{
+    writeRun(1000);
+    CRingParallelScanner scanner(m_fd, FormatSelector::v12, 2, 4);
+    ThrowingFactory factory;
+    CPPUNIT_ASSERT_THROW(scanner.scan(factory), std::logic_error);
+}
+// An empty file has no chunks:
+
+void v12scantest::empty_1()
+{
+    CRingParallelScanner scanner(m_fd, FormatSelector::v12, 2);
+    EQ(size_t(0), scanner.getChunks().size());
+    RecordingFactory factory;
+    EQ(size_t(0), scanner.scan(factory).size());
+}